@@ -5,3 +5,6 @@ src/main-menu.cpp)
 set(FACTORY_SRC
 src/factory/font_render.cpp
 src/factory/collector.cpp)
+
+set(SYSTEM_SRC
+src/system/thread-pool.cpp)
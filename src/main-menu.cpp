@@ -144,6 +144,32 @@ public:
     }
 };
 
+class HeadlessArgument: public Argument::Parameter {
+public:
+    HeadlessArgument(Global::InitConditions * conditions):
+    conditions(conditions){
+    }
+
+    Global::InitConditions * conditions;
+
+    vector<string> keywords() const {
+        vector<string> out;
+        out.push_back("headless");
+        out.push_back("nographics");
+        return out;
+    }
+
+    string description() const {
+        return " : Run without a display or sound, such as for mugen:batch on a server";
+    }
+
+    vector<string>::iterator parse(vector<string>::iterator current, vector<string>::iterator end, Argument::ActionRefs & actions){
+        conditions->graphics = Global::InitConditions::Disabled;
+        conditions->sound = false;
+        return current;
+    }
+};
+
 class HelpArgument: public Argument::Parameter {
 public:
     HelpArgument(const vector<Util::ReferenceCount<Argument::Parameter> > & arguments):
@@ -861,6 +887,7 @@ int rtech_main(int argc, char ** argv){
     arguments.push_back(Util::ReferenceCount<Argument::Parameter>(new WindowedArgument(&conditions)));
     arguments.push_back(Util::ReferenceCount<Argument::Parameter>(new DataPathArgument()));
     arguments.push_back(Util::ReferenceCount<Argument::Parameter>(new SoundArgument(&conditions)));
+    arguments.push_back(Util::ReferenceCount<Argument::Parameter>(new HeadlessArgument(&conditions)));
     arguments.push_back(Util::ReferenceCount<Argument::Parameter>(new MusicArgument(&music_on)));
     arguments.push_back(Util::ReferenceCount<Argument::Parameter>(new DebugArgument()));
     arguments.push_back(Util::ReferenceCount<Argument::Parameter>(new DebugFileArgument()));
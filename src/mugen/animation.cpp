@@ -8,6 +8,7 @@
 
 #include "character-state.h"
 #include "sprite.h"
+#include "atlas.h"
 #include "util.h"
 #include "exception.h"
 #include <sstream>
@@ -137,10 +138,20 @@ Frame::~Frame(){
      */
 }
 
+AnimationFrames::AnimationFrames(){
+}
+
+AnimationFrames::~AnimationFrames(){
+    for (vector<Frame*>::iterator it = frames.begin(); it != frames.end(); it++){
+        delete *it;
+    }
+}
+
 /*
 Holds mugen animations, ie: player.air
 */
 Animation::Animation():
+frameSet(new AnimationFrames()),
 loopPosition(0),
 playOnce(false),
 type(Mugen::Unknown),
@@ -149,15 +160,17 @@ showOffense(false){
 }
         
 Animation::Animation(const PaintownUtil::ReferenceCount<Sprite> & sprite, bool mask):
+frameSet(new AnimationFrames()),
 loopPosition(0),
 playOnce(false),
 type(Mugen::Unknown),
 showDefense(false),
 showOffense(false){
-    frames.push_back(new Frame(sprite, mask));
+    frameSet->frames.push_back(new Frame(sprite, mask));
 }
 
 Animation::Animation(const Animation &copy):
+frameSet(copy.frameSet),
 playOnce(copy.playOnce),
 state(copy.state){
     this->loopPosition = copy.loopPosition;
@@ -165,38 +178,38 @@ state(copy.state){
     this->type = copy.type;
     this->showDefense = copy.showDefense;
     this->showOffense = copy.showOffense;
-    for (vector<Frame*>::const_iterator it = copy.frames.begin(); it != copy.frames.end(); it++){
-        Frame * old = *it;
-        this->frames.push_back(new Frame(*old));
-    }
     this->getState().ticks = 0;
     this->getState().virtual_ticks = 0;
     this->getState().started = false;
 }
 
 Animation::~Animation(){
-    for (std::vector< Frame * >::iterator i = frames.begin() ; i != frames.end() ; ++i){
-	if (*i){
-            delete (*i);
-        }
+}
+
+void Animation::ownFrames(){
+    PaintownUtil::ReferenceCount<AnimationFrames> mine(new AnimationFrames());
+    for (vector<Frame*>::const_iterator it = frameSet->frames.begin(); it != frameSet->frames.end(); it++){
+        Frame * old = *it;
+        mine->frames.push_back(new Frame(*old));
     }
+    frameSet = mine;
 }
 
 void Animation::addFrame(Frame *frame){
     if (frame->loopstart){
-	loopPosition = frames.size();
+	loopPosition = frameSet->frames.size();
     }
-    frames.push_back(frame);
+    frameSet->frames.push_back(frame);
 }
 
 const Frame * Animation::getNext(){
-    if (getState().position < frames.size() - 1){
+    if (getState().position < frameSet->frames.size() - 1){
         getState().position += 1;
     } else {
         getState().position = loopPosition;
     }
     
-    return frames[getState().position];
+    return frameSet->frames[getState().position];
 }
 
 /* time elapsed since a given element has been shown. negative if the
@@ -207,14 +220,14 @@ const Frame * Animation::getNext(){
  */
 int Animation::animationElementElapsed(int position) const {
     int total = 0;
-    if (position < 1 || position > (int) frames.size() + 1){
+    if (position < 1 || position > (int) frameSet->frames.size() + 1){
         ostringstream out;
-        out << "Invalid animation position: " << position << ". Position must be in the range 1 to " << (frames.size() + 1);
+        out << "Invalid animation position: " << position << ". Position must be in the range 1 to " << (frameSet->frames.size() + 1);
         throw MugenNormalRuntimeException(out.str());
     }
 
     for (int from = (int) this->getState().position; from < position - 1; from++){
-        total -= frames[from]->time;
+        total -= frameSet->frames[from]->time;
     }
 
     if (position - 1 == (int) this->getState().position){
@@ -223,7 +236,7 @@ int Animation::animationElementElapsed(int position) const {
     }
 
     for (int from = position - 1; from < (int) this->getState().position; from++){
-        total += frames[from]->time;
+        total += frameSet->frames[from]->time;
     }
 
     return total;
@@ -232,17 +245,17 @@ int Animation::animationElementElapsed(int position) const {
 /* time left in the animation */
 int Animation::animationTime() const {
     // return (int) position - (int) frames.size() + 1;
-    if (frames[getState().position]->time == -1){
+    if (frameSet->frames[getState().position]->time == -1){
         return -1;
     }
 
-    int left = frames[getState().position]->time - getState().ticks - 1;
+    int left = frameSet->frames[getState().position]->time - getState().ticks - 1;
     /* FIXME: might need to add virtual_ticks here for loop time */
-    for (unsigned int rest = getState().position + 1; rest < frames.size(); rest++){
-        if (frames[rest]->time == -1){
+    for (unsigned int rest = getState().position + 1; rest < frameSet->frames.size(); rest++){
+        if (frameSet->frames[rest]->time == -1){
             return -1;
         }
-        left += frames[rest]->time;
+        left += frameSet->frames[rest]->time;
     }
     // Global::debug(0) << "Animation time " << left << endl;
     return left;
@@ -285,7 +298,7 @@ static vector<Area> scaleBoxes(const vector<Area> & boxes, double x, double y){
 
 
 const std::vector<Area> Animation::getDefenseBoxes(bool reverse, double xscale, double yscale) const {
-    Frame * frame = frames[getState().position];
+    Frame * frame = frameSet->frames[getState().position];
     if (reverse){
         return scaleBoxes(reverseBoxes(frame->getDefenseBoxes()), xscale, yscale);
     }
@@ -293,7 +306,7 @@ const std::vector<Area> Animation::getDefenseBoxes(bool reverse, double xscale,
 }
 
 const std::vector<Area> Animation::getAttackBoxes(bool reverse, double xscale, double yscale) const {
-    Frame * frame = frames[getState().position];
+    Frame * frame = frameSet->frames[getState().position];
     if (reverse){
         return scaleBoxes(reverseBoxes(frame->getAttackBoxes()), xscale, yscale);
     }
@@ -305,13 +318,13 @@ void Animation::virtualTick(){
 }
 
 void Animation::logic(){
-    if (getState().position < frames.size()){
-        if (frames[getState().position]->time != -1){
+    if (getState().position < frameSet->frames.size()){
+        if (frameSet->frames[getState().position]->time != -1){
             getState().ticks += 1;
-            if (getState().ticks >= frames[getState().position]->time){
+            if (getState().ticks >= frameSet->frames[getState().position]->time){
                 getState().ticks = 0;
                 getState().virtual_ticks = 0;
-                if (getState().position < frames.size() - 1){
+                if (getState().position < frameSet->frames.size() - 1){
                     getState().position += 1;
                 } else {
 		    if (!playOnce){
@@ -327,7 +340,7 @@ void Animation::logic(){
 }
         
 void Animation::setPosition(int position){
-    if (position < (int) frames.size() && position >= 0){
+    if (position < (int) frameSet->frames.size() && position >= 0){
         this->getState().position = position;
         this->getState().ticks = 0;
         this->getState().virtual_ticks = 0;
@@ -348,6 +361,10 @@ void Animation::renderFrame(Frame * frame, int xaxis, int yaxis, const Graphics:
     
     frame->render(xaxis, yaxis, work, effects);
 
+    if (showDefense || showOffense){
+        Atlas::Batch::flush();
+    }
+
     if (showDefense){
         renderCollision(getDefenseBoxes(effects.facing, effects.scalex, effects.scaley), work, xaxis, yaxis, Graphics::makeColor(0, 255, 0));
     }
@@ -358,12 +375,12 @@ void Animation::renderFrame(Frame * frame, int xaxis, int yaxis, const Graphics:
 }
 
 void Animation::render(int xaxis, int yaxis, const Graphics::Bitmap & work, const Mugen::Effects & effects){
-    if (getState().position >= frames.size()){
+    if (getState().position >= frameSet->frames.size()){
         return;
     }
 
-    Mugen::Effects combined = frames[getState().position]->effects + effects;
-    renderFrame(frames[getState().position], xaxis, yaxis, work, combined);
+    Mugen::Effects combined = frameSet->frames[getState().position]->effects + effects;
+    renderFrame(frameSet->frames[getState().position], xaxis, yaxis, work, combined);
 }
         
 Animation * Animation::copy() const {
@@ -371,40 +388,40 @@ Animation * Animation::copy() const {
 }
 
 void Animation::render(int xaxis, int yaxis, const Graphics::Bitmap &work, double scalex, double scaley){
-    if (getState().position >= frames.size()){
+    if (getState().position >= frameSet->frames.size()){
         return;
     }
 
-    Mugen::Effects effects = frames[getState().position]->effects;
+    Mugen::Effects effects = frameSet->frames[getState().position]->effects;
     effects.scalex = scalex;
     effects.scaley = scaley;
 
-    renderFrame(frames[getState().position], xaxis, yaxis, work, effects);
+    renderFrame(frameSet->frames[getState().position], xaxis, yaxis, work, effects);
 
 #if 0
     // Modify with frame adjustment
-    const int placex = xaxis+frames[position]->xoffset;
-    const int placey = yaxis+frames[position]->yoffset;
+    const int placex = xaxis+frameSet->frames[position]->xoffset;
+    const int placey = yaxis+frameSet->frames[position]->yoffset;
     try{
-        frames[position]->sprite->render(placex,placey,work,frames[position]->effects);
+        frameSet->frames[position]->sprite->render(placex,placey,work,frameSet->frames[position]->effects);
         
         if (showDefense){
-            renderCollision( frames[position]->defenseCollision, work, xaxis, yaxis, Bitmap::makeColor( 0,255,0 ) );
+            renderCollision( frameSet->frames[position]->defenseCollision, work, xaxis, yaxis, Bitmap::makeColor( 0,255,0 ) );
         }
 
         if (showOffense){
-            renderCollision( frames[position]->attackCollision, work, xaxis, yaxis,  Bitmap::makeColor( 255,0,0 ) );
+            renderCollision( frameSet->frames[position]->attackCollision, work, xaxis, yaxis,  Bitmap::makeColor( 255,0,0 ) );
         }
     } catch (const LoadException & e){
         Global::debug(0) << "Error loading sprite: " << e.getReason() << endl;
         /* FIXME: do something sensible here */
-        frames[position]->sprite = 0;
+        frameSet->frames[position]->sprite = 0;
     }
 #endif
 }
 
 Mugen::Effects Animation::getCurrentEffects(bool facing, bool vfacing, double scalex, double scaley){
-    Frame * frame = frames[getState().position];
+    Frame * frame = frameSet->frames[getState().position];
     Mugen::Effects effects = frame->effects;
     effects.scalex = scalex;
     effects.scaley = scaley;
@@ -414,11 +431,11 @@ Mugen::Effects Animation::getCurrentEffects(bool facing, bool vfacing, double sc
 }
 
 void Animation::render(bool facing, bool vfacing, const int xaxis, const int yaxis, const Graphics::Bitmap &work, const double scalex, const double scaley, Graphics::Bitmap::Filter * filter){
-    if (getState().position >= frames.size()){
+    if (getState().position >= frameSet->frames.size()){
         return;
     }
 
-    Frame * frame = frames[getState().position];
+    Frame * frame = frameSet->frames[getState().position];
     Mugen::Effects effects = frame->effects;
     effects.scalex = scalex;
     effects.scaley = scaley;
@@ -446,11 +463,11 @@ void Animation::render(bool facing, bool vfacing, const int xaxis, const int yax
 }
 
 void Animation::renderReflection(bool facing, bool vfacing, int alpha, const int xaxis, const int yaxis, const Graphics::Bitmap &work, const double scalex, const double scaley){
-    if (getState().position >= frames.size()){
+    if (getState().position >= frameSet->frames.size()){
         return;
     }
 
-    Frame * frame = frames[getState().position];
+    Frame * frame = frameSet->frames[getState().position];
     Mugen::Effects effects = frame->effects;
     effects.facing = facing;
     effects.vfacing = vfacing;
@@ -463,7 +480,7 @@ void Animation::renderReflection(bool facing, bool vfacing, int alpha, const int
 }
 
 void Animation::forwardFrame(){
-    if (getState().position < frames.size() -1){
+    if (getState().position < frameSet->frames.size() -1){
         getState().position++;
     } else {
         getState().position = loopPosition;
@@ -474,12 +491,12 @@ void Animation::backFrame(){
     if (getState().position > loopPosition){
         getState().position--;
     } else {
-        getState().position = frames.size() - 1;
+        getState().position = frameSet->frames.size() - 1;
     }
 }
 	
 Frame *Animation::getCurrentFrame(){
-    return frames[getPosition()];
+    return frameSet->frames[getPosition()];
 }
         
 const AnimationState & Animation::getState() const {
@@ -505,7 +522,7 @@ void Animation::deserialize(const Token * token){
 /* who uses this function? */
 /*
 void Animation::reloadBitmaps(){
-    for( std::vector< Frame * >::iterator i = frames.begin() ; i != frames.end() ; ++i ){
+    for( std::vector< Frame * >::iterator i = frameSet->frames.begin() ; i != frameSet->frames.end() ; ++i ){
 	Frame *frame = *i;
 	if (frame->sprite != NULL){
 	   // if (frame->bmp) delete frame->bmp;
@@ -96,6 +96,18 @@ class Frame{
 	//int colorDestination;
 };
 
+/* The frames of an animation. Frames don't change once the air file is
+ * loaded so copies of an animation (helpers, effects, explods) share them
+ * and only keep their own AnimationState.
+ */
+class AnimationFrames{
+public:
+    AnimationFrames();
+    virtual ~AnimationFrames();
+
+    std::vector<Frame*> frames;
+};
+
 /*
  * Holds mugen animations, ie: player.air
  */
@@ -117,6 +129,11 @@ class Animation{
 	// Add a frame
 	void addFrame(Frame *);
 
+        /* Copies share their frames, call this before changing the frames
+         * of a copy so the original keeps its own.
+         */
+        void ownFrames();
+
         virtual inline unsigned int getPosition() const {
             return getState().position;
         }
@@ -182,7 +199,7 @@ class Animation{
         }
 	
         inline const std::vector<Frame*> & getFrames() const {
-            return frames;
+            return frameSet->frames;
         }
 
         int animationTime() const;
@@ -202,7 +219,7 @@ class Animation{
 	}
 	
 	virtual inline bool isDone(){
-	    return (getState().position == frames.size() -1);
+	    return (getState().position == frameSet->frames.size() -1);
 	}
 
         const AnimationState & getState() const;
@@ -217,7 +234,7 @@ class Animation{
         void renderFrame(Frame * frame, int xaxis, int yaxis, const Graphics::Bitmap & work, const Mugen::Effects & effects);
 	
     private:
-	std::vector< Frame * > frames;
+        PaintownUtil::ReferenceCount<AnimationFrames> frameSet;
 	
 	unsigned int loopPosition;
 	
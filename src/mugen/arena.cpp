@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include <new>
+#include "arena.h"
+
+/* The arena bound to each thread. r-tech1 has no thread local storage so use
+ * the compiler's, like simulation.cpp.
+ */
+#ifdef _MSC_VER
+#define ARENA_THREAD_LOCAL __declspec(thread)
+#else
+#define ARENA_THREAD_LOCAL __thread
+#endif
+
+namespace Mugen{
+
+static ARENA_THREAD_LOCAL Arena * bound = NULL;
+
+/* In front of every piece so release() knows where it came from. 16 bytes
+ * so the object after it is aligned for anything.
+ */
+union Header{
+    struct Owner{
+        Arena * arena;
+        size_t size;
+    } owner;
+    char padding[16];
+};
+
+Arena::Arena():
+current(NULL),
+left(0),
+allocations(0),
+live(0){
+    for (size_t i = 0; i < Classes; i++){
+        freeList[i] = NULL;
+    }
+}
+
+Arena::~Arena(){
+    for (std::vector<char *>::iterator it = blocks.begin(); it != blocks.end(); it++){
+        free(*it);
+    }
+}
+
+void * Arena::allocate(size_t size){
+    size_t total = sizeof(Header) + size;
+    Arena * arena = bound;
+    Header * header = NULL;
+    if (arena != NULL && total <= Granularity * Classes){
+        total = (total + Granularity - 1) / Granularity * Granularity;
+        header = (Header*) arena->take(total);
+    } else {
+        arena = NULL;
+        header = (Header*) malloc(total);
+        if (header == NULL){
+            throw std::bad_alloc();
+        }
+    }
+
+    header->owner.arena = arena;
+    header->owner.size = total;
+    return header + 1;
+}
+
+void Arena::release(void * memory){
+    if (memory == NULL){
+        return;
+    }
+
+    Header * header = (Header*) memory - 1;
+    if (header->owner.arena == NULL){
+        free(header);
+    } else {
+        header->owner.arena->give(header, header->owner.size);
+    }
+}
+
+void * Arena::take(size_t size){
+    allocations += 1;
+    live += 1;
+
+    size_t index = size / Granularity - 1;
+    if (freeList[index] != NULL){
+        void * out = freeList[index];
+        freeList[index] = *(void**) out;
+        return out;
+    }
+
+    /* whatever is left of the last block is wasted, it is less than the
+     * largest piece
+     */
+    if (left < size){
+        current = (char*) malloc(BlockSize);
+        if (current == NULL){
+            left = 0;
+            throw std::bad_alloc();
+        }
+        blocks.push_back(current);
+        left = BlockSize;
+    }
+
+    void * out = current;
+    current += size;
+    left -= size;
+    return out;
+}
+
+void Arena::give(void * memory, size_t size){
+    live -= 1;
+    size_t index = size / Granularity - 1;
+    *(void**) memory = freeList[index];
+    freeList[index] = memory;
+}
+
+Arena::Scope::Scope(Arena * arena):
+previous(bound){
+    bound = arena;
+}
+
+Arena::Scope::~Scope(){
+    bound = previous;
+}
+
+}
@@ -0,0 +1,89 @@
+#ifndef _paintown_mugen_arena_h
+#define _paintown_mugen_arena_h
+
+#include <stddef.h>
+#include <vector>
+
+namespace Mugen{
+
+/* Memory for the many small objects a character is made of: the ast nodes
+ * its files parse into, its compiled triggers and its state controllers.
+ * Ast::Element, Compiler::Value and StateController get their memory from
+ * Arena::allocate, which takes it from the arena bound to the calling thread
+ * with a Scope, or from the heap when no arena is bound.
+ *
+ * An arena hands out pieces of large blocks and keeps the pieces that are
+ * deleted on free lists to use again, so loading and unloading characters
+ * doesn't leave small objects scattered all over the heap. Objects are
+ * still deleted one at a time but that only puts them on a free list, the
+ * blocks go back to the heap in one go when the arena is destroyed. So
+ * everything made in an arena has to be gone before the arena is.
+ *
+ * An arena is not locked, only one thread can use it at a time.
+ */
+class Arena{
+public:
+    Arena();
+    ~Arena();
+
+    /* memory from the bound arena, or from the heap */
+    static void * allocate(size_t size);
+    /* gives memory from allocate() back to wherever it came from */
+    static void release(void * memory);
+
+    /* Binds an arena to the calling thread until the scope ends. Scopes
+     * nest, the previous arena is bound again when this one goes away. A
+     * NULL arena means the heap.
+     */
+    class Scope{
+    public:
+        Scope(Arena * arena);
+        ~Scope();
+
+    protected:
+        Arena * previous;
+    };
+
+    /* number of objects made in this arena */
+    inline unsigned int getAllocations() const {
+        return allocations;
+    }
+
+    /* number of objects made in this arena that were not deleted yet */
+    inline unsigned int getLive() const {
+        return live;
+    }
+
+    /* bytes taken from the heap */
+    inline size_t getSize() const {
+        return blocks.size() * BlockSize;
+    }
+
+protected:
+    void * take(size_t size);
+    void give(void * memory, size_t size);
+
+    static const size_t BlockSize = 64 * 1024;
+    /* pieces are multiples of 16 bytes, larger ones come from the heap */
+    static const size_t Granularity = 16;
+    static const size_t Classes = 32;
+
+    std::vector<char *> blocks;
+    /* unused part of the last block */
+    char * current;
+    size_t left;
+
+    /* free pieces for each size, linked through their first word */
+    void * freeList[Classes];
+
+    unsigned int allocations;
+    unsigned int live;
+
+private:
+    Arena(const Arena & copy);
+    Arena & operator=(const Arena & copy);
+};
+
+}
+
+#endif
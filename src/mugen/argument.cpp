@@ -4,6 +4,8 @@
 #include "menu.h"
 #include <r-tech1/debug.h>
 #include "game.h"
+#include "compiler.h"
+#include "parse-cache.h"
 
 using std::vector;
 using std::string;
@@ -147,7 +149,9 @@ struct MugenInstant{
         Watch,
         Arcade,
         Script,
-        Team
+        Team,
+        Batch,
+        Record
     };
 
     MugenInstant():
@@ -396,6 +400,205 @@ public:
     }
 };
 
+class MugenBatchArgument: public Argument::Parameter {
+public:
+    MugenInstant data;
+
+    vector<string> keywords() const {
+        vector<string> out;
+        out.push_back("mugen:batch");
+        return out;
+    }
+
+    string description() const {
+        return " <player 1 name>[:<behavior>],<player 2 name>[:<behavior>],<stage> [matches] : Run matches as fast as possible without drawing or sound and show who won. A behavior is ai (the default), random, dummy or the path to a script. Combine with 'headless' to run without a display";
+    }
+
+    class Run: public Argument::Action {
+    public:
+
+        Run(MugenInstant data, int matches):
+            data(data),
+            matches(matches){
+            }
+
+        MugenInstant data;
+        int matches;
+
+        void act(){
+            Util::loadMotif();
+            Global::debug(0) << "Mugen batch mode player1 '" << data.player1 << "' behavior '" << data.player1Script << "' player2 '" << data.player2 << "' behavior '" << data.player2Script << "' stage '" << data.stage << "' matches " << matches << endl;
+            Mugen::Game::startBatch(data.player1, data.player1Script, data.player2, data.player2Script, data.stage, matches);
+        }
+    };
+
+    vector<string>::iterator parse(vector<string>::iterator current, vector<string>::iterator end, Argument::ActionRefs & actions){
+        current++;
+        if (current != end){
+            data.enabled = parseMugenInstant(*current, &data.player1, &data.player2, &data.stage);
+            string player, behavior;
+            splitString(data.player1, ':', player, behavior);
+            if (player != ""){
+                data.player1 = player;
+                data.player1Script = behavior;
+            }
+
+            player = "";
+            behavior = "";
+            splitString(data.player2, ':', player, behavior);
+            if (player != ""){
+                data.player2 = player;
+                data.player2Script = behavior;
+            }
+
+            data.kind = MugenInstant::Batch;
+
+            int matches = 1;
+            vector<string>::iterator next = current;
+            next++;
+            if (next != end && atoi(next->c_str()) > 0){
+                matches = atoi(next->c_str());
+                current = next;
+            }
+
+            actions.push_back(::Util::ReferenceCount<Argument::Action>(new Run(data, matches)));
+        } else {
+            Global::debug(0) << "Expected an argument. Example: mugen:batch kfm:ai,ken:random,falls 100" << endl;
+        }
+
+        return current;
+    }
+};
+
+class MugenRecordArgument: public Argument::Parameter {
+public:
+    MugenInstant data;
+
+    vector<string> keywords() const {
+        vector<string> out;
+        out.push_back("mugen:record");
+        return out;
+    }
+
+    string description() const {
+        return " <player 1 name>,<player 2 name>,<stage> <file> : Play against the ai and save the match as a replay in file";
+    }
+
+    class Run: public Argument::Action {
+    public:
+
+        Run(MugenInstant data, const string & file):
+            data(data),
+            file(file){
+            }
+
+        MugenInstant data;
+        string file;
+
+        void act(){
+            Util::loadMotif();
+            Global::debug(0) << "Mugen record mode player1 '" << data.player1 << "' player2 '" << data.player2 << "' stage '" << data.stage << "' file '" << file << "'" << endl;
+            Mugen::Game::startRecord(data.player1, data.player2, data.stage, file);
+        }
+    };
+
+    vector<string>::iterator parse(vector<string>::iterator current, vector<string>::iterator end, Argument::ActionRefs & actions){
+        current++;
+        if (current != end){
+            data.enabled = parseMugenInstant(*current, &data.player1, &data.player2, &data.stage);
+            data.kind = MugenInstant::Record;
+
+            string file = "mugen.replay";
+            vector<string>::iterator next = current;
+            next++;
+            if (next != end){
+                file = *next;
+                current = next;
+            }
+
+            actions.push_back(::Util::ReferenceCount<Argument::Action>(new Run(data, file)));
+        } else {
+            Global::debug(0) << "Expected an argument. Example: mugen:record kfm,ken,falls kfm.replay" << endl;
+        }
+
+        return current;
+    }
+};
+
+class MugenReplayArgument: public Argument::Parameter {
+public:
+    vector<string> keywords() const {
+        vector<string> out;
+        out.push_back("mugen:replay");
+        return out;
+    }
+
+    string description() const {
+        return " <file> : Play a replay made with mugen:record as fast as possible without drawing or sound";
+    }
+
+    class Run: public Argument::Action {
+    public:
+        Run(const string & file):
+            file(file){
+            }
+
+        string file;
+
+        void act(){
+            Util::loadMotif();
+            Mugen::Game::playReplay(file);
+        }
+    };
+
+    vector<string>::iterator parse(vector<string>::iterator current, vector<string>::iterator end, Argument::ActionRefs & actions){
+        current++;
+        if (current != end){
+            actions.push_back(::Util::ReferenceCount<Argument::Action>(new Run(*current)));
+        } else {
+            Global::debug(0) << "Expected an argument. Example: mugen:replay kfm.replay" << endl;
+        }
+
+        return current;
+    }
+};
+
+class MugenShowFoldsArgument: public Argument::Parameter {
+public:
+    vector<string> keywords() const {
+        vector<string> out;
+        out.push_back("mugen:show-folds");
+        return out;
+    }
+
+    string description() const {
+        return " : Log the trigger expressions that are folded or cached when characters load";
+    }
+
+    vector<string>::iterator parse(vector<string>::iterator current, vector<string>::iterator end, Argument::ActionRefs & actions){
+        Compiler::setShowOptimizations(true);
+        return current;
+    }
+};
+
+class MugenFastParseArgument: public Argument::Parameter {
+public:
+    vector<string> keywords() const {
+        vector<string> out;
+        out.push_back("mugen:fast-parse");
+        return out;
+    }
+
+    string description() const {
+        return " : Read .def, .air, .cmd and .cns files with the hand written parsers instead of the peg parsers";
+    }
+
+    vector<string>::iterator parse(vector<string>::iterator current, vector<string>::iterator end, Argument::ActionRefs & actions){
+        ParseCache::setFastParser(true);
+        return current;
+    }
+};
+
 class MugenServerArgument: public Argument::Parameter {
 public:
     vector<string> keywords() const {
@@ -481,6 +684,11 @@ std::vector< ::Util::ReferenceCount<Argument::Parameter> > arguments(){
     all.push_back(::Util::ReferenceCount<Argument::Parameter>(new MugenWatchArgument()));
     all.push_back(::Util::ReferenceCount<Argument::Parameter>(new MugenTeamArgument()));
     all.push_back(::Util::ReferenceCount<Argument::Parameter>(new MugenArcadeArgument()));
+    all.push_back(::Util::ReferenceCount<Argument::Parameter>(new MugenBatchArgument()));
+    all.push_back(::Util::ReferenceCount<Argument::Parameter>(new MugenRecordArgument()));
+    all.push_back(::Util::ReferenceCount<Argument::Parameter>(new MugenReplayArgument()));
+    all.push_back(::Util::ReferenceCount<Argument::Parameter>(new MugenShowFoldsArgument()));
+    all.push_back(::Util::ReferenceCount<Argument::Parameter>(new MugenFastParseArgument()));
 
     all.push_back(::Util::ReferenceCount<Argument::Parameter>(new MugenServerArgument()));
     all.push_back(::Util::ReferenceCount<Argument::Parameter>(new MugenClientArgument()));
@@ -62,6 +62,18 @@ public:
         return token;
     }
 
+    static ExpressionUnary * readBinary(BinaryReader & in){
+        int type;
+        int line, column;
+        in >> line >> column >> type;
+        Value * value = in.readValue();
+        return new ExpressionUnary(line, column, UnaryType(type), value);
+    }
+
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryExpressionUnary << getLine() << getColumn() << (int) getExpressionType() << getExpression();
+    }
+
     using Element::operator==;
     virtual bool operator==(const Value & him) const {
         return him == *this;
@@ -271,6 +283,19 @@ public:
         return new ExpressionInfix(line, column, InfixType(type), Value::deserialize(left), Value::deserialize(right));
     }
 
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryExpressionInfix << getLine() << getColumn() << (int) getExpressionType() << getLeft() << getRight();
+    }
+
+    static ExpressionInfix * readBinary(BinaryReader & in){
+        int type;
+        int line, column;
+        in >> line >> column >> type;
+        Value * left = in.readValue();
+        Value * right = in.readValue();
+        return new ExpressionInfix(line, column, InfixType(type), left, right);
+    }
+
     virtual inline const Value * getRight() const {
         return right;
     }
@@ -201,6 +201,29 @@ public:
 
         return section;
     }
+
+    /* values and attributes are written in walk order, each with its own code */
+    void writeBinary(BinaryWriter & out) const {
+        out << BinarySection << getName() << getLine() << getColumn() << (int) walkList.size();
+        std::list<Attribute*>::const_iterator attribute_it = attributes.begin();
+        std::list<Value*>::const_iterator value_it = values.begin();
+        for (std::list<WalkList>::const_iterator it = walkList.begin(); it != walkList.end(); it++){
+            switch (*it){
+                case WalkAttribute : {
+                    out << (const Attribute*) *attribute_it;
+                    attribute_it++;
+                    break;
+                }
+                case WalkValue : {
+                    out << (const Value*) *value_it;
+                    value_it++;
+                    break;
+                }
+            }
+        }
+    }
+
+    static Section * readBinary(BinaryReader & in);
     
     std::string toString() const {
         std::ostringstream out;
@@ -116,6 +116,7 @@ public:
     }
 
     static Value * deserialize(const Token * token);
+    static Value * readBinary(BinaryReader & in);
 
     /*
     using Element::operator==;
@@ -84,6 +84,17 @@ public:
         *token << SERIAL_ARGUMENT << getLine() << getColumn() << argument;
         return token;
     }
+
+    static Argument * readBinary(BinaryReader & in){
+        int line, column;
+        int argument;
+        in >> line >> column >> argument;
+        return new Argument(line, column, argument);
+    }
+
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryArgument << getLine() << getColumn() << argument;
+    }
         
     virtual std::string getType() const {
         return "argument";
@@ -189,4 +189,106 @@ Function * Function::deserialize(const Token * token){
     return new Function(line, column, name, args);
 }
 
+Function * Function::readBinary(BinaryReader & in){
+    string name;
+    int line, column;
+    in >> name >> line >> column;
+    return new Function(line, column, name, (ValueList*) in.readValue());
+}
+
+AttributeArray * AttributeArray::readBinary(BinaryReader & in){
+    int line, column;
+    in >> line >> column;
+    Value * name = in.readValue();
+    Value * index = in.readValue();
+    Value * value = in.readValue();
+    Keyword * keyword = dynamic_cast<Keyword*>(name);
+    if (keyword != NULL){
+        return new AttributeArray(line, column, keyword, index, value);
+    }
+    Identifier * identifier = dynamic_cast<Identifier*>(name);
+    if (identifier != NULL){
+        return new AttributeArray(line, column, identifier, index, value);
+    }
+    throw Exception("Binary ast error: no name given for an attribute array");
+}
+
+static bool isAttribute(BinaryCode code){
+    return code == BinaryAttributeSimple ||
+           code == BinaryAttributeArray ||
+           code == BinaryAttributeKeyword;
+}
+
+static Attribute * readAttribute(BinaryCode code, BinaryReader & in){
+    switch (code){
+        case BinaryNull: return NULL;
+        case BinaryAttributeSimple: return AttributeSimple::readBinary(in);
+        case BinaryAttributeArray: return AttributeArray::readBinary(in);
+        case BinaryAttributeKeyword: return AttributeKeyword::readBinary(in);
+        default: break;
+    }
+
+    throw Exception("Binary ast error: not an attribute");
+}
+
+static Value * readValue(BinaryCode code, BinaryReader & in){
+    switch (code){
+        case BinaryNull: return NULL;
+        case BinaryResource: return Resource::readBinary(in);
+        case BinaryNumber: return Number::readBinary(in);
+        case BinaryArgument: return Argument::readBinary(in);
+        case BinaryExpressionInfix: return ExpressionInfix::readBinary(in);
+        case BinaryExpressionUnary: return ExpressionUnary::readBinary(in);
+        case BinaryKeyword: return Keyword::readBinary(in);
+        case BinaryFunction: return Function::readBinary(in);
+        case BinaryIdentifier: return Identifier::readBinary(in);
+        case BinaryHelper: return Helper::readBinary(in);
+        case BinaryString: return String::readBinary(in);
+        case BinaryValueAttribute: return ValueAttribute::readBinary(in);
+        case BinaryValueList: return ValueList::readBinary(in);
+        case BinaryRange: return Range::readBinary(in);
+        case BinaryHitDefAttribute: return HitDefAttribute::readBinary(in);
+        case BinaryHitDefAttackAttribute: return HitDefAttackAttribute::readBinary(in);
+        case BinaryKeyList: return KeyList::readBinary(in);
+        case BinaryKeySingle: return KeySingle::readBinary(in);
+        case BinaryKeyModifier: return KeyModifier::readBinary(in);
+        case BinaryKeyCombined: return KeyCombined::readBinary(in);
+        case BinaryFilename: return Filename::readBinary(in);
+        default: break;
+    }
+
+    throw Exception("Binary ast error: not a value");
+}
+
+Attribute * Attribute::readBinary(BinaryReader & in){
+    return readAttribute(in.readCode(), in);
+}
+
+Value * Value::readBinary(BinaryReader & in){
+    return readValue(in.readCode(), in);
+}
+
+Section * Section::readBinary(BinaryReader & in){
+    if (in.readCode() != BinarySection){
+        throw Exception("Binary ast error: not a section");
+    }
+    string name;
+    int line, column, count;
+    in >> name >> line >> column >> count;
+    Section * section = new Section(new string(name), line, column);
+    for (int i = 0; i < count; i++){
+        BinaryCode code = in.readCode();
+        if (code == BinaryNull){
+            throw Exception("Binary ast error: empty section entry");
+        }
+        if (isAttribute(code)){
+            section->addAttribute(readAttribute(code, in));
+        } else {
+            section->addValue(readValue(code, in));
+        }
+    }
+
+    return section;
+}
+
 }
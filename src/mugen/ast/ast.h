@@ -3,6 +3,8 @@
 
 #include <map>
 #include <string>
+#include "binary.h"
+#include "../arena.h"
 
 class Token;
 
@@ -76,6 +78,15 @@ public:
      */
     static const int SERIAL_VERSION = 31;
 
+    /* nodes are kept in the arena of whoever is parsing, see arena.h */
+    static void * operator new(size_t size){
+        return Mugen::Arena::allocate(size);
+    }
+
+    static void operator delete(void * memory){
+        Mugen::Arena::release(memory);
+    }
+
     virtual void mark(std::map<const void*, bool> & marks) const = 0;
 
 #define define_equals(class_name) virtual bool operator!=(const class_name & him) const { return !(*this == him); } virtual bool operator==(const class_name & him) const { return false; }
@@ -113,6 +124,9 @@ public:
 
     virtual Token * serialize() const = 0;
 
+    /* same as serialize() but in the form BinaryReader reads */
+    virtual void writeBinary(BinaryWriter & out) const = 0;
+
     /* create a deep copy of this object */
     virtual Element * copy() const = 0;
 
@@ -86,6 +86,18 @@ public:
     }
 
     static AttributeArray * deserialize(const Token * token);
+    static AttributeArray * readBinary(BinaryReader & in);
+
+    /* the name is either a keyword or an identifier */
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryAttributeArray << getLine() << getColumn();
+        if (keyword_name != NULL){
+            out << keyword_name;
+        } else {
+            out << identifier_name;
+        }
+        out << index << value;
+    }
 
     Token * serialize() const {
         Token * token = new Token();
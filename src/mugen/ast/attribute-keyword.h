@@ -87,6 +87,18 @@ public:
         }
     }
 
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryAttributeKeyword << getLine() << getColumn() << name << value;
+    }
+
+    static AttributeKeyword * readBinary(BinaryReader & in){
+        int line, column;
+        in >> line >> column;
+        Keyword * keyword = (Keyword*) in.readValue();
+        Value * value = in.readValue();
+        return new AttributeKeyword(line, column, keyword, value);
+    }
+
     virtual View view() const {
         if (value != NULL){
             return value->view();
@@ -84,6 +84,18 @@ public:
     
     static AttributeSimple * deserialize(const Token * token);
 
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryAttributeSimple << getLine() << getColumn() << name << value;
+    }
+
+    static AttributeSimple * readBinary(BinaryReader & in){
+        int line, column;
+        in >> line >> column;
+        Identifier * name = (Identifier*) in.readValue();
+        Value * value = in.readValue();
+        return new AttributeSimple(line, column, name, value);
+    }
+
     std::string valueAsString() const {
         std::string str;
         view() >> str;
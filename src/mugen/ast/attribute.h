@@ -30,6 +30,7 @@ public:
     }
 
     static Attribute * deserialize(const Token * token);
+    static Attribute * readBinary(BinaryReader & in);
 
     using Element::operator==;
     virtual bool operator==(const std::string & str) const = 0;
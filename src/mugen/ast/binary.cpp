@@ -0,0 +1,214 @@
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "binary.h"
+#include "all.h"
+
+using std::string;
+
+namespace Ast{
+
+static const char * BINARY_MAGIC = "MAST";
+static const int BINARY_MAGIC_LENGTH = 4;
+
+/* zig-zag so small negative numbers, like the -1 of a missing line, stay small */
+static uint32_t zigzag(int value){
+    return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+}
+
+static int unzigzag(uint32_t value){
+    return (int) (value >> 1) ^ -(int) (value & 1);
+}
+
+BinaryWriter::BinaryWriter(){
+}
+
+void BinaryWriter::writeUnsigned(uint32_t value){
+    while (value >= 0x80){
+        nodes += (char) ((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    nodes += (char) value;
+}
+
+BinaryWriter & BinaryWriter::operator<<(BinaryCode code){
+    nodes += (char) code;
+    return *this;
+}
+
+BinaryWriter & BinaryWriter::operator<<(int value){
+    writeUnsigned(zigzag(value));
+    return *this;
+}
+
+BinaryWriter & BinaryWriter::operator<<(bool value){
+    nodes += (char) (value ? 1 : 0);
+    return *this;
+}
+
+/* Most numbers in mugen files are small integers, those are written as an
+ * integer and the rest as the bytes of the double.
+ */
+BinaryWriter & BinaryWriter::operator<<(double value){
+    if (value >= -1000000 && value <= 1000000 && value == (int) value && !(value == 0 && 1 / value < 0)){
+        nodes += (char) 0;
+        return *this << (int) value;
+    }
+    char bytes[sizeof(double)];
+    memcpy(bytes, &value, sizeof(double));
+    nodes += (char) 1;
+    nodes.append(bytes, sizeof(double));
+    return *this;
+}
+
+BinaryWriter & BinaryWriter::operator<<(const string & value){
+    std::map<string, uint32_t>::iterator found = stringIndex.find(value);
+    if (found == stringIndex.end()){
+        found = stringIndex.insert(std::make_pair(value, (uint32_t) strings.size())).first;
+        strings.push_back(&found->first);
+    }
+    writeUnsigned(found->second);
+    return *this;
+}
+
+BinaryWriter & BinaryWriter::operator<<(const Value * value){
+    if (value == NULL){
+        return *this << BinaryNull;
+    }
+    value->writeBinary(*this);
+    return *this;
+}
+
+BinaryWriter & BinaryWriter::operator<<(const Attribute * attribute){
+    if (attribute == NULL){
+        return *this << BinaryNull;
+    }
+    attribute->writeBinary(*this);
+    return *this;
+}
+
+string BinaryWriter::finish(uint64_t source) const {
+    BinaryWriter header;
+    header.nodes.append(BINARY_MAGIC, BINARY_MAGIC_LENGTH);
+    header.writeUnsigned(Element::SERIAL_VERSION);
+    for (int i = 0; i < 8; i++){
+        header.nodes += (char) ((source >> (i * 8)) & 0xff);
+    }
+    header.writeUnsigned(strings.size());
+    for (std::vector<const string*>::const_iterator it = strings.begin(); it != strings.end(); it++){
+        const string & value = **it;
+        header.writeUnsigned(value.size());
+        header.nodes += value;
+    }
+
+    return header.nodes + nodes;
+}
+
+BinaryReader::BinaryReader(const char * data, int length):
+data(data),
+length(length),
+position(0),
+source(0){
+    need(BINARY_MAGIC_LENGTH);
+    if (memcmp(data, BINARY_MAGIC, BINARY_MAGIC_LENGTH) != 0){
+        throw Exception("Not a binary ast");
+    }
+    position += BINARY_MAGIC_LENGTH;
+
+    if (readUnsigned() != (uint32_t) Element::SERIAL_VERSION){
+        throw Exception("Mistmatch between serial versions");
+    }
+
+    for (int i = 0; i < 8; i++){
+        source |= (uint64_t) readByte() << (i * 8);
+    }
+
+    uint32_t count = readUnsigned();
+    /* every string takes at least a byte, so a broken count fails here
+     * instead of reserving a huge vector
+     */
+    need(count);
+    strings.reserve(count);
+    for (uint32_t i = 0; i < count; i++){
+        uint32_t size = readUnsigned();
+        need(size);
+        strings.push_back(string(data + position, size));
+        position += size;
+    }
+}
+
+void BinaryReader::need(int bytes) const {
+    if (bytes < 0 || length - position < bytes){
+        throw Exception("Binary ast is cut short");
+    }
+}
+
+unsigned char BinaryReader::readByte(){
+    need(1);
+    unsigned char out = (unsigned char) data[position];
+    position += 1;
+    return out;
+}
+
+uint32_t BinaryReader::readUnsigned(){
+    uint32_t out = 0;
+    for (int shift = 0; shift < 35; shift += 7){
+        unsigned char byte = readByte();
+        out |= (uint32_t) (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0){
+            return out;
+        }
+    }
+    throw Exception("Bad integer in binary ast");
+}
+
+BinaryCode BinaryReader::readCode(){
+    unsigned char code = readByte();
+    if (code >= BinaryLast){
+        throw Exception("Bad node in binary ast");
+    }
+    return (BinaryCode) code;
+}
+
+BinaryReader & BinaryReader::operator>>(int & value){
+    value = unzigzag(readUnsigned());
+    return *this;
+}
+
+BinaryReader & BinaryReader::operator>>(bool & value){
+    value = readByte() != 0;
+    return *this;
+}
+
+BinaryReader & BinaryReader::operator>>(double & value){
+    if (readByte() == 0){
+        int whole;
+        *this >> whole;
+        value = whole;
+        return *this;
+    }
+    need(sizeof(double));
+    memcpy(&value, data + position, sizeof(double));
+    position += sizeof(double);
+    return *this;
+}
+
+BinaryReader & BinaryReader::operator>>(string & value){
+    uint32_t index = readUnsigned();
+    if (index >= strings.size()){
+        throw Exception("Bad string in binary ast");
+    }
+    value = strings[index];
+    return *this;
+}
+
+Value * BinaryReader::readValue(){
+    return Value::readBinary(*this);
+}
+
+Attribute * BinaryReader::readAttribute(){
+    return Attribute::readBinary(*this);
+}
+
+}
@@ -0,0 +1,124 @@
+#ifndef _paintown_ast_binary_h
+#define _paintown_ast_binary_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace Ast{
+
+class Value;
+class Attribute;
+
+/* One byte in front of every node in the binary form. These are part of
+ * the file format so add new codes at the end and bump SERIAL_VERSION if an
+ * existing node changes what it writes.
+ */
+enum BinaryCode{
+    BinaryNull = 0,
+    BinarySection,
+    BinaryAttributeSimple,
+    BinaryAttributeArray,
+    BinaryAttributeKeyword,
+    BinaryResource,
+    BinaryNumber,
+    BinaryArgument,
+    BinaryExpressionInfix,
+    BinaryExpressionUnary,
+    BinaryKeyword,
+    BinaryFunction,
+    BinaryIdentifier,
+    BinaryHelper,
+    BinaryString,
+    BinaryValueAttribute,
+    BinaryValueList,
+    BinaryRange,
+    BinaryHitDefAttribute,
+    BinaryHitDefAttackAttribute,
+    BinaryKeySingle,
+    BinaryKeyModifier,
+    BinaryKeyCombined,
+    BinaryKeyList,
+    BinaryFilename,
+    BinaryLast
+};
+
+/* Writes an ast in a compact binary form instead of a Token, see the
+ * writeBinary() methods of the nodes. Integers are variable length, doubles
+ * are copied as is and every string is kept once in a table at the front of
+ * the output, so the identifiers that repeat all through a cns file cost a
+ * byte or two each.
+ *
+ * The output is
+ *   magic, SERIAL_VERSION, a 64-bit hash of the source file,
+ *   the string table, then the nodes in the order they were written
+ */
+class BinaryWriter{
+public:
+    BinaryWriter();
+
+    BinaryWriter & operator<<(BinaryCode code);
+    BinaryWriter & operator<<(int value);
+    BinaryWriter & operator<<(bool value);
+    BinaryWriter & operator<<(double value);
+    BinaryWriter & operator<<(const std::string & value);
+    /* NULL is written as BinaryNull */
+    BinaryWriter & operator<<(const Value * value);
+    BinaryWriter & operator<<(const Attribute * attribute);
+
+    /* The whole file. The hash is stored in the header so a reader can tell
+     * if the file it came from has changed.
+     */
+    std::string finish(uint64_t source) const;
+
+protected:
+    void writeUnsigned(uint32_t value);
+
+    std::string nodes;
+    std::map<std::string, uint32_t> stringIndex;
+    std::vector<const std::string*> strings;
+};
+
+/* Reads what a BinaryWriter wrote straight out of a block of memory, which
+ * has to stay around until the nodes are made. A file that is cut short or
+ * doesn't match throws an Ast::Exception rather than making a bad ast.
+ */
+class BinaryReader{
+public:
+    BinaryReader(const char * data, int length);
+
+    uint64_t getSource() const {
+        return source;
+    }
+
+    bool hasMore() const {
+        return position < length;
+    }
+
+    BinaryCode readCode();
+
+    BinaryReader & operator>>(int & value);
+    BinaryReader & operator>>(bool & value);
+    BinaryReader & operator>>(double & value);
+    BinaryReader & operator>>(std::string & value);
+
+    /* NULL for BinaryNull */
+    Value * readValue();
+    Attribute * readAttribute();
+
+protected:
+    uint32_t readUnsigned();
+    unsigned char readByte();
+    void need(int bytes) const;
+
+    const char * data;
+    int length;
+    int position;
+    uint64_t source;
+    std::vector<std::string> strings;
+};
+
+}
+
+#endif
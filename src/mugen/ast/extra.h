@@ -7,6 +7,8 @@
 #include <string.h>
 #include "Section.h"
 #include "exception.h"
+#include "../arena.h"
+#include <r-tech1/pointer.h>
 #include <r-tech1/token.h>
 #include <r-tech1/tokenreader.h>
 
@@ -21,11 +23,22 @@ public:
     /* boiler plate stuff */
 
     AstParse(std::list<Section*> * sections):
-    sections(sections){
+    sections(sections),
+    owner(true){
+    }
+
+    /* Looks at the sections of another parse without taking them over. The
+     * other parse has to outlive this one.
+     */
+    static AstParse * borrow(const AstParse & from){
+        AstParse * out = new AstParse(from.sections);
+        out->owner = false;
+        return out;
     }
 
     AstParse(Token * token):
-    sections(NULL){
+    sections(NULL),
+    owner(true){
         sections = deserialize(token);
     }
 
@@ -94,7 +107,17 @@ public:
         return my_it == sections->end() && him_it == him.sections->end();
     }
 
+    /* The arena the sections were made in. It is let go after the sections
+     * are deleted.
+     */
+    void setArena(const Util::ReferenceCount<Mugen::Arena> & arena){
+        this->arena = arena;
+    }
+
     virtual ~AstParse(){
+        if (!owner){
+            return;
+        }
         if (sections != NULL){
             for (std::list<Section*>::iterator section_it = sections->begin(); section_it != sections->end(); section_it++){
                 delete (*section_it);
@@ -128,6 +151,32 @@ public:
         return token;
     }
 
+    /* the binary form the parse cache keeps on disk, see binary.h */
+    void writeBinary(BinaryWriter & out) const {
+        out << (int) sections->size();
+        for (std::list<Section*>::const_iterator section_it = sections->begin(); section_it != sections->end(); section_it++){
+            (*section_it)->writeBinary(out);
+        }
+    }
+
+    static std::list<Section*> * readBinary(BinaryReader & in){
+        int count;
+        in >> count;
+        std::list<Section*> * out = new std::list<Section*>();
+        try{
+            for (int i = 0; i < count; i++){
+                out->push_back(Section::readBinary(in));
+            }
+        } catch (const Exception & fail){
+            for (std::list<Section*>::iterator it = out->begin(); it != out->end(); it++){
+                delete *it;
+            }
+            delete out;
+            throw;
+        }
+        return out;
+    }
+
     static int lowerCase(int c){ return tolower(c); }
 
     static std::string downcase(std::string str){
@@ -150,6 +199,9 @@ public:
 protected:
 
     std::list<Section*> * sections;
+    /* false if the sections belong to another parse */
+    bool owner;
+    Util::ReferenceCount<Mugen::Arena> arena;
 };
 
 }
@@ -86,6 +86,17 @@ public:
         return new Filename(line, column, new std::string(out));
     }
 
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryFilename << getLine() << getColumn() << *str;
+    }
+
+    static Filename * readBinary(BinaryReader & in){
+        std::string out;
+        int line, column;
+        in >> line >> column >> out;
+        return new Filename(line, column, new std::string(out));
+    }
+
     using Element::operator==;
     virtual bool operator==(const Value & him) const {
         return him == *this;
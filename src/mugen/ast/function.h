@@ -66,6 +66,12 @@ public:
 
     static Function * deserialize(const Token * token);
 
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryFunction << name << getLine() << getColumn() << args;
+    }
+
+    static Function * readBinary(BinaryReader & in);
+
     static std::string downcase(std::string str){
         std::transform(str.begin(), str.end(), str.begin(), lowerCase);
         return str;
@@ -77,6 +77,19 @@ public:
         return new Helper(line, column, name, NULL, Value::deserialize(next));
     }
 
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryHelper << getLine() << getColumn() << name << original << expression;
+    }
+
+    static Helper * readBinary(BinaryReader & in){
+        std::string name;
+        int line, column;
+        in >> line >> column >> name;
+        Value * original = in.readValue();
+        Value * expression = in.readValue();
+        return new Helper(line, column, name, expression, original);
+    }
+
     using Element::operator==;
     bool operator==(const Value & him) const {
         return him == *this;
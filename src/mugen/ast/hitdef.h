@@ -71,6 +71,17 @@ public:
         token->view() >> line >> column >> value;
         return new HitDefAttribute(line, column, value);
     }
+
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryHitDefAttribute << getLine() << getColumn() << value;
+    }
+
+    static HitDefAttribute * readBinary(BinaryReader & in){
+        std::string value;
+        int line, column;
+        in >> line >> column >> value;
+        return new HitDefAttribute(line, column, value);
+    }
     
     virtual Element * copy() const {
         return new HitDefAttribute(getLine(), getColumn(), value);
@@ -170,6 +181,25 @@ public:
         return attribute;
     }
 
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryHitDefAttackAttribute << getLine() << getColumn() << (int) values.size();
+        for (std::vector<std::string>::const_iterator it = values.begin(); it != values.end(); it++){
+            out << *it;
+        }
+    }
+
+    static HitDefAttackAttribute * readBinary(BinaryReader & in){
+        int line, column, count;
+        in >> line >> column >> count;
+        HitDefAttackAttribute * attribute = new HitDefAttackAttribute(line, column);
+        for (int i = 0; i < count; i++){
+            std::string value;
+            in >> value;
+            attribute->addAttribute(value);
+        }
+        return attribute;
+    }
+
     using Element::operator==;
     virtual bool operator==(const Value & him) const {
         return him == *this;
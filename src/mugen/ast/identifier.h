@@ -100,6 +100,26 @@ public:
         return token;
     }
 
+    /* unlike serialize() this keeps the separate names */
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryIdentifier << getLine() << getColumn() << (int) names.size();
+        for (std::list<std::string>::const_iterator it = names.begin(); it != names.end(); it++){
+            out << *it;
+        }
+    }
+
+    static Identifier * readBinary(BinaryReader & in){
+        std::list<std::string> names;
+        int line, column, count;
+        in >> line >> column >> count;
+        for (int i = 0; i < count; i++){
+            std::string name;
+            in >> name;
+            names.push_back(name);
+        }
+        return new Identifier(line, column, names);
+    }
+
     virtual std::string toString() const {
         return stringed;
     }
@@ -105,6 +105,17 @@ public:
         return new KeySingle(line, column, what.c_str());
     }
 
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryKeySingle << getLine() << getColumn() << name;
+    }
+
+    static KeySingle * readBinary(BinaryReader & in){
+        std::string what;
+        int line, column;
+        in >> line >> column >> what;
+        return new KeySingle(line, column, what.c_str());
+    }
+
     virtual bool operator==(const Key & key) const {
         return key == *this;
     }
@@ -203,6 +214,18 @@ public:
         return new KeyModifier(line, column, ModifierType(type), (Key*) Value::deserialize(next), extra);
     }
 
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryKeyModifier << getLine() << getColumn() << (int) getModifierType() << getExtra() << getKey();
+    }
+
+    static KeyModifier * readBinary(BinaryReader & in){
+        int type = 0;
+        int extra = 0;
+        int line, column;
+        in >> line >> column >> type >> extra;
+        return new KeyModifier(line, column, ModifierType(type), (Key*) in.readValue(), extra);
+    }
+
     using Element::operator==;
     virtual bool operator==(const Key & key) const {
         return key == *this;
@@ -301,6 +324,18 @@ public:
                                (Key*) Value::deserialize(left),
                                (Key*) Value::deserialize(right));
     }
+
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryKeyCombined << getLine() << getColumn() << key1 << key2;
+    }
+
+    static KeyCombined * readBinary(BinaryReader & in){
+        int line, column;
+        in >> line >> column;
+        Key * left = (Key*) in.readValue();
+        Key * right = (Key*) in.readValue();
+        return new KeyCombined(line, column, left, right);
+    }
     
     virtual std::string toString() const {
         std::ostringstream out;
@@ -399,6 +434,23 @@ public:
         }
         return new KeyList(line, column, keys);
     }
+
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryKeyList << getLine() << getColumn() << (int) keys.size();
+        for (std::vector<Key*>::const_iterator it = keys.begin(); it != keys.end(); it++){
+            out << *it;
+        }
+    }
+
+    static KeyList * readBinary(BinaryReader & in){
+        std::vector<Key*> keys;
+        int line, column, count;
+        in >> line >> column >> count;
+        for (int i = 0; i < count; i++){
+            keys.push_back((Key*) in.readValue());
+        }
+        return new KeyList(line, column, keys);
+    }
     
     virtual std::string toString() const {
         std::ostringstream out;
@@ -84,6 +84,17 @@ public:
         return new Keyword(line, column, name);
     }
 
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryKeyword << getLine() << getColumn() << toString();
+    }
+
+    static Keyword * readBinary(BinaryReader & in){
+        std::string name;
+        int line, column;
+        in >> line >> column >> name;
+        return new Keyword(line, column, name);
+    }
+
     static std::string downcase(std::string str){
         std::transform(str.begin(), str.end(), str.begin(), lowerCase);
         return str;
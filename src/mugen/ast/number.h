@@ -107,6 +107,17 @@ public:
         *token << SERIAL_NUMBER << getLine() << getColumn() << value;
         return token;
     }
+
+    static Number * readBinary(BinaryReader & in){
+        double value;
+        int line, column;
+        in >> line >> column >> value;
+        return new Number(line, column, value);
+    }
+
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryNumber << getLine() << getColumn() << value;
+    }
     
         
     virtual std::string getType() const {
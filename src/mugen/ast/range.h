@@ -79,6 +79,19 @@ public:
         return new Range(line, column, RangeType(type), Value::deserialize(low), Value::deserialize(high));
     }
 
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryRange << getLine() << getColumn() << (int) getRangeType() << getLow() << getHigh();
+    }
+
+    static Range * readBinary(BinaryReader & in){
+        int type;
+        int line, column;
+        in >> line >> column >> type;
+        Value * low = in.readValue();
+        Value * high = in.readValue();
+        return new Range(line, column, RangeType(type), low, high);
+    }
+
     class RangeView: public ViewImplementation {
     public:
         RangeView(const Range * owner):
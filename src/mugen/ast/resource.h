@@ -93,6 +93,19 @@ public:
         return token;
     }
 
+    static Resource * readBinary(BinaryReader & in){
+        int line, column;
+        bool fightfx, own;
+        in >> line >> column;
+        Value * value = in.readValue();
+        in >> fightfx >> own;
+        return new Resource(line, column, value, fightfx, own);
+    }
+
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryResource << getLine() << getColumn() << value << fightfx << own;
+    }
+
     /* if it starts with 'f' */
     bool isFight() const {
         return fightfx;
@@ -74,6 +74,17 @@ public:
         token->view() >> line >> column >> out;
         return new String(line, column, new std::string(out));
     }
+
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryString << getLine() << getColumn() << *str;
+    }
+
+    static String * readBinary(BinaryReader & in){
+        std::string out;
+        int line, column;
+        in >> line >> column >> out;
+        return new String(line, column, new std::string(out));
+    }
     
     virtual std::string getType() const {
         return "string";
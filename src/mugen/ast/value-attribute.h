@@ -99,6 +99,17 @@ public:
         return token;
     }
 
+    static ValueAttribute * readBinary(BinaryReader & in){
+        int line, column;
+        in >> line >> column;
+        Attribute * attribute = in.readAttribute();
+        return new ValueAttribute(line, column, attribute);
+    }
+
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryValueAttribute << getLine() << getColumn() << attribute;
+    }
+
     virtual ~ValueAttribute(){
         delete attribute;
     }
@@ -64,6 +64,23 @@ public:
         return new ValueList(line, column, values);
     }
 
+    void writeBinary(BinaryWriter & out) const {
+        out << BinaryValueList << getLine() << getColumn() << (int) values.size();
+        for (std::list<Value*>::const_iterator it = values.begin(); it != values.end(); it++){
+            out << *it;
+        }
+    }
+
+    static ValueList * readBinary(BinaryReader & in){
+        std::list<Value*> values;
+        int line, column, count;
+        in >> line >> column >> count;
+        for (int i = 0; i < count; i++){
+            values.push_back(in.readValue());
+        }
+        return new ValueList(line, column, values);
+    }
+
     virtual Value * get(unsigned int index) const {
         if (index < values.size()){
             unsigned int count = 0;
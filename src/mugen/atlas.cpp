@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <r-tech1/graphics/bitmap.h>
+#include <r-tech1/timedifference.h>
+#include <r-tech1/pointer.h>
+#include <r-tech1/debug.h>
+#include "atlas.h"
+#include "sprite.h"
+
+#ifdef USE_ALLEGRO5
+#include <allegro5/allegro.h>
+#endif
+
+namespace PaintownUtil = ::Util;
+
+using namespace std;
+
+namespace Mugen{
+
+namespace Atlas{
+
+static bool enabled = false;
+
+void setEnabled(bool what){
+    enabled = what;
+}
+
+bool isEnabled(){
+    return enabled;
+}
+
+/* left empty around each image so filtering never picks up the pixels of
+ * the image next to it
+ */
+static const int padding = 1;
+
+/* an image and all the sprites that use it */
+struct Image{
+    PaintownUtil::ReferenceCount<Graphics::Bitmap> bitmap;
+    vector<PaintownUtil::ReferenceCount<Sprite> > sprites;
+};
+
+static bool tallerFirst(const Image * a, const Image * b){
+    if (a->bitmap->getHeight() != b->bitmap->getHeight()){
+        return a->bitmap->getHeight() > b->bitmap->getHeight();
+    }
+    return a->bitmap->getWidth() > b->bitmap->getWidth();
+}
+
+/* A row of images in a page. The images go in tallest first so every image
+ * put on a shelf fits under the first one.
+ */
+struct Shelf{
+    Shelf(unsigned int page, int y, int height):
+        page(page),
+        x(0),
+        y(y),
+        height(height){
+        }
+
+    unsigned int page;
+    int x, y;
+    int height;
+};
+
+int pack(const SpriteMap & sprites, int pageWidth, int pageHeight){
+    /* keyed by the bitmap so linked sprites are only packed once */
+    map<Graphics::Bitmap*, Image> images;
+    for (SpriteMap::const_iterator group = sprites.begin(); group != sprites.end(); group++){
+        for (GroupMap::const_iterator item = group->second.begin(); item != group->second.end(); item++){
+            PaintownUtil::ReferenceCount<Sprite> sprite = item->second;
+            if (sprite == NULL){
+                continue;
+            }
+            PaintownUtil::ReferenceCount<Graphics::Bitmap> bitmap = sprite->getBitmap(true);
+            if (bitmap == NULL ||
+                bitmap->getWidth() + padding > pageWidth ||
+                bitmap->getHeight() + padding > pageHeight){
+                continue;
+            }
+            Image & image = images[bitmap.raw()];
+            image.bitmap = bitmap;
+            image.sprites.push_back(sprite);
+        }
+    }
+
+    vector<Image*> order;
+    for (map<Graphics::Bitmap*, Image>::iterator it = images.begin(); it != images.end(); it++){
+        order.push_back(&it->second);
+    }
+    sort(order.begin(), order.end(), tallerFirst);
+
+    vector<PaintownUtil::ReferenceCount<Graphics::Bitmap> > pages;
+    /* the top of the unused part of each page */
+    vector<int> bottoms;
+    vector<Shelf> shelves;
+
+    for (vector<Image*>::iterator it = order.begin(); it != order.end(); it++){
+        Image & image = **it;
+        int width = image.bitmap->getWidth() + padding;
+        int height = image.bitmap->getHeight() + padding;
+
+        Shelf * use = NULL;
+        for (vector<Shelf>::iterator shelf = shelves.begin(); shelf != shelves.end(); shelf++){
+            if (shelf->x + width <= pageWidth && height <= shelf->height){
+                use = &*shelf;
+                break;
+            }
+        }
+
+        if (use == NULL){
+            unsigned int page = 0;
+            while (page < pages.size() && bottoms[page] + height > pageHeight){
+                page += 1;
+            }
+            if (page == pages.size()){
+                PaintownUtil::ReferenceCount<Graphics::Bitmap> fresh(new Graphics::Bitmap(pageWidth, pageHeight));
+                fresh->fill(Graphics::MaskColor());
+                pages.push_back(fresh);
+                bottoms.push_back(0);
+            }
+            shelves.push_back(Shelf(page, bottoms[page], height));
+            bottoms[page] += height;
+            use = &shelves.back();
+        }
+
+        const PaintownUtil::ReferenceCount<Graphics::Bitmap> & page = pages[use->page];
+        image.bitmap->Blit(use->x, use->y, *page);
+        for (vector<PaintownUtil::ReferenceCount<Sprite> >::iterator sprite = image.sprites.begin(); sprite != image.sprites.end(); sprite++){
+            (*sprite)->setAtlasImage(page, use->x, use->y);
+        }
+        use->x += width;
+    }
+
+    return pages.size();
+}
+
+/* how many batches are alive */
+static int batches = 0;
+static bool holding = false;
+/* what the held draws go to */
+static const Graphics::Bitmap * heldTarget = NULL;
+
+Batch::Batch(){
+    batches += 1;
+}
+
+Batch::~Batch(){
+    batches -= 1;
+    if (batches == 0){
+        flush();
+    }
+}
+
+void Batch::draw(const void * page, bool plain, const Graphics::Bitmap & where){
+    bool hold = batches > 0 && plain && page != NULL;
+    if (holding && (!hold || &where != heldTarget)){
+        flush();
+    }
+
+    /* allegro5 keeps holding across pages, it sends the held draws itself
+     * when the page changes
+     */
+    if (hold && !holding){
+#ifdef USE_ALLEGRO5
+        al_hold_bitmap_drawing(true);
+#endif
+        holding = true;
+        heldTarget = &where;
+    }
+}
+
+void Batch::flush(){
+    if (holding){
+#ifdef USE_ALLEGRO5
+        al_hold_bitmap_drawing(false);
+#endif
+        holding = false;
+        heldTarget = NULL;
+    }
+}
+
+}
+
+/* how many frames go into each line of the log */
+static const int reportFrames = 300;
+
+static int draws = 0;
+static int batches = 0;
+static const void * lastSource = NULL;
+static TransType lastTrans = None;
+static TimeDifference frameTimer;
+
+static int lastDraws = 0;
+static int lastBatches = 0;
+static double lastFrameTime = 0;
+
+static int frames = 0;
+static int totalDraws = 0;
+static int totalBatches = 0;
+static double totalTime = 0;
+
+void DrawReport::beginFrame(){
+    draws = 0;
+    batches = 0;
+    lastSource = NULL;
+    frameTimer.startTime();
+}
+
+void DrawReport::draw(const void * source, TransType trans){
+    if (draws == 0 || source != lastSource || trans != lastTrans){
+        batches += 1;
+        lastSource = source;
+        lastTrans = trans;
+    }
+    draws += 1;
+}
+
+void DrawReport::endFrame(){
+    frameTimer.endTime();
+    lastDraws = draws;
+    lastBatches = batches;
+    lastFrameTime = frameTimer.getTime();
+
+    frames += 1;
+    totalDraws += draws;
+    totalBatches += batches;
+    totalTime += lastFrameTime;
+    if (frames == reportFrames){
+        Global::debug(1, "draw") << "Average of " << frames << " frames: " << (double) totalDraws / frames << " sprite draws in " << (double) totalBatches / frames << " batches, " << totalTime / frames / 1000 << "ms a frame" << endl;
+        frames = 0;
+        totalDraws = 0;
+        totalBatches = 0;
+        totalTime = 0;
+    }
+}
+
+int DrawReport::getDraws(){
+    return lastDraws;
+}
+
+int DrawReport::getBatches(){
+    return lastBatches;
+}
+
+double DrawReport::getFrameTime(){
+    return lastFrameTime;
+}
+
+}
@@ -0,0 +1,79 @@
+#ifndef _paintown_mugen_atlas_h
+#define _paintown_mugen_atlas_h
+
+#include "common.h"
+#include "util.h"
+
+namespace Mugen{
+
+/* Packs the images of a sprite map into a few big page bitmaps. Each sprite
+ * then draws from a sub-rectangle of a page instead of from its own bitmap,
+ * so the frames of a character and its helpers come out of a handful of
+ * textures. Draws from the same page are only sent to the gpu together
+ * inside a Batch.
+ */
+namespace Atlas{
+    /* Off unless the "atlas" option is set, see Data::setAtlas. It has not
+     * been measured to be faster yet. Packing decodes every sprite at load
+     * instead of when it is first drawn, and with the software renderers a
+     * blit costs the same either way.
+     */
+    void setEnabled(bool enabled);
+    bool isEnabled();
+
+    /* Packs the masked image of every sprite that fits in a page. Linked
+     * sprites that share an image only take up space once. Returns the
+     * number of pages made.
+     */
+    int pack(const SpriteMap & sprites, int pageWidth = 1024, int pageHeight = 1024);
+
+    /* While a Batch is alive, plain sprite draws from atlas pages are held
+     * with al_hold_bitmap_drawing and allegro5 sends each run of them from
+     * the same page as one draw. A plain draw has no blending, palette
+     * filter, rotation or scaling. Any other sprite draw sends the held ones
+     * first, and so does the end of the batch.
+     *
+     * Nothing but bitmaps can be drawn while drawing is held, so call
+     * flush() before drawing anything that is not a sprite inside a batch.
+     * Only does anything with allegro5.
+     */
+    class Batch{
+    public:
+        Batch();
+        ~Batch();
+
+        /* called by a sprite before it draws. page is the atlas page the
+         * sprite is in, or NULL.
+         */
+        static void draw(const void * page, bool plain, const Graphics::Bitmap & where);
+
+        /* send the held draws now */
+        static void flush();
+    };
+}
+
+/* Counts the sprite draws in a frame and the batches they fall into, where a
+ * batch is a run of draws from the same page with the same blend mode. Draw
+ * order can't change without changing what is on the screen, so that is the
+ * fewest batches the frame can be drawn in. The averages and the time taken
+ * to draw a frame are logged at debug level 1 every few seconds.
+ */
+class DrawReport{
+public:
+    static void beginFrame();
+
+    /* source is the atlas page, or the bitmap itself if it isn't in one */
+    static void draw(const void * source, TransType trans);
+
+    static void endFrame();
+
+    /* for the last frame that ended */
+    static int getDraws();
+    static int getBatches();
+    /* in microseconds */
+    static double getFrameTime();
+};
+
+}
+
+#endif
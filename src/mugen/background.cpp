@@ -9,6 +9,7 @@
 #include "globals.h"
 #include <r-tech1/debug.h>
 #include "sprite.h"
+#include "atlas.h"
 #include <r-tech1/regex.h>
 #include <r-tech1/file-system.h>
 #include <r-tech1/timedifference.h>
@@ -516,32 +517,77 @@ public:
     vector<Point>::iterator current_point;
 };
 
-void NormalElement::render(int cameraX, int cameraY, const Graphics::Bitmap &bmp, Graphics::Bitmap::Filter * filter){
-    if (!getVisible()){
-        return;
+bool NormalElement::isStatic() const {
+    if (sprite == NULL){
+        return false;
     }
-    const int addw = sprite->getWidth() + getTileSpacing().x;
-    const int addh = sprite->getHeight() + getTileSpacing().y;
-    const int currentX = (int)(bmp.getWidth()/2 + getCurrentX() - cameraX + cameraX * (1 - getDeltaX()));
-    const int currentY = (int)(getCurrentY() - cameraY + cameraY * (1 - getDeltaY()));
+
+    if (getVelocityX() != 0 || getVelocityY() != 0){
+        return false;
+    }
+
+    if ((getSinX().amp != 0 && getSinX().period != 0) ||
+        (getSinY().amp != 0 && getSinY().period != 0)){
+        return false;
+    }
+
+    /* a tile of 1 repeats forever */
+    return getTrans() == None && getTile().x != 1 && getTile().y != 1;
+}
+
+int NormalElement::getScreenX(int cameraX, const Graphics::Bitmap & work) const {
+    return (int)(work.getWidth()/2 + getCurrentX() - cameraX + cameraX * (1 - getDeltaX()));
+}
+
+int NormalElement::getScreenY(int cameraY, const Graphics::Bitmap & work) const {
+    return (int)(getCurrentY() - cameraY + cameraY * (1 - getDeltaY()));
+}
+
+void NormalElement::clip(int cameraX, int cameraY, const Graphics::Bitmap & work) const {
     const int windowAddX = (int) (getWindowDeltaX() * cameraX);
     const int windowAddY = (int) (getWindowDeltaY() * cameraY);
+    work.setClipRect(getWindow().x + windowAddX, getWindow().y + windowAddY, getWindow().getX2() + windowAddX, getWindow().getY2() + windowAddY);
+}
 
-    // const int currentX = (bmp.getWidth()/2) + int((getStart().x + cameraX + getVelocityX() + getSinX().get()) * getDeltaX());
-    // const int currentY =  int((getStart().y + y + getVelocityY() + getSinY().get()) * getDeltaY());
-    // const int currentY = (int) (getStart().y - cameraY);
-    
-    // Set the clipping window
-    bmp.setClipRect( getWindow().x + windowAddX, getWindow().y + windowAddY, getWindow().getX2() + windowAddX, getWindow().getY2() + windowAddY );
+void NormalElement::getArea(int & x1, int & y1, int & x2, int & y2) const {
+    const int addw = sprite->getWidth() + getTileSpacing().x;
+    const int addh = sprite->getHeight() + getTileSpacing().y;
+    const int xTiles = getTile().x <= 0 ? 1 : getTile().x;
+    const int yTiles = getTile().y <= 0 ? 1 : getTile().y;
+
+    /* the last tile can be to the left of the first if the spacing is negative enough */
+    x1 = -sprite->getX() + std::min(0, (xTiles - 1) * addw);
+    y1 = -sprite->getY() + std::min(0, (yTiles - 1) * addh);
+    x2 = -sprite->getX() + std::max(0, (xTiles - 1) * addw) + sprite->getWidth();
+    y2 = -sprite->getY() + std::max(0, (yTiles - 1) * addh) + sprite->getHeight();
+}
 
-    Tiler tiler(getTile(), currentX, currentY, addw, addh, sprite->getX(), sprite->getY(), sprite->getWidth(), sprite->getHeight(), bmp.getWidth(), bmp.getHeight());
+void NormalElement::draw(int x, int y, const Graphics::Bitmap & work, Graphics::Bitmap::Filter * filter){
+    const int addw = sprite->getWidth() + getTileSpacing().x;
+    const int addh = sprite->getHeight() + getTileSpacing().y;
+    Tiler tiler(getTile(), x, y, addw, addh, sprite->getX(), sprite->getY(), sprite->getWidth(), sprite->getHeight(), work.getWidth(), work.getHeight());
 
     Effects effects = getEffects();
     effects.filter = filter;
     while (tiler.hasMore()){
         Point where = tiler.nextPoint();
-        sprite->render(where.x, where.y, bmp, effects);
+        sprite->render(where.x, where.y, work, effects);
     }
+}
+
+void NormalElement::render(int cameraX, int cameraY, const Graphics::Bitmap &bmp, Graphics::Bitmap::Filter * filter){
+    if (!getVisible()){
+        return;
+    }
+
+    // const int currentX = (bmp.getWidth()/2) + int((getStart().x + cameraX + getVelocityX() + getSinX().get()) * getDeltaX());
+    // const int currentY =  int((getStart().y + y + getVelocityY() + getSinY().get()) * getDeltaY());
+    // const int currentY = (int) (getStart().y - cameraY);
+    
+    // Set the clipping window
+    clip(cameraX, cameraY, bmp);
+
+    draw(getScreenX(cameraX, bmp), getScreenY(cameraY, bmp), bmp, filter);
 
 #if 0
     /* Render initial sprite */
@@ -732,13 +778,23 @@ void AnimationElement::render(int cameraX, int cameraY, const Graphics::Bitmap &
     bmp.setClipRect(0, 0,bmp.getWidth(),bmp.getHeight());
 }
 
+/* With allegro5 a stretched blit of each row is done by the gpu, and locking
+ * a video bitmap to draw into it costs more than that.
+ */
+#ifdef USE_ALLEGRO5
+static const bool defaultRasterRows = false;
+#else
+static const bool defaultRasterRows = true;
+#endif
+
 ParallaxElement::ParallaxElement(const string & name, Ast::Section * data, const Mugen::SpriteMap & sprites):
 BackgroundElement(name, data),
 sprite(0),
 xscaleX(0),
 xscaleY(0),
 yscale(100),
-yscaleDelta(0){
+yscaleDelta(0),
+rasterRows(defaultRasterRows){
 
     class Walker: public Ast::Walker{
     public:
@@ -806,7 +862,10 @@ void ParallaxElement::act(){
     getSinY().act();
 }
 
-static void doParallaxXScale(PaintownUtil::ReferenceCount<Mugen::Sprite> bmp, const Graphics::Bitmap & work, int cameraX, int cameraY, int offsetX, int offsetY, int extraX, int extraY, double xscale_top, double xscale_bottom, int centerX, int centerY, double deltaX, double deltaY, double yscaleDelta, const Mugen::Effects & effects){
+/* Rows are drawn from the raster when there is one, and with
+ * Sprite::drawPartStretched otherwise. Both draw the same pixels.
+ */
+static void doParallaxXScale(PaintownUtil::ReferenceCount<Mugen::Sprite> bmp, const ParallaxRaster * raster, const Graphics::Bitmap & work, int cameraX, int cameraY, int offsetX, int offsetY, int extraX, int extraY, double xscale_top, double xscale_bottom, int centerX, int centerY, double deltaX, double deltaY, double yscaleDelta, const Mugen::Effects & effects){
     const int height = bmp->getHeight();
     const int width = bmp->getWidth();
 
@@ -839,7 +898,12 @@ static void doParallaxXScale(PaintownUtil::ReferenceCount<Mugen::Sprite> bmp, co
         /* FIXME: sprig has an off-by-1 error so the height can't be 1 here.
          * try to fix this someday!
          */
-        bmp->drawPartStretched(0, liney, width, 2, movex, movey, width, 2 - cameraY * liney * yscaleDelta / 100, effects, work);
+        int rows = (int)(2 - cameraY * liney * yscaleDelta / 100);
+        if (raster != NULL){
+            raster->drawRows(liney, 2, movex, movey, width, rows, effects.mask, work);
+        } else {
+            bmp->drawPartStretched(0, liney, width, 2, movex, movey, width, rows, effects, work);
+        }
         /*
         Graphics::Bitmap single(bmp, 0, liney, width, 2);
         // single.drawStretched(movex, movey, width, 1 - cameraY * (liney + 1) * yscaleDelta, work);
@@ -854,7 +918,7 @@ static void doParallaxXScale(PaintownUtil::ReferenceCount<Mugen::Sprite> bmp, co
 
 }
 
-static void doParallax(PaintownUtil::ReferenceCount<Mugen::Sprite> bmp, const Graphics::Bitmap & work, int cameraX, int cameraY, int offsetX, int offsetY, int extraX, int extraY, double xscale_top, double xscale_bottom, int centerX, int centerY, double deltaX, double deltaY, const Mugen::Effects & effects){
+static void doParallax(PaintownUtil::ReferenceCount<Mugen::Sprite> bmp, const ParallaxRaster * raster, const Graphics::Bitmap & work, int cameraX, int cameraY, int offsetX, int offsetY, int extraX, int extraY, double xscale_top, double xscale_bottom, int centerX, int centerY, double deltaX, double deltaY, const Mugen::Effects & effects){
     const int height = bmp->getHeight();
     const int width = bmp->getWidth();
 
@@ -951,7 +1015,11 @@ static void doParallax(PaintownUtil::ReferenceCount<Mugen::Sprite> bmp, const Gr
         int destWidth = x2 - x1;
         int destHeight = 1;
 
-        bmp->drawPartStretched(0, liney, width, 1, x1, y + liney, x2 - x1, 1, effects, work);
+        if (raster != NULL){
+            raster->drawRows(liney, 1, destX, destY, destWidth, 1, effects.mask, work);
+        } else {
+            bmp->drawPartStretched(0, liney, width, 1, x1, y + liney, x2 - x1, 1, effects, work);
+        }
 
         /*
         Graphics::Bitmap single(bmp, 0, liney, width, 1);
@@ -1027,20 +1095,45 @@ void ParallaxElement::render(int cameraX, int cameraY, const Graphics::Bitmap &
     /* mugen doesn't actually tile in the y direction for parallax */
     tile.y = 0;
 
+    /* The rows are drawn by a ParallaxRaster unless the sprite is scaled,
+     * which only drawPartStretched knows how to do.
+     */
+    ParallaxRaster * useRaster = NULL;
+    if (rasterRows && fabs(effects.scalex - 1) < 0.00001 && fabs(effects.scaley - 1) < 0.00001){
+        if (raster == NULL){
+            PaintownUtil::ReferenceCount<Graphics::Bitmap> bitmap = sprite->getBitmap(getMask());
+            if (bitmap != NULL){
+                raster = PaintownUtil::ReferenceCount<ParallaxRaster>(new ParallaxRaster(*bitmap));
+            }
+        }
+        useRaster = raster.raw();
+        if (useRaster != NULL){
+            useRaster->setClip(max(0, getWindow().x + windowAddX), max(0, getWindow().y + windowAddY),
+                               min(work.getWidth(), getWindow().getX2() + windowAddX), min(work.getHeight(), getWindow().getY2() + windowAddY));
+            /* held sprites have to be drawn before the pixels under them */
+            Atlas::Batch::flush();
+            work.lock();
+        }
+    }
+
     if (xscaleX || xscaleY){
         Tiler tiler(tile, currentX, currentY, addw, addh, sprite->getX(), sprite->getY(), sprite->getWidth(), sprite->getHeight(), work.getWidth(), work.getHeight());
         while (tiler.hasMore()){
             Point where = tiler.nextPoint();
-            doParallaxXScale(sprite, work, cameraX, cameraY, where.x, where.y, sprite->getX(), sprite->getY(), xscaleX, xscaleY, work.getWidth()/2, 0, getDeltaX(), getDeltaY(), getYScaleDelta(), effects);
+            doParallaxXScale(sprite, useRaster, work, cameraX, cameraY, where.x, where.y, sprite->getX(), sprite->getY(), xscaleX, xscaleY, work.getWidth()/2, 0, getDeltaX(), getDeltaY(), getYScaleDelta(), effects);
         }
     } else {
         Tiler tiler(tile, currentX, currentY, width.x, addh, sprite->getX(), sprite->getY(), sprite->getWidth(), sprite->getHeight(), work.getWidth(), work.getHeight());
         while (tiler.hasMore()){
             Point where = tiler.nextPoint();
-            doParallax(sprite, work, cameraX, cameraY, where.x, where.y, sprite->getX(), sprite->getY(), (double) width.x / sprite->getWidth(), (double) width.y / sprite->getWidth(), work.getWidth()/2, 0, getDeltaX(), getDeltaY(), effects);
+            doParallax(sprite, useRaster, work, cameraX, cameraY, where.x, where.y, sprite->getX(), sprite->getY(), (double) width.x / sprite->getWidth(), (double) width.y / sprite->getWidth(), work.getWidth()/2, 0, getDeltaX(), getDeltaY(), effects);
         }
     }
 
+    if (useRaster != NULL){
+        work.unlock();
+    }
+
     /*
     Tiler tiler(tile, currentX, currentY, addw, addh, sprite->getX(), sprite->getY(), sprite->getWidth(), sprite->getHeight(), work.getWidth(), work.getHeight());
 
@@ -1717,11 +1810,163 @@ void BackgroundController::act(){
     }
 }
 
+/* Bigger than this and the bitmap takes more memory than it saves time */
+static const int MAX_LAYER_PIXELS = 2048 * 1024;
+
+StaticLayer::StaticLayer(unsigned int first, const vector<NormalElement *> & elements):
+first(first),
+elements(elements),
+built(false),
+direct(false),
+left(0),
+top(0){
+}
+
+StaticLayer::~StaticLayer(){
+}
+
+/* A controller can give an element a velocity or a sin at any time */
+bool StaticLayer::isStatic() const {
+    for (vector<NormalElement *>::const_iterator it = elements.begin(); it != elements.end(); it++){
+        if (!(*it)->isStatic()){
+            return false;
+        }
+    }
+    return true;
+}
+
+vector<StaticLayer::Position> StaticLayer::getPositions() const {
+    vector<Position> positions;
+    for (vector<NormalElement *>::const_iterator it = elements.begin(); it != elements.end(); it++){
+        NormalElement * element = *it;
+        positions.push_back(Position(element->getVisible(), (int) element->getCurrentX(), (int) element->getCurrentY()));
+    }
+    return positions;
+}
+
+void StaticLayer::build(const vector<Position> & positions){
+    built = true;
+    drawn = positions;
+    direct = false;
+    cache = NULL;
+
+    bool any = false;
+    int right = 0;
+    int bottom = 0;
+    for (unsigned int i = 0; i < elements.size(); i++){
+        if (!positions[i].visible){
+            continue;
+        }
+
+        int x1, y1, x2, y2;
+        elements[i]->getArea(x1, y1, x2, y2);
+        x1 += positions[i].x;
+        y1 += positions[i].y;
+        x2 += positions[i].x;
+        y2 += positions[i].y;
+        if (!any){
+            left = x1;
+            top = y1;
+            right = x2;
+            bottom = y2;
+            any = true;
+        } else {
+            left = std::min(left, x1);
+            top = std::min(top, y1);
+            right = std::max(right, x2);
+            bottom = std::max(bottom, y2);
+        }
+    }
+
+    /* nothing to draw */
+    if (!any){
+        return;
+    }
+
+    if ((double) (right - left) * (bottom - top) > MAX_LAYER_PIXELS){
+        direct = true;
+        return;
+    }
+
+    cache = PaintownUtil::ReferenceCount<Graphics::Bitmap>(new Graphics::Bitmap(right - left, bottom - top));
+    cache->clearToMask();
+    for (unsigned int i = 0; i < elements.size(); i++){
+        if (positions[i].visible){
+            elements[i]->draw(positions[i].x - left, positions[i].y - top, *cache);
+        }
+    }
+}
+
+void StaticLayer::renderElements(int cameraX, int cameraY, const Graphics::Bitmap & work, Graphics::Bitmap::Filter * filter){
+    for (vector<NormalElement *>::iterator it = elements.begin(); it != elements.end(); it++){
+        (*it)->render(cameraX, cameraY, work, filter);
+    }
+}
+
+void StaticLayer::render(int cameraX, int cameraY, const Graphics::Bitmap & work, Graphics::Bitmap::Filter * filter){
+    /* the filter changes from frame to frame */
+    if (filter != NULL || !isStatic()){
+        renderElements(cameraX, cameraY, work, filter);
+        return;
+    }
+
+    vector<Position> positions = getPositions();
+    if (!built || !(positions == drawn)){
+        /* Something is moving the elements around, wait until it stops
+         * before drawing the bitmap again.
+         */
+        if (built && !(positions == moved)){
+            moved = positions;
+            renderElements(cameraX, cameraY, work, filter);
+            return;
+        }
+        build(positions);
+    }
+
+    if (direct){
+        renderElements(cameraX, cameraY, work, filter);
+        return;
+    }
+
+    if (cache == NULL){
+        return;
+    }
+
+    /* The elements get to the screen by truncating a double, which can round
+     * one of them differently from the others when they are partly off the
+     * left or the top. Only blit the bitmap when all of them moved the same.
+     */
+    int moveX = 0;
+    int moveY = 0;
+    bool any = false;
+    for (unsigned int i = 0; i < elements.size(); i++){
+        if (!positions[i].visible){
+            continue;
+        }
+
+        int x = elements[i]->getScreenX(cameraX, work) - positions[i].x;
+        int y = elements[i]->getScreenY(cameraY, work) - positions[i].y;
+        if (!any){
+            moveX = x;
+            moveY = y;
+            any = true;
+        } else if (x != moveX || y != moveY){
+            renderElements(cameraX, cameraY, work, filter);
+            return;
+        }
+    }
+
+    elements.front()->clip(cameraX, cameraY, work);
+    cache->draw(moveX + left, moveY + top, work);
+    work.setClipRect(0, 0, work.getWidth(), work.getHeight());
+}
+
 Background::Background(const Filesystem::AbsolutePath &file, const std::string &header):
 file(file),
 header(header),
 debug(false),
-clearColor(Graphics::MaskColor()){
+clearColor(Graphics::MaskColor()),
+staticLayers(true){
     TimeDifference diff;
     diff.startTime();
     AstRef parsed(Mugen::Util::parseDef(file));
@@ -1928,12 +2173,15 @@ clearColor(Graphics::MaskColor()){
         out << "Error while parsing " << file.path() << " " << fail.getFullReason();
         throw MugenException(out.str(), __FILE__, __LINE__);
     }
+
+    findStaticLayers();
 }
 
 Background::Background(const AstRef & parsed, const string & header, const Mugen::SpriteMap & sprites):
 header(header),
 debug(false),
-clearColor(Graphics::MaskColor()){
+clearColor(Graphics::MaskColor()),
+staticLayers(true){
     // for linked position in backgrounds
     BackgroundElement * priorElement = NULL;
     /* use the sprites that are passed in unless the background has a def
@@ -2083,6 +2331,8 @@ clearColor(Graphics::MaskColor()){
         out << "Error while parsing " << file.path() << " " << fail.getFullReason();
         throw MugenException(out.str(), __FILE__, __LINE__);
     }
+
+    findStaticLayers();
 }
 
 Background::~Background(){
@@ -2122,6 +2372,67 @@ Background::~Background(){
             delete controller;
         }
     }
+    for (vector<StaticLayer *>::iterator it = backgroundLayers.begin(); it != backgroundLayers.end(); it++){
+        delete *it;
+    }
+
+    for (vector<StaticLayer *>::iterator it = foregroundLayers.begin(); it != foregroundLayers.end(); it++){
+        delete *it;
+    }
+}
+
+/* Elements can share a layer if they are static and would be drawn the same
+ * way with the camera anywhere.
+ */
+static bool sameLayer(const NormalElement * a, const NormalElement * b){
+    return a->getDeltaX() == b->getDeltaX() &&
+           a->getDeltaY() == b->getDeltaY() &&
+           a->getWindow().x == b->getWindow().x &&
+           a->getWindow().y == b->getWindow().y &&
+           a->getWindow().getX2() == b->getWindow().getX2() &&
+           a->getWindow().getY2() == b->getWindow().getY2() &&
+           a->getWindowDeltaX() == b->getWindowDeltaX() &&
+           a->getWindowDeltaY() == b->getWindowDeltaY();
+}
+
+static int countTiles(const NormalElement * element){
+    return (element->getTile().x <= 0 ? 1 : element->getTile().x) *
+           (element->getTile().y <= 0 ? 1 : element->getTile().y);
+}
+
+static vector<StaticLayer *> findLayers(const vector<BackgroundElement *> & elements){
+    vector<StaticLayer *> layers;
+    unsigned int start = 0;
+    while (start < elements.size()){
+        vector<NormalElement *> run;
+        int tiles = 0;
+        unsigned int next = start;
+        while (next < elements.size()){
+            NormalElement * element = dynamic_cast<NormalElement *>(elements[next]);
+            if (element == NULL || !element->isStatic() ||
+                (!run.empty() && !sameLayer(run.front(), element))){
+                break;
+            }
+            run.push_back(element);
+            tiles += countTiles(element);
+            next += 1;
+        }
+
+        /* a single sprite is already a single blit */
+        if (tiles > 1){
+            layers.push_back(new StaticLayer(start, run));
+        }
+
+        start = run.empty() ? next + 1 : next;
+    }
+    return layers;
+}
+
+void Background::findStaticLayers(){
+#ifndef USE_ALLEGRO5
+    backgroundLayers = findLayers(backgrounds);
+    foregroundLayers = findLayers(foregrounds);
+#endif
 }
 void Background::act(){
     // Backgrounds
@@ -2142,6 +2453,38 @@ void Background::act(){
     }
 }
 
+/* Draws the elements in order, a static layer in place of the elements it covers */
+static void renderElements(const vector<BackgroundElement *> & elements, const vector<StaticLayer *> & layers, int x, int y, const Graphics::Bitmap & bmp, Graphics::Bitmap::Filter * filter){
+    vector<StaticLayer *>::const_iterator layer = layers.begin();
+    unsigned int index = 0;
+    while (index < elements.size()){
+        if (layer != layers.end() && (*layer)->getFirst() == index){
+            (*layer)->render(x, y, bmp, filter);
+            index += (*layer)->size();
+            layer++;
+        } else {
+            elements[index]->render(x, y, bmp, filter);
+            index += 1;
+        }
+    }
+}
+
+void Background::setStaticLayers(bool enabled){
+    staticLayers = enabled;
+}
+
+void Background::setParallaxRaster(bool enabled){
+    for (int i = 0; i < 2; i++){
+        const vector<BackgroundElement*> & elements = i == 0 ? backgrounds : foregrounds;
+        for (vector<BackgroundElement*>::const_iterator it = elements.begin(); it != elements.end(); it++){
+            ParallaxElement * parallax = dynamic_cast<ParallaxElement*>(*it);
+            if (parallax != NULL){
+                parallax->setRasterRows(enabled);
+            }
+        }
+    }
+}
+
 void Background::renderBackground(int x, int y, const Graphics::Bitmap &bmp, Graphics::Bitmap::Filter * filter){
     if (clearColor != Graphics::MaskColor()){
 	bmp.fill(clearColor);
@@ -2151,17 +2494,11 @@ void Background::renderBackground(int x, int y, const Graphics::Bitmap &bmp, Gra
 	bmp.fill(Graphics::MaskColor());
     }
 
-    for( vector< BackgroundElement *>::iterator i = backgrounds.begin(); i != backgrounds.end(); ++i ){
-	BackgroundElement *element = *i;
-	element->render(x, y, bmp, filter);
-    }
+    renderElements(backgrounds, staticLayers ? backgroundLayers : vector<StaticLayer *>(), x, y, bmp, filter);
 }
 
 void Background::renderForeground(int x, int y, const Graphics::Bitmap &bmp, Graphics::Bitmap::Filter * filter){
-    for( vector< BackgroundElement *>::iterator i = foregrounds.begin(); i != foregrounds.end(); ++i ){
-	BackgroundElement *element = *i;
-	element->render(x, y, bmp, filter);
-    }
+    renderElements(foregrounds, staticLayers ? foregroundLayers : vector<StaticLayer *>(), x, y, bmp, filter);
 }
 
 //! Returns a vector of Elements by given ID usefull for when assigning elements to a background controller
@@ -7,6 +7,7 @@
 #include <math.h>
 #include "animation.h"
 #include "sprite.h"
+#include "parallax.h"
 #include "util.h"
 #include "ast/all.h"
 #include <r-tech1/graphics/bitmap.h>
@@ -263,6 +264,24 @@ class NormalElement : public BackgroundElement {
 	virtual inline void setSprite(PaintownUtil::ReferenceCount<Mugen::Sprite> sprite){
 	    this->sprite = sprite;
 	}
+
+        /* True if only a controller can move it, so no velocity, no sin, no
+         * translucency and a set number of tiles.
+         */
+        virtual bool isStatic() const;
+
+        /* Where the start ends up on the work bitmap */
+        virtual int getScreenX(int cameraX, const Graphics::Bitmap & work) const;
+        virtual int getScreenY(int cameraY, const Graphics::Bitmap & work) const;
+
+        //! Set the clip of the work bitmap to the window
+        virtual void clip(int cameraX, int cameraY, const Graphics::Bitmap & work) const;
+
+        //! Draws all the tiles with the start at x, y. Clipping is left alone.
+        virtual void draw(int x, int y, const Graphics::Bitmap & work, Graphics::Bitmap::Filter * filter = NULL);
+
+        /* The box the tiles of a static element cover, relative to its start */
+        virtual void getArea(int & x1, int & y1, int & x2, int & y2) const;
     private:
 	//! Sprite Based
 	PaintownUtil::ReferenceCount<Mugen::Sprite> sprite;
@@ -290,6 +309,7 @@ class ParallaxElement : public BackgroundElement {
 	virtual void render(int x, int y, const Graphics::Bitmap &, Graphics::Bitmap::Filter * filter = NULL);
 	virtual inline void setSprite(PaintownUtil::ReferenceCount<Mugen::Sprite> sprite){
 	    this->sprite = sprite;
+            this->raster = NULL;
 	}
 	virtual inline void setXScale(double x, double y){
 	    this->xscaleX = x;
@@ -312,6 +332,13 @@ class ParallaxElement : public BackgroundElement {
         virtual inline double getYScaleDelta() const {
             return this->yscaleDelta;
         }
+
+        /* draw the rows with a ParallaxRaster instead of drawPartStretched.
+         * on by default except with allegro5.
+         */
+        virtual inline void setRasterRows(bool enabled){
+            this->rasterRows = enabled;
+        }
     private:
 	//! Sprite Based
 	PaintownUtil::ReferenceCount<Mugen::Sprite> sprite;
@@ -324,6 +351,9 @@ class ParallaxElement : public BackgroundElement {
 	double yscale;
 	//! Delta for yscale per unit in percent (defaults to 0)
 	double yscaleDelta;
+        /* pixels of the sprite for drawing the rows, made on the first render */
+        PaintownUtil::ReferenceCount<ParallaxRaster> raster;
+        bool rasterRows;
 };
 
 /*! Dummy Element - Not an interactive element, it used mostly as support in Position Link chains */
@@ -410,6 +440,64 @@ class BackgroundController{
 	std::vector < Controller *> controllers;
 };
 
+/*! A run of neighbouring normal elements that are static and scroll with the
+ * same delta and window. They are drawn once into a bitmap so the whole run
+ * costs one blit a frame. Controllers can still show, hide or move them, the
+ * bitmap is drawn again once the elements have settled somewhere new and
+ * until then they are drawn one by one.
+ */
+class StaticLayer{
+public:
+    StaticLayer(unsigned int first, const std::vector<NormalElement *> & elements);
+    virtual ~StaticLayer();
+
+    //! Index of the first element in the background or foreground list
+    inline unsigned int getFirst() const {
+        return first;
+    }
+
+    inline unsigned int size() const {
+        return elements.size();
+    }
+
+    virtual void render(int cameraX, int cameraY, const Graphics::Bitmap & work, Graphics::Bitmap::Filter * filter);
+
+protected:
+    struct Position{
+        Position(bool visible, int x, int y):
+        visible(visible), x(x), y(y){
+        }
+
+        bool operator==(const Position & him) const {
+            return visible == him.visible && x == him.x && y == him.y;
+        }
+
+        bool visible;
+        int x;
+        int y;
+    };
+
+    bool isStatic() const;
+    std::vector<Position> getPositions() const;
+    void build(const std::vector<Position> & positions);
+    void renderElements(int cameraX, int cameraY, const Graphics::Bitmap & work, Graphics::Bitmap::Filter * filter);
+
+    unsigned int first;
+    std::vector<NormalElement *> elements;
+
+    /* where the elements were when the bitmap was made */
+    std::vector<Position> drawn;
+    /* where they were the last time they had moved from there */
+    std::vector<Position> moved;
+    bool built;
+    /* the elements are spread out too far to fit in a bitmap */
+    bool direct;
+    PaintownUtil::ReferenceCount<Graphics::Bitmap> cache;
+    /* upper left of the bitmap relative to the element starts */
+    int left;
+    int top;
+};
+
 /*! Our Background */
 class Background{
     public:
@@ -422,6 +510,12 @@ class Background{
 	virtual void act();
 	virtual void renderBackground(int cameraX, int cameraY, const Graphics::Bitmap &, Graphics::Bitmap::Filter * filter = NULL);
 	virtual void renderForeground(int cameraX, int cameraY, const Graphics::Bitmap &, Graphics::Bitmap::Filter * filter = NULL);
+
+        //! Draw runs of static elements from their cached bitmaps, on by default
+        virtual void setStaticLayers(bool enabled);
+
+        //! Draw parallax rows with a ParallaxRaster, see ParallaxElement::setRasterRows
+        virtual void setParallaxRaster(bool enabled);
 	
         //! Returns a vector of Elements by given ID
         std::vector< BackgroundElement * > getIDList(int ID);
@@ -435,7 +529,8 @@ class Background{
         }
 
     private:
-	
+        void findStaticLayers();
+
 	//! File where background is in
         Filesystem::AbsolutePath file;
 	
@@ -470,6 +565,11 @@ class Background{
 
         //! Controllers
         std::vector< BackgroundController *> controllers;
+
+        //! Runs of static elements, in order
+        std::vector< StaticLayer *> backgroundLayers;
+        std::vector< StaticLayer *> foregroundLayers;
+        bool staticLayers;
 };
     
 }
@@ -27,13 +27,16 @@ Behavior::~Behavior(){
 void Behavior::hit(Object * enemy){
 }
 
+void Behavior::latch(bool reversed){
+}
+
 DummyBehavior::DummyBehavior(){
 }
     
 void DummyBehavior::flip(){
 }
 
-vector<string> DummyBehavior::currentCommands(const Mugen::Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed){
+vector<string> DummyBehavior::currentCommands(const Mugen::Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed){
     vector<string> out;
     return out;
 }
@@ -55,7 +58,9 @@ static void debugit(const string & what, const InputMap<Mugen::Keys> & right){
 
 HumanBehavior::HumanBehavior(const InputMap<Mugen::Keys> & right, const InputMap<Mugen::Keys> & left):
 right(right),
-left(left){
+left(left),
+latching(false),
+latchedTick((unsigned long) -1){
 }
     
 InputMap<Keys> & HumanBehavior::getInput(bool facingRight){
@@ -70,6 +75,32 @@ void HumanBehavior::flip(){
     bool forward = input.pressed.forward;
     input.pressed.forward = input.pressed.back;
     input.pressed.back = forward;
+
+    forward = latched.pressed.forward;
+    latched.pressed.forward = latched.pressed.back;
+    latched.pressed.back = forward;
+}
+
+/* a key let go of between two latches is still let go of */
+static void keepReleased(Input::Key & now, const Input::Key & before){
+    now.a = now.a || before.a;
+    now.b = now.b || before.b;
+    now.c = now.c || before.c;
+    now.x = now.x || before.x;
+    now.y = now.y || before.y;
+    now.z = now.z || before.z;
+    now.back = now.back || before.back;
+    now.forward = now.forward || before.forward;
+    now.up = now.up || before.up;
+    now.down = now.down || before.down;
+    now.start = now.start || before.start;
+}
+
+void HumanBehavior::latch(bool reversed){
+    Input::Key released = latched.released;
+    latched = updateInput(getInput(reversed), latched);
+    keepReleased(latched.released, released);
+    latching = true;
 }
 
 Mugen::Input HumanBehavior::updateInput(InputMap<Keys> & keys, Mugen::Input old){
@@ -126,18 +157,31 @@ Mugen::Input HumanBehavior::updateInput(InputMap<Keys> & keys, Mugen::Input old)
     return old;
 }
 
-vector<string> HumanBehavior::currentCommands(const Mugen::Stage & stage, Character * owner, const vector<Command2*> & commands, bool reversed){
+Mugen::Input HumanBehavior::readInput(const Mugen::Stage & stage, bool reversed){
+    if (latching){
+        /* helpers can ask more than once a tick, only the first one uses up
+         * the released keys
+         */
+        if (stage.getTicks() != latchedTick){
+            latchedTick = stage.getTicks();
+            input = latched;
+            latched.released = Input::Key();
+        }
+        return input;
+    }
+
+    return updateInput(getInput(reversed), input);
+}
+
+vector<string> HumanBehavior::currentCommands(const Mugen::Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed){
     vector<string> out;
     
     // InputMap<Mugen::Keys>::Output output = InputManager::getMap(getInput(reversed));
-    input = updateInput(getInput(reversed), input);
+    input = readInput(stage, reversed);
 
-    for (vector<Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
-        Command2 * command = *it;
-        if (command->handle(input, stage.getTicks())){
-            Global::debug(1) << "command: " << command->getName() << endl;
-            out.push_back(command->getName());
-        }
+    commands.handle(input, stage.getTicks(), out);
+    for (vector<string>::const_iterator it = out.begin(); it != out.end(); it++){
+        Global::debug(1) << "command: " << *it << endl;
     }
 
     return out;
@@ -161,16 +205,16 @@ RandomAIBehavior::RandomAIBehavior(){
 void RandomAIBehavior::flip(){
 }
 
-static string randomCommand(const vector<Command2*> & commands){
+static string randomCommand(const CommandAutomaton & commands){
     if (commands.size() == 0){
         return "";
     }
 
     int choice = Mugen::random(commands.size());
-    return commands[choice]->getName();
+    return commands.getName(choice);
 }
 
-vector<string> RandomAIBehavior::currentCommands(const Mugen::Stage & stage, Character * owner, const vector<Command2*> & commands, bool reversed){
+vector<string> RandomAIBehavior::currentCommands(const Mugen::Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed){
     vector<string> out;
     if (Mugen::random(100) > 90){
         out.push_back(randomCommand(commands));
@@ -213,13 +257,13 @@ dontMove(0){
  *  - subtract points based on the number of times the move has been tried
  *  - subtract points if the move has been done recently
  */
-string LearningAIBehavior::selectBestCommand(int distance, const vector<Command2*> & commands){
+string LearningAIBehavior::selectBestCommand(int distance, const CommandAutomaton & commands){
     Move * currentMove = NULL;
     string what = "";
     double points = 0;
 
-    for (vector<Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
-        string name = (*it)->getName();
+    for (int command = 0; command < commands.size(); command++){
+        string name = commands.getName(command);
 
         /* Skip movement keys */
         if (name == "holdfwd" ||
@@ -282,7 +326,7 @@ static LearningAIBehavior::Direction randomDirection(){
     }
 }
 
-vector<string> LearningAIBehavior::currentCommands(const Mugen::Stage & stage, Character * owner, const vector<Command2*> & commands, bool reversed){
+vector<string> LearningAIBehavior::currentCommands(const Mugen::Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed){
 
     vector<string> out;
 
@@ -393,7 +437,7 @@ ScriptedBehavior::ScriptedBehavior(const Filesystem::AbsolutePath & path){
     currentAction = actions.begin();
 }
 
-std::vector<std::string> ScriptedBehavior::currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed){
+std::vector<std::string> ScriptedBehavior::currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed){
     vector<string> out;
 
     if (currentAction != actions.end()){
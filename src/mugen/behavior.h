@@ -11,7 +11,7 @@ namespace Mugen{
 
 class Object;
 class Character;
-class Command2;
+class CommandAutomaton;
 class Stage;
 
 /* handles input and tells the character what commands to invoke */
@@ -19,7 +19,7 @@ class Behavior{
 public:
     Behavior();
    
-    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed) = 0;
+    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed) = 0;
 
     /* called when the player changes direction. useful for updating
      * the input mapping.
@@ -29,6 +29,13 @@ public:
     /* hit someone */
     virtual void hit(Object * enemy);
 
+    /* Read the input devices now and use what was read in the next
+     * currentCommands() instead of reading them then. When the match logic
+     * runs on its own thread this is called from the thread that polls the
+     * input devices, with the match locked.
+     */
+    virtual void latch(bool reversed);
+
     virtual ~Behavior();
 };
 
@@ -36,10 +43,12 @@ class HumanBehavior: public Behavior {
 public:
     HumanBehavior(const InputMap<Keys> &, const InputMap<Keys> &);
 
-    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed);
+    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed);
     
     virtual void flip();
 
+    virtual void latch(bool reversed);
+
     virtual ~HumanBehavior();
     
     virtual void updateKeys(const InputMap<Keys> &, const InputMap<Keys> &);
@@ -49,11 +58,21 @@ public:
 protected:
     InputMap<Keys> & getInput(bool facing);
     Mugen::Input updateInput(InputMap<Keys> & keys, Mugen::Input old);
+    /* the input for this tick, what latch() read if it has been called and
+     * what the input devices say right now otherwise
+     */
+    Mugen::Input readInput(const Stage & stage, bool reversed);
 
 protected:
     InputMap<Keys> right;
     InputMap<Keys> left;
     Mugen::Input input;
+
+    /* set once latch() has been called */
+    bool latching;
+    Mugen::Input latched;
+    /* the stage tick the latched input was last used for */
+    unsigned long latchedTick;
 };
 
 /* dummy does absolutely nothing */
@@ -61,7 +80,7 @@ class DummyBehavior: public Behavior {
 public:
     DummyBehavior();
 
-    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed);
+    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed);
     virtual void flip();
 
     virtual ~DummyBehavior();
@@ -72,7 +91,7 @@ class RandomAIBehavior: public Behavior {
 public:
     RandomAIBehavior();
 
-    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed);
+    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed);
     virtual void flip();
 
     virtual ~RandomAIBehavior();
@@ -92,7 +111,7 @@ public:
         std::vector<std::string> commands;
     };
 
-    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed);
+    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed);
     virtual void flip();
 
     virtual ~ScriptedBehavior();
@@ -110,7 +129,7 @@ public:
     /* 1 is easy, 10 is hard */
     LearningAIBehavior(int difficult);
 
-    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed);
+    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed);
     virtual void flip();
     
     virtual void hit(Object * enemy);
@@ -148,7 +167,7 @@ public:
     };
 
 protected:
-    std::string selectBestCommand(int distance, const std::vector<Command2*> & commands);
+    std::string selectBestCommand(int distance, const CommandAutomaton & commands);
 
     std::map<std::string, Move> moves;
 
@@ -30,6 +30,7 @@ struct HitAttributes{
 };
 Token * serialize(const HitAttributes & data);
 HitAttributes deserializeHitAttributes(const Token * data);
+void digest(StateHash & out, const HitAttributes & data);
 
 
 struct ResourceEffect{
@@ -45,6 +46,7 @@ struct ResourceEffect{
 };
 Token * serialize(const ResourceEffect & data);
 ResourceEffect deserializeResourceEffect(const Token * data);
+void digest(StateHash & out, const ResourceEffect & data);
 
 
 struct HitFlags{
@@ -68,6 +70,7 @@ struct HitFlags{
 };
 Token * serialize(const HitFlags & data);
 HitFlags deserializeHitFlags(const Token * data);
+void digest(StateHash & out, const HitFlags & data);
 
 
 struct PauseTime{
@@ -81,6 +84,7 @@ struct PauseTime{
 };
 Token * serialize(const PauseTime & data);
 PauseTime deserializePauseTime(const Token * data);
+void digest(StateHash & out, const PauseTime & data);
 
 
 struct Distance{
@@ -94,6 +98,7 @@ struct Distance{
 };
 Token * serialize(const Distance & data);
 Distance deserializeDistance(const Token * data);
+void digest(StateHash & out, const Distance & data);
 
 
 
@@ -108,6 +113,7 @@ struct Attribute{
 };
 Token * serialize(const Attribute & data);
 Attribute deserializeAttribute(const Token * data);
+void digest(StateHash & out, const Attribute & data);
 
 
 struct Priority{
@@ -121,6 +127,7 @@ struct Priority{
 };
 Token * serialize(const Priority & data);
 Priority deserializePriority(const Token * data);
+void digest(StateHash & out, const Priority & data);
 
 
 struct Damage{
@@ -134,6 +141,7 @@ struct Damage{
 };
 Token * serialize(const Damage & data);
 Damage deserializeDamage(const Token * data);
+void digest(StateHash & out, const Damage & data);
 
 
 struct SparkPosition{
@@ -147,6 +155,7 @@ struct SparkPosition{
 };
 Token * serialize(const SparkPosition & data);
 SparkPosition deserializeSparkPosition(const Token * data);
+void digest(StateHash & out, const SparkPosition & data);
 
 
 struct GetPower{
@@ -160,6 +169,7 @@ struct GetPower{
 };
 Token * serialize(const GetPower & data);
 GetPower deserializeGetPower(const Token * data);
+void digest(StateHash & out, const GetPower & data);
 
 
 struct GivePower{
@@ -173,6 +183,7 @@ struct GivePower{
 };
 Token * serialize(const GivePower & data);
 GivePower deserializeGivePower(const Token * data);
+void digest(StateHash & out, const GivePower & data);
 
 
 struct GroundVelocity{
@@ -186,6 +197,7 @@ struct GroundVelocity{
 };
 Token * serialize(const GroundVelocity & data);
 GroundVelocity deserializeGroundVelocity(const Token * data);
+void digest(StateHash & out, const GroundVelocity & data);
 
 
 struct AirVelocity{
@@ -199,6 +211,7 @@ struct AirVelocity{
 };
 Token * serialize(const AirVelocity & data);
 AirVelocity deserializeAirVelocity(const Token * data);
+void digest(StateHash & out, const AirVelocity & data);
 
 
 struct AirGuardVelocity{
@@ -212,6 +225,7 @@ struct AirGuardVelocity{
 };
 Token * serialize(const AirGuardVelocity & data);
 AirGuardVelocity deserializeAirGuardVelocity(const Token * data);
+void digest(StateHash & out, const AirGuardVelocity & data);
 
 
 
@@ -224,6 +238,7 @@ struct Shake{
 };
 Token * serialize(const Shake & data);
 Shake deserializeShake(const Token * data);
+void digest(StateHash & out, const Shake & data);
 
 struct Fall{
     Fall(){
@@ -251,6 +266,7 @@ struct Fall{
 };
 Token * serialize(const Fall & data);
 Fall deserializeFall(const Token * data);
+void digest(StateHash & out, const Fall & data);
 
 struct HitDefinition{
     HitDefinition(){
@@ -346,6 +362,7 @@ struct HitDefinition{
 };
 Token * serialize(const HitDefinition & data);
 HitDefinition deserializeHitDefinition(const Token * data);
+void digest(StateHash & out, const HitDefinition & data);
 
 
 struct HitOverride{
@@ -362,6 +379,7 @@ struct HitOverride{
 };
 Token * serialize(const HitOverride & data);
 HitOverride deserializeHitOverride(const Token * data);
+void digest(StateHash & out, const HitOverride & data);
 
 
 
@@ -375,6 +393,7 @@ struct Shake1{
 };
 Token * serialize(const Shake1 & data);
 Shake1 deserializeShake1(const Token * data);
+void digest(StateHash & out, const Shake1 & data);
 
 struct Fall1{
     Fall1(){
@@ -398,6 +417,7 @@ struct Fall1{
 };
 Token * serialize(const Fall1 & data);
 Fall1 deserializeFall1(const Token * data);
+void digest(StateHash & out, const Fall1 & data);
 
 struct HitState{
     HitState(){
@@ -443,6 +463,7 @@ struct HitState{
 };
 Token * serialize(const HitState & data);
 HitState deserializeHitState(const Token * data);
+void digest(StateHash & out, const HitState & data);
 
 
 
@@ -459,6 +480,7 @@ struct HitSound{
 };
 Token * serialize(const HitSound & data);
 HitSound deserializeHitSound(const Token * data);
+void digest(StateHash & out, const HitSound & data);
 
 struct ReversalData{
     ReversalData(){
@@ -489,6 +511,7 @@ struct ReversalData{
 };
 Token * serialize(const ReversalData & data);
 ReversalData deserializeReversalData(const Token * data);
+void digest(StateHash & out, const ReversalData & data);
 
 
 
@@ -509,6 +532,7 @@ struct WidthOverride{
 };
 Token * serialize(const WidthOverride & data);
 WidthOverride deserializeWidthOverride(const Token * data);
+void digest(StateHash & out, const WidthOverride & data);
 
 
 struct HitByOverride{
@@ -527,6 +551,7 @@ struct HitByOverride{
 };
 Token * serialize(const HitByOverride & data);
 HitByOverride deserializeHitByOverride(const Token * data);
+void digest(StateHash & out, const HitByOverride & data);
 
 
 struct TransOverride{
@@ -544,6 +569,7 @@ struct TransOverride{
 };
 Token * serialize(const TransOverride & data);
 TransOverride deserializeTransOverride(const Token * data);
+void digest(StateHash & out, const TransOverride & data);
 
 
 struct SpecialStuff{
@@ -557,6 +583,7 @@ struct SpecialStuff{
 };
 Token * serialize(const SpecialStuff & data);
 SpecialStuff deserializeSpecialStuff(const Token * data);
+void digest(StateHash & out, const SpecialStuff & data);
 
 
 struct Bind{
@@ -576,6 +603,7 @@ struct Bind{
 };
 Token * serialize(const Bind & data);
 Bind deserializeBind(const Token * data);
+void digest(StateHash & out, const Bind & data);
 
 
 struct CharacterData{
@@ -589,6 +617,7 @@ struct CharacterData{
 };
 Token * serialize(const CharacterData & data);
 CharacterData deserializeCharacterData(const Token * data);
+void digest(StateHash & out, const CharacterData & data);
 
 
 struct DrawAngleEffect{
@@ -606,6 +635,7 @@ struct DrawAngleEffect{
 };
 Token * serialize(const DrawAngleEffect & data);
 DrawAngleEffect deserializeDrawAngleEffect(const Token * data);
+void digest(StateHash & out, const DrawAngleEffect & data);
 
 struct StateData{
     StateData(){
@@ -685,10 +715,11 @@ struct StateData{
     double virtualz;
     Facing facing;
     double power;
-    std::map<std::string, std::string > commandState;
+    std::string commandState;
 };
 Token * serialize(const StateData & data);
 StateData deserializeStateData(const Token * data);
+void digest(StateHash & out, const StateData & data);
 
 
 struct AnimationState{
@@ -708,6 +739,7 @@ struct AnimationState{
 };
 Token * serialize(const AnimationState & data);
 AnimationState deserializeAnimationState(const Token * data);
+void digest(StateHash & out, const AnimationState & data);
 
 
 struct ScreenBound{
@@ -725,6 +757,7 @@ struct ScreenBound{
 };
 Token * serialize(const ScreenBound & data);
 ScreenBound deserializeScreenBound(const Token * data);
+void digest(StateHash & out, const ScreenBound & data);
 
 
 
@@ -745,6 +778,7 @@ struct Pause{
 };
 Token * serialize(const Pause & data);
 Pause deserializePause(const Token * data);
+void digest(StateHash & out, const Pause & data);
 
 
 struct Zoom{
@@ -800,6 +834,7 @@ struct Zoom{
 };
 Token * serialize(const Zoom & data);
 Zoom deserializeZoom(const Token * data);
+void digest(StateHash & out, const Zoom & data);
 
 
 struct EnvironmentColor{
@@ -815,6 +850,7 @@ struct EnvironmentColor{
 };
 Token * serialize(const EnvironmentColor & data);
 EnvironmentColor deserializeEnvironmentColor(const Token * data);
+void digest(StateHash & out, const EnvironmentColor & data);
 
 
 struct SuperPause{
@@ -834,6 +870,7 @@ struct SuperPause{
 };
 Token * serialize(const SuperPause & data);
 SuperPause deserializeSuperPause(const Token * data);
+void digest(StateHash & out, const SuperPause & data);
 
 struct StageStateData{
     StageStateData(){
@@ -869,6 +906,7 @@ struct StageStateData{
 };
 Token * serialize(const StageStateData & data);
 StageStateData deserializeStageStateData(const Token * data);
+void digest(StateHash & out, const StageStateData & data);
 
 
 struct PlayerData{
@@ -894,6 +932,7 @@ struct PlayerData{
 };
 Token * serialize(const PlayerData & data);
 PlayerData deserializePlayerData(const Token * data);
+void digest(StateHash & out, const PlayerData & data);
 
 }
 
@@ -22,9 +22,11 @@
 #include <r-tech1/timedifference.h>
 #include <r-tech1/debug.h>
 #include <r-tech1/message-queue.h>
+#include <r-tech1/thread.h>
 #include "factory/font_render.h"
 
 #include "animation.h"
+#include "atlas.h"
 #include "item.h"
 #include "item-content.h"
 #include "section.h"
@@ -42,6 +44,7 @@
 #include "behavior.h"
 #include "state-controller.h"
 #include "helper.h"
+#include "color-table.h"
 
 #include <r-tech1/input/input-map.h>
 #include <r-tech1/input/input-manager.h>
@@ -121,6 +124,73 @@ int CharacterId::intValue() const {
     return id;
 }
 
+CommandHistory::CommandHistory():
+total(0){
+}
+
+void CommandHistory::append(const vector<string> & commands, uint32_t ticks){
+    if (runs.size() > 0 && runs.back().commands == commands){
+        runs.back().ticks += ticks;
+    } else {
+        runs.push_back(Run(commands, total, ticks));
+    }
+    total += ticks;
+}
+
+void CommandHistory::add(const vector<string> & commands){
+    append(commands, 1);
+}
+
+unsigned int CommandHistory::find(uint32_t tick) const {
+    /* the last run that starts at or before the tick */
+    unsigned int low = 0;
+    unsigned int high = runs.size();
+    while (high - low > 1){
+        unsigned int middle = (low + high) / 2;
+        if (runs[middle].start <= tick){
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+void CommandHistory::set(uint32_t tick, const vector<string> & commands){
+    if (tick >= total){
+        if (tick > total){
+            append(none, tick - total);
+        }
+        append(commands, 1);
+        return;
+    }
+
+    unsigned int index = find(tick);
+    if (runs[index].commands == commands){
+        return;
+    }
+
+    /* split the run around the tick */
+    Run old = runs[index];
+    vector<Run> replace;
+    if (tick > old.start){
+        replace.push_back(Run(old.commands, old.start, tick - old.start));
+    }
+    replace.push_back(Run(commands, tick, 1));
+    if (tick + 1 < old.start + old.ticks){
+        replace.push_back(Run(old.commands, tick + 1, old.start + old.ticks - tick - 1));
+    }
+    runs.erase(runs.begin() + index);
+    runs.insert(runs.begin() + index, replace.begin(), replace.end());
+}
+
+const vector<string> & CommandHistory::get(uint32_t tick) const {
+    if (tick >= total){
+        return none;
+    }
+    return runs[find(tick)].commands;
+}
+
 static string sourceLocation(const Ast::AttributeSimple & simple, const Filesystem::AbsolutePath & path){
     ostringstream out;
     out << "in " << path.path() << " at line " << simple.getLine() << " column " << simple.getColumn();
@@ -258,19 +328,19 @@ void State::transitionTo(const Mugen::Stage & stage, Character & who){
     FullEnvironment environment(stage, who);
 
     if (animation != NULL){
-        who.setAnimation((int) animation->evaluate(environment).toNumber());
+        who.setAnimation((int) Compiler::evaluateNumber(animation, environment));
     }
 
     if (changeControl){
-        who.setControl(control->evaluate(environment).toBool());
+        who.setControl(Compiler::evaluateBool(control, environment));
     }
 
     if (juggle != NULL){
-        who.setCurrentJuggle((int) juggle->evaluate(environment).toNumber());
+        who.setCurrentJuggle((int) Compiler::evaluateNumber(juggle, environment));
     }
 
     if (changeSpritePriority && spritePriority != NULL){
-        who.setSpritePriority((int) spritePriority->evaluate(environment).toNumber());
+        who.setSpritePriority((int) Compiler::evaluateNumber(spritePriority, environment));
     }
 
     if (powerChanged()){
@@ -304,8 +374,8 @@ void State::transitionTo(const Mugen::Stage & stage, Character & who){
     who.setReversalInactive();
 
     if (changeVelocity){
-        who.setXVelocity(velocity_x->evaluate(FullEnvironment(stage, who)).toNumber());
-        who.setYVelocity(velocity_y->evaluate(FullEnvironment(stage, who)).toNumber());
+        who.setXVelocity(Compiler::evaluateNumber(velocity_x, environment));
+        who.setYVelocity(Compiler::evaluateNumber(velocity_y, environment));
         // Global::debug(0) << "Velocity set to " << velocity_x->evaluate(FullEnvironment(stage, who)).toNumber() << ", " << velocity_y->evaluate(FullEnvironment(stage, who)).toNumber() << endl;
     }
 
@@ -335,10 +405,7 @@ void State::transitionTo(const Mugen::Stage & stage, Character & who){
         }
     }
     
-    for (vector<StateController*>::iterator it = controllers.begin(); it != controllers.end(); it++){
-        StateController * controller = *it;
-        controller->resetPersistent();
-    }
+    who.resetStatePersistent(id);
 }
 
 State::~State(){
@@ -559,13 +626,15 @@ void Character::reverseFacing(){
 }
 
 Character::Character(const Filesystem::AbsolutePath & s, int alliance):
-Object(alliance){
+Object(alliance),
+arena(new Arena()){
     getLocalData().location = s;
     initialize();
 }
 
 Character::Character(const Filesystem::AbsolutePath & s, const int x, const int y, int alliance):
-Object(alliance){
+Object(alliance),
+arena(new Arena()){
     getLocalData().location = s;
     initialize();
 }
@@ -573,15 +642,14 @@ Object(alliance){
 Character::Character(const Character & copy):
 Object(copy),
 stateControllerId(copy.stateControllerId),
+statePersistent(copy.statePersistent),
+arena(copy.arena),
 localData(copy.localData),
 stateData(copy.stateData){
 }
 
 Character::~Character(){
     stopRecording();
-    for (vector<Command2*>::iterator it = getLocalData().commands.begin(); it != getLocalData().commands.end(); it++){
-        delete (*it);
-    }
 }
 
 void Character::initialize(){
@@ -688,8 +756,8 @@ void Character::loadSelectData(){
     }
 }
     
-void Character::addCommand(Command2 * command){
-    getLocalData().commands.push_back(command);
+void Character::addCommand(const Command2 & command){
+    getLocalData().commands.add(command);
 }
 
 void Character::setAnimation(int animation, int element){
@@ -780,7 +848,7 @@ void Character::loadCmdFile(const Filesystem::RelativePath & path){
 
                         try{
                             /* parser guarantees the key will be a KeyList */
-                            self.addCommand(new Command2(name, (Ast::KeyList*) key, time, bufferTime));
+                            self.addCommand(Command2(name, (Ast::KeyList*) key, time, bufferTime));
                         } catch (const MugenException & fail){
                             Global::debug(0) << "Could not add command for '" << name << "': " << fail.getTrace() << std::endl;
                         }
@@ -1561,6 +1629,8 @@ PaintownUtil::ReferenceCount<State> Character::parseStateDefinition(Ast::Section
         
 static map<string, StateController::Type> types;
 static bool typesSetup = false;
+/* characters can be loaded on several threads at once */
+static PaintownUtil::Thread::LockObject typesLock;
 
 StateController * Character::parseState(Ast::Section * section){
     std::string head = section->getName();
@@ -1573,6 +1643,7 @@ StateController * Character::parseState(Ast::Section * section){
     public:
         StateControllerWalker():
         type(StateController::Unknown){
+            PaintownUtil::Thread::ScopedLock scoped(typesLock);
             if (!typesSetup){
                 typesSetup = true;
                 types["afterimage"] = StateController::AfterImage;
@@ -1842,6 +1913,9 @@ void Character::load(int useAct){
 #endif
 
     MessageQueue::info("Loading " + getLocalData().location.getFilename().path());
+
+    /* everything compiled from the character's files goes in its arena */
+    Arena::Scope arenaScope(arena.raw());
     
     // baseDir = Filesystem::cleanse(Mugen::Util::getFileDir(location));
     getLocalData().baseDir = getLocalData().location.getDirectory();
@@ -2013,6 +2087,7 @@ void Character::load(int useAct){
 
                 compileTime.endTime();
                 Global::debug(1) << compileTime.printTime("Compile time") << std::endl;
+                Global::debug(1) << "Arena has " << arena->getAllocations() << " objects, " << arena->getLive() << " live, in " << arena->getSize() / 1024 << "kb" << std::endl;
 
 #if 0
                 for (vector<Location>::iterator it = walker.stateFiles.begin(); it != walker.stateFiles.end(); it++){
@@ -2188,6 +2263,9 @@ void Character::loadGraphics(int palette){
     getLocalData().sprites = SpriteMap();
 
     Util::readSprites(Storage::instance().lookupInsensitive(getLocalData().baseDir, Filesystem::RelativePath(getLocalData().sffFile)), finalPalette, getLocalData().sprites, true);
+    if (Atlas::isEnabled()){
+        Atlas::pack(getLocalData().sprites);
+    }
 
     Global::debug(2) << "Reading Air (animation) Data..." << endl;
     getLocalData().animations = Util::loadAnimations(Storage::instance().lookupInsensitive(getLocalData().baseDir, Filesystem::RelativePath(getLocalData().airFile)), getLocalData().sprites, true);
@@ -2359,8 +2437,7 @@ void Character::fixAssumptions(){
             vector<Ast::Key*> keys;
             keys.push_back(new Ast::KeyModifier(-1, -1, Ast::KeyModifier::Release, new Ast::KeySingle(-1, -1, "U")));
             keys.push_back(new Ast::KeySingle(-1, -1, "U"));
-            Command2 * doubleJumpCommand = new Command2(jumpCommand, new Ast::KeyList(-1, -1, keys), 5, 0);
-            addCommand(doubleJumpCommand);
+            addCommand(Command2(jumpCommand, new Ast::KeyList(-1, -1, keys), 5, 0));
 
             setSystemVariable(JumpIndex, RuntimeValue(0));
 
@@ -2561,7 +2638,7 @@ void Character::renderSprite(const int x, const int y, const unsigned int group,
     }
 }
         
-const std::vector<Command2 *> & Character::getCommands() const {
+const CommandAutomaton & Character::getCommands() const {
     return getLocalData().commands;
 }
         
@@ -2657,62 +2734,60 @@ PaintownUtil::ReferenceCount<Animation> Character::getCurrentAnimation() const {
 }
 
 void Character::resetStatePersistent(){
-    for (map<int, PaintownUtil::ReferenceCount<State> >::const_iterator it = getLocalData().states.begin(); it != getLocalData().states.end(); it++){
-        const PaintownUtil::ReferenceCount<State> & state = it->second;
-        if (state != NULL){
-            const std::vector<StateController*> & controllers = state->getControllers();
-            map<unsigned int, int> use;
-
-            for (vector<StateController*>::const_iterator it2 = controllers.begin(); it2 != controllers.end(); it2++){
-                StateController * controller = *it2;
-                controller->resetPersistent();
-            }
-        }
-    }
+    statePersistent.clear();
+}
+
+void Character::resetStatePersistent(int state){
+    statePersistent.erase(state);
 }
 
 void Character::setStatePersistent(const std::map<int, std::map<uint32_t, int> > & statePersistent){
-    resetStatePersistent();
+    this->statePersistent = statePersistent;
+}
 
-    for (std::map<int, std::map<uint32_t, int> >::const_iterator it = statePersistent.begin(); it != statePersistent.end(); it++){
-        PaintownUtil::ReferenceCount<State> state = getSelfState(it->first);
-        if (state != NULL){
-            const map<uint32_t, int> & persistent = it->second;
+const std::map<int, std::map<uint32_t, int> > & Character::getStatePersistent() const {
+    return statePersistent;
+}
 
-            for (map<uint32_t, int>::const_iterator it2 = persistent.begin(); it2 != persistent.end(); it2++){
-                StateController * controller = state->findControllerById(it2->first);
-                if (controller != NULL){
-                    controller->setCurrentPersistent(it2->second);
-                }
-            }
-        }
+bool Character::getConstant(int key, RuntimeValue & out) const {
+    map<int, RuntimeValue>::const_iterator found = constants.find(key);
+    if (found != constants.end()){
+        out = found->second;
+        return true;
     }
+    return false;
 }
 
-std::map<int, std::map<uint32_t, int> > Character::getStatePersistent() const {
-    map<int, map<uint32_t, int> > data;
-        
-    for (map<int, PaintownUtil::ReferenceCount<State> >::const_iterator it = getLocalData().states.begin(); it != getLocalData().states.end(); it++){
-        const PaintownUtil::ReferenceCount<State> & state = it->second;
-        if (state != NULL){
-            const std::vector<StateController*> & controllers = state->getControllers();
-            map<uint32_t, int> use;
-
-            for (vector<StateController*>::const_iterator it2 = controllers.begin(); it2 != controllers.end(); it2++){
-                StateController * controller = *it2;
-                if (controller->getPersistent() != controller->getCurrentPersistent()){
-                    use[controller->getId()] = controller->getCurrentPersistent();
-                }
-            }
+void Character::setConstant(int key, const RuntimeValue & value) const {
+    constants[key] = value;
+}
 
-            if (use.size() > 0){
-                data[state->getState()] = use;
-            }
+bool Character::persistentOk(int state, const StateController * controller){
+    /* a missing counter is at the controller's persistent value. counters
+     * are only kept while they are somewhere else so controllers that run
+     * every tick don't leave empty entries in snapshots and the state hash.
+     */
+    int current = controller->getPersistent();
+    map<int, map<uint32_t, int> >::iterator counters = statePersistent.find(state);
+    if (counters != statePersistent.end()){
+        map<uint32_t, int>::iterator found = counters->second.find(controller->getId());
+        if (found != counters->second.end()){
+            current = found->second;
         }
+    }
 
+    bool ok = controller->persistentOk(current);
+
+    if (current != controller->getPersistent()){
+        statePersistent[state][controller->getId()] = current;
+    } else if (counters != statePersistent.end()){
+        counters->second.erase(controller->getId());
+        if (counters->second.empty()){
+            statePersistent.erase(counters);
+        }
     }
 
-    return data;
+    return ok;
 }
 
 /* returns all the commands that are currently active */
@@ -2758,7 +2833,7 @@ static bool holdingBlock(const vector<string> & commands){
     return false;
 }
 
-void Character::processAfterImages(){
+void Character::processAfterImages(bool record){
     if (getLocalData().afterImage.lifetime > 0){
         getLocalData().afterImage.lifetime -= 1;
     }
@@ -2767,6 +2842,15 @@ void Character::processAfterImages(){
         getLocalData().afterImage.currentTime -= 1;
     }
 
+    /* keep the timers going so the afterimage picks up where it would have */
+    if (!record){
+        if (getLocalData().afterImage.timegap > 0 && getLocalData().afterImage.currentTime <= 0){
+            getLocalData().afterImage.currentTime += getLocalData().afterImage.timegap;
+        }
+        getLocalData().afterImage.frames.clear();
+        return;
+    }
+
     int x = (int) getX();
     int y = (int) getRY();
 
@@ -2826,15 +2910,7 @@ std::vector<std::string> Character::currentInputs() const {
 }
         
 void Character::setInputs(uint32_t tick, const std::vector<std::string> & inputs){
-    /*
-    while (tick <= getLocalData().inputHistory.size()){
-        getLocalData().inputHistory.push_back(vector<string>());
-    }
-    */
-    if (getLocalData().inputHistory.size() < tick){
-        getLocalData().inputHistory.resize(tick);
-    }
-    getLocalData().inputHistory[tick - 1] = inputs;
+    getLocalData().inputHistory.set(tick - 1, inputs);
 }
 
 /* Inherited members */
@@ -2862,7 +2938,7 @@ void Character::act(Stage * stage){
     getStateData().transOverride.enabled = false;
     getStateData().drawAngleData.enabled = false;
 
-    processAfterImages();
+    processAfterImages(!stage->isSimulationOnly());
 
     if (getLocalData().paletteEffects.time > 0){
         getLocalData().paletteEffects.counter += 1;
@@ -2891,11 +2967,11 @@ void Character::act(Stage * stage){
         // stage->getTicks() - 1 >= getLocalData().inputHistory.size()){
         /* active is the current set of commands */
         getStateData().active = doInput(*stage);
-        getLocalData().inputHistory.push_back(getStateData().active);
+        getLocalData().inputHistory.add(getStateData().active);
 
         recordCommands(getStateData().active);
     } else {
-        getStateData().active = getLocalData().inputHistory[stage->getTicks() - 1];
+        getStateData().active = getLocalData().inputHistory.get(stage->getTicks() - 1);
     }
 
     if (getHitState().recoverTime > 0){
@@ -3403,6 +3479,8 @@ bool Character::doStates(Mugen::Stage & stage, const vector<string> & active, in
         // Global::debug(0) << getDisplayName() << " evaluating state " << stateNumber << " states " << state->getControllers().size() << std::endl;
         const vector<StateController*> & controllers = state->getControllers();
         FullEnvironment environment(stage, *this, active);
+        TriggerCache triggers;
+        environment.setCache(&triggers);
         for (vector<StateController*>::const_iterator it = controllers.begin(); it != controllers.end(); it++){
             StateController * controller = *it;
             Global::debug(2 * !controller->getDebug()) << "State " << stateNumber << " check state controller " << controller->getName() << endl;
@@ -3431,9 +3509,12 @@ bool Character::doStates(Mugen::Stage & stage, const vector<string> & active, in
                     /* check if the controller's persistent values allow it
                      * to be activated.
                      */
-                    if (controller->persistentOk()){
+                    if (persistentOk(state->getState(), controller)){
                         Global::debug(2, getDisplayName()) << "Activate controller " << controller->getName() << std::endl;
-                        /* activate may modify the current state */
+                        /* activate may modify the current state, and anything
+                         * else, so forget the triggers seen so far
+                         */
+                        triggers.clear();
                         controller->activate(stage, *this, active);
 
                         /* 8/27/2012 - the mugen docs say this about negative states:
@@ -3514,6 +3595,12 @@ void Character::drawAfterImage(const AfterImage & afterImage, const AfterImage::
                 greenExtraMultiply = pow(extraMultiplier.green, extra);
                 blueExtraAdd = extraAdd.blue * extra;
                 blueExtraMultiply = pow(extraMultiplier.blue, extra);
+
+                for (int i = 0; i < 256; i++){
+                    table.set(i, doFilter(i, redPart, redExtraAdd, redExtraMultiply),
+                                 doFilter(i, greenPart, greenExtraAdd, greenExtraMultiply),
+                                 doFilter(i, bluePart, blueExtraAdd, blueExtraMultiply));
+                }
             }
 
         const AfterImage::RGBx & bright;
@@ -3522,7 +3609,9 @@ void Character::drawAfterImage(const AfterImage & afterImage, const AfterImage::
         const AfterImage::RGBx & extraAdd;
         const AfterImage::RGBx & extraMultiplier;
         const int extra;
-        mutable map<Graphics::Color, Graphics::Color> cache;
+
+        /* used by the software renderer, the shader does the same math */
+        ColorTable table;
 
         double redExtraAdd;
         double redExtraMultiply;
@@ -3535,17 +3624,12 @@ void Character::drawAfterImage(const AfterImage & afterImage, const AfterImage::
         Save greenPart;
         Save bluePart;
 
-        Graphics::Color doFilter(int red, int green, int blue) const {
-            double red_out = red;
-            double green_out = green;
-            double blue_out = blue;
+        /* one component, each of them only depends on its own value */
+        static unsigned char doFilter(int value, const Save & part, double extraAdd, double extraMultiply){
+            double out = value;
 
-            // red_out = (red_out + bright.red) * contrast.red / 256 + post.red;
-            // green_out = (green_out + bright.green) * contrast.green / 256 + post.green;
-            // blue_out = (blue_out + bright.blue) * contrast.blue / 256 + post.blue;
-            red_out = red_out * redPart.multiplier + redPart.adder;
-            green_out = green_out * greenPart.multiplier + greenPart.adder;
-            blue_out = blue_out * bluePart.multiplier + bluePart.adder;
+            // out = (out + bright) * contrast / 256 + post;
+            out = out * part.multiplier + part.adder;
 
             /* the mugen docs lied:
              * "In one application of these palette effects, first the paladd components are added to the afterimage palette, then the components are multiplied by the palmul multipliers. These effects are applied zero times to the most recent afterimage frame, once to the  second-newest afterimage frame, twice in succession to the third-newest afterimage frame, etc."
@@ -3555,20 +3639,12 @@ void Character::drawAfterImage(const AfterImage & afterImage, const AfterImage::
              * and then do all the multiply operations second.
              */
 
-            red_out += redExtraAdd;
-            red_out *= redExtraMultiply;
-            green_out += greenExtraAdd;
-            green_out *= greenExtraMultiply;
-            blue_out += blueExtraAdd;
-            blue_out *= blueExtraMultiply;
+            out += extraAdd;
+            out *= extraMultiply;
 
             /*
-            red_out += extraAdd.red * extra;
-            red_out *= pow(extraMultiplier.red, extra);
-            green_out += extraAdd.green * extra;
-            green_out *= pow(extraMultiplier.green, extra);
-            blue_out += extraAdd.blue * extra;
-            blue_out *= pow(extraMultiplier.blue, extra);
+            out += extraAdd.red * extra;
+            out *= pow(extraMultiplier.red, extra);
             */
 
             /* This is what the code would look like if the mugen docs
@@ -3576,36 +3652,19 @@ void Character::drawAfterImage(const AfterImage & afterImage, const AfterImage::
              */
             /*
                for (int i = 0; i < extra; i++){
-               red_out += extraAdd.red;
-               red_out *= extraMultiplier.red;
-               green_out += extraAdd.green;
-               green_out *= extraMultiplier.green;
-               blue_out += extraAdd.blue;
-               blue_out *= extraMultiplier.blue;
+               out += extraAdd.red;
+               out *= extraMultiplier.red;
                }
                */
 
-            if (red_out < 0){
-                red_out = 0;
-            }
-            if (red_out > 255){
-                red_out = 255;
-            }
-            if (green_out < 0){
-                green_out = 0;
-            }
-            if (green_out > 255){
-                green_out = 255;
+            if (out < 0){
+                out = 0;
             }
-            if (blue_out < 0){
-                blue_out = 0;
-            }
-            if (blue_out > 255){
-                blue_out = 255;
+            if (out > 255){
+                out = 255;
             }
 
-            Graphics::Color out = Graphics::makeColor((int) red_out, (int) green_out, (int) blue_out);
-            return out;
+            return (unsigned char) (int) out;
         }
 
         PaintownUtil::ReferenceCount<Graphics::Shader> shader;
@@ -3644,16 +3703,7 @@ void Character::drawAfterImage(const AfterImage & afterImage, const AfterImage::
         }
 
         Graphics::Color filter(Graphics::Color pixel) const {
-            if (cache.find(pixel) != cache.end()){
-                return cache[pixel];
-            }
-
-            int red = Graphics::getRed(pixel);
-            int green = Graphics::getGreen(pixel);
-            int blue = Graphics::getBlue(pixel);
-            Graphics::Color out = doFilter(red, green, blue);
-            cache[pixel] = out;
-            return out;
+            return table.apply(pixel);
         }
     };
 
@@ -3695,7 +3745,8 @@ class PaletteFilter: public Graphics::Bitmap::Filter {
         sinBlue(sinBlue),
         period(period),
         invert(invert),
-        color(color){
+        color(color),
+        table(ColorTable::palette(time, addRed, addGreen, addBlue, multiplyRed, multiplyGreen, multiplyBlue, sinRed, sinGreen, sinBlue, period, invert, color)){
         }
 
         int time;
@@ -3711,65 +3762,9 @@ class PaletteFilter: public Graphics::Bitmap::Filter {
         int period;
         int invert;
         int color;
-        
-        mutable map<Graphics::Color, Graphics::Color> cache;
-
-        Graphics::Color doFilter(int red, int green, int blue) const {
-            int newRed = red;
-            int newGreen = green;
-            int newBlue = blue;
-
-            if (color < 255){
-                double greyRed = (1 - 0.299) * color / 255 + 0.299;
-                double greyGreen = (1 - 0.587) * color / 255 + 0.587;
-                double greyBlue = (1 - 0.114) * color / 255 + 0.114;
-                red = (int)(red * greyRed + 0.5 + 16);
-                green = (int)(green * greyGreen + 0.5 + 16);
-                blue = (int)(blue * greyBlue + 0.5 + 16);
-            }
 
-            if (invert){
-                red = 255 - red;
-                green = 255 - green;
-                blue = 255 - blue;
-            }
-
-            if (period > 0){
-                newRed = (red + addRed + sinRed * sin(2 * PaintownUtil::pi * time / period)) * multiplyRed / 256;
-                newGreen = (green + addGreen + sinGreen * sin(2 * PaintownUtil::pi * time / period)) * multiplyGreen / 256;
-                newBlue = (blue + addBlue + sinBlue * sin(2 * PaintownUtil::pi * time / period)) * multiplyBlue / 256;
-            } else {
-                newRed = (red + addRed) * multiplyRed / 256;
-                newGreen = (green + addGreen) * multiplyGreen / 256;
-                newBlue = (blue + addBlue) * multiplyBlue / 256;
-            }
-
-            if (newRed > 255){
-                newRed = 255;
-            }
-
-            if (newRed < 0){
-                newRed = 0;
-            }
-
-            if (newGreen > 255){
-                newGreen = 255;
-            }
-
-            if (newGreen < 0){
-                newGreen = 0;
-            }
-
-            if (newBlue > 255){
-                newBlue = 255;
-            }
-
-            if (newBlue < 0){
-                newBlue = 0;
-            }
-
-            return Graphics::makeColor(newRed, newGreen, newBlue);
-        }
+        /* used by the software renderer, the shader does the same math */
+        ColorTable table;
 
         PaintownUtil::ReferenceCount<Graphics::Shader> shader;
 
@@ -3808,17 +3803,7 @@ class PaletteFilter: public Graphics::Bitmap::Filter {
         }
 
         Graphics::Color filter(Graphics::Color pixel) const {
-            
-            if (cache.find(pixel) != cache.end()){
-                return cache[pixel];
-            }
-
-            int red = Graphics::getRed(pixel);
-            int green = Graphics::getGreen(pixel);
-            int blue = Graphics::getBlue(pixel);
-            Graphics::Color out = doFilter(red, green, blue);
-            cache[pixel] = out;
-            return out;
+            return table.apply(pixel);
         }
     };
 
@@ -3987,6 +3972,7 @@ void Character::draw(Graphics::Bitmap * work, int cameraX, int cameraY){
         if (getAlliance() == Mugen::Stage::Player2Side){
             wx = work->getWidth() - width - 1;
         }
+        Atlas::Batch::flush();
         Graphics::Bitmap::transBlender(0, 0, 0, 128);
         work->translucent().rectangleFill(wx, wy, wx+width, wy+height, Graphics::makeColor(0, 0, 0));
         work->translucent().line(0, wy+height, wx+width, wy+height, Graphics::makeColor(64, 64, 64));
@@ -4330,6 +4316,7 @@ int Character::getSpritePriority() const {
 /* Replace the sprites from the given animation with sprites from our own sff file */
 PaintownUtil::ReferenceCount<Animation> Character::replaceSprites(const PaintownUtil::ReferenceCount<Animation> & animation){
     PaintownUtil::ReferenceCount<Animation> update = PaintownUtil::ReferenceCount<Animation>(new Animation(*animation));
+    update->ownFrames();
     const vector<Frame*> & frames = update->getFrames();
     for (vector<Frame*>::const_iterator it = frames.begin(); it != frames.end(); it++){
         Frame * frame = *it;
@@ -4656,25 +4643,7 @@ int Character::getAirFront() const {
 
 void Character::setStateData(const StateData & data){
     this->stateData = data;
-    const std::map<std::string, std::string > & serializedCommands = data.commandState;;
-
-    std::map<std::string, Command2*> commandMap;
-    const vector<Command2*> & commands = getCommands();
-    for (vector<Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
-        Command2 * command = *it;
-        commandMap[command->getName()] = command;
-    }
-
-    for (map<string, string>::const_iterator it = serializedCommands.begin(); it != serializedCommands.end(); it++){
-        string name = it->first;
-        string value = it->second;
-
-        Command2 * command = commandMap[name];
-        if (command != NULL){
-            TokenReader reader;
-            command->deserialize(reader.readTokenFromString(value));
-        }
-    }
+    getLocalData().commands.deserialize(data.commandState);
 }
 
 Character::LocalData::LocalData(){
@@ -19,6 +19,7 @@
 #include "common.h"
 #include "sprite.h"
 #include "character-state.h"
+#include "constraint.h"
 
 namespace Ast{
     class KeyList;
@@ -85,6 +86,52 @@ struct RecordingInformation{
     }
 };
 
+/* The commands of every tick of a match, for replaying it from a snapshot.
+ * Most ticks have the same commands as the tick before, so the ticks are
+ * kept as runs of equal commands and adding a tick usually just counts it.
+ * Ticks are indexed from 0.
+ */
+class CommandHistory{
+public:
+    CommandHistory();
+
+    /* commands of the tick after the last one */
+    void add(const std::vector<std::string> & commands);
+
+    /* replace the commands of a tick. ticks between the last one and this
+     * one get no commands.
+     */
+    void set(uint32_t tick, const std::vector<std::string> & commands);
+
+    /* no commands past the last tick */
+    const std::vector<std::string> & get(uint32_t tick) const;
+
+    inline uint32_t size() const {
+        return total;
+    }
+
+protected:
+    struct Run{
+        Run(const std::vector<std::string> & commands, uint32_t start, uint32_t ticks):
+        commands(commands),
+        start(start),
+        ticks(ticks){
+        }
+
+        std::vector<std::string> commands;
+        uint32_t start;
+        uint32_t ticks;
+    };
+
+    void append(const std::vector<std::string> & commands, uint32_t ticks);
+    /* index of the run the tick is in */
+    unsigned int find(uint32_t tick) const;
+
+    std::vector<Run> runs;
+    uint32_t total;
+    std::vector<std::string> none;
+};
+
 struct AfterImage{
     AfterImage():
         currentTime(0),
@@ -404,6 +451,13 @@ public:
         void setCurrentAnimationState(const AnimationState & state);
         void setStatePersistent(const std::map<int, std::map<uint32_t, int> > & statePersistent);
         void resetStatePersistent();
+        /* reset the persistent countdowns of the controllers in one state */
+        void resetStatePersistent(int state);
+
+        /* where the character's ast and controllers were made */
+        inline const Arena & getArena() const {
+            return *arena;
+        }
 
         virtual void drawReflection(Graphics::Bitmap * work, int rel_x, int rel_y, int intensity);
             
@@ -467,7 +521,13 @@ public:
         return getStateData().currentState;
     }
 
-    virtual std::map<int, std::map<uint32_t, int> > getStatePersistent() const;
+    virtual const std::map<int, std::map<uint32_t, int> > & getStatePersistent() const;
+
+    /* Values of expressions that only use this character's constants, by
+     * the key the compiler gave the expression. Not copied to helpers.
+     */
+    virtual bool getConstant(int key, RuntimeValue & out) const;
+    virtual void setConstant(int key, const RuntimeValue & value) const;
 
     /* Gets the state from this character regardless of what characterData holds */
     virtual PaintownUtil::ReferenceCount<State> getSelfState(int id) const;
@@ -1163,7 +1223,7 @@ public:
         const CharacterId & getId() const;
         void setId(const CharacterId & id);
 
-        virtual const std::vector<Command2 *> & getCommands() const;
+        virtual const CommandAutomaton & getCommands() const;
 
 protected:
     void initialize();
@@ -1180,7 +1240,7 @@ protected:
     virtual void loadCnsFile(const Filesystem::RelativePath & path);
     virtual void loadStateFile(const Filesystem::AbsolutePath & base, const std::string & path);
 
-    virtual void addCommand(Command2 * command);
+    virtual void addCommand(const Command2 & command);
 
     virtual void setConstant(std::string name, const std::vector<double> & values);
     virtual void setConstant(std::string name, double value);
@@ -1188,6 +1248,9 @@ protected:
     virtual std::vector<std::string> doInput(const Mugen::Stage & stage);
     virtual bool doStates(Mugen::Stage & stage, const std::vector<std::string> & active, int state);
 
+    /* true if the persistent countdown of the controller lets it activate */
+    bool persistentOk(int state, const StateController * controller);
+
     void resetJump(Mugen::Stage & stage, const std::vector<std::string> & inputs);
     void doubleJump(Mugen::Stage & stage, const std::vector<std::string> & inputs);
     void stopGuarding(Mugen::Stage & stage, const std::vector<std::string> & inputs);
@@ -1212,7 +1275,11 @@ public:
     virtual void setAfterImage(int time, int length, int timegap, int framegap, TransType effects, int paletteColor, bool invertColor, const AfterImage::RGBx & bright, const AfterImage::RGBx & contrast, const AfterImage::RGBx & postBright, const AfterImage::RGBx & add, const AfterImage::RGBx & multiply);
 
     void drawAfterImage(const AfterImage & afterImage, const AfterImage::Image & frame, int index, int x, int y, const Graphics::Bitmap & work);
-    void processAfterImages();
+    /* Counts down the afterimage timers. New frames are only kept if
+     * `record' is true, otherwise the frames are dropped since nothing will
+     * draw them.
+     */
+    void processAfterImages(bool record);
 
     virtual void setPaletteEffects(int time, int addRed, int addGreen, int addBlue, int multiplyRed, int multiplyGreen, int multiplyBlue, int sinRed, int sinGreen, int sinBlue, int period, int invert, int color);
     Graphics::Bitmap::Filter * getPaletteEffects(unsigned int time);
@@ -1228,6 +1295,15 @@ protected:
     unsigned int stateControllerId;
     unsigned int nextStateControllerId();
 
+    /* persistent countdown of each controller, by state number and then
+     * controller id. a controller without an entry is at its persistent
+     * value. the states themselves can be shared with helpers so the
+     * countdowns can't be kept in the controllers.
+     */
+    std::map<int, std::map<uint32_t, int> > statePersistent;
+
+    mutable std::map<int, RuntimeValue> constants;
+
     /* Data that doesn't have to be sent to remote instances */
     struct LocalData{
         LocalData();
@@ -1428,7 +1504,7 @@ protected:
         /* Commands, Triggers or whatever else we come up with */
         std::map<std::string, Constant> constants;
 
-        std::vector<Command2 *> commands;
+        CommandAutomaton commands;
 
         // Debug state
         bool debug;
@@ -1470,7 +1546,7 @@ protected:
         PaintownUtil::ReferenceCount<RecordingInformation> record;
 
         /* records entire history of inputs */
-        std::vector< std::vector<std::string > > inputHistory;
+        CommandHistory inputHistory;
 
         double max_health;
 
@@ -1504,6 +1580,11 @@ protected:
         double air_gethit_recover_yaccel;
     };
 
+    /* Holds the ast nodes and controllers made while loading. It comes
+     * before the data that uses it so it is destroyed last. Copies of the
+     * character share it.
+     */
+    PaintownUtil::ReferenceCount<Arena> arena;
     LocalData localData;
     StateData stateData;
 
@@ -6,6 +6,7 @@
 #include "config.h"
 #include "sprite.h"
 #include "animation.h"
+#include "atlas.h"
 #include "parse-cache.h"
 #include "font.h"
 #include "sound.h"
@@ -1544,6 +1545,9 @@ GameInfo::GameInfo(const Filesystem::AbsolutePath & fightFile){
                         simple.view() >> sff;
                         Global::debug(1) << "Got Sprite File: '" << sff << "'" << endl;
                         Util::readSprites(Util::findFile(Filesystem::RelativePath(sff)), Filesystem::AbsolutePath(), self.sprites, true);
+                        if (Atlas::isEnabled()){
+                            Atlas::pack(self.sprites);
+                        }
                         /*
                         for( Mugen::SpriteMap::iterator i = self.sprites.begin() ; i != self.sprites.end() ; ++i ){
                             // Load these sprites so they are ready to use
@@ -2187,6 +2191,16 @@ void GameInfo::act(Mugen::Stage & stage, Mugen::Character & player1, Mugen::Char
     combo.act(player1, player2);
     roundControl.act(stage, player1, player2);
     winIconDisplay.act(player1, player2);
+    checkRound(stage, player1, player2);
+}
+
+void GameInfo::simulate(Mugen::Stage & stage, Mugen::Character & player1, Mugen::Character & player2){
+    timer.act();
+    roundControl.act(stage, player1, player2);
+    checkRound(stage, player1, player2);
+}
+
+void GameInfo::checkRound(Mugen::Stage & stage, Mugen::Character & player1, Mugen::Character & player2){
     if (roundControl.getState() == Round::PlayingGame){
         if (!timer.isStarted()){
             timer.reset();
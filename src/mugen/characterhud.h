@@ -808,6 +808,11 @@ class GameInfo{
 	virtual ~GameInfo();
 
         virtual void act(Mugen::Stage & stage, Mugen::Character & player1, Mugen::Character & player2);
+        /* Only the parts of act() that change the state of the match, the
+         * timer and the round, in the same order as act(). The bars, faces,
+         * names, combo counter and win icons are left alone.
+         */
+        virtual void simulate(Mugen::Stage & stage, Mugen::Character & player1, Mugen::Character & player2);
         virtual void render(const Element::Layer &, const Graphics::Bitmap &);
 
         virtual void reset(Mugen::Stage & stage, Mugen::Character & player1, Mugen::Character & player2);
@@ -840,6 +845,8 @@ class GameInfo{
     private:
         
         void parseAnimations(const PaintownUtil::ReferenceCount<Ast::AstParse> & parsed);
+        /* starts the timer and ends the round on time over or a knock out */
+        void checkRound(Mugen::Stage & stage, Mugen::Character & player1, Mugen::Character & player2);
 	
 	//! Player Data
 	Bar player1LifeBar;
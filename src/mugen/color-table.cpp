@@ -0,0 +1,65 @@
+#include <math.h>
+#include <r-tech1/funcs.h>
+#include "color-table.h"
+
+namespace PaintownUtil = ::Util;
+
+namespace Mugen{
+
+ColorTable::ColorTable(){
+    for (int i = 0; i < 256; i++){
+        set(i, i, i, i);
+    }
+}
+
+/* One component of palfx. The doubles are the parts that are the same for
+ * every value, they are worked out once by palette().
+ */
+static unsigned char paletteComponent(int value, int add, int multiply, int sinAmount, double wave, double grey, int period, int invert, int color){
+    if (color < 255){
+        value = (int)(value * grey + 0.5 + 16);
+    }
+
+    if (invert){
+        value = 255 - value;
+    }
+
+    int out = 0;
+    if (period > 0){
+        out = (value + add + sinAmount * wave) * multiply / 256;
+    } else {
+        out = (value + add) * multiply / 256;
+    }
+
+    if (out > 255){
+        out = 255;
+    }
+
+    if (out < 0){
+        out = 0;
+    }
+
+    return out;
+}
+
+ColorTable ColorTable::palette(int time, int addRed, int addGreen, int addBlue, int multiplyRed, int multiplyGreen, int multiplyBlue, int sinRed, int sinGreen, int sinBlue, int period, int invert, int color){
+    double greyRed = (1 - 0.299) * color / 255 + 0.299;
+    double greyGreen = (1 - 0.587) * color / 255 + 0.587;
+    double greyBlue = (1 - 0.114) * color / 255 + 0.114;
+
+    double wave = 0;
+    if (period > 0){
+        wave = sin(2 * PaintownUtil::pi * time / period);
+    }
+
+    ColorTable out;
+    for (int i = 0; i < 256; i++){
+        out.set(i, paletteComponent(i, addRed, multiplyRed, sinRed, wave, greyRed, period, invert, color),
+                   paletteComponent(i, addGreen, multiplyGreen, sinGreen, wave, greyGreen, period, invert, color),
+                   paletteComponent(i, addBlue, multiplyBlue, sinBlue, wave, greyBlue, period, invert, color));
+    }
+
+    return out;
+}
+
+}
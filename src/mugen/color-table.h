@@ -0,0 +1,46 @@
+#ifndef _paintown_mugen_color_table_h
+#define _paintown_mugen_color_table_h
+
+#include <r-tech1/graphics/bitmap.h>
+
+namespace Mugen{
+
+/* A color effect where each of red, green and blue only depends on its own
+ * old value, which is true of palfx, the stage's palette effects and the
+ * afterimage effects. The effect is worked out once for all 256 values of
+ * each component when it is made, so filtering a pixel is three lookups
+ * instead of doing the math (and a sin() or pow()) for every color a sprite
+ * uses.
+ */
+class ColorTable{
+public:
+    /* leaves colors as they are */
+    ColorTable();
+
+    /* PalFX and the stage's PalFX
+     *   time - ticks since the effect started, for the sin part
+     *   color - 255 is full color, 0 is grey
+     */
+    static ColorTable palette(int time, int addRed, int addGreen, int addBlue, int multiplyRed, int multiplyGreen, int multiplyBlue, int sinRed, int sinGreen, int sinBlue, int period, int invert, int color);
+
+    inline void set(int value, unsigned char red, unsigned char green, unsigned char blue){
+        this->red[value] = red;
+        this->green[value] = green;
+        this->blue[value] = blue;
+    }
+
+    inline Graphics::Color apply(Graphics::Color pixel) const {
+        return Graphics::makeColor(red[Graphics::getRed(pixel)],
+                                   green[Graphics::getGreen(pixel)],
+                                   blue[Graphics::getBlue(pixel)]);
+    }
+
+protected:
+    unsigned char red[256];
+    unsigned char green[256];
+    unsigned char blue[256];
+};
+
+}
+
+#endif
@@ -182,13 +182,15 @@ Win
 #include "character.h"
 #include "helper.h"
 #include "random.h"
+#include "simulation.h"
 #include "stage.h"
 #include <r-tech1/funcs.h>
 #include <r-tech1/regex.h>
+#include <r-tech1/debug.h>
+#include <r-tech1/thread.h>
 #include <math.h>
 #include <sstream>
 #include <string>
-#include "config.h"
 #include "projectile.h"
 
 namespace PaintownUtil = ::Util;
@@ -506,33 +508,86 @@ RuntimeValue EmptyEnvironment::getArg1() const {
     throw MugenException("Cannot get arg1 from an empty environment", __FILE__, __LINE__);
 }
                         
-template<class ReturnType> Compiler::Value * getCharacterField(ReturnType (Character::*getter)() const, const std::string & name){
+/* Whether a getter's return type becomes a Double or a Bool */
+template<class Type> struct IsNumber{
+    enum { value = 0 };
+};
+
+template<> struct IsNumber<int>{
+    enum { value = 1 };
+};
+
+template<> struct IsNumber<double>{
+    enum { value = 1 };
+};
+
+template<> struct IsNumber<bool>{
+    enum { value = 1 };
+};
+
+template<class Type> static inline double asNumber(const Type & value){
+    return RuntimeValue(value).toNumber();
+}
+
+static inline double asNumber(int value){
+    return value;
+}
+
+static inline double asNumber(double value){
+    return value;
+}
+
+static inline double asNumber(bool value){
+    return value ? 1 : 0;
+}
+
+template<class ReturnType> Compiler::Value * getCharacterField(ReturnType (Character::*getter)() const, const std::string & name, Compiler::Constness constness = Compiler::Varying){
     class CharacterGetter: public Compiler::Value {
     public:
-        CharacterGetter(ReturnType (Character::*getter)() const, const std::string & name):
+        CharacterGetter(ReturnType (Character::*getter)() const, const std::string & name, Compiler::Constness constness):
         getter(getter),
-        name(name){
+        name(name),
+        constant(constness){
         }
         
         ReturnType (Character::*getter)() const;
         const std::string name;
+        const Compiler::Constness constant;
 
         RuntimeValue evaluate(const Environment & environment) const {
             const Character & guy = environment.getCharacter();
             return RuntimeValue((guy.*getter)());
         }
 
+        double evaluateNumber(const Environment & environment) const {
+            const Character & guy = environment.getCharacter();
+            return asNumber((guy.*getter)());
+        }
+
+        bool isNumber() const {
+            return IsNumber<ReturnType>::value;
+        }
+
         std::string toString() const {
             return name;
         }
 
+        Compiler::Constness constness() const {
+            return constant;
+        }
+
         Compiler::Value * copy() const {
-            return new CharacterGetter(getter, name);
+            return new CharacterGetter(getter, name, constant);
         }
 
     };
 
-    return new CharacterGetter(getter, name);
+    return new CharacterGetter(getter, name, constness);
+}
+
+/* A field that is loaded from the character's files and never changes */
+template<class ReturnType> Compiler::Value * getCharacterConstant(ReturnType (Character::*getter)() const, const std::string & name){
+    return getCharacterField(getter, name, Compiler::CharacterConstant);
 }
 
 }
@@ -548,6 +603,226 @@ void runtimeError(const std::string & fail, const std::string & where, int line)
     throw MugenNormalRuntimeException(fail, where, line);
 }
 
+static bool showOptimizations = false;
+
+void setShowOptimizations(bool show){
+    showOptimizations = show;
+}
+
+static bool shareTriggers = true;
+
+void setShareTriggers(bool share){
+    shareTriggers = share;
+}
+
+/* Expressions with the same text get the same key. Characters can be loaded
+ * on different threads so the table is locked.
+ */
+static PaintownUtil::Thread::LockObject expressionKeysLock;
+static map<string, int> expressionKeys;
+
+static int expressionKey(const string & text, bool & seen){
+    PaintownUtil::Thread::ScopedLock scoped(expressionKeysLock);
+    map<string, int>::iterator found = expressionKeys.find(text);
+    seen = found != expressionKeys.end();
+    if (seen){
+        return found->second;
+    }
+    int key = expressionKeys.size();
+    expressionKeys[text] = key;
+    return key;
+}
+
+static Constness combine(Constness left, Constness right){
+    return left > right ? left : right;
+}
+
+namespace{
+
+/* The result of a constant expression, computed when it was compiled */
+class Folded: public Value {
+public:
+    Folded(const RuntimeValue & value, const string & text):
+    value(value),
+    text(text){
+    }
+
+    RuntimeValue value;
+    string text;
+
+    RuntimeValue evaluate(const Environment & environment) const {
+        return value;
+    }
+
+    double evaluateNumber(const Environment & environment) const {
+        return value.toNumber();
+    }
+
+    bool evaluateBool(const Environment & environment) const {
+        return value.toBool();
+    }
+
+    bool isNumber() const {
+        return value.isDouble() || value.isBool();
+    }
+
+    string toString() const {
+        return text;
+    }
+
+    Constness constness() const {
+        return Constant;
+    }
+
+    Value * copy() const {
+        return new Folded(value, text);
+    }
+};
+
+/* An expression that only uses the character's constants. Each character
+ * computes it the first time it is needed and keeps the result.
+ */
+class CharacterCached: public Value {
+public:
+    CharacterCached(Value * value, int key):
+    value(value),
+    key(key){
+    }
+
+    Value * value;
+    int key;
+
+    virtual ~CharacterCached(){
+        delete value;
+    }
+
+    /* take the expression back, used when it becomes part of a bigger one */
+    Value * release(){
+        Value * out = value;
+        value = NULL;
+        return out;
+    }
+
+    RuntimeValue evaluate(const Environment & environment) const {
+        const Character & guy = environment.getCharacter();
+        RuntimeValue out;
+        if (!guy.getConstant(key, out)){
+            out = value->evaluate(environment);
+            guy.setConstant(key, out);
+        }
+        return out;
+    }
+
+    bool isNumber() const {
+        return value->isNumber();
+    }
+
+    string toString() const {
+        return value->toString();
+    }
+
+    Constness constness() const {
+        return CharacterConstant;
+    }
+
+    Value * copy() const {
+        return new CharacterCached(Compiler::copy(value), key);
+    }
+};
+
+/* A trigger that looks in the environment's TriggerCache before evaluating */
+class SharedTrigger: public Value {
+public:
+    SharedTrigger(Value * value, int key):
+    value(value),
+    key(key){
+    }
+
+    Value * value;
+    int key;
+
+    virtual ~SharedTrigger(){
+        delete value;
+    }
+
+    RuntimeValue evaluate(const Environment & environment) const {
+        TriggerCache * cache = environment.getCache();
+        if (cache == NULL){
+            return value->evaluate(environment);
+        }
+        RuntimeValue out;
+        if (!cache->get(key, out)){
+            out = value->evaluate(environment);
+            cache->set(key, out);
+        }
+        return out;
+    }
+
+    bool isNumber() const {
+        return value->isNumber();
+    }
+
+    string toString() const {
+        return value->toString();
+    }
+
+    Constness constness() const {
+        return value->constness();
+    }
+
+    Value * copy() const {
+        return new SharedTrigger(Compiler::copy(value), key);
+    }
+};
+
+/* Strips the per character cache off an expression that is about to become
+ * part of a bigger per character constant, which will be cached instead.
+ */
+Value * uncache(Value * value){
+    CharacterCached * cached = dynamic_cast<CharacterCached*>(value);
+    if (cached != NULL){
+        Value * out = cached->release();
+        delete cached;
+        return out;
+    }
+    return value;
+}
+
+/* Constant expressions are computed now, per character constants are
+ * wrapped so they are computed once per character. `source' is what `value'
+ * was compiled from.
+ */
+Value * optimize(Value * value, const Ast::Value & source){
+    switch (value->constness()){
+        case Constant: {
+            try{
+                RuntimeValue result = value->evaluate(EmptyEnvironment());
+                Folded * folded = new Folded(result, value->toString());
+                if (showOptimizations){
+                    Global::debug(0, "compiler") << "Folded `" << source.toString() << "'" << std::endl;
+                }
+                delete value;
+                return folded;
+            } catch (const MugenException & fail){
+                /* leave it to fail at runtime like it used to */
+                return value;
+            }
+        }
+        case CharacterConstant: {
+            bool seen = false;
+            int key = expressionKey(source.toString(), seen);
+            if (showOptimizations){
+                Global::debug(0, "compiler") << "Cached per character `" << source.toString() << "'" << std::endl;
+            }
+            return new CharacterCached(value, key);
+        }
+        case Varying: break;
+    }
+    return value;
+}
+
+}
+
 namespace{
 
 class CompileWalker: public Ast::Walker {
@@ -829,6 +1104,14 @@ public:
                     return RuntimeValue(environment.getCharacter().getAnimation());
                 }
 
+                double evaluateNumber(const Environment & environment) const {
+                    return environment.getCharacter().getAnimation();
+                }
+
+                bool isNumber() const {
+                    return true;
+                }
+
                 virtual std::string toString() const {
                     return "anim";
                 }
@@ -1827,6 +2110,14 @@ public:
                     return RuntimeValue(environment.getCharacter().getStateTime());
                 }
 
+                double evaluateNumber(const Environment & environment) const {
+                    return environment.getCharacter().getStateTime();
+                }
+
+                bool isNumber() const {
+                    return true;
+                }
+
                 virtual std::string toString() const {
                     return "Time";
                 }
@@ -1873,6 +2164,18 @@ public:
                     return RuntimeValue(environment.getCharacter().hasControl());
                 }
 
+                bool evaluateBool(const Environment & environment) const {
+                    return environment.getCharacter().hasControl();
+                }
+
+                double evaluateNumber(const Environment & environment) const {
+                    return environment.getCharacter().hasControl() ? 1 : 0;
+                }
+
+                bool isNumber() const {
+                    return true;
+                }
+
                 virtual std::string toString() const {
                     return "ctrl";
                 }
@@ -1929,6 +2232,14 @@ public:
                     return RuntimeValue(environment.getCharacter().getCurrentState());
                 }
 
+                double evaluateNumber(const Environment & environment) const {
+                    return environment.getCharacter().getCurrentState();
+                }
+
+                bool isNumber() const {
+                    return true;
+                }
+
                 virtual std::string toString() const {
                     return "stateno";
                 }
@@ -2053,7 +2364,7 @@ public:
         }
         
         if (identifier == "tickspersecond"){
-            return compile(Mugen::Data::getInstance().getGameSpeed());
+            return compile(Mugen::Simulation::current().getGameSpeed());
         }
 
         std::ostringstream out;
@@ -2411,6 +2722,10 @@ public:
                 return new JustString(*this);
             }
 
+            Constness constness() const {
+                return Constant;
+            }
+
             virtual std::string toString() const {
                 return value.getStringValue();
             }
@@ -2452,11 +2767,27 @@ public:
                 return new JustNumber(*this);
             }
 
+            Constness constness() const {
+                return Constant;
+            }
+
             RuntimeValue value;
 
             RuntimeValue evaluate(const Environment & environment) const {
                 return value;
             }
+
+            double evaluateNumber(const Environment & environment) const {
+                return value.getDoubleValue();
+            }
+
+            bool evaluateBool(const Environment & environment) const {
+                return value.getDoubleValue() != 0;
+            }
+
+            bool isNumber() const {
+                return true;
+            }
         };
 
         double x;
@@ -2561,7 +2892,7 @@ public:
 
                 Value * compileConst(const Ast::Identifier & identifier){
                     if (identifier == "data.life"){
-                        return getCharacterField(&Character::getMaxHealth, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getMaxHealth, identifier.toLowerString());
                     }
                     
                     if (identifier == "data.power"){
@@ -2574,11 +2905,11 @@ public:
                     }
                     
                     if (identifier == "data.defence"){
-                        return getCharacterField(&Character::getDefense, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getDefense, identifier.toLowerString());
                     }
 
                     if (identifier == "data.attack"){
-                        return getCharacterField(&Character::getAttack, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAttack, identifier.toLowerString());
                     }
 
                     if (identifier == "data.fall.defence_mul"){
@@ -2645,59 +2976,59 @@ public:
                     }
 
                     if (identifier == "movement.airjump.num"){
-                        return getCharacterField(&Character::getExtraJumps, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getExtraJumps, identifier.toLowerString());
                     }
 
                     if (identifier == "movement.airjump.height"){
-                        return getCharacterField(&Character::getAirJumpHeight, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirJumpHeight, identifier.toLowerString());
                     }
 
                     if (identifier == "movement.yaccel"){
-                        return getCharacterField(&Character::getGravity, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getGravity, identifier.toLowerString());
                     }
                     
                     if (identifier == "movement.crouch.friction"){
-                        return getCharacterField(&Character::getCrouchingFriction, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getCrouchingFriction, identifier.toLowerString());
                     }
 
                     if (identifier == "movement.crouch.friction.threshold"){
-                        return getCharacterField(&Character::getCrouchingFrictionThreshold, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getCrouchingFrictionThreshold, identifier.toLowerString());
                     }
 
                     if (identifier == "movement.stand.friction"){
-                        return getCharacterField(&Character::getStandingFriction, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getStandingFriction, identifier.toLowerString());
                     }
 
                     if (identifier == "movement.stand.friction.threshold"){
-                        return getCharacterField(&Character::getStandingFrictionThreshold, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getStandingFrictionThreshold, identifier.toLowerString());
                     }
 
                     if (identifier == "movement.jump.changeanim.threshold"){
-                        return getCharacterField(&Character::getJumpChangeAnimationThreshold, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getJumpChangeAnimationThreshold, identifier.toLowerString());
                     }
 
                     if (identifier == "movement.air.gethit.groundlevel"){
-                        return getCharacterField(&Character::getAirGetHitGroundLevel, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirGetHitGroundLevel, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.walk.back.x"){
-                        return getCharacterField(&Character::getWalkBackX, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getWalkBackX, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.walk.fwd.x"){
-                        return getCharacterField(&Character::getWalkForwardX, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getWalkForwardX, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.run.fwd.x"){
-                        return getCharacterField(&Character::getRunForwardX, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getRunForwardX, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.run.fwd.y"){
-                        return getCharacterField(&Character::getRunForwardY, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getRunForwardY, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.jump.neu.x"){
-                        return getCharacterField(&Character::getNeutralJumpingX, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getNeutralJumpingX, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.jump.y" ||
@@ -2705,35 +3036,35 @@ public:
                          * jump.y, but some characters use it anyway (Gouki)
                          */
                         identifier == "velocity.runjump.y"){
-                        return getCharacterField(&Character::getNeutralJumpingY, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getNeutralJumpingY, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.runjump.back.x"){
-                        return getCharacterField(&Character::getRunJumpBack, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getRunJumpBack, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.run.back.x"){
-                        return getCharacterField(&Character::getRunBackX, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getRunBackX, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.run.back.y"){
-                        return getCharacterField(&Character::getRunBackY, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getRunBackY, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.jump.back.x"){
-                        return getCharacterField(&Character::getJumpBack, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getJumpBack, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.jump.fwd.x"){
-                        return getCharacterField(&Character::getJumpForward, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getJumpForward, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.runjump.fwd.x"){
-                        return getCharacterField(&Character::getRunJumpForward, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getRunJumpForward, identifier.toLowerString());
                     }
                        
                     if (identifier == "movement.air.gethit.airrecover.yaccel"){
-                        return getCharacterField(&Character::getAirHitRecoverYAccel, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirHitRecoverYAccel, identifier.toLowerString());
                     }
 
                     /* FIXME others
@@ -2748,99 +3079,99 @@ public:
                        movement.down.friction.threshold: Returns value of the "down.friction.threshold" parameter. (float)
                        */
                     if (identifier == "velocity.air.gethit.airrecover.mul.x"){
-                        return getCharacterField(&Character::getAirHitRecoverMultiplierX, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirHitRecoverMultiplierX, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.air.gethit.airrecover.mul.y"){
-                        return getCharacterField(&Character::getAirHitRecoverMultiplierY, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirHitRecoverMultiplierY, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.air.gethit.groundrecover.x"){
-                        return getCharacterField(&Character::getAirHitGroundRecoverX, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirHitGroundRecoverX, identifier.toLowerString());
                     }
                     
                     if (identifier == "velocity.air.gethit.groundrecover.y"){
-                        return getCharacterField(&Character::getAirHitGroundRecoverY, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirHitGroundRecoverY, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.air.gethit.airrecover.add.x"){
-                        return getCharacterField(&Character::getAirHitRecoverAddX, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirHitRecoverAddX, identifier.toLowerString());
                     }
                     
                     if (identifier == "velocity.air.gethit.airrecover.add.y"){
-                        return getCharacterField(&Character::getAirHitRecoverAddY, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirHitRecoverAddY, identifier.toLowerString());
                     }
                      
                     if (identifier == "velocity.air.gethit.airrecover.up"){
-                        return getCharacterField(&Character::getAirHitRecoverUp, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirHitRecoverUp, identifier.toLowerString());
                     }
                     
                     if (identifier == "velocity.air.gethit.airrecover.down"){
-                        return getCharacterField(&Character::getAirHitRecoverDown, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirHitRecoverDown, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.air.gethit.airrecover.fwd"){
-                        return getCharacterField(&Character::getAirHitRecoverForward, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirHitRecoverForward, identifier.toLowerString());
                     }
                     
                     if (identifier == "velocity.air.gethit.airrecover.back"){
-                        return getCharacterField(&Character::getAirHitRecoverBack, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirHitRecoverBack, identifier.toLowerString());
                     }
                      
                     if (identifier == "velocity.airjump.neu.x"){
-                        return getCharacterField(&Character::getAirJumpNeutralX, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirJumpNeutralX, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.airjump.y"){
-                        return getCharacterField(&Character::getAirJumpNeutralY, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirJumpNeutralY, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.airjump.back.x"){
-                        return getCharacterField(&Character::getAirJumpBack, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirJumpBack, identifier.toLowerString());
                     }
 
                     if (identifier == "velocity.airjump.fwd.x"){
-                        return getCharacterField(&Character::getAirJumpForward, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirJumpForward, identifier.toLowerString());
                     }
                     
                     if (identifier == "size.xscale"){
-                        return getCharacterField(&Character::getXScale, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getXScale, identifier.toLowerString());
                     }
                     
                     if (identifier == "size.yscale"){
-                        return getCharacterField(&Character::getYScale, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getYScale, identifier.toLowerString());
                     }
                     
                     if (identifier == "size.ground.back"){
-                        return getCharacterField(&Character::getGroundBack, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getGroundBack, identifier.toLowerString());
                     }
 
                     if (identifier == "size.ground.front"){
-                        return getCharacterField(&Character::getGroundFront, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getGroundFront, identifier.toLowerString());
                     }
 
                     if (identifier == "size.air.back"){
-                        return getCharacterField(&Character::getAirBack, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirBack, identifier.toLowerString());
                     }
 
                     if (identifier == "size.air.front"){
-                        return getCharacterField(&Character::getAirFront, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAirFront, identifier.toLowerString());
                     }
 
                     if (identifier == "size.height"){
-                        return getCharacterField(&Character::getHeight, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getHeight, identifier.toLowerString());
                     }
 
                     if (identifier == "size.attack.dist"){
-                        return getCharacterField(&Character::getAttackDistance, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getAttackDistance, identifier.toLowerString());
                     }
 
                     if (identifier == "size.proj.attack.dist"){
-                        return getCharacterField(&Character::getProjectileAttackDistance, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getProjectileAttackDistance, identifier.toLowerString());
                     }
 
                     if (identifier == "size.proj.doscale"){
-                        return getCharacterField(&Character::getProjectileScale, identifier.toLowerString());
+                        return getCharacterConstant(&Character::getProjectileScale, identifier.toLowerString());
                     }
 
                     if (identifier == "size.head.pos.x"){
@@ -4521,6 +4852,10 @@ public:
                 return new Unary(Compiler::copy(expression), type);
             }
 
+            Constness constness() const {
+                return expression->constness();
+            }
+
             RuntimeValue evaluate(const Environment & environment) const {
                 switch (type){
                     case Ast::ExpressionUnary::Not : {
@@ -4535,6 +4870,33 @@ public:
                     default: compileError("Can't get here", __FILE__, __LINE__); return RuntimeValue();
                 }
             }
+
+            double evaluateNumber(const Environment & environment) const {
+                switch (type){
+                    case Ast::ExpressionUnary::Not : {
+                        return !expression->evaluateBool(environment) ? 1 : 0;
+                    }
+                    case Ast::ExpressionUnary::Minus : {
+                        return -expression->evaluateNumber(environment);
+                    }
+                    case Ast::ExpressionUnary::Negation : {
+                        return ~(int) expression->evaluateNumber(environment);
+                    }
+                    default: compileError("Can't get here", __FILE__, __LINE__); return 0;
+                }
+            }
+
+            bool evaluateBool(const Environment & environment) const {
+                if (type == Ast::ExpressionUnary::Not){
+                    return !expression->evaluateBool(environment);
+                }
+                return evaluateNumber(environment) != 0;
+            }
+
+            /* not gives a bool, the others a double */
+            bool isNumber() const {
+                return true;
+            }
         };
 
         switch (expression.getExpressionType()){
@@ -4550,7 +4912,7 @@ public:
             }
         }
 
-        return new Unary(compile(expression.getExpression()), expression.getExpressionType());
+        return optimize(new Unary(uncache(compile(expression.getExpression())), expression.getExpressionType()), expression);
     }
     
     virtual void onExpressionUnary(const Ast::ExpressionUnary & expression){
@@ -4565,6 +4927,14 @@ public:
                     return RuntimeValue(environment.getCharacter().getXVelocity());
                 }
 
+                double evaluateNumber(const Environment & environment) const {
+                    return environment.getCharacter().getXVelocity();
+                }
+
+                bool isNumber() const {
+                    return true;
+                }
+
                 virtual std::string toString() const {
                     return "vel x";
                 }
@@ -4584,6 +4954,14 @@ public:
                     return RuntimeValue(environment.getCharacter().getYVelocity());
                 }
 
+                double evaluateNumber(const Environment & environment) const {
+                    return environment.getCharacter().getYVelocity();
+                }
+
+                bool isNumber() const {
+                    return true;
+                }
+
                 std::string toString() const {
                     return "vel y";
                 }
@@ -4671,6 +5049,14 @@ public:
                     return RuntimeValue(environment.getCharacter().getYPosition());
                 }
 
+                double evaluateNumber(const Environment & environment) const {
+                    return environment.getCharacter().getYPosition();
+                }
+
+                bool isNumber() const {
+                    return true;
+                }
+
                 virtual std::string toString() const {
                     return "pos y";
                 }
@@ -4690,6 +5076,14 @@ public:
                     return RuntimeValue(environment.getCharacter().getX());
                 }
 
+                double evaluateNumber(const Environment & environment) const {
+                    return environment.getCharacter().getX();
+                }
+
+                bool isNumber() const {
+                    return true;
+                }
+
                 std::string toString() const {
                     return "pos x";
                 }
@@ -4912,6 +5306,10 @@ public:
                 return new Infix(Compiler::copy(left), Compiler::copy(right->copy()), type);
             }
 
+            Constness constness() const {
+                return combine(left->constness(), right->constness());
+            }
+
             std::string toString() const {
                 std::ostringstream out;
                 out << left->toString();
@@ -5076,9 +5474,131 @@ public:
                 runtimeError("Can't get here", __FILE__, __LINE__);
                 return RuntimeValue();
             }
+
+            /* comparisons are only done on doubles if both sides are numbers,
+             * otherwise strings, ranges and state types compare like they do
+             * in evaluate()
+             */
+            bool compareNumbers() const {
+                return left->isNumber() && right->isNumber();
+            }
+
+            double evaluateNumber(const Environment & environment) const {
+                switch (type){
+                    case ExpressionInfix::BitwiseOr : {
+                        return ((int) left->evaluateNumber(environment)) |
+                               ((int) right->evaluateNumber(environment));
+                    }
+                    case ExpressionInfix::BitwiseXOr : {
+                        return ((int) left->evaluateNumber(environment)) ^
+                               ((int) right->evaluateNumber(environment));
+                    }
+                    case ExpressionInfix::BitwiseAnd : {
+                        return ((int) left->evaluateNumber(environment)) &
+                               ((int) right->evaluateNumber(environment));
+                    }
+                    case ExpressionInfix::Assignment : {
+                        return 0;
+                    }
+                    case ExpressionInfix::Add : {
+                        return left->evaluateNumber(environment) + right->evaluateNumber(environment);
+                    }
+                    case ExpressionInfix::Subtract : {
+                        return left->evaluateNumber(environment) - right->evaluateNumber(environment);
+                    }
+                    case ExpressionInfix::Multiply : {
+                        return left->evaluateNumber(environment) * right->evaluateNumber(environment);
+                    }
+                    case ExpressionInfix::Divide : {
+                        return left->evaluateNumber(environment) / right->evaluateNumber(environment);
+                    }
+                    case ExpressionInfix::Modulo : {
+                        int result_left = (int) left->evaluateNumber(environment);
+                        int result_right = (int) right->evaluateNumber(environment);
+                        if (result_right == 0){
+                            runtimeError("mod by 0", __FILE__, __LINE__);
+                        }
+                        return result_left % result_right;
+                    }
+                    case ExpressionInfix::Power : {
+                        return pow(left->evaluateNumber(environment), right->evaluateNumber(environment));
+                    }
+                    default : {
+                        /* the rest give a bool */
+                        return evaluateBool(environment) ? 1 : 0;
+                    }
+                }
+            }
+
+            bool evaluateBool(const Environment & environment) const {
+                switch (type){
+                    case ExpressionInfix::Or : {
+                        return left->evaluateBool(environment) ||
+                               right->evaluateBool(environment);
+                    }
+                    case ExpressionInfix::XOr : {
+                        return left->evaluateBool(environment) ^
+                               right->evaluateBool(environment);
+                    }
+                    case ExpressionInfix::And : {
+                        return left->evaluateBool(environment) &&
+                               right->evaluateBool(environment);
+                    }
+                    case ExpressionInfix::Equals : {
+                        if (compareNumbers()){
+                            return fabs(left->evaluateNumber(environment) - right->evaluateNumber(environment)) < 0.0000001;
+                        }
+                        return left->evaluate(environment) == right->evaluate(environment);
+                    }
+                    case ExpressionInfix::Unequals : {
+                        if (compareNumbers()){
+                            return !(fabs(left->evaluateNumber(environment) - right->evaluateNumber(environment)) < 0.0000001);
+                        }
+                        return !(left->evaluate(environment) == right->evaluate(environment));
+                    }
+                    case ExpressionInfix::GreaterThanEquals : {
+                        if (compareNumbers()){
+                            return left->evaluateNumber(environment) >= right->evaluateNumber(environment);
+                        }
+                        return left->evaluate(environment) >= right->evaluate(environment);
+                    }
+                    case ExpressionInfix::GreaterThan : {
+                        if (compareNumbers()){
+                            return left->evaluateNumber(environment) > right->evaluateNumber(environment);
+                        }
+                        return left->evaluate(environment) > right->evaluate(environment);
+                    }
+                    case ExpressionInfix::LessThanEquals : {
+                        if (compareNumbers()){
+                            return left->evaluateNumber(environment) <= right->evaluateNumber(environment);
+                        }
+                        return left->evaluate(environment) <= right->evaluate(environment);
+                    }
+                    case ExpressionInfix::LessThan : {
+                        if (compareNumbers()){
+                            return left->evaluateNumber(environment) < right->evaluateNumber(environment);
+                        }
+                        return left->evaluate(environment) < right->evaluate(environment);
+                    }
+                    default : {
+                        return evaluateNumber(environment) != 0;
+                    }
+                }
+            }
+
+            /* every operator gives a double or a bool */
+            bool isNumber() const {
+                return true;
+            }
         };
 
-        return new Infix(compile(expression.getLeft()), compile(expression.getRight()), expression.getExpressionType());
+        Value * left = compile(expression.getLeft());
+        Value * right = compile(expression.getRight());
+        if (combine(left->constness(), right->constness()) == CharacterConstant){
+            left = uncache(left);
+            right = uncache(right);
+        }
+        return optimize(new Infix(left, right, expression.getExpressionType()), expression);
 
         /*
         std::ostringstream out;
@@ -5127,9 +5647,45 @@ std::string Value::toString() const {
     return out.str();
 }
 
+Constness Value::constness() const {
+    return Varying;
+}
+
+double Value::evaluateNumber(const Environment & environment) const {
+    return evaluate(environment).toNumber();
+}
+
+bool Value::evaluateBool(const Environment & environment) const {
+    return evaluate(environment).toBool();
+}
+
+bool Value::isNumber() const {
+    return false;
+}
+
 Value::~Value(){
 }
 
+static bool typedEvaluation = true;
+
+void setTypedEvaluation(bool typed){
+    typedEvaluation = typed;
+}
+
+double evaluateNumber(const Value * value, const Environment & environment){
+    if (typedEvaluation){
+        return value->evaluateNumber(environment);
+    }
+    return value->evaluate(environment).toNumber();
+}
+
+bool evaluateBool(const Value * value, const Environment & environment){
+    if (typedEvaluation){
+        return value->evaluateBool(environment);
+    }
+    return value->evaluate(environment).toBool();
+}
+
 /* Ast object -> Compiled object
  * Caller must delete the result at some point.
  */
@@ -5181,5 +5737,27 @@ Value * copy(Value * value){
     return NULL;
 }
 
+Value * compileTrigger(const Ast::Value * input){
+    Value * compiled = compile(input);
+
+    /* identifiers and numbers are cheaper to evaluate than to look up, and
+     * random has to be called every time
+     */
+    string type = input->getType();
+    if (!shareTriggers ||
+        compiled->constness() != Varying ||
+        (type != "infix expression" && type != "unary expression" && type != "function" && type != "helper") ||
+        PaintownUtil::lowerCaseAll(input->toString()).find("random") != string::npos){
+        return compiled;
+    }
+
+    bool seen = false;
+    int key = expressionKey(input->toString(), seen);
+    if (showOptimizations && seen){
+        Global::debug(0, "compiler") << "Shared trigger `" << input->toString() << "'" << std::endl;
+    }
+    return new SharedTrigger(compiled, key);
+}
+
 }
 }
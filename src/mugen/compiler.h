@@ -3,7 +3,9 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include "common.h"
+#include "arena.h"
 
 namespace Ast{
     class Value;
@@ -205,6 +207,38 @@ public:
     Range range;
 };
 
+/* Results of triggers while a character runs through one state. Until a
+ * controller activates nothing can change, so a trigger that appears in
+ * several controllers only has to be evaluated once. The keys come from
+ * Compiler::compileTrigger.
+ */
+class TriggerCache{
+public:
+    TriggerCache(){
+    }
+
+    inline bool get(int key, RuntimeValue & out) const {
+        std::map<int, RuntimeValue>::const_iterator found = values.find(key);
+        if (found != values.end()){
+            out = found->second;
+            return true;
+        }
+        return false;
+    }
+
+    inline void set(int key, const RuntimeValue & value){
+        values[key] = value;
+    }
+
+    /* call after a controller activates */
+    inline void clear(){
+        values.clear();
+    }
+
+protected:
+    std::map<int, RuntimeValue> values;
+};
+
 class Environment{
 public:
     Environment(){
@@ -216,6 +250,11 @@ public:
 
     virtual RuntimeValue getArg1() const = 0;
 
+    /* NULL if triggers should not be cached */
+    virtual TriggerCache * getCache() const {
+        return NULL;
+    }
+
     virtual ~Environment(){
     }
 };
@@ -239,19 +278,22 @@ public:
     FullEnvironment(const Mugen::Stage & stage, const Character & character, const std::vector<std::string> commands):
     stage(stage),
     character(character),
-    commands(commands){
+    commands(commands),
+    cache(NULL){
     }
 
     FullEnvironment(const Mugen::Stage & stage, const Character & character, const std::vector<std::string> commands, const RuntimeValue & arg1):
     stage(stage),
     character(character),
     commands(commands),
-    arg1(arg1){
+    arg1(arg1),
+    cache(NULL){
     }
 
     FullEnvironment(const Mugen::Stage & stage, const Character & character):
     stage(stage),
-    character(character){
+    character(character),
+    cache(NULL){
     }
 
     /*
@@ -281,11 +323,20 @@ public:
         return commands;
     }
 
+    virtual inline TriggerCache * getCache() const {
+        return cache;
+    }
+
+    virtual inline void setCache(TriggerCache * cache){
+        this->cache = cache;
+    }
+
 protected:
     const Mugen::Stage & stage;
     const Character & character;
     std::vector<std::string> commands;
     RuntimeValue arg1;
+    TriggerCache * cache;
 };
 
 double toNumber(const RuntimeValue & value);
@@ -306,15 +357,59 @@ namespace Mugen{
 
 namespace Compiler{
 
+    /* What the result of a value depends on, from least to most */
+    enum Constness{
+        /* nothing, the value is folded when it is compiled */
+        Constant,
+        /* only the constants loaded from the character's files, like
+         * const(size.height), so each character computes it once
+         */
+        CharacterConstant,
+        /* anything else */
+        Varying
+    };
+
     class Value{
     public:
         Value();
+
+        /* compiled values live in the arena of the character that loads
+         * them, see arena.h
+         */
+        static void * operator new(size_t size){
+            return Arena::allocate(size);
+        }
+
+        static void operator delete(void * memory){
+            Arena::release(memory);
+        }
+
         virtual RuntimeValue evaluate(const Environment & environment) const = 0;
+
+        /* The same as evaluate(environment).toNumber() and toBool(). Values
+         * that know they are numbers compute these directly on doubles, so
+         * nothing along the way builds a RuntimeValue.
+         */
+        virtual double evaluateNumber(const Environment & environment) const;
+        virtual bool evaluateBool(const Environment & environment) const;
+
+        /* True if evaluate() always gives a Double or a Bool */
+        virtual bool isNumber() const;
+
         virtual std::string toString() const;
         virtual Value * copy() const = 0;
+        virtual Constness constness() const;
         virtual ~Value();
     };
 
+    /* What controllers and triggers use to get a number or a bool out of a
+     * value. With typed evaluation turned off they go through evaluate()
+     * instead, which is how the two are checked against each other.
+     */
+    double evaluateNumber(const Value * value, const Environment & environment);
+    bool evaluateBool(const Value * value, const Environment & environment);
+    void setTypedEvaluation(bool typed);
+
     /* deletes `input' */
     Value * compileAndDelete(const Ast::Value * input);
 
@@ -324,6 +419,19 @@ namespace Compiler{
     Value * compile(int immediate);
     Value * compile(double immediate);
     Value * copy(Value * value);
+
+    /* Like compile but triggers with the same text share their result
+     * through the environment's TriggerCache.
+     */
+    Value * compileTrigger(const Ast::Value * input);
+
+    /* Log the expressions that were folded or cached while compiling */
+    void setShowOptimizations(bool show);
+
+    /* If false compileTrigger is the same as compile. On by default, tests
+     * turn it off to compare against.
+     */
+    void setShareTriggers(bool share);
 }
 
 }
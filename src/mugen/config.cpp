@@ -5,6 +5,7 @@
 #include "util.h"
 #include "exception.h"
 #include "parse-cache.h"
+#include "atlas.h"
 
 #include "globals.h"
 #include <r-tech1/debug.h>
@@ -67,7 +68,11 @@ sysExplodMax(),
 helperMax(),
 playerProjectileMax(),
 firstRun(),
-search(SelectDefAndAuto){
+search(SelectDefAndAuto),
+threadedLogic(false),
+interpolate(false),
+atlas(false),
+desyncLog(){
     
     Filesystem::AbsolutePath baseDir = configFile.getDirectory();
     const Filesystem::AbsolutePath ourDefFile = Mugen::Util::fixFileName(baseDir, configFile.getFilename().path());
@@ -158,6 +163,27 @@ search(SelectDefAndAuto){
     } catch (const ios_base::failure & ex){
         Mugen::Configuration::set("team-lose-on-ko", teamLoseOnKO);
     }
+    try {
+        *Mugen::Configuration::get("threaded-logic") >> threadedLogic;
+    } catch (const ios_base::failure & ex){
+        Mugen::Configuration::set("threaded-logic", threadedLogic);
+    }
+    try {
+        *Mugen::Configuration::get("interpolate") >> interpolate;
+    } catch (const ios_base::failure & ex){
+        Mugen::Configuration::set("interpolate", interpolate);
+    }
+    try {
+        *Mugen::Configuration::get("atlas") >> atlas;
+    } catch (const ios_base::failure & ex){
+        Mugen::Configuration::set("atlas", atlas);
+    }
+    Atlas::setEnabled(atlas);
+    try {
+        *Mugen::Configuration::get("desync-log") >> desyncLog;
+    } catch (const ios_base::failure & ex){
+        Mugen::Configuration::set("desync-log", desyncLog);
+    }
 
 #if 0
     try {
@@ -332,6 +358,43 @@ double Data::getGameSpeed(){
 bool Data::getDrawShadows(){
     return drawShadows;
 }
+
+void Data::setThreadedLogic(bool threaded){
+    this->threadedLogic = threaded;
+    Mugen::Configuration::set("threaded-logic", threaded);
+}
+
+bool Data::getThreadedLogic(){
+    return threadedLogic;
+}
+
+void Data::setInterpolate(bool interpolate){
+    this->interpolate = interpolate;
+    Mugen::Configuration::set("interpolate", interpolate);
+}
+
+bool Data::getInterpolate(){
+    return interpolate;
+}
+
+void Data::setAtlas(bool atlas){
+    this->atlas = atlas;
+    Mugen::Configuration::set("atlas", atlas);
+    Atlas::setEnabled(atlas);
+}
+
+bool Data::getAtlas(){
+    return atlas;
+}
+
+void Data::setDesyncLog(const std::string & path){
+    this->desyncLog = path;
+    Mugen::Configuration::set("desync-log", path);
+}
+
+const std::string & Data::getDesyncLog(){
+    return desyncLog;
+}
         
 Filesystem::RelativePath Data::cleanse(const Filesystem::RelativePath & path){
     string str = path.path();
@@ -70,6 +70,28 @@ class Data{
         double getGameSpeed();
 
         bool getDrawShadows();
+
+        /* run the match logic on its own thread at a fixed tick rate */
+        void setThreadedLogic(bool threaded);
+
+        bool getThreadedLogic();
+
+        /* with threaded logic, draw positions between the last two ticks */
+        void setInterpolate(bool interpolate);
+
+        bool getInterpolate();
+
+        /* pack sprites into atlas pages, see atlas.h */
+        void setAtlas(bool atlas);
+
+        bool getAtlas();
+
+        /* if not empty, network matches write the hash of every tick to this
+         * path with .server or .client at the end, see test/mugen/desync.cpp
+         */
+        void setDesyncLog(const std::string & path);
+
+        const std::string & getDesyncLog();
         
         enum SearchType{
             SelectDef=0,
@@ -178,6 +200,12 @@ class Data{
          
          /* Auto search (Use Searcher to add characters and stages to select screen and ignore select.def) */
          SearchType search;
+
+         /* Not part of mugen.cfg, only kept in our own configuration */
+         bool threadedLogic;
+         bool interpolate;
+         bool atlas;
+         std::string desyncLog;
 };
 
 }
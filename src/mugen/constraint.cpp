@@ -4,9 +4,11 @@
 #include <r-tech1/debug.h>
 #include <r-tech1/token.h>
 #include <math.h>
+#include <stdlib.h>
 #include <vector>
 #include <string>
 #include <set>
+#include <map>
 #include <sstream>
 #include <exception>
 
@@ -69,6 +71,12 @@ public:
         return satisfied;
     }
 
+    virtual void compile(CompiledConstraint & out, const std::map<uint32_t, int> & index) const {
+        Constraint::compile(out, index);
+        out.kind = CompiledConstraint::Delay;
+        out.delay = delayTime;
+    }
+
     virtual string toString() const {
         std::ostringstream out;
 
@@ -116,6 +124,11 @@ public:
     virtual bool satisfy(const Mugen::Input & input, int tick){
         return Constraint::doSatisfy(input, tick);
     }
+
+    virtual void compile(CompiledConstraint & out, const std::map<uint32_t, int> & index) const {
+        Constraint::compile(out, index);
+        out.kind = CompiledConstraint::Hold;
+    }
 };
 
 class CombinedConstraint: public Constraint {
@@ -156,6 +169,13 @@ public:
         return false;
     }
 
+    virtual void compile(CompiledConstraint & out, const std::map<uint32_t, int> & index) const {
+        Constraint::compile(out, index);
+        out.kind = CompiledConstraint::Combine;
+        out.key1 = index.find(key1->getId())->second;
+        out.key2 = index.find(key2->getId())->second;
+    }
+
     virtual string toString() const {
         return key1->toString() + "+" + key2->toString();
     }
@@ -846,6 +866,88 @@ bool Constraint::doSatisfy(const Mugen::Input & input, int tick){
     return false;
 }
 
+CompiledConstraint::CompiledConstraint():
+kind(Key),
+keys(0),
+all(true),
+delay(0),
+key1(0),
+key2(0),
+emit(false),
+depends(0){
+}
+
+/* bit of each key in CommandAutomaton::inputBits, released keys are 16 bits
+ * above the pressed ones.
+ */
+enum InputBit{
+    BitA,
+    BitB,
+    BitC,
+    BitX,
+    BitY,
+    BitZ,
+    BitBack,
+    BitForward,
+    BitUp,
+    BitDown,
+    BitStart
+};
+
+static const int ReleasedShift = 16;
+
+static uint32_t pressedBit(InputBit bit){
+    return 1 << bit;
+}
+
+static uint32_t releasedBit(InputBit bit){
+    return 1 << (bit + ReleasedShift);
+}
+
+void Constraint::compile(CompiledConstraint & out, const std::map<uint32_t, int> & index) const {
+    out.kind = CompiledConstraint::Key;
+    out.all = true;
+    out.emit = emit;
+    switch (type){
+        case PressA: out.keys = pressedBit(BitA); break;
+        case ReleaseA: out.keys = releasedBit(BitA); break;
+        case PressB: out.keys = pressedBit(BitB); break;
+        case ReleaseB: out.keys = releasedBit(BitB); break;
+        case PressC: out.keys = pressedBit(BitC); break;
+        case ReleaseC: out.keys = releasedBit(BitC); break;
+        case PressX: out.keys = pressedBit(BitX); break;
+        case ReleaseX: out.keys = releasedBit(BitX); break;
+        case PressY: out.keys = pressedBit(BitY); break;
+        case ReleaseY: out.keys = releasedBit(BitY); break;
+        case PressZ: out.keys = pressedBit(BitZ); break;
+        case ReleaseZ: out.keys = releasedBit(BitZ); break;
+        case PressStart: out.keys = pressedBit(BitStart); break;
+        case ReleaseStart: out.keys = releasedBit(BitStart); break;
+        case PressForward: out.keys = pressedBit(BitForward); break;
+        case ReleaseForward: out.keys = releasedBit(BitForward); break;
+        case PressBack: out.keys = pressedBit(BitBack); break;
+        case ReleaseBack: out.keys = releasedBit(BitBack); break;
+        case PressUp: out.keys = pressedBit(BitUp); break;
+        case ReleaseUp: out.keys = releasedBit(BitUp); break;
+        case PressDown: out.keys = pressedBit(BitDown); break;
+        case ReleaseDown: out.keys = releasedBit(BitDown); break;
+
+        /* both keys have to be pressed but releasing either one is enough,
+         * same as doSatisfy.
+         */
+        case PressForwardUp: out.keys = pressedBit(BitForward) | pressedBit(BitUp); break;
+        case ReleaseForwardUp: out.keys = releasedBit(BitForward) | releasedBit(BitUp); out.all = false; break;
+        case PressBackUp: out.keys = pressedBit(BitBack) | pressedBit(BitUp); break;
+        case ReleaseBackUp: out.keys = releasedBit(BitBack) | releasedBit(BitUp); out.all = false; break;
+        case PressForwardDown: out.keys = pressedBit(BitForward) | pressedBit(BitDown); break;
+        case ReleaseForwardDown: out.keys = releasedBit(BitForward) | releasedBit(BitDown); out.all = false; break;
+        case PressBackDown: out.keys = pressedBit(BitBack) | pressedBit(BitDown); break;
+        case ReleaseBackDown: out.keys = releasedBit(BitBack) | releasedBit(BitDown); out.all = false; break;
+
+        case Combine: out.keys = 0; break;
+    }
+}
+
 bool Constraint::satisfy(const Mugen::Input & input, int tick){
     if (!satisfied){
         /*
@@ -1038,4 +1140,305 @@ void Command2::deserialize(const Token * token){
     }
 }
 
+/* Layout of the state array. Each command has a header followed by the
+ * state of each of its constraints.
+ */
+enum CommandField{
+    UseBufferTime,
+    Emitted,
+    CommandHeader
+};
+
+enum ConstraintField{
+    Satisfied,
+    SatisfiedTick,
+    Held,
+    ConstraintSize
+};
+
+CommandAutomaton::CommandAutomaton():
+tables(new Tables()),
+lastInput(0){
+}
+
+void CommandAutomaton::add(const Command2 & command){
+    Tables & use = *tables.raw();
+    const vector<ConstraintRef> & constraints = command.constraints;
+
+    std::map<uint32_t, int> index;
+    for (unsigned int i = 0; i < constraints.size(); i++){
+        index[constraints[i]->getId()] = i;
+    }
+
+    Command compiled;
+    compiled.name = command.getName();
+    compiled.maxTime = command.maxTime;
+    compiled.bufferTime = command.bufferTime;
+    compiled.first = use.constraints.size();
+    compiled.count = constraints.size();
+    compiled.words = (compiled.count + 31) / 32;
+    if (compiled.words == 0){
+        compiled.words = 1;
+    }
+    compiled.state = use.stateSize;
+
+    for (unsigned int i = 0; i < constraints.size(); i++){
+        const ConstraintRef & constraint = constraints[i];
+        CompiledConstraint out;
+        constraint->compile(out, index);
+
+        out.depends = use.depends.size();
+        use.depends.resize(use.depends.size() + compiled.words, 0);
+        const set<ConstraintCompare> & depends = constraint->getDepends();
+        for (set<ConstraintCompare>::const_iterator it = depends.begin(); it != depends.end(); it++){
+            int at = index[it->constraint->getId()];
+            use.depends[out.depends + at / 32] |= 1 << (at % 32);
+        }
+
+        use.constraints.push_back(out);
+    }
+
+    use.stateSize += CommandHeader + compiled.count * ConstraintSize;
+    if (compiled.words > use.maxWords){
+        use.maxWords = compiled.words;
+    }
+    use.commands.push_back(compiled);
+
+    state.resize(use.stateSize, 0);
+    satisfied.resize(use.maxWords, 0);
+}
+
+int CommandAutomaton::size() const {
+    return tables->commands.size();
+}
+
+const std::string & CommandAutomaton::getName(int command) const {
+    return tables->commands[command].name;
+}
+
+uint32_t CommandAutomaton::inputBits(const Mugen::Input & input){
+    uint32_t out = 0;
+#define Bit(key, bit) \
+    if (input.pressed.key){ out |= pressedBit(bit); } \
+    if (input.released.key){ out |= releasedBit(bit); }
+
+    Bit(a, BitA);
+    Bit(b, BitB);
+    Bit(c, BitC);
+    Bit(x, BitX);
+    Bit(y, BitY);
+    Bit(z, BitZ);
+    Bit(back, BitBack);
+    Bit(forward, BitForward);
+    Bit(up, BitUp);
+    Bit(down, BitDown);
+    Bit(start, BitStart);
+
+#undef Bit
+    return out;
+}
+
+Mugen::Input CommandAutomaton::bitsInput(uint32_t bits){
+    Mugen::Input out;
+#define Bit(key, bit) \
+    out.pressed.key = (bits & pressedBit(bit)) != 0; \
+    out.released.key = (bits & releasedBit(bit)) != 0;
+
+    Bit(a, BitA);
+    Bit(b, BitB);
+    Bit(c, BitC);
+    Bit(x, BitX);
+    Bit(y, BitY);
+    Bit(z, BitZ);
+    Bit(back, BitBack);
+    Bit(forward, BitForward);
+    Bit(up, BitUp);
+    Bit(down, BitDown);
+    Bit(start, BitStart);
+
+#undef Bit
+    return out;
+}
+
+void CommandAutomaton::reset(){
+    for (vector<int>::iterator it = state.begin(); it != state.end(); it++){
+        *it = 0;
+    }
+}
+
+/* Same as Command2::resetConstraints. The held count of a delay constraint
+ * is not reset there either.
+ */
+void CommandAutomaton::reset(const Command & command){
+    int * data = &state[command.state];
+    data[Emitted] = 0;
+    for (int i = 0; i < command.count; i++){
+        int * constraint = data + CommandHeader + i * ConstraintSize;
+        constraint[Satisfied] = 0;
+        constraint[SatisfiedTick] = 0;
+    }
+}
+
+/* Same as Constraint::satisfy and its subclasses */
+bool CommandAutomaton::satisfy(const Command & command, int index, uint32_t input, int ticks){
+    const CompiledConstraint & constraint = tables->constraints[command.first + index];
+    int * data = &state[command.state + CommandHeader + index * ConstraintSize];
+
+    bool pressed = false;
+    if (constraint.all){
+        pressed = (input & constraint.keys) == constraint.keys;
+    } else {
+        pressed = (input & constraint.keys) != 0;
+    }
+
+    switch (constraint.kind){
+        case CompiledConstraint::Key: {
+            if (!data[Satisfied] && pressed){
+                data[Satisfied] = 1;
+                data[SatisfiedTick] = ticks;
+            }
+            return data[Satisfied];
+        }
+        case CompiledConstraint::Delay: {
+            if (!data[Satisfied]){
+                if (pressed){
+                    data[Held] += 1;
+                } else {
+                    data[Held] = 0;
+                }
+                data[Satisfied] = data[Held] >= constraint.delay;
+            }
+            return data[Satisfied];
+        }
+        case CompiledConstraint::Hold: {
+            return pressed;
+        }
+        case CompiledConstraint::Combine: {
+            const int threshold = 4;
+            if (!data[Satisfied]){
+                if (satisfy(command, constraint.key1, input, ticks) &&
+                    satisfy(command, constraint.key2, input, ticks)){
+                    const int * key1 = &state[command.state + CommandHeader + constraint.key1 * ConstraintSize];
+                    const int * key2 = &state[command.state + CommandHeader + constraint.key2 * ConstraintSize];
+                    if (abs(key1[SatisfiedTick] - key2[SatisfiedTick]) < threshold){
+                        data[Satisfied] = 1;
+                        data[SatisfiedTick] = ticks;
+                    }
+                }
+            }
+            return data[Satisfied];
+        }
+    }
+
+    return false;
+}
+
+/* Same as Command2::handle */
+bool CommandAutomaton::handle(const Command & command, uint32_t input, int ticks){
+    if (state[command.state + UseBufferTime] > 0){
+        state[command.state + UseBufferTime] -= 1;
+        return true;
+    }
+
+    int active = 0;
+    if (command.count > 0){
+        int tick = state[command.state + CommandHeader + SatisfiedTick];
+        if (tick > 0 && tick < ticks){
+            active = ticks - tick;
+        }
+    }
+
+    if (active > command.maxTime && input == 0){
+        reset(command);
+    }
+
+    for (int word = 0; word < command.words; word++){
+        satisfied[word] = 0;
+    }
+
+    const Tables & use = *tables.raw();
+    bool emit = false;
+    int count = 0;
+    for (int i = 0; i < command.count; i++){
+        const CompiledConstraint & constraint = use.constraints[command.first + i];
+        const uint32_t * depends = &use.depends[constraint.depends];
+        bool all = true;
+        for (int word = 0; word < command.words; word++){
+            if ((depends[word] & satisfied[word]) != depends[word]){
+                all = false;
+                break;
+            }
+        }
+
+        if (all && satisfy(command, i, input, ticks)){
+            satisfied[i / 32] |= 1 << (i % 32);
+            count += 1;
+            if (constraint.emit){
+                emit = true;
+            }
+        }
+    }
+
+    /* Can only emit once until a reset */
+    if (state[command.state + Emitted]){
+        emit = false;
+    }
+
+    if (emit){
+        state[command.state + UseBufferTime] = command.bufferTime - 1;
+        state[command.state + Emitted] = 1;
+    }
+
+    if (count == command.count){
+        reset(command);
+    }
+
+    return emit;
+}
+
+void CommandAutomaton::handle(const Mugen::Input & input, int ticks, std::vector<std::string> & out){
+    uint32_t bits = inputBits(input);
+    lastInput = bits;
+    const vector<Command> & commands = tables->commands;
+    for (vector<Command>::const_iterator it = commands.begin(); it != commands.end(); it++){
+        const Command & command = *it;
+        if (handle(command, bits, ticks)){
+            out.push_back(command.name);
+        }
+    }
+}
+
+/* Most of the state is 0 so zeros are left out, "3,,,1" is 3, 0, 0, 1 */
+std::string CommandAutomaton::serialize() const {
+    std::ostringstream out;
+    for (unsigned int i = 0; i < state.size(); i++){
+        if (i > 0){
+            out << ",";
+        }
+        if (state[i] != 0){
+            out << state[i];
+        }
+    }
+    return out.str();
+}
+
+void CommandAutomaton::deserialize(const std::string & data){
+    reset();
+    unsigned int index = 0;
+    int value = 0;
+    int sign = 1;
+    for (unsigned int i = 0; i <= data.size() && index < state.size(); i++){
+        if (i == data.size() || data[i] == ','){
+            state[index] = value * sign;
+            index += 1;
+            value = 0;
+            sign = 1;
+        } else if (data[i] == '-'){
+            sign = -1;
+        } else {
+            value = value * 10 + (data[i] - '0');
+        }
+    }
+}
+
 }
@@ -2,6 +2,7 @@
 #define _paintown_mugen_constraint_h
 
 #include <set>
+#include <map>
 #include <vector>
 #include <string>
 #include "command.h"
@@ -13,6 +14,32 @@ namespace PaintownUtil = ::Util;
 
 namespace Mugen{
 
+/* A constraint flattened into the tables of a CommandAutomaton */
+struct CompiledConstraint{
+    enum Kind{
+        Key,
+        Delay,
+        Hold,
+        Combine
+    };
+
+    CompiledConstraint();
+
+    Kind kind;
+    /* input bits the constraint looks at, see CommandAutomaton::inputBits */
+    uint32_t keys;
+    /* all of the keys have to be set, otherwise any one of them will do */
+    bool all;
+    /* how long a Delay constraint has to be held */
+    int delay;
+    /* the two halves of a Combine constraint, as indices into the command */
+    int key1;
+    int key2;
+    bool emit;
+    /* offset of the dependency bits in CommandAutomaton's depends table */
+    int depends;
+};
+
 /* Implements operator< so the std::set is properly ordered */
 class Constraint;
 class ConstraintCompare{
@@ -91,6 +118,11 @@ public:
 
     virtual void reset();
 
+    /* fill in the kind and keys of `out'. `index' maps constraint ids to
+     * their position in the command.
+     */
+    virtual void compile(CompiledConstraint & out, const std::map<uint32_t, int> & index) const;
+
     uint32_t getId() const;
 
     bool isDominate() const;
@@ -135,6 +167,8 @@ public:
     void deserialize(const Token * token);
 
 protected:
+    friend class CommandAutomaton;
+
     void resetConstraints();
     int activeTicks(int ticks);
 
@@ -146,6 +180,85 @@ protected:
     bool emitted;
 };
 
+/* All the commands of a character compiled into flat tables. Handling a
+ * tick turns the input into a bitmask once, then for each command walks its
+ * constraints in order and checks their dependencies with a few bitwise
+ * ands. It behaves exactly like running every Command2 by itself.
+ *
+ * The tables don't change once the commands are added so copies of the
+ * automaton share them. The state of the commands (how far along each one
+ * is) is a single array of ints that is cheap to copy and to serialize.
+ */
+class CommandAutomaton{
+public:
+    CommandAutomaton();
+
+    /* Add commands before making copies of the automaton, the tables are
+     * shared with copies.
+     */
+    void add(const Command2 & command);
+
+    /* Run one tick of input through all the commands. The names of the
+     * commands that fire are added to `out'.
+     */
+    void handle(const Mugen::Input & input, int ticks, std::vector<std::string> & out);
+
+    int size() const;
+    const std::string & getName(int command) const;
+
+    /* forget any partially entered commands */
+    void reset();
+
+    std::string serialize() const;
+    void deserialize(const std::string & data);
+
+    static uint32_t inputBits(const Mugen::Input & input);
+    /* The opposite of inputBits */
+    static Mugen::Input bitsInput(uint32_t bits);
+
+    /* inputBits of the input given to the last handle() */
+    inline uint32_t getLastInput() const {
+        return lastInput;
+    }
+
+protected:
+    struct Command{
+        std::string name;
+        int maxTime;
+        int bufferTime;
+        /* first constraint in the constraints table */
+        int first;
+        int count;
+        /* words of dependency bits per constraint */
+        int words;
+        /* offset of this command in the state array */
+        int state;
+    };
+
+    struct Tables{
+        Tables():
+            stateSize(0),
+            maxWords(0){
+            }
+
+        std::vector<Command> commands;
+        std::vector<CompiledConstraint> constraints;
+        std::vector<uint32_t> depends;
+        int stateSize;
+        int maxWords;
+    };
+
+    bool handle(const Command & command, uint32_t input, int ticks);
+    bool satisfy(const Command & command, int constraint, uint32_t input, int ticks);
+    void reset(const Command & command);
+
+    PaintownUtil::ReferenceCount<Tables> tables;
+    std::vector<int> state;
+    /* scratch space for the constraints satisfied during a tick */
+    std::vector<uint32_t> satisfied;
+    uint32_t lastInput;
+};
+
 }
 
 #endif
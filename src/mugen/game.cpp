@@ -33,6 +33,8 @@
 #include "characterhud.h"
 #include "storyboard.h"
 #include "behavior.h"
+#include "replay.h"
+#include "random.h"
 #include "network.h"
 #include "parse-cache.h"
 #include "config.h"
@@ -813,6 +815,252 @@ void Game::startScript(const std::string & player1Name, const string & player1Sc
     script.run();
 }
 
+class StartBatch: public StartGameMode {
+public:
+    StartBatch(const std::string & player1Name,
+               const std::string & player1Behavior,
+               const std::string & player2Name,
+               const std::string & player2Behavior,
+               const std::string & stageName,
+               int matches):
+    StartGameMode(player1Name, player2Name, stageName),
+    player1Behavior(player1Behavior),
+    player2Behavior(player2Behavior),
+    stageName(stageName),
+    matches(matches){
+    }
+
+    std::string player1Behavior;
+    std::string player2Behavior;
+    std::string stageName;
+    int matches;
+
+    static PaintownUtil::ReferenceCount<Behavior> makeBehavior(const std::string & kind){
+        if (kind == "" || kind == "ai"){
+            return PaintownUtil::ReferenceCount<Behavior>(new LearningAIBehavior(Mugen::Data::getInstance().getDifficulty()));
+        }
+        if (kind == "random"){
+            return PaintownUtil::ReferenceCount<Behavior>(new RandomAIBehavior());
+        }
+        if (kind == "dummy"){
+            return PaintownUtil::ReferenceCount<Behavior>(new DummyBehavior());
+        }
+        return PaintownUtil::ReferenceCount<Behavior>(new ScriptedBehavior(Filesystem::AbsolutePath(kind)));
+    }
+
+    /* a match that goes on longer than this (an hour at 60 ticks a second),
+     * for example on a stage with no round timer, is stopped without a winner
+     */
+    static const uint64_t MaxTicks = 60 * 60 * 60;
+
+    /* the stage keeps round and win state around so each match gets a new one */
+    void newStage(){
+        stage = new Stage(Storage::instance().find(Filesystem::RelativePath("mugen/stages/" + stageName + ".def")));
+        stage->load();
+        stage->addPlayer1(getPlayer1().raw());
+        stage->addPlayer2(getPlayer2().raw());
+    }
+
+    virtual void run(){
+        ParseCache cache;
+        PaintownUtil::ReferenceCount<Behavior> behavior1 = makeBehavior(player1Behavior);
+        PaintownUtil::ReferenceCount<Behavior> behavior2 = makeBehavior(player2Behavior);
+        getPlayer1()->setBehavior(behavior1.raw());
+        getPlayer2()->setBehavior(behavior2.raw());
+
+        const std::string name1 = getPlayer1()->getDisplayName();
+        const std::string name2 = getPlayer2()->getDisplayName();
+
+        int player1Wins = 0;
+        int player2Wins = 0;
+        int draws = 0;
+        int unfinished = 0;
+        uint64_t totalTicks = 0;
+
+        TimeDifference timer;
+        timer.startTime();
+        for (int match = 0; match < matches; match++){
+            if (match > 0){
+                newStage();
+            }
+            stage->getSimulation().disableSounds();
+
+            int matchWins1 = getPlayer1()->getMatchWins();
+            int matchWins2 = getPlayer2()->getMatchWins();
+
+            stage->reset();
+            uint64_t ticks = 0;
+            while (!stage->isMatchOver() && ticks < MaxTicks){
+                stage->logic();
+                ticks += 1;
+            }
+            totalTicks += ticks;
+
+            std::ostream & out = Global::debug(0, "batch");
+            out << "Match " << (match + 1) << ": ";
+            if (!stage->isMatchOver()){
+                unfinished += 1;
+                out << "stopped, no winner";
+            } else if (getPlayer1()->getMatchWins() > matchWins1){
+                player1Wins += 1;
+                out << name1 << " (player 1) wins";
+            } else if (getPlayer2()->getMatchWins() > matchWins2){
+                player2Wins += 1;
+                out << name2 << " (player 2) wins";
+            } else {
+                draws += 1;
+                out << "draw";
+            }
+            out << " after " << ticks << " ticks" << std::endl;
+
+            getPlayer1()->resetPlayer();
+            getPlayer2()->resetPlayer();
+        }
+        timer.endTime();
+
+        double seconds = timer.getTime() / 1000000.0;
+        std::ostream & out = Global::debug(0, "batch");
+        out << matches << " matches. " << name1 << " won " << player1Wins << ", " << name2 << " won " << player2Wins << ", " << draws << " draws";
+        if (unfinished > 0){
+            out << ", " << unfinished << " stopped";
+        }
+        out << std::endl;
+        out << totalTicks << " ticks in " << seconds << " seconds";
+        if (seconds > 0){
+            out << " (" << (totalTicks / seconds) << " ticks per second)";
+        }
+        out << std::endl;
+    }
+};
+
+void Game::startBatch(const std::string & player1Name, const std::string & player1Behavior, const std::string & player2Name, const std::string & player2Behavior, const std::string & stageName, int matches){
+    StartBatch batch(player1Name, player1Behavior, player2Name, player2Behavior, stageName, matches);
+    batch.run();
+}
+
+/* Player 1 plays against the ai and the match is saved as a replay */
+class StartRecord: public StartGameMode {
+public:
+    StartRecord(const std::string & player1Name,
+                const std::string & player2Name,
+                const std::string & stageName,
+                const std::string & file):
+    StartGameMode(player1Name, player2Name, stageName),
+    stageName(stageName),
+    file(file){
+    }
+
+    std::string stageName;
+    std::string file;
+
+    static void describe(InputReplay::Player & player, const Character & character, const std::string & behavior){
+        player.name = Storage::instance().cleanse(character.getLocation()).path();
+        player.version = InputReplay::fileVersion(character.getLocation());
+        player.behavior = behavior;
+    }
+
+    virtual void run(){
+        InputReplay replay;
+        replay.seed = (uint32_t) System::currentMilliseconds();
+        Filesystem::AbsolutePath stagePath = Storage::instance().find(Filesystem::RelativePath("mugen/stages/" + stageName + ".def"));
+        replay.stage = Storage::instance().cleanse(stagePath).path();
+        replay.stageVersion = InputReplay::fileVersion(stagePath);
+        describe(replay.players[0], *getPlayer1(), "input");
+        describe(replay.players[1], *getPlayer2(), "ai");
+
+        HumanBehavior player1Behavior(getPlayer1Keys(), getPlayer1InputLeft());
+        PaintownUtil::ReferenceCount<Behavior> player2Behavior = StartBatch::makeBehavior("ai");
+        RecordBehavior record1(player1Behavior, replay.players[0]);
+        RecordBehavior record2(*player2Behavior, replay.players[1]);
+        getPlayer1()->setBehavior(&record1);
+        getPlayer2()->setBehavior(&record2);
+
+        RunMatchOptions options;
+        options.setBehavior(&player1Behavior, NULL);
+
+        stage->getSimulation().setRandom(Random(replay.seed));
+        stage->reset();
+        try{
+            Game::runMatch(stage.raw(), "", options);
+        } catch (const QuitGameException & quit){
+            /* keep what was played so far */
+        }
+
+        replay.save(Filesystem::AbsolutePath(file));
+        Global::debug(0) << "Saved " << replay.players[0].ticks() << " ticks to " << file << std::endl;
+    }
+};
+
+void Game::startRecord(const std::string & player1Name, const std::string & player2Name, const std::string & stageName, const std::string & file){
+    StartRecord record(player1Name, player2Name, stageName, file);
+    record.run();
+}
+
+static void checkVersion(const std::string & what, const Filesystem::AbsolutePath & path, uint64_t version){
+    if (InputReplay::fileVersion(path) != version){
+        Global::debug(0) << "Warning: " << what << " " << path.path() << " changed since the replay was recorded, it may not play back the same" << std::endl;
+    }
+}
+
+void Game::playReplay(const std::string & file){
+    InputReplay replay = InputReplay::load(Filesystem::AbsolutePath(file));
+
+    ParseCache cache;
+    PaintownUtil::ReferenceCount<Character> players[2];
+    PaintownUtil::ReferenceCount<Behavior> behaviors[2];
+    vector<ReplayBehavior*> inputs;
+    for (int i = 0; i < 2; i++){
+        const InputReplay::Player & player = replay.players[i];
+        Filesystem::AbsolutePath path = Storage::instance().find(Filesystem::RelativePath(player.name));
+        checkVersion("character", path, player.version);
+        players[i] = new Character(path, i == 0 ? Stage::Player1Side : Stage::Player2Side);
+        players[i]->load();
+        if (player.behavior == "input"){
+            ReplayBehavior * input = new ReplayBehavior(player);
+            inputs.push_back(input);
+            behaviors[i] = input;
+        } else {
+            behaviors[i] = StartBatch::makeBehavior(player.behavior);
+        }
+        players[i]->setBehavior(behaviors[i].raw());
+    }
+
+    Filesystem::AbsolutePath stagePath = Storage::instance().find(Filesystem::RelativePath(replay.stage));
+    checkVersion("stage", stagePath, replay.stageVersion);
+    Stage stage(stagePath);
+    stage.load();
+    stage.addPlayer1(players[0].raw());
+    stage.addPlayer2(players[1].raw());
+    stage.getSimulation().disableSounds();
+    stage.getSimulation().setRandom(Random(replay.seed));
+    stage.reset();
+
+    uint32_t ticks = 0;
+    TimeDifference timer;
+    timer.startTime();
+    while (!stage.isMatchOver()){
+        /* the match could have been quit before it ended */
+        bool done = inputs.size() > 0;
+        for (vector<ReplayBehavior*>::iterator it = inputs.begin(); it != inputs.end(); it++){
+            done = done && (*it)->done();
+        }
+        if (done){
+            break;
+        }
+
+        stage.logic();
+        ticks += 1;
+    }
+    timer.endTime();
+
+    std::ostream & out = Global::debug(0, "replay");
+    out << "Played " << ticks << " ticks. " << players[0]->getDisplayName() << " has " << players[0]->getHealth() << " life, " << players[1]->getDisplayName() << " has " << players[1]->getHealth() << " life";
+    if (timer.getTime() > 0){
+        out << " (" << (ticks / (timer.getTime() / 1000000.0)) << " ticks per second)";
+    }
+    out << std::endl;
+}
+
 void Game::doTraining(Searcher & searcher){
     int time = Mugen::Data::getInstance().getTime();
     Mugen::Data::getInstance().setTime(-1);
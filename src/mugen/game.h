@@ -63,6 +63,14 @@ class Game {
         static void startTeam(const std::string & player1Name, const std::string & player2Name, const std::string & player3Name, const std::string & player4Name, const std::string & stageName);
         /* start a scripted match */
         static void startScript(const std::string & player1Name, const std::string & player1Script, const std::string & player2Name, const std::string & player2Script, const std::string & stageName);
+        /* run matches as fast as possible without drawing or sound and report
+         * who won. a behavior is 'ai', 'random', 'dummy' or the path to a script.
+         */
+        static void startBatch(const std::string & player1Name, const std::string & player1Behavior, const std::string & player2Name, const std::string & player2Behavior, const std::string & stageName, int matches);
+        /* player 1 against the ai, saved as a replay in `file' when the match ends */
+        static void startRecord(const std::string & player1Name, const std::string & player2Name, const std::string & stageName, const std::string & file);
+        /* play a replay made by startRecord without drawing or sound */
+        static void playReplay(const std::string & file);
     private:
 #ifdef HAVE_NETWORKING
         static void startNetworkVersus1(const PaintownUtil::ReferenceCount<Character> & player1,
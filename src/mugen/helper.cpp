@@ -18,6 +18,10 @@ name(owner->getName() + " " + name + " (helper)"){
     getLocalData().animations = owner->getAnimations();
     getLocalData().sounds = owner->getSounds();
     getLocalData().commonSounds = owner->getCommonSounds();
+    /* the helper runs its own states so it shouldn't see the owner's
+     * persistent countdowns.
+     */
+    resetStatePersistent();
 }
 
 Helper::~Helper(){
@@ -55,19 +59,11 @@ RefState Helper::getState(int id, Stage & stage) const {
     if (id == -1){
         return RefState(NULL);
     }
-    map<int, RefState>::const_iterator findIt = proxyStates.find(id);
-    if (findIt == proxyStates.end()){
-        RefState dad = Character::getState(id, stage);
-        if (dad != NULL){
-            /* this is why proxyStates has to be mutable */
-            proxyStates[id] = RefState(dad->deepCopy());
-            return proxyStates[id];
-        }
-    } else {
-        return findIt->second;
-    }
-    return RefState(NULL);
-
+    /* states are never changed while the game runs, the persistent
+     * countdowns of the controllers are kept in the helper itself. so the
+     * helper can run the owner's states directly instead of copies.
+     */
+    return Character::getState(id, stage);
 }
     
 const std::string Helper::getName() const {
@@ -97,7 +93,8 @@ PaintownUtil::ReferenceCount<Animation> Helper::getAnimation(int id) const {
         if (originalAnimation != NULL){
             /* We have to copy the animation because the animation stores state about
              * which frame is being shown and we don't want to mess up the
-             * original characters animations.
+             * original characters animations. The copy shares the frames
+             * with the original so its cheap.
              * this is why proxyAnimations has to be mutable */
             proxyAnimations[id] = PaintownUtil::ReferenceCount<Animation>(new Animation(*originalAnimation));
             return proxyAnimations[id];
@@ -52,7 +52,6 @@ protected:
     HitDefinition hit;
     DummyBehavior dummy;
     mutable std::map< int, PaintownUtil::ReferenceCount<Animation> > proxyAnimations;
-    mutable std::map< int, PaintownUtil::ReferenceCount<State> > proxyStates;
 
     /* Id of the helper according to mugen script */
     int id;
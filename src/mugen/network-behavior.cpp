@@ -79,13 +79,13 @@ void NetworkLocalBehavior::begin(){
     }
 }
 
-void NetworkLocalBehavior::start(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed){
+void NetworkLocalBehavior::start(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed){
     vector<string> current = local->currentCommands(stage, owner, commands, reversed);
     this->commands.push_back(current);
     sendCommands(current, socket);
 }
 
-std::vector<std::string> NetworkLocalBehavior::currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed){
+std::vector<std::string> NetworkLocalBehavior::currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed){
     vector<string> out = this->commands.front();
     this->commands.pop_front();
     return out;
@@ -99,6 +99,10 @@ void NetworkLocalBehavior::hit(Object * enemy){
     local->hit(enemy);
 }
 
+void NetworkLocalBehavior::latch(bool reversed){
+    local->latch(reversed);
+}
+
 NetworkLocalBehavior::~NetworkLocalBehavior(){
     /* we do not own local, don't delete it */
 }
@@ -188,7 +192,7 @@ vector<string> NetworkRemoteBehavior::nextCommand(){
     return out;
 }
 
-std::vector<std::string> NetworkRemoteBehavior::currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed){
+std::vector<std::string> NetworkRemoteBehavior::currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed){
     return nextCommand();
 }
 
@@ -20,12 +20,14 @@ public:
     /* Start some stuff */
     virtual void begin();
 
-    virtual void start(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed);
-    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed);
+    virtual void start(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed);
+    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed);
     virtual void flip();
     
     virtual void hit(Object * enemy);
 
+    virtual void latch(bool reversed);
+
     virtual ~NetworkLocalBehavior();
 
 protected:
@@ -41,7 +43,7 @@ public:
     
     virtual void begin();
 
-    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed);
+    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed);
     virtual void flip();
     
     virtual void hit(Object * enemy);
@@ -29,6 +29,7 @@
 
 #include <string>
 #include <vector>
+#include <fstream>
 
 using std::string;
 using std::vector;
@@ -204,7 +205,8 @@ public:
     enum Type{
         InputType,
         PingType,
-        WorldType
+        WorldType,
+        HashType
     };
 
     Packet(Type type):
@@ -267,6 +269,19 @@ public:
     
 };
 
+/* The hash of the game state at the end of a tick, see Stage::hashState() */
+class HashPacket: public Packet {
+public:
+    HashPacket(uint32_t tick, uint64_t hash):
+    Packet(HashType),
+    tick(tick),
+    hash(hash){
+    }
+
+    uint32_t tick;
+    uint64_t hash;
+};
+
 Input deserializeInput(const Token * token){
     Input out;
 
@@ -336,6 +351,12 @@ static PaintownUtil::ReferenceCount<Packet> readPacket(const Network::Socket & s
             }
             break;
         }
+        case Packet::HashType: {
+            uint32_t tick = Network::read32(socket);
+            uint32_t high = Network::read32(socket);
+            uint32_t low = Network::read32(socket);
+            return PaintownUtil::ReferenceCount<Packet>(new HashPacket(tick, ((uint64_t) high << 32) | low));
+        }
         default: {
             std::ostringstream out;
             out << "Unknown packet type: " << type;
@@ -420,6 +441,17 @@ static void sendPacket(const Network::Socket & socket, const PaintownUtil::Refer
             buffer.send(socket);
             break;
         }
+        case Packet::HashType: {
+            PaintownUtil::ReferenceCount<HashPacket> hash = packet;
+            NetworkBuffer buffer;
+            buffer << (int16_t) NetworkMagic;
+            buffer << (int16_t) Packet::HashType;
+            buffer << hash->tick;
+            buffer << (uint32_t) (hash->hash >> 32);
+            buffer << (uint32_t) (hash->hash & 0xffffffff);
+            buffer.send(socket);
+            break;
+        }
         default: {
             throw MugenException("Unknown packet type", __FILE__, __LINE__);
         }
@@ -470,17 +502,14 @@ public:
         return getInput(stage.getTicks());
     }
 
-    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed){
+    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed){
         vector<string> out;
 
         Input input = getInput(stage);
 
-        for (vector<Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
-            Command2 * command = *it;
-            if (command->handle(input, stage.getTicks())){
-                Global::debug(1) << "command: " << command->getName() << std::endl;
-                out.push_back(command->getName());
-            }
+        commands.handle(input, stage.getTicks(), out);
+        for (vector<string>::const_iterator it = out.begin(); it != out.end(); it++){
+            Global::debug(1) << "command: " << *it << std::endl;
         }
 
         return out;
@@ -515,22 +544,19 @@ public:
             return history[stage.getTicks()];
         }
 
-        input = updateInput(getInput(reversed), input);
+        input = readInput(stage, reversed);
         return input;
     }
     
-    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, const std::vector<Command2*> & commands, bool reversed){
+    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed){
         vector<string> out;
 
         Input use = getInput(stage, reversed);
         history[stage.getTicks()] = use;
 
-        for (vector<Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
-            Command2 * command = *it;
-            if (command->handle(use, stage.getTicks())){
-                Global::debug(1) << "command: " << command->getName() << std::endl;
-                out.push_back(command->getName());
-            }
+        commands.handle(use, stage.getTicks(), out);
+        for (vector<string>::const_iterator it = out.begin(); it != out.end(); it++){
+            Global::debug(1) << "command: " << *it << std::endl;
         }
 
         return out;
@@ -540,9 +566,7 @@ public:
      * the input mapping.
      */
     virtual void flip(){
-        bool forward = input.pressed.forward;
-        input.pressed.forward = input.pressed.back;
-        input.pressed.back = forward;
+        HumanBehavior::flip();
     }
 
     virtual ~HumanNetworkBehavior(){
@@ -557,6 +581,7 @@ public:
     virtual void handlePing(const PaintownUtil::ReferenceCount<PingPacket> & packet) = 0;
     virtual void handleInput(const PaintownUtil::ReferenceCount<InputPacket> & packet) = 0;
     virtual void handleWorld(const PaintownUtil::ReferenceCount<WorldPacket> & packet) = 0;
+    virtual void handleHash(const PaintownUtil::ReferenceCount<HashPacket> & packet) = 0;
 
     virtual ~HostHandler(){
     }
@@ -647,6 +672,10 @@ public:
                 host.handleWorld(packet);
                 break;
             }
+            case Packet::HashType: {
+                host.handleHash(packet);
+                break;
+            }
         }
     }
 
@@ -671,11 +700,99 @@ public:
     }
 };
 
+/* Both sides hash their state at the end of every tick and every so often
+ * send the hash of a tick far enough in the past that all the inputs for it
+ * have arrived. If the other side's hash for that tick is different the two
+ * games have gone out of sync.
+ *
+ * With the desync-log option each side also writes a `tick hash' line for
+ * every tick, which test/mugen/desync.cpp can compare after the match. A tick
+ * is only written once it is too old to be replayed, so its hash is final.
+ */
+class DesyncChecker{
+public:
+    DesyncChecker(const std::string & side):
+    reported(false){
+        const std::string & path = Data::getInstance().getDesyncLog();
+        if (path != ""){
+            log.open((path + "." + side).c_str());
+        }
+    }
+
+    ~DesyncChecker(){
+        for (std::map<uint32_t, uint64_t>::iterator it = local.begin(); it != local.end(); it++){
+            write(it->first, it->second);
+        }
+    }
+
+    /* How far behind the current tick the hashes that get sent are */
+    static const uint32_t Delay = 120;
+    /* Send a hash this often */
+    static const uint32_t Every = 30;
+
+    PaintownUtil::Thread::LockObject lock;
+    std::map<uint32_t, uint64_t> local;
+    std::map<uint32_t, uint64_t> remote;
+    bool reported;
+    std::ofstream log;
+
+    void write(uint32_t tick, uint64_t hash){
+        if (log.is_open()){
+            log << tick << " " << hash << "\n";
+        }
+    }
+
+    /* Call after each Stage::logic(), including the replayed ones */
+    void record(Stage & stage){
+        uint32_t tick = stage.getTicks();
+        uint64_t hash = stage.hashState();
+        PaintownUtil::Thread::ScopedLock scoped(lock);
+        local[tick] = hash;
+    }
+
+    void handleHash(const PaintownUtil::ReferenceCount<HashPacket> & packet){
+        PaintownUtil::Thread::ScopedLock scoped(lock);
+        remote[packet->tick] = packet->hash;
+    }
+
+    void exchange(uint32_t tick, PacketHandler & handler){
+        if (tick > Delay && tick % Every == 0){
+            uint32_t old = tick - Delay;
+            PaintownUtil::Thread::ScopedLock scoped(lock);
+            if (local.find(old) != local.end()){
+                handler.sendPacket(PaintownUtil::ReferenceCount<Packet>(new HashPacket(old, local[old])));
+            }
+        }
+
+        check(tick);
+    }
+
+    void check(uint32_t tick){
+        PaintownUtil::Thread::ScopedLock scoped(lock);
+        for (std::map<uint32_t, uint64_t>::iterator it = remote.begin(); it != remote.end(); it++){
+            std::map<uint32_t, uint64_t>::iterator mine = local.find(it->first);
+            if (mine != local.end() && mine->second != it->second && !reported){
+                Global::debug(0) << "Desync at tick " << it->first << std::endl;
+                /* Only the first one is interesting */
+                reported = true;
+            }
+        }
+        remote.clear();
+
+        /* Keep enough to answer hashes that arrive late */
+        while (local.size() > 0 && local.begin()->first + Delay * 4 < tick){
+            write(local.begin()->first, local.begin()->second);
+            local.erase(local.begin());
+        }
+    }
+};
+
 class NetworkServerObserver: public NetworkObserver, public HostHandler {
 public:
     NetworkServerObserver(Network::Socket reliable, const PaintownUtil::ReferenceCount<Character> & player1, const PaintownUtil::ReferenceCount<Character> & player2, HumanBehavior & player1Behavior, NetworkBehavior & player2Behavior):
     NetworkObserver(),
     handler(reliable, *this),
+    desync("server"),
     reliable(reliable),
     player1(player1),
     player2(player2),
@@ -687,6 +804,7 @@ public:
     }
 
     PacketHandler handler;
+    DesyncChecker desync;
 
     PaintownUtil::Thread::LockObject lock;
     Network::Socket reliable;
@@ -735,6 +853,10 @@ public:
     virtual void handleWorld(const PaintownUtil::ReferenceCount<WorldPacket> & world){
         Global::debug(0) << "Should not have gotten a world packet from the client" << std::endl;
     }
+
+    virtual void handleHash(const PaintownUtil::ReferenceCount<HashPacket> & packet){
+        desync.handleHash(packet);
+    }
     
     virtual void start(){
         handler.start();
@@ -778,6 +900,7 @@ public:
                 stage.updateState(*lastState);
                 stage.setReplay(true);
                 Mugen::Sound::disableSounds();
+                stage.setSimulationOnly(true);
                 uint32_t replay = currentTicks - lastState->getStageData().ticker;
                 for (uint32_t i = 0; i < replay; i++){
                     if (stage.getTicks() == largestInput){
@@ -785,7 +908,9 @@ public:
                     }
 
                     stage.logic();
+                    desync.record(stage);
                 }
+                stage.setSimulationOnly(false);
                 Mugen::Sound::enableSounds();
                 stage.setReplay(false);
 
@@ -820,6 +945,9 @@ public:
             PaintownUtil::ReferenceCount<World> state = stage.snapshotState();
             handler.sendPacket(PaintownUtil::ReferenceCount<Packet>(new WorldPacket(state)));
         }
+
+        desync.record(stage);
+        desync.exchange(stage.getTicks(), handler);
     }
 };
 
@@ -838,6 +966,7 @@ public:
     NetworkClientObserver(Network::Socket socket, const PaintownUtil::ReferenceCount<Character> & player1, const PaintownUtil::ReferenceCount<Character> & player2, HumanBehavior & player1Behavior, NetworkBehavior & player2Behavior):
     NetworkObserver(),
     handler(socket, *this),
+    desync("client"),
     socket(socket),
     player1(player1),
     player2(player2),
@@ -847,6 +976,7 @@ public:
     }
 
     PacketHandler handler;
+    DesyncChecker desync;
 
     Network::Socket socket;
     PaintownUtil::ReferenceCount<Character> player1;
@@ -892,6 +1022,10 @@ public:
     virtual void handleWorld(const PaintownUtil::ReferenceCount<WorldPacket> & packet){
         setWorld(packet->getWorld());
     }
+
+    virtual void handleHash(const PaintownUtil::ReferenceCount<HashPacket> & packet){
+        desync.handleHash(packet);
+    }
     
     virtual void start(){
         handler.start();
@@ -947,12 +1081,15 @@ public:
 
                 stage.setReplay(true);
                 Mugen::Sound::disableSounds();
+                stage.setSimulationOnly(true);
                 for (uint32_t i = 0; i < replayTicks; i++){
                     if (stage.getTicks() == largestInput){
                         lastState = stage.snapshotState();
                     }
                     stage.logic();
+                    desync.record(stage);
                 }
+                stage.setSimulationOnly(false);
                 Mugen::Sound::enableSounds();
                 stage.setReplay(false);
 
@@ -975,6 +1112,9 @@ public:
             */
             handler.sendPacket(PaintownUtil::ReferenceCount<Packet>(new InputPacket(latest, stage.getTicks())));
         // }
+
+        desync.record(stage);
+        desync.exchange(stage.getTicks(), handler);
     }
 };
 
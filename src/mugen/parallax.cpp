@@ -0,0 +1,76 @@
+#include <stdint.h>
+#include "parallax.h"
+
+namespace Mugen{
+
+ParallaxRaster::ParallaxRaster(const Graphics::Bitmap & sprite):
+width(sprite.getWidth()),
+height(sprite.getHeight()),
+mask(Graphics::MaskColor()),
+clipX1(0),
+clipY1(0),
+clipX2(0),
+clipY2(0){
+    pixels.reserve(width * height);
+    sprite.lock();
+    for (int y = 0; y < height; y++){
+        for (int x = 0; x < width; x++){
+            pixels.push_back(sprite.getPixel(x, y));
+        }
+    }
+    sprite.unlock();
+}
+
+void ParallaxRaster::setClip(int x1, int y1, int x2, int y2){
+    clipX1 = x1;
+    clipY1 = y1;
+    clipX2 = x2;
+    clipY2 = y2;
+}
+
+void ParallaxRaster::drawRows(int row, int rows, int x, int y, int length, int height, bool masked, const Graphics::Bitmap & work) const {
+    if (length <= 0 || rows <= 0 || height <= 0){
+        return;
+    }
+
+    /* the part of each row that is inside the clip */
+    int start = x < clipX1 ? clipX1 - x : 0;
+    int end = x + length > clipX2 ? clipX2 - x : length;
+    if (start >= end){
+        return;
+    }
+
+    for (int line = 0; line < height; line++){
+        int source = row + (int) ((int64_t) line * rows / height);
+        int destY = y + line;
+        if (source < 0 || source >= this->height || destY < clipY1 || destY >= clipY2){
+            continue;
+        }
+        drawRow(&pixels[source * width], x, destY, start, end, length, masked, work);
+    }
+}
+
+/* Pixel i of the row comes from pixel i * width / length of the sprite,
+ * which is stepped to with a whole part and a remainder so it's the same
+ * pixel a stretched blit picks.
+ */
+void ParallaxRaster::drawRow(const Graphics::Color * source, int x, int y, int start, int end, int length, bool masked, const Graphics::Bitmap & work) const {
+    const int whole = width / length;
+    const int remainder = width % length;
+    int position = (int) ((int64_t) start * width / length);
+    int error = (int) ((int64_t) start * width % length);
+    for (int i = start; i < end; i++){
+        Graphics::Color color = source[position];
+        if (!masked || color != mask){
+            work.putPixelNormal(x + i, y, color);
+        }
+        position += whole;
+        error += remainder;
+        if (error >= length){
+            error -= length;
+            position += 1;
+        }
+    }
+}
+
+}
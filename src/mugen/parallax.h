@@ -0,0 +1,56 @@
+#ifndef _paintown_mugen_parallax_h
+#define _paintown_mugen_parallax_h
+
+#include <vector>
+#include <r-tech1/graphics/bitmap.h>
+
+namespace Mugen{
+
+/* Draws the rows of a parallax floor straight into the work bitmap. The
+ * pixels of the sprite are copied out once when this is made, then every
+ * scanline is a stretched copy of one of its rows stepped through with
+ * integers. That replaces a stretched blit, and on sff v1 sprites a trip
+ * through getFinalBitmap(), for every row of every tile.
+ *
+ * The source rows and pixels are picked the way a stretched blit picks them,
+ * so the result is the same as Sprite::drawPartStretched without scaling.
+ */
+class ParallaxRaster{
+public:
+    ParallaxRaster(const Graphics::Bitmap & sprite);
+
+    inline int getWidth() const {
+        return width;
+    }
+
+    inline int getHeight() const {
+        return height;
+    }
+
+    /* Nothing outside of x1, y1 to x2, y2 is drawn, x2 and y2 are the first
+     * pixels that are left out.
+     */
+    void setClip(int x1, int y1, int x2, int y2);
+
+    /* Stretches 'rows' rows of the sprite starting at 'row' to 'height' rows
+     * of the work bitmap starting at y, with the left edge at x and each row
+     * 'length' pixels long. Rows past the bottom of the sprite are left out.
+     * If 'masked' pixels that are the mask color are skipped. The work bitmap
+     * has to be locked.
+     */
+    void drawRows(int row, int rows, int x, int y, int length, int height, bool masked, const Graphics::Bitmap & work) const;
+
+protected:
+    void drawRow(const Graphics::Color * source, int x, int y, int start, int end, int length, bool masked, const Graphics::Bitmap & work) const;
+
+    int width;
+    int height;
+    std::vector<Graphics::Color> pixels;
+    Graphics::Color mask;
+
+    int clipX1, clipY1, clipX2, clipY2;
+};
+
+}
+
+#endif
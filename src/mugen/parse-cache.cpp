@@ -1,10 +1,16 @@
 #include <list>
 #include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
 #include <exception>
 #include "parse-cache.h"
 #include "parser/all.h"
+#include "parser/fast.h"
 #include "ast/all.h"
 #include "ast/extra.h"
+#include "ast/binary.h"
+#include "serialize.h"
 #include "globals.h"
 #include <r-tech1/file-system.h>
 #include <r-tech1/system.h>
@@ -30,63 +36,94 @@ static int replaceSlash(int what){
 
 static const char * MUGEN_CACHE = "mugen-cache";
 
-/* true if path1 has a newer modification time than path2 */
-static bool newer(const Filesystem::AbsolutePath & path1, const Filesystem::AbsolutePath & path2){
-    PaintownUtil::ReferenceCount<Storage::File> file1 = Storage::instance().open(path1);
-    PaintownUtil::ReferenceCount<Storage::File> file2 = Storage::instance().open(path2);
-    int modTime1 = file1 != NULL ? file1->getModificationTime() : 0;
-    int modTime2 = file2 != NULL ? file2->getModificationTime() : 0;
-    return modTime1 >= modTime2;
-    // return System::getModificationTime(path1.path()) >= System::getModificationTime(path2.path());
-}
-
-static AstRef loadCached(const Filesystem::AbsolutePath & path){
+/* The whole source file. The parsers read it from memory and the cached
+ * parse is checked against a hash of it.
+ */
+static void readSource(const Filesystem::AbsolutePath & path, vector<char> & data){
     if (!Storage::instance().exists(path)){
-        throw MugenException("Original file does not exist", __FILE__, __LINE__);
+        throw MugenException(path.path() + " does not exist", __FILE__, __LINE__);
     }
-    string converted = Storage::instance().cleanse(path).path();
-    std::transform(converted.begin(), converted.end(), converted.begin(), replaceSlash);
-    Filesystem::AbsolutePath fullPath = Storage::instance().userDirectory().join(Filesystem::RelativePath(MUGEN_CACHE)).join(Filesystem::RelativePath(converted));
-    if (!newer(fullPath, path)){
-        throw MugenException("File is old", __FILE__, __LINE__);
+    Util::ReferenceCount<Storage::File> file = Storage::instance().open(path);
+    if (file->getSize() < 1){
+        throw MugenException(path.path() + " contains no bytes", __FILE__, __LINE__);
     }
-    TokenReader reader;
-    Global::debug(1, "mugen-parse-cache") << "Loading from cache " << fullPath.path() << endl;
-    return PaintownUtil::ReferenceCount<Ast::AstParse>(new Ast::AstParse(reader.readTokenFromFile(fullPath.path().c_str())));
+    data.resize(file->getSize());
+    file->readLine(&data[0], data.size());
 }
 
-static void saveParse(const Filesystem::AbsolutePath & path, const PaintownUtil::ReferenceCount<Ast::AstParse> & parse){
-    ofstream out(path.path().c_str());
-    Token * serial = parse->serialize();
-    serial->toStringCompact(out);
-    out << endl;
-    out.close();
-    delete serial;
+static uint64_t sourceHash(const vector<char> & data){
+    StateHash hash;
+    hash.add(&data[0], data.size());
+    return hash.get();
+}
+
+static Filesystem::AbsolutePath cacheDirectory(){
+    return Storage::instance().userDirectory().join(Filesystem::RelativePath(MUGEN_CACHE));
 }
 
-static void saveCached(const Util::ReferenceCount<Ast::AstParse> & parse, const Filesystem::AbsolutePath & path){
+static Filesystem::AbsolutePath cachePath(const Filesystem::AbsolutePath & path){
     string converted = Storage::instance().cleanse(path).path();
     std::transform(converted.begin(), converted.end(), converted.begin(), replaceSlash);
-    Filesystem::AbsolutePath cache = Storage::instance().userDirectory().join(Filesystem::RelativePath(MUGEN_CACHE));
+    return cacheDirectory().join(Filesystem::RelativePath(converted + ".ast"));
+}
+
+/* The cached parse is only used if it was made from a file with the same
+ * contents, so copying a character around or touching its files doesn't
+ * matter but any edit does.
+ */
+static AstRef loadCached(const Filesystem::AbsolutePath & path, uint64_t source){
+    Filesystem::AbsolutePath fullPath = cachePath(path);
+    ifstream in(fullPath.path().c_str(), ios::in | ios::binary);
+    if (!in.good()){
+        throw MugenException("No cached parse", __FILE__, __LINE__);
+    }
+    ostringstream data;
+    data << in.rdbuf();
+    string bytes = data.str();
+
+    Ast::BinaryReader reader(bytes.data(), bytes.size());
+    if (reader.getSource() != source){
+        throw MugenException("File has changed", __FILE__, __LINE__);
+    }
+    Global::debug(1, "mugen-parse-cache") << "Loading from cache " << fullPath.path() << endl;
+    return AstRef(new Ast::AstParse(Ast::AstParse::readBinary(reader)));
+}
 
+static void saveCached(const AstRef & parse, const Filesystem::AbsolutePath & path, uint64_t source){
+    Filesystem::AbsolutePath cache = cacheDirectory();
     if (!System::isDirectory(cache.path())){
         /* like mkdir -p */
         System::makeAllDirectory(cache.path());
     }
 
-    Filesystem::AbsolutePath fullPath = cache.join(Filesystem::RelativePath(converted));
+    Filesystem::AbsolutePath fullPath = cachePath(path);
     Global::debug(1, "mugen-parse-cache") << "Saving cache to " << fullPath.path() << endl;
-    saveParse(fullPath, parse);
+    Ast::BinaryWriter writer;
+    parse->writeBinary(writer);
+    ofstream out(fullPath.path().c_str(), ios::out | ios::binary);
+    out << writer.finish(source);
+    out.close();
 }
 
-/* attempts to load from a file on disk. if the file doesn't exist then
- * parse it for real and save it to disk.
+/* attempts to load from a file on disk. if the file doesn't exist or was made
+ * from a different version of the source then parse it for real and save it
+ * to disk.
  */
 Util::ReferenceCount<Ast::AstParse> Parser::loadFile(const Filesystem::AbsolutePath & path){
+    vector<char> data;
+    readSource(path, data);
+    uint64_t source = sourceHash(data);
+
+    /* The parse stays in the cache after whoever asked for it is gone, so
+     * it can't use their arena.
+     */
+    PaintownUtil::ReferenceCount<Arena> arena(new Arena());
+    Arena::Scope arenaScope(arena.raw());
+
     try{
-        return loadCached(path);
-    } catch (const TokenException & fail){
-        Global::debug(1, "mugen-parse-cache") << "Cache load warning: " << fail.getTrace() << endl;
+        AstRef cached = loadCached(path, source);
+        cached->setArena(arena);
+        return cached;
     } catch (const MugenException & fail){
         Global::debug(1, "mugen-parse-cache") << "Cache load warning: " << fail.getTrace() << endl;
     } catch (const Filesystem::Exception & fail){
@@ -94,9 +131,10 @@ Util::ReferenceCount<Ast::AstParse> Parser::loadFile(const Filesystem::AbsoluteP
     }
 
     Global::debug(1, "mugen-parse-cache") << "Parsing " << path.path() << endl;
-    Util::ReferenceCount<Ast::AstParse> out = doParse(path);
+    Util::ReferenceCount<Ast::AstParse> out = doParse(data);
+    out->setArena(arena);
     try{
-        saveCached(out, path);
+        saveCached(out, path, source);
     } catch (...){
         Global::debug(0) << "Failed to save cached file " << path.path() << endl;
         /* failed for some reason */
@@ -106,6 +144,7 @@ Util::ReferenceCount<Ast::AstParse> Parser::loadFile(const Filesystem::AbsoluteP
 }
 
 void Parser::destroy(){
+    PaintownUtil::Thread::ScopedLock scoped(lock);
     cache.clear();
 }
 
@@ -132,13 +171,17 @@ static list<Ast::Section*> * copy(list<Ast::Section*> * input){
  * then either load it from disk or parse it.
  * returns a new copy of the AST so you must delete it later.
  */
+/* Matches running on other threads can ask for the same file, so callers
+ * never get a copy of the cached reference (its count isn't thread safe).
+ * Instead they get their own reference that borrows the cached sections.
+ */
 Util::ReferenceCount<Ast::AstParse> Parser::parse(const Filesystem::AbsolutePath & path){
     PaintownUtil::Thread::ScopedLock scoped(lock);
     if (cache[path] == NULL){
         cache[path] = loadFile(path);
     }
 
-    return cache[path];
+    return Util::ReferenceCount<Ast::AstParse>(Ast::AstParse::borrow(*cache[path]));
 }
 
 CmdCache::CmdCache(){
@@ -159,82 +202,97 @@ DefCache::DefCache(){
 DefCache::~DefCache(){
 }
 
-static list<Ast::Section*> * reallyParseX(const Filesystem::AbsolutePath & path, const void * (*parse)(const char * data, int length, bool stats)){
-    if (!Storage::instance().exists(path)){
-        throw MugenException(path.path() + " does not exist", __FILE__, __LINE__);
-    }
-    Util::ReferenceCount<Storage::File> file = Storage::instance().open(path);
-    if (file->getSize() < 1){
-        throw MugenException(path.path() + " contains no bytes", __FILE__, __LINE__);
-    }
+static list<Ast::Section*> * reallyParseX(const vector<char> & data, const void * (*parse)(const char * data, int length, bool stats)){
     /* The PEG interface doesn't know about Paintown's Storage::File interface and
      * it never will so the next best thing is to read the entire file into
      * memory and pass it along to the parser. The PEG will actually do this operation
      * internally anyway given a filename so its not like this is has any overhead.
      */
-    char * data = new char[file->getSize()];
-    file->readLine(data, file->getSize());
-    list<Ast::Section*> * out = NULL;
-    try{
-        out = (list<Ast::Section*>*) parse(data, file->getSize(), false);
-    } catch (...){
-        delete[] data;
-        throw;
+    return (list<Ast::Section*>*) parse(&data[0], data.size(), false);
+}
+
+/* Use the hand written parsers in parser/fast.h instead of the peg ones */
+static bool useFastParser = false;
+
+static list<Ast::Section*> * reallyParseCmd(const vector<char> & data){
+    if (useFastParser){
+        return reallyParseX(data, Fast::parseCmd);
     }
-    delete[] data;
-    return out;
+    return reallyParseX(data, Cmd::parse);
 }
 
-static list<Ast::Section*> * reallyParseCmd(const Filesystem::AbsolutePath & path){
-    return reallyParseX(path, Cmd::parse);
+static list<Ast::Section*> * reallyParseAir(const vector<char> & data){
+    if (useFastParser){
+        return reallyParseX(data, Fast::parseAir);
+    }
+    return reallyParseX(data, Air::parse);
 }
 
-static list<Ast::Section*> * reallyParseAir(const Filesystem::AbsolutePath & path){
-    return reallyParseX(path, Air::parse);
+static list<Ast::Section*> * reallyParseDef(const vector<char> & data){
+    if (useFastParser){
+        return reallyParseX(data, Fast::parseDef);
+    }
+    return reallyParseX(data, Def::parse);
 }
 
-static list<Ast::Section*> * reallyParseDef(const Filesystem::AbsolutePath & path){
-    return reallyParseX(path, Def::parse);
+static list<Ast::Section*> * parseFile(const Filesystem::AbsolutePath & path, list<Ast::Section*> * (*parse)(const vector<char> & data)){
+    vector<char> data;
+    readSource(path, data);
+    return parse(data);
 }
 
-Util::ReferenceCount<Ast::AstParse> CmdCache::doParse(const Filesystem::AbsolutePath & path){
-    return Util::ReferenceCount<Ast::AstParse>(new Ast::AstParse(reallyParseCmd(path)));
+Util::ReferenceCount<Ast::AstParse> CmdCache::doParse(const vector<char> & data){
+    return Util::ReferenceCount<Ast::AstParse>(new Ast::AstParse(reallyParseCmd(data)));
 }
 
-Util::ReferenceCount<Ast::AstParse> AirCache::doParse(const Filesystem::AbsolutePath & path){
-    return Util::ReferenceCount<Ast::AstParse>(new Ast::AstParse(reallyParseAir(path)));
+Util::ReferenceCount<Ast::AstParse> AirCache::doParse(const vector<char> & data){
+    return Util::ReferenceCount<Ast::AstParse>(new Ast::AstParse(reallyParseAir(data)));
 }
 
-Util::ReferenceCount<Ast::AstParse> DefCache::doParse(const Filesystem::AbsolutePath & path){
-    return Util::ReferenceCount<Ast::AstParse>(new Ast::AstParse(reallyParseDef(path)));
+Util::ReferenceCount<Ast::AstParse> DefCache::doParse(const vector<char> & data){
+    return Util::ReferenceCount<Ast::AstParse>(new Ast::AstParse(reallyParseDef(data)));
 }
 
 ParseCache * ParseCache::cache = NULL;
+PaintownUtil::Thread::LockObject ParseCache::cacheLock;
+
+ParseCache * ParseCache::current(){
+    PaintownUtil::Thread::ScopedLock scoped(cacheLock);
+    return cache;
+}
 
 Util::ReferenceCount<Ast::AstParse> ParseCache::parseCmd(const Filesystem::AbsolutePath & path){
-    if (cache == NULL){
-        return Util::ReferenceCount<Ast::AstParse>(new Ast::AstParse(reallyParseCmd(path)));
+    ParseCache * shared = current();
+    if (shared == NULL){
+        return Util::ReferenceCount<Ast::AstParse>(new Ast::AstParse(parseFile(path, reallyParseCmd)));
     }
-    return cache->doParseCmd(path);
+    return shared->doParseCmd(path);
 }
     
 Util::ReferenceCount<Ast::AstParse> ParseCache::parseAir(const Filesystem::AbsolutePath & path){
-    if (cache == NULL){
-        return Util::ReferenceCount<Ast::AstParse>(new Ast::AstParse(reallyParseAir(path)));
+    ParseCache * shared = current();
+    if (shared == NULL){
+        return Util::ReferenceCount<Ast::AstParse>(new Ast::AstParse(parseFile(path, reallyParseAir)));
     }
-    return cache->doParseAir(path);
+    return shared->doParseAir(path);
 }
 
 Util::ReferenceCount<Ast::AstParse> ParseCache::parseDef(const Filesystem::AbsolutePath & path){
-    if (cache == NULL){
-        return Util::ReferenceCount<Ast::AstParse>(new Ast::AstParse(reallyParseDef(path)));
+    ParseCache * shared = current();
+    if (shared == NULL){
+        return Util::ReferenceCount<Ast::AstParse>(new Ast::AstParse(parseFile(path, reallyParseDef)));
     }
-    return cache->doParseDef(path);
+    return shared->doParseDef(path);
+}
+
+void ParseCache::setFastParser(bool fast){
+    useFastParser = fast;
 }
 
 void ParseCache::destroy(){
-    if (cache){
-        cache->destroyCache();
+    ParseCache * shared = current();
+    if (shared){
+        shared->destroyCache();
     }
 }
 
@@ -242,10 +300,11 @@ ParseCache::ParseCache(){
     /* If there is already an existing cache then this object will not be the target of
      * static calls. If there is not an existing cache then this becomes the 'global' one.
      */
+    PaintownUtil::Thread::ScopedLock scoped(cacheLock);
     if (cache == NULL){
         cache = this;
     } else {
-        Global::debug(0) << "Minor bug: a parse cache already exists" << endl;
+        Global::debug(1) << "A parse cache already exists" << endl;
     }
 }
 
@@ -256,6 +315,7 @@ void ParseCache::destroyCache(){
 }
 
 ParseCache::~ParseCache(){
+    PaintownUtil::Thread::ScopedLock scoped(cacheLock);
     if (cache == this){
         cache = NULL;
     }
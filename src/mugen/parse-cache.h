@@ -3,6 +3,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include <r-tech1/thread.h>
 #include <r-tech1/pointer.h>
 #include <r-tech1/file-system.h>
@@ -27,7 +28,8 @@ public:
     void destroy();
 
 protected:
-    virtual PaintownUtil::ReferenceCount<Ast::AstParse> doParse(const Filesystem::AbsolutePath & path) = 0;
+    /* data is the contents of the file */
+    virtual PaintownUtil::ReferenceCount<Ast::AstParse> doParse(const std::vector<char> & data) = 0;
     PaintownUtil::ReferenceCount<Ast::AstParse> loadFile(const Filesystem::AbsolutePath & path);
 
     std::map<const Filesystem::AbsolutePath, PaintownUtil::ReferenceCount<Ast::AstParse> > cache;
@@ -39,7 +41,7 @@ public:
     CmdCache();
     virtual ~CmdCache();
 protected:
-    virtual PaintownUtil::ReferenceCount<Ast::AstParse> doParse(const Filesystem::AbsolutePath & path);
+    virtual PaintownUtil::ReferenceCount<Ast::AstParse> doParse(const std::vector<char> & data);
 };
 
 class AirCache: public Parser {
@@ -48,7 +50,7 @@ public:
     virtual ~AirCache();
 
 protected:
-    virtual PaintownUtil::ReferenceCount<Ast::AstParse> doParse(const Filesystem::AbsolutePath & path);
+    virtual PaintownUtil::ReferenceCount<Ast::AstParse> doParse(const std::vector<char> & data);
 };
 
 class DefCache: public Parser {
@@ -56,9 +58,13 @@ public:
     DefCache();
     virtual ~DefCache();
 protected:
-    virtual PaintownUtil::ReferenceCount<Ast::AstParse> doParse(const Filesystem::AbsolutePath & path);
+    virtual PaintownUtil::ReferenceCount<Ast::AstParse> doParse(const std::vector<char> & data);
 };
 
+/* The first ParseCache made becomes the one the static functions use. Matches
+ * running on several threads share it, so make it before starting them and
+ * keep it around until they are done.
+ */
 class ParseCache{
 public:
     ParseCache();
@@ -71,6 +77,11 @@ public:
 
     /* clear the cache */
     static void destroy();
+
+    /* Parse with the hand written parsers instead of the peg parsers. Set
+     * it before anything is loaded, files already in the cache are kept.
+     */
+    static void setFastParser(bool fast);
 protected:
 
     PaintownUtil::ReferenceCount<Ast::AstParse> doParseCmd(const Filesystem::AbsolutePath & path);
@@ -78,7 +89,10 @@ protected:
     PaintownUtil::ReferenceCount<Ast::AstParse> doParseDef(const Filesystem::AbsolutePath & path);
     void destroyCache();
 
+    static ParseCache * current();
+
     static ParseCache * cache;
+    static PaintownUtil::Thread::LockObject cacheLock;
 
     CmdCache cmdCache;
     AirCache airCache;
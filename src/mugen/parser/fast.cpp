@@ -0,0 +1,2338 @@
+#include <list>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include "mugen/ast/all.h"
+#include "all.h"
+#include "fast.h"
+
+/* Each parser below follows its .peg file rule for rule. A rule is a method
+ * that either consumes its input and returns what it made, or returns
+ * NULL/false with the position where it started. Ordered choices become a
+ * series of attempts from the same position and `(x)*' becomes a loop that
+ * goes back to the start of the last, failed, iteration.
+ *
+ * Nothing is memoized, the few places where the grammar tries the same
+ * rule twice at one position reuse the first result instead.
+ */
+
+using namespace std;
+
+namespace Mugen{
+namespace Fast{
+
+typedef list<Ast::Section*> SectionList;
+
+static inline bool isDigit(char c){
+    return c >= '0' && c <= '9';
+}
+
+static inline bool isLetter(char c){
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static inline bool isAlphaDigit(char c){
+    return isLetter(c) || isDigit(c);
+}
+
+static inline bool isNewline(char c){
+    return c == '\n' || c == '\r';
+}
+
+static inline char lower(char c){
+    if (c >= 'A' && c <= 'Z'){
+        return c - 'A' + 'a';
+    }
+    return c;
+}
+
+/* The peg parsers read every number with an istream */
+static double toNumber(const string & text){
+    istringstream in(text);
+    double value = 0;
+    in >> value;
+    return value;
+}
+
+static void deleteSections(SectionList * sections){
+    for (SectionList::iterator it = sections->begin(); it != sections->end(); it++){
+        delete *it;
+    }
+    delete sections;
+}
+
+class Scanner{
+public:
+    Scanner(const char * buffer, int length):
+    broken(false),
+    buffer(buffer),
+    length(length),
+    position(0),
+    lineChecked(0){
+        lineStarts.push_back(0);
+    }
+
+    /* Set where the peg parser would throw an error. The parse is abandoned
+     * and the peg parser runs instead to report it.
+     */
+    bool broken;
+
+protected:
+    inline char get(int at) const {
+        if (at < length){
+            return buffer[at];
+        }
+        return '\0';
+    }
+
+    inline char current() const {
+        return get(position);
+    }
+
+    inline bool atEnd() const {
+        return position >= length;
+    }
+
+    inline bool match(char c){
+        if (position < length && buffer[position] == c){
+            position += 1;
+            return true;
+        }
+        return false;
+    }
+
+    bool match(const char * text){
+        int at = position;
+        for (const char * c = text; *c != '\0'; c++, at++){
+            if (get(at) != *c){
+                return false;
+            }
+        }
+        position = at;
+        return true;
+    }
+
+    bool matchCase(const char * text){
+        int at = position;
+        for (const char * c = text; *c != '\0'; c++, at++){
+            if (at >= length || lower(buffer[at]) != lower(*c)){
+                return false;
+            }
+        }
+        position = at;
+        return true;
+    }
+
+    /* the first of a NULL terminated list of literals that matches */
+    const char * matchFirst(const char * const * names){
+        for (int i = 0; names[i] != NULL; i++){
+            if (match(names[i])){
+                return names[i];
+            }
+        }
+        return NULL;
+    }
+
+    const char * matchFirstCase(const char * const * names){
+        for (int i = 0; names[i] != NULL; i++){
+            if (matchCase(names[i])){
+                return names[i];
+            }
+        }
+        return NULL;
+    }
+
+    /* rest of the line up to but not including the newline */
+    void restOfLine(){
+        while (position < length && !isNewline(buffer[position])){
+            position += 1;
+        }
+    }
+
+    bool newline(){
+        if (position < length && isNewline(buffer[position])){
+            position += 1;
+            return true;
+        }
+        return false;
+    }
+
+    /* line_end = newline+ | &<eof> */
+    bool lineEnd(){
+        if (newline()){
+            while (newline()){
+            }
+            return true;
+        }
+        return atEnd();
+    }
+
+    /* "[" s name:(!"]" .)+ "]", the name is returned in begin and end */
+    template <class Parser>
+    bool sectionTitle(Parser & parser, int & begin, int & end){
+        int start = position;
+        if (!match('[')){
+            return false;
+        }
+        parser.spaces();
+        begin = position;
+        while (position < length && buffer[position] != ']'){
+            position += 1;
+        }
+        end = position;
+        if (end == begin || !match(']')){
+            position = start;
+            return false;
+        }
+        return true;
+    }
+
+    string text(int begin, int end) const {
+        return string(buffer + begin, end - begin);
+    }
+
+    double digits(int begin, int end) const {
+        /* small enough to be exact as a double */
+        if (end - begin < 16){
+            double value = 0;
+            for (int i = begin; i < end; i++){
+                value = value * 10 + (buffer[i] - '0');
+            }
+            return value;
+        }
+        return toNumber(text(begin, end));
+    }
+
+    /* Lines and columns count from 1. The start of each line is found the
+     * first time a position past it is asked for, after that the line is
+     * a binary search.
+     */
+    int lineAt(int at){
+        for (; lineChecked < at && lineChecked < length; lineChecked++){
+            if (buffer[lineChecked] == '\n'){
+                lineStarts.push_back(lineChecked + 1);
+            }
+        }
+        return upper_bound(lineStarts.begin(), lineStarts.end(), at) - lineStarts.begin();
+    }
+
+    int columnAt(int at){
+        return at - lineStarts[lineAt(at) - 1] + 1;
+    }
+
+    const char * buffer;
+    const int length;
+    int position;
+
+    int lineChecked;
+    vector<int> lineStarts;
+};
+
+/* def.peg */
+class DefParser: public Scanner {
+public:
+    DefParser(const char * buffer, int length):
+    Scanner(buffer, length){
+    }
+
+    SectionList * start(){
+        SectionList * sections = new SectionList();
+        whitespace();
+        while (newline()){
+        }
+        while (!broken){
+            int save = position;
+            if (!line(sections)){
+                position = save;
+                break;
+            }
+            whitespace();
+            lineEnd();
+        }
+
+        if (broken || !atEnd()){
+            deleteSections(sections);
+            return NULL;
+        }
+        return sections;
+    }
+
+    bool space(){
+        return match(' ') || match('\t');
+    }
+
+    void spaces(){
+        while (space()){
+        }
+    }
+
+protected:
+    bool comment(){
+        if (match(';') || match('=')){
+            while (position < length && buffer[position] != '\n'){
+                position += 1;
+            }
+            return true;
+        }
+        if (match("--")){
+            restOfLine();
+            return true;
+        }
+        return false;
+    }
+
+    void whitespace(){
+        while (space() || comment()){
+        }
+    }
+
+    bool line(SectionList * sections){
+        int save = position;
+        spaces();
+        if (comment()){
+            return true;
+        }
+
+        position = save;
+        spaces();
+        Ast::Section * section = this->section();
+        if (section != NULL){
+            sections->push_back(section);
+            return true;
+        }
+
+        position = save;
+        if (space()){
+            spaces();
+            return true;
+        }
+        return false;
+    }
+
+    Ast::Section * section(){
+        int start = position;
+        int begin, end;
+        if (!sectionTitle(*this, begin, end)){
+            return NULL;
+        }
+        /* section_start also allows spaces before the ], but they were
+         * already taken as part of the name
+         */
+        Ast::Section * section = new Ast::Section(new string(text(begin, end)), lineAt(start), columnAt(start));
+        whitespace();
+        if (!newline()){
+            delete section;
+            position = start;
+            return NULL;
+        }
+        while (newline()){
+        }
+
+        while (!broken){
+            int save = position;
+            /* like the peg parser the line is kept even if something
+             * follows it on the same line
+             */
+            if (!sectionLine(section)){
+                position = save;
+                break;
+            }
+            whitespace();
+            if (!lineEnd()){
+                position = save;
+                break;
+            }
+        }
+
+        return section;
+    }
+
+    bool sectionLine(Ast::Section * section){
+        int save = position;
+        spaces();
+        if (comment()){
+            return true;
+        }
+
+        position = save;
+        spaces();
+        Ast::Attribute * attribute = this->attribute();
+        if (attribute != NULL){
+            section->addAttribute(attribute);
+            return true;
+        }
+
+        position = save;
+        spaces();
+        if (matchCase("loopstart")){
+            section->addValue(new Ast::Number(-1, -1, 0));
+            return true;
+        }
+
+        position = save;
+        spaces();
+        Ast::Value * values = valueList();
+        if (values != NULL){
+            section->addValue(values);
+            return true;
+        }
+
+        position = save;
+        if (space()){
+            spaces();
+            if (current() != '['){
+                return true;
+            }
+        }
+        position = save;
+        return false;
+    }
+
+    /* name ("." name)* */
+    Ast::Identifier * identifier(){
+        if (!isLetter(current())){
+            return NULL;
+        }
+        list<string> names;
+        names.push_back(name());
+        while (current() == '.' && isLetter(get(position + 1))){
+            position += 1;
+            names.push_back(name());
+        }
+        return new Ast::Identifier(names);
+    }
+
+    string name(){
+        int begin = position;
+        position += 1;
+        while (isAlphaDigit(current())){
+            position += 1;
+        }
+        return text(begin, position);
+    }
+
+    bool lineEndOrCommentAhead() const {
+        char next = current();
+        return atEnd() || isNewline(next) || next == ';' || next == '=' || (next == '-' && get(position + 1) == '-');
+    }
+
+    Ast::Attribute * attribute(){
+        int start = position;
+        Ast::Identifier * id = identifier();
+        if (id == NULL){
+            return NULL;
+        }
+        int after = position;
+
+        spaces();
+        if (match('=')){
+            spaces();
+            if (lineEndOrCommentAhead()){
+                return new Ast::AttributeSimple(lineAt(start), columnAt(start), id);
+            }
+
+            Ast::Value * data = valueList();
+            if (data == NULL){
+                data = filename();
+            }
+            if (data != NULL){
+                return new Ast::AttributeSimple(lineAt(start), columnAt(start), id, data);
+            }
+        }
+
+        /* id(index) = values is not supported by the peg parser either */
+        position = after;
+        spaces();
+        if (match('(')){
+            spaces();
+            Ast::Value * index = number();
+            if (index != NULL){
+                spaces();
+                if (match(')')){
+                    spaces();
+                    if (match('=')){
+                        spaces();
+                        Ast::Value * data = valueList();
+                        if (data != NULL){
+                            delete data;
+                            broken = true;
+                        }
+                    }
+                }
+                delete index;
+            }
+        }
+
+        delete id;
+        position = start;
+        return NULL;
+    }
+
+    Ast::Attribute * attributeSimple(){
+        int start = position;
+        Ast::Identifier * id = identifier();
+        if (id == NULL){
+            return NULL;
+        }
+        spaces();
+        if (match('=')){
+            spaces();
+            Ast::Value * data = value();
+            if (data != NULL){
+                return new Ast::AttributeSimple(id, data);
+            }
+        }
+        delete id;
+        position = start;
+        return NULL;
+    }
+
+    Ast::Value * valueList(){
+        int start = position;
+        Ast::Value * first = value();
+        if (first == NULL){
+            return NULL;
+        }
+        list<Ast::Value*> values;
+        values.push_back(first);
+        while (true){
+            int next = position;
+            spaces();
+            if (!match(',')){
+                position = next;
+                break;
+            }
+            spaces();
+            Ast::Value * more = value();
+            if (more == NULL){
+                more = new Ast::Keyword(-1, -1, "empty");
+            }
+            values.push_back(more);
+        }
+        return new Ast::ValueList(lineAt(start), columnAt(start), values);
+    }
+
+    bool filenameChar() const {
+        if (atEnd()){
+            return false;
+        }
+        char next = current();
+        return next != ',' && next != '\n' && next != '[' && next != '\r' && next != '=' && next != ';';
+    }
+
+    Ast::Value * filename(){
+        int start = position;
+        if (current() == '"'){
+            return NULL;
+        }
+        while (filenameChar()){
+            position += 1;
+        }
+        if (position == start){
+            return NULL;
+        }
+        return new Ast::Filename(lineAt(start), columnAt(start), new string(text(start, position)));
+    }
+
+    Ast::Value * quoted(){
+        int start = position;
+        if (!match('"')){
+            return NULL;
+        }
+        while (position < length && buffer[position] != '"' && buffer[position] != '\n'){
+            position += 1;
+        }
+        if (!match('"')){
+            position = start;
+            return NULL;
+        }
+        return new Ast::String(-1, -1, new string(text(start + 1, position - 1)));
+    }
+
+    /* dates are not used, they parse as 0 */
+    bool date(){
+        int start = position;
+        const char separators[] = {'.', '/'};
+        for (int i = 0; i < 2; i++){
+            position = start;
+            bool ok = true;
+            for (int part = 0; part < 3 && ok; part++){
+                if (part > 0 && !match(separators[i])){
+                    ok = false;
+                    break;
+                }
+                int begin = position;
+                while (isDigit(current())){
+                    position += 1;
+                }
+                ok = position > begin;
+            }
+            if (ok){
+                return true;
+            }
+        }
+        position = start;
+        return false;
+    }
+
+    Ast::Value * number(){
+        int start = position;
+        char sign = current();
+        if (sign == '-' || sign == '+'){
+            position += 1;
+        } else {
+            sign = 0;
+        }
+
+        int left = position;
+        while (isDigit(current())){
+            position += 1;
+        }
+        int leftEnd = position;
+
+        double value = 0;
+        if (match('.')){
+            int right = position;
+            while (isDigit(current())){
+                position += 1;
+            }
+            if (position == right){
+                position = start;
+                return NULL;
+            }
+            value = toNumber(text(left, leftEnd) + "." + text(right, position));
+        } else {
+            if (leftEnd == left){
+                position = start;
+                return NULL;
+            }
+            value = digits(left, leftEnd);
+        }
+
+        if (sign == '-'){
+            value = -value;
+        }
+        return new Ast::Number(-1, -1, value);
+    }
+
+    Ast::Value * value(){
+        int start = position;
+        Ast::Value * out = quoted();
+        if (out != NULL){
+            return out;
+        }
+
+        if (date()){
+            return new Ast::Number(-1, -1, 0);
+        }
+
+        out = number();
+        if (out != NULL){
+            if (!isLetter(current()) && current() != '-'){
+                return out;
+            }
+            delete out;
+            position = start;
+        }
+
+        Ast::Attribute * attribute = attributeSimple();
+        if (attribute != NULL){
+            return new Ast::ValueAttribute(-1, -1, attribute);
+        }
+
+        static const char * keywords[] = {"normal", "parallax", "addalpha", "add1", "add", "sub", NULL};
+        const char * keyword = matchFirst(keywords);
+        if (keyword != NULL){
+            if (!isAlphaDigit(current())){
+                return new Ast::Keyword(-1, -1, keyword);
+            }
+            position = start;
+        }
+
+        static const char * letters[] = {"s", "h", NULL};
+        for (int i = 0; letters[i] != NULL; i++){
+            if (matchCase(letters[i])){
+                if (!filenameChar() && current() != '.'){
+                    return new Ast::Keyword(-1, -1, letters[i]);
+                }
+                position = start;
+            }
+        }
+
+        if (matchCase("a")){
+            delete number();
+            if (!filenameChar()){
+                return new Ast::Keyword(-1, -1, "a");
+            }
+            position = start;
+        }
+
+        return filename();
+    }
+};
+
+/* air.peg */
+class AirParser: public Scanner {
+public:
+    AirParser(const char * buffer, int length):
+    Scanner(buffer, length){
+    }
+
+    SectionList * start(){
+        SectionList * sections = new SectionList();
+        whitespace();
+        while (newline()){
+        }
+        while (!broken){
+            int save = position;
+            spacesAndNewlines();
+            if (!line(sections)){
+                position = save;
+                break;
+            }
+            whitespace();
+            lineEnd();
+        }
+        spacesAndNewlines();
+
+        if (broken || !atEnd()){
+            deleteSections(sections);
+            return NULL;
+        }
+        return sections;
+    }
+
+    bool space(){
+        if (position < length && (buffer[position] == ' ' || buffer[position] == '\t' || (unsigned char) buffer[position] == 255)){
+            position += 1;
+            return true;
+        }
+        return false;
+    }
+
+    void spaces(){
+        while (space()){
+        }
+    }
+
+protected:
+    void spacesAndNewlines(){
+        while (space() || newline()){
+        }
+    }
+
+    bool comment(){
+        if (match(';') || match('=') || match("--")){
+            restOfLine();
+            return true;
+        }
+        return false;
+    }
+
+    void whitespace(){
+        while (space() || comment()){
+        }
+    }
+
+    bool line(SectionList * sections){
+        int save = position;
+        spaces();
+        if (comment()){
+            return true;
+        }
+
+        position = save;
+        spaces();
+        Ast::Section * section = action();
+        if (section != NULL){
+            sections->push_back(section);
+            return true;
+        }
+        return false;
+    }
+
+    /* "[" s "Begin" s "Action" s num:integer s (!"]" .)* "]" */
+    string * actionStart(){
+        int start = position;
+        if (match('[')){
+            spaces();
+            if (matchCase("Begin")){
+                spaces();
+                if (matchCase("Action")){
+                    spaces();
+                    Ast::Value * number = integer();
+                    if (number != NULL){
+                        spaces();
+                        while (position < length && buffer[position] != ']'){
+                            position += 1;
+                        }
+                        if (match(']')){
+                            string * header = new string("Begin Action " + number->toString());
+                            delete number;
+                            return header;
+                        }
+                        delete number;
+                    }
+                }
+            }
+        }
+        position = start;
+        return NULL;
+    }
+
+    Ast::Section * action(){
+        int start = position;
+        string * header = actionStart();
+        if (header == NULL){
+            return NULL;
+        }
+        Ast::Section * section = new Ast::Section(header);
+        whitespace();
+        if (!newline()){
+            delete section;
+            position = start;
+            return NULL;
+        }
+        while (newline()){
+        }
+
+        while (!broken){
+            int save = position;
+            if (!actionLine(section)){
+                position = save;
+                break;
+            }
+            whitespace();
+            if (!lineEnd()){
+                position = save;
+                break;
+            }
+        }
+
+        return section;
+    }
+
+    bool actionLine(Ast::Section * section){
+        int save = position;
+        spaces();
+        if (comment()){
+            return true;
+        }
+
+        position = save;
+        spaces();
+        Ast::Attribute * attribute = collisionDefault();
+        if (attribute == NULL){
+            position = save;
+            spaces();
+            attribute = collision();
+        }
+        if (attribute != NULL){
+            section->addAttribute(attribute);
+            return true;
+        }
+
+        position = save;
+        spaces();
+        Ast::Value * values = valueList();
+        if (values != NULL){
+            section->addValue(values);
+            return true;
+        }
+
+        position = save;
+        spaces();
+        if (matchCase("loopstart")){
+            match(':');
+            section->addAttribute(new Ast::AttributeKeyword(-1, -1, new Ast::Keyword(-1, -1, "loopstart")));
+            return true;
+        }
+
+        position = save;
+        if (space()){
+            spaces();
+            return true;
+        }
+
+        /* anything else up to the end of the line is skipped, unless it
+         * starts the next action
+         */
+        position = save;
+        spaces();
+        string * header = actionStart();
+        if (header != NULL){
+            delete header;
+            position = save;
+            return false;
+        }
+        position = save;
+        if (atEnd() || isNewline(current())){
+            return false;
+        }
+        restOfLine();
+        cout << "Warning: ignoring input at line " << lineAt(save) << " column " << columnAt(save) << endl;
+        return true;
+    }
+
+    Ast::Attribute * collisionDefault(){
+        static const char * names[] = {"Clsn2Default", "Clsn1Default", "Clsn2", "Clsn1", NULL};
+        int start = position;
+        for (int i = 0; names[i] != NULL; i++){
+            position = start;
+            if (matchCase(names[i]) && match(':')){
+                spaces();
+                Ast::Value * number = integer();
+                if (number != NULL){
+                    return new Ast::AttributeKeyword(-1, -1, new Ast::Keyword(-1, -1, names[i]), number);
+                }
+            }
+        }
+        position = start;
+        return NULL;
+    }
+
+    /* name s "[" s index s "]" s "=" s n1 s "," s n2 s "," s n3 s "," s n4 */
+    Ast::Attribute * collision(){
+        static const char * names[] = {"Clsn2", "Clsn1", "Clsn", NULL};
+        int start = position;
+        for (int i = 0; names[i] != NULL; i++){
+            position = start;
+            if (!matchCase(names[i])){
+                continue;
+            }
+            spaces();
+            if (!match('[')){
+                continue;
+            }
+            spaces();
+            Ast::Value * index = integer();
+            if (index == NULL){
+                continue;
+            }
+            spaces();
+            if (match(']')){
+                spaces();
+                if (match('=')){
+                    spaces();
+                    list<Ast::Value*> box;
+                    while (box.size() < 4){
+                        if (box.size() > 0){
+                            spaces();
+                            if (!match(',')){
+                                break;
+                            }
+                            spaces();
+                        }
+                        Ast::Value * number = integer();
+                        if (number == NULL){
+                            break;
+                        }
+                        box.push_back(number);
+                    }
+                    if (box.size() == 4){
+                        return new Ast::AttributeArray(-1, -1, new Ast::Keyword(-1, -1, names[i]), index, new Ast::ValueList(box));
+                    }
+                    for (list<Ast::Value*>::iterator it = box.begin(); it != box.end(); it++){
+                        delete *it;
+                    }
+                }
+            }
+            delete index;
+        }
+        position = start;
+        return NULL;
+    }
+
+    Ast::Value * integer(){
+        int start = position;
+        char sign = current();
+        if (sign == '-' || sign == '+'){
+            position += 1;
+        } else {
+            sign = 0;
+        }
+        int begin = position;
+        while (isDigit(current())){
+            position += 1;
+        }
+        if (position == begin){
+            position = start;
+            return NULL;
+        }
+        double value = digits(begin, position);
+        if (sign == '-'){
+            value = -value;
+        }
+        return new Ast::Number(-1, -1, value);
+    }
+
+    Ast::Value * valueList(){
+        Ast::Value * first = value();
+        if (first == NULL){
+            return NULL;
+        }
+        list<Ast::Value*> values;
+        values.push_back(first);
+        while (true){
+            int next = position;
+            spaces();
+            if (!match(',')){
+                position = next;
+                break;
+            }
+            spaces();
+            Ast::Value * more = value();
+            if (more == NULL){
+                more = new Ast::Keyword(-1, -1, "empty");
+            }
+            values.push_back(more);
+        }
+        return new Ast::ValueList(values);
+    }
+
+    /* a prefix followed by a number as one keyword, like a1 or as5d1 */
+    Ast::Value * prefixed(const char * prefix){
+        int start = position;
+        if (!matchCase(prefix)){
+            return NULL;
+        }
+        Ast::Value * source = integer();
+        if (source == NULL){
+            position = start;
+            return NULL;
+        }
+        string out = prefix + source->toString();
+        delete source;
+        return new Ast::Keyword(-1, -1, out);
+    }
+
+    Ast::Value * value(){
+        Ast::Value * out = integer();
+        if (out != NULL){
+            return out;
+        }
+
+        int start = position;
+        Ast::Value * source = prefixed("as");
+        if (source != NULL){
+            if (matchCase("d")){
+                Ast::Value * dest = integer();
+                if (dest != NULL){
+                    string keyword = source->toString() + "d" + dest->toString();
+                    delete source;
+                    delete dest;
+                    return new Ast::Keyword(-1, -1, keyword);
+                }
+            }
+            delete source;
+            position = start;
+        }
+
+        static const char * letters[] = {"a", "s", NULL};
+        for (int i = 0; letters[i] != NULL; i++){
+            out = prefixed(letters[i]);
+            if (out != NULL){
+                return out;
+            }
+            if (matchCase(letters[i])){
+                return new Ast::Keyword(-1, -1, letters[i]);
+            }
+        }
+
+        static const char * flips[] = {"vh", "hv", "v", "h", NULL};
+        const char * flip = matchFirstCase(flips);
+        if (flip != NULL){
+            return new Ast::Keyword(-1, -1, flip);
+        }
+
+        return NULL;
+    }
+};
+
+/* cmd.peg, which is used for .cmd, .cns and .st files */
+class CmdParser: public Scanner {
+public:
+    CmdParser(const char * buffer, int length):
+    Scanner(buffer, length){
+    }
+
+    SectionList * start(){
+        SectionList * sections = new SectionList();
+        whitespace();
+        while (newline()){
+        }
+        while (!broken){
+            int save = position;
+            spacesAndNewlines();
+            if (!line(sections)){
+                position = save;
+                break;
+            }
+            whitespace();
+            lineEnd();
+        }
+        spacesAndNewlines();
+
+        if (broken || !atEnd()){
+            deleteSections(sections);
+            return NULL;
+        }
+        return sections;
+    }
+
+    bool space(){
+        return match(' ') || match('\t');
+    }
+
+    void spaces(){
+        while (space()){
+        }
+    }
+
+protected:
+    typedef Ast::ExpressionInfix::InfixType InfixType;
+
+    void spacesAndNewlines(){
+        while (space() || newline()){
+        }
+    }
+
+    bool comment(){
+        if (match(';') || match('=') || match("--") || match("::")){
+            restOfLine();
+            return true;
+        }
+        return false;
+    }
+
+    void whitespace(){
+        while (space() || comment()){
+        }
+    }
+
+    bool lineEndAhead() const {
+        return atEnd() || isNewline(current());
+    }
+
+    bool line(SectionList * sections){
+        int save = position;
+        spaces();
+        Ast::Section * section = this->section();
+        if (section != NULL){
+            sections->push_back(section);
+            return true;
+        }
+
+        /* text before the first section is skipped */
+        position = save;
+        restOfLine();
+        if (newline()){
+            return true;
+        }
+        position = save;
+        return false;
+    }
+
+    Ast::Section * section(){
+        int start = position;
+        int begin, end;
+        if (!sectionTitle(*this, begin, end)){
+            return NULL;
+        }
+        Ast::Section * section = new Ast::Section(new string(text(begin, end)), lineAt(start), columnAt(start));
+        whitespace();
+        while (!broken){
+            int save = position;
+            spacesAndNewlines();
+            if (!sectionItem(section)){
+                position = save;
+                break;
+            }
+        }
+        return section;
+    }
+
+    bool sectionItem(Ast::Section * section){
+        int save = position;
+        spaces();
+        Ast::Attribute * attribute = assignment();
+        if (attribute != NULL){
+            whitespace();
+            if (lineEnd()){
+                section->addAttribute(attribute);
+                return true;
+            }
+            delete attribute;
+        }
+        if (broken){
+            return false;
+        }
+
+        position = save;
+        Ast::Identifier * name = identifier();
+        if (name != NULL){
+            spaces();
+            if (match('=')){
+                int begin = position;
+                restOfLine();
+                int end = position;
+                lineEnd();
+                cout << "Warning: invalid line at " << lineAt(save) << " '" << name->toString() << " =" << text(begin, end) << "'" << endl;
+                delete name;
+                return true;
+            }
+            delete name;
+        }
+
+        /* anything else up to the end of the line is skipped, unless it
+         * starts the next section
+         */
+        position = save;
+        spaces();
+        int begin, end;
+        if (sectionTitle(*this, begin, end)){
+            position = save;
+            return false;
+        }
+        position = save;
+        if (lineEndAhead()){
+            return false;
+        }
+        restOfLine();
+        return lineEnd();
+    }
+
+    Ast::Attribute * assignment(){
+        int start = position;
+        if (matchCase("command")){
+            spaces();
+            if (match('=')){
+                spaces();
+                return new Ast::AttributeSimple(new Ast::SimpleIdentifier(-1, -1, "command"), keys());
+            }
+        }
+
+        position = start;
+        Ast::Identifier * name = identifier();
+        if (name != NULL){
+            int after = position;
+            spaces();
+            if (match('=')){
+                spaces();
+                Ast::Value * value = expression();
+                if (value != NULL){
+                    return new Ast::AttributeSimple(lineAt(start), columnAt(start), name, value);
+                }
+            }
+
+            position = after;
+            spaces();
+            if (match("!=")){
+                spaces();
+                Ast::Value * value = expression();
+                if (value != NULL){
+                    return new Ast::AttributeSimple(name, new Ast::ExpressionUnary(-1, -1, Ast::ExpressionUnary::Negation, value));
+                }
+            }
+
+            position = after;
+            spaces();
+            if (match('=')){
+                whitespace();
+                if (lineEndAhead()){
+                    return new Ast::AttributeSimple(name);
+                }
+            }
+
+            position = after;
+            spaces();
+            if (match('(')){
+                spaces();
+                Ast::Value * index = integer();
+                if (index != NULL){
+                    spaces();
+                    if (match(')')){
+                        spaces();
+                        if (match('=')){
+                            spaces();
+                            Ast::Value * value = expression();
+                            if (value != NULL){
+                                return new Ast::AttributeArray(-1, -1, name, index, value);
+                            }
+                        }
+                    }
+                    delete index;
+                }
+            }
+            delete name;
+        }
+
+        position = start;
+        if (matchCase("ctrl")){
+            return new Ast::AttributeSimple(new Ast::SimpleIdentifier("ctrl"), new Ast::Number(-1, -1, 1));
+        }
+        return NULL;
+    }
+
+    /* keys are never missing, a command with no keys gets an empty list */
+    Ast::Key * keys(){
+        vector<Ast::Key*> all;
+        Ast::Key * first = key();
+        if (first == NULL){
+            return new Ast::KeyList(-1, -1, all);
+        }
+        all.push_back(first);
+        while (true){
+            int next = position;
+            spaces();
+            if (match(',')){
+                spaces();
+                Ast::Key * more = key();
+                if (more != NULL){
+                    all.push_back(more);
+                    continue;
+                }
+            }
+            position = next;
+            break;
+        }
+
+        int next = position;
+        spaces();
+        if (!match(',')){
+            position = next;
+        }
+        return new Ast::KeyList(-1, -1, all);
+    }
+
+    Ast::Key * key(){
+        int start = position;
+        Ast::Key * left = keyReal();
+        if (left == NULL){
+            return NULL;
+        }
+        while (true){
+            int next = position;
+            spaces();
+            if (match('+')){
+                spaces();
+                Ast::Key * right = keyReal();
+                if (right != NULL){
+                    left = new Ast::KeyCombined(-1, -1, left, right);
+                    continue;
+                }
+            }
+            position = next;
+            break;
+        }
+
+        /* !identifier */
+        if (isLetter(current())){
+            delete left;
+            position = start;
+            return NULL;
+        }
+        return left;
+    }
+
+    Ast::Key * keyReal(){
+        int start = position;
+        vector<Ast::KeyModifier::ModifierType> modifiers;
+        vector<int> ticks;
+        while (true){
+            if (match('~')){
+                int begin = position;
+                while (isDigit(current())){
+                    position += 1;
+                }
+                modifiers.push_back(Ast::KeyModifier::Release);
+                ticks.push_back((int) digits(begin, position));
+            } else if (match('$')){
+                modifiers.push_back(Ast::KeyModifier::Direction);
+                ticks.push_back(0);
+            } else if (match('/')){
+                modifiers.push_back(Ast::KeyModifier::MustBeHeldDown);
+                ticks.push_back(0);
+            } else if (match('>')){
+                modifiers.push_back(Ast::KeyModifier::Only);
+                ticks.push_back(0);
+            } else {
+                break;
+            }
+        }
+
+        static const char * names[] = {"DB", "B", "DF", "D", "F", "UF", "UB", "U", "a", "b", "c", "x", "y", "z", "s", NULL};
+        const char * name = matchFirst(names);
+        if (name == NULL){
+            position = start;
+            return NULL;
+        }
+
+        Ast::Key * key = new Ast::KeySingle(-1, -1, name);
+        for (unsigned int i = 0; i < modifiers.size(); i++){
+            key = new Ast::KeyModifier(-1, -1, modifiers[i], key, ticks[i]);
+        }
+        return key;
+    }
+
+    Ast::Identifier * identifier(){
+        if (!isLetter(current())){
+            return NULL;
+        }
+        int start = position;
+        list<string> names;
+        names.push_back(name());
+        while (current() == '.' && isLetter(get(position + 1))){
+            position += 1;
+            names.push_back(name());
+        }
+        return new Ast::Identifier(lineAt(start), columnAt(start), names);
+    }
+
+    string name(){
+        int begin = position;
+        position += 1;
+        while (isAlphaDigit(current())){
+            position += 1;
+        }
+        return text(begin, position);
+    }
+
+    Ast::Value * integer(){
+        int start = position;
+        bool sign = current() == '-' || current() == '+';
+        if (sign){
+            position += 1;
+        }
+        int begin = position;
+        while (isDigit(current())){
+            position += 1;
+        }
+        if (position == begin){
+            position = start;
+            return NULL;
+        }
+        double value = digits(begin, position);
+        /* makeInteger in cmd.peg negates the number for either sign */
+        if (sign){
+            value = -value;
+        }
+        return new Ast::Number(lineAt(start), columnAt(start), value);
+    }
+
+    Ast::Value * floating(){
+        int start = position;
+        char sign = current();
+        if (sign == '-' || sign == '+'){
+            position += 1;
+        } else {
+            sign = 0;
+        }
+        int left = position;
+        while (isDigit(current())){
+            position += 1;
+        }
+        int leftEnd = position;
+        if (match('.')){
+            int right = position;
+            while (isDigit(current())){
+                position += 1;
+            }
+            double value = 0;
+            if (position > right){
+                value = toNumber(text(left, leftEnd) + "." + text(right, position));
+            } else if (leftEnd > left){
+                value = digits(left, leftEnd);
+            } else {
+                position = start;
+                return NULL;
+            }
+            return new Ast::Number(-1, -1, sign == '-' ? -value : value);
+        }
+        position = start;
+        return NULL;
+    }
+
+    Ast::Value * quoted(){
+        int start = position;
+        if (!match('"')){
+            return NULL;
+        }
+        while (position < length && buffer[position] != '"' && buffer[position] != '\n'){
+            position += 1;
+        }
+        if (!match('"')){
+            position = start;
+            return NULL;
+        }
+        return new Ast::String(-1, -1, new string(text(start + 1, position - 1)));
+    }
+
+    static inline bool isHitFlag(char c){
+        return c == 'H' || c == 'A' || c == 'M' || c == 'F' || c == 'D' || c == 'L';
+    }
+
+    Ast::Value * hitflag(){
+        int start = position;
+        while (isHitFlag(current())){
+            position += 1;
+        }
+        if (position == start){
+            return NULL;
+        }
+        int end = position;
+        /* makeHitFlags in cmd.peg reads the modifier but loses it, so MAF+
+         * is just MAF
+         */
+        if (current() == '+' || current() == '-'){
+            position += 1;
+        }
+        if (current() == '.'){
+            position = start;
+            return NULL;
+        }
+        return new Ast::SimpleIdentifier(text(start, end));
+    }
+
+    struct Axis{
+        const char * name;
+        const char * axis;
+        const char * keyword;
+    };
+
+    Ast::Value * keyword(){
+        static const Axis axes[] = {
+            {"vel", "y", "vel y"},
+            {"vel", "x", "vel x"},
+            {"pos", "y", "pos y"},
+            {"pos", "x", "pos x"},
+            {"p2dist", "x", "p2dist x"},
+            {"p2dist", "y", "p2dist y"},
+            {"p1dist", "x", "p1dist x"},
+            {"p1dist", "y", "p1dist y"},
+            {"p2bodydist", "x", "p2bodydist x"},
+            {"p2bodydist", "y", "p2bodydist y"},
+            {"p1bodydist", "x", "p1bodydist x"},
+            {"p1bodydist", "y", "p1bodydist y"},
+            {"parentdist", "x", "parentdist x"},
+            {"screenpos", "x", "screenpos x"},
+            {"screenpos", "y", "screenpos y"},
+            {"parentdist", "y", "parentdist y"},
+            {"rootdist", "x", "rootdist x"},
+            {"rootdist", "y", "rootdist y"},
+            {NULL, NULL, NULL}
+        };
+
+        int start = position;
+        Ast::Value * out = NULL;
+        char first = lower(current());
+        if (first == 'v' || first == 'p' || first == 's' || first == 'r'){
+            for (int i = 0; axes[i].name != NULL; i++){
+                position = start;
+                if (matchCase(axes[i].name) && space()){
+                    spaces();
+                    if (matchCase(axes[i].axis)){
+                        out = new Ast::Keyword(-1, -1, axes[i].keyword);
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (out == NULL){
+            position = start;
+            out = hitflag();
+        }
+
+        if (out != NULL && isAlphaDigit(current())){
+            delete out;
+            out = NULL;
+        }
+
+        if (out == NULL){
+            position = start;
+        }
+        return out;
+    }
+
+    bool keywordAhead(){
+        int start = position;
+        Ast::Value * out = keyword();
+        position = start;
+        if (out != NULL){
+            delete out;
+            return true;
+        }
+        return false;
+    }
+
+    const char * functionName(){
+        static const char * names[] = {
+            "abs", "const", "selfanimexist", "ifelse", "gethitvar", "floor",
+            "ceil", "exp", "acos", "asin", "atan", "tan", "cos", "sin", "log",
+            "ln", "sysfvar", "sysvar", "var", "numexplod", "numhelper",
+            "numprojid", "fvar", "ishelper", "numtarget", "animelemtime",
+            "animelemno", "animexist", "playeridexist", "projguarded",
+            "projcanceltime", "projhittime", "projhit", "projcontacttime",
+            "projcontact", NULL
+        };
+        return matchFirstCase(names);
+    }
+
+    bool lookingAt(const char * const * names){
+        int start = position;
+        bool found = matchFirstCase(names) != NULL;
+        position = start;
+        return found;
+    }
+
+    bool functionNameAhead(){
+        int start = position;
+        bool found = functionName() != NULL;
+        position = start;
+        return found;
+    }
+
+    /* words that start with s or f but aren't resources */
+    bool resourceS(){
+        static const char * names[] = {
+            "stateno", "statetime", "statetype", "selfstate", "slidetime",
+            "statetypeset", "superpause", "screenbound", "sprpriority",
+            "sndpan", "stopsnd", "size.xscale", "size.yscale",
+            "size.ground.back", "size.ground.front", "size.air.back",
+            "size.air.front", "size.height", "size.attack.dist",
+            "size.proj.attack.dist", "size.proj.doscale", "size.head.pos.x",
+            "size.head.pos.y", "size.mid.pos.x", "size.mid.pos.y",
+            "size.shadowoffset", "size.draw.offset.x", "size.draw.offset.y",
+            NULL
+        };
+        return lookingAt(names) || functionNameAhead() || keywordAhead();
+    }
+
+    bool resourceF(){
+        static const char * names[] = {
+            "frontedgebodydist", "frontedgedist", "front", "forcefeedback",
+            "fallenvshake", "facing", "fallcount", "fall.damage", "fall.xvel",
+            "fall.yvel", "fall.recover", "fall.time", "fall.recovertime",
+            "fall", NULL
+        };
+        return lookingAt(names) || functionNameAhead() || keywordAhead();
+    }
+
+    Ast::Value * resource(){
+        int start = position;
+        char first = lower(current());
+        if (first == 's' && !resourceS()){
+            match(current());
+            /* don't take hitdef attributes like SCA */
+            char next = lower(current());
+            if (next != 'c' && next != 'a'){
+                Ast::Value * any = expressionC();
+                if (any != NULL){
+                    return new Ast::Resource(-1, -1, any, false, true);
+                }
+            }
+        } else if (first == 'f' && !resourceF()){
+            match(current());
+            Ast::Value * any = expressionC();
+            if (any != NULL){
+                return new Ast::Resource(-1, -1, any, true, false);
+            }
+        }
+        position = start;
+        return NULL;
+    }
+
+    Ast::Value * value(){
+        Ast::Value * out = floating();
+        if (out == NULL){
+            out = integer();
+        }
+        if (out == NULL){
+            out = keyword();
+        }
+        if (out == NULL){
+            out = resource();
+        }
+        if (out == NULL){
+            out = identifier();
+        }
+        if (out == NULL){
+            out = range();
+        }
+        if (out == NULL){
+            out = quoted();
+        }
+        if (out == NULL){
+            out = hitflag();
+        }
+        return out;
+    }
+
+    static Ast::Range::RangeType rangeType(char open, char close){
+        if (open == '['){
+            return close == ']' ? Ast::Range::AllInclusive : Ast::Range::LeftInclusiveRightExclusive;
+        }
+        return close == ')' ? Ast::Range::AllExclusive : Ast::Range::LeftExclusiveRightInclusive;
+    }
+
+    Ast::Value * range(){
+        int start = position;
+        char open = current();
+        if (open != '[' && open != '('){
+            return NULL;
+        }
+        position += 1;
+        spaces();
+        Ast::Value * low = expressionC();
+        if (low != NULL){
+            spaces();
+            if (match(',')){
+                spaces();
+                Ast::Value * high = expressionC();
+                if (high != NULL){
+                    spaces();
+                    char close = current();
+                    if (close == ']' || close == ')'){
+                        position += 1;
+                        return new Ast::Range(-1, -1, rangeType(open, close), low, high);
+                    }
+                    delete high;
+                }
+            }
+            delete low;
+        }
+        position = start;
+        return NULL;
+    }
+
+    /* A range like (1, 2] or an expression in parentheses. The peg parser
+     * tries the range first and then the expression from the beginning, so
+     * nested parentheses would be parsed again and again, instead the part
+     * they share is parsed once.
+     */
+    Ast::Value * rangeOrParenthesis(){
+        int start = position;
+        position += 1;
+        spaces();
+        Ast::Value * inside = NULL;
+        Ast::Value * low = expressionC();
+        if (low == NULL){
+            inside = commaList();
+        } else {
+            int afterLow = position;
+            spaces();
+            if (match(',')){
+                spaces();
+                Ast::Value * high = expressionC();
+                if (high == NULL){
+                    delete low;
+                    position = start;
+                    return NULL;
+                }
+                int afterHigh = position;
+                spaces();
+                char close = current();
+                if (close == ']' || close == ')'){
+                    position += 1;
+                    return new Ast::Range(-1, -1, rangeType('(', close), low, high);
+                }
+                position = afterHigh;
+                list<Ast::Value*> values;
+                values.push_back(low);
+                values.push_back(high);
+                moreValues(values);
+                inside = binaryRest(2, new Ast::ValueList(values));
+            } else {
+                position = afterLow;
+                inside = low;
+            }
+        }
+
+        if (inside != NULL){
+            spaces();
+            if (match(')')){
+                return inside;
+            }
+            delete inside;
+        }
+        position = start;
+        return NULL;
+    }
+
+    /* (s "," s expr_c)* */
+    void moreValues(list<Ast::Value*> & values){
+        while (true){
+            int next = position;
+            spaces();
+            if (match(',')){
+                spaces();
+                Ast::Value * more = expressionC();
+                if (more != NULL){
+                    values.push_back(more);
+                    continue;
+                }
+            }
+            position = next;
+            break;
+        }
+    }
+
+    /* the second form of valuelist, which starts with a comma */
+    Ast::Value * commaList(){
+        int start = position;
+        spaces();
+        if (match(',')){
+            spaces();
+            Ast::Value * first = expressionC();
+            if (first != NULL){
+                list<Ast::Value*> values;
+                values.push_back(first);
+                moreValues(values);
+                return binaryRest(2, new Ast::ValueList(values));
+            }
+        }
+        position = start;
+        return NULL;
+    }
+
+    /* expr = expr_c !(s ",") | valuelist expr2_rest */
+    Ast::Value * expression(){
+        int start = position;
+        Ast::Value * first = expressionC();
+        if (first == NULL){
+            return commaList();
+        }
+
+        int after = position;
+        spaces();
+        if (current() != ','){
+            position = after;
+            return first;
+        }
+        position = after;
+
+        list<Ast::Value*> values;
+        values.push_back(first);
+        moreValues(values);
+        if (values.size() == 1){
+            delete first;
+            position = start;
+            return NULL;
+        }
+        return binaryRest(2, new Ast::ValueList(values));
+    }
+
+    struct Operator{
+        const char * text;
+        InfixType type;
+    };
+
+    /* The operators of expr_rest through expr12_rest, loosest first. At
+     * each level the first operator that matches is taken.
+     */
+    static const Operator * operators(int level){
+        static const Operator level1[] = {{"||", Ast::ExpressionInfix::Or}, {NULL, Ast::ExpressionInfix::Or}};
+        static const Operator level2[] = {{"^^", Ast::ExpressionInfix::XOr}, {NULL, Ast::ExpressionInfix::Or}};
+        static const Operator level3[] = {{"&&", Ast::ExpressionInfix::And}, {NULL, Ast::ExpressionInfix::Or}};
+        static const Operator level4[] = {{"|", Ast::ExpressionInfix::BitwiseOr}, {NULL, Ast::ExpressionInfix::Or}};
+        static const Operator level5[] = {{"^", Ast::ExpressionInfix::BitwiseXOr}, {NULL, Ast::ExpressionInfix::Or}};
+        static const Operator level6[] = {{"&", Ast::ExpressionInfix::BitwiseAnd}, {NULL, Ast::ExpressionInfix::Or}};
+        static const Operator level7[] = {{":=", Ast::ExpressionInfix::Assignment}, {NULL, Ast::ExpressionInfix::Or}};
+        static const Operator level8[] = {{"=", Ast::ExpressionInfix::Equals}, {"!=", Ast::ExpressionInfix::Unequals}, {NULL, Ast::ExpressionInfix::Or}};
+        static const Operator level9[] = {{"<=", Ast::ExpressionInfix::LessThanEquals}, {">=", Ast::ExpressionInfix::GreaterThanEquals}, {"<", Ast::ExpressionInfix::LessThan}, {">", Ast::ExpressionInfix::GreaterThan}, {NULL, Ast::ExpressionInfix::Or}};
+        static const Operator level10[] = {{"+", Ast::ExpressionInfix::Add}, {"-", Ast::ExpressionInfix::Subtract}, {NULL, Ast::ExpressionInfix::Or}};
+        static const Operator level11[] = {{"*", Ast::ExpressionInfix::Multiply}, {"/", Ast::ExpressionInfix::Divide}, {"%", Ast::ExpressionInfix::Modulo}, {NULL, Ast::ExpressionInfix::Or}};
+        static const Operator level12[] = {{"**", Ast::ExpressionInfix::Power}, {NULL, Ast::ExpressionInfix::Or}};
+        static const Operator * levels[] = {NULL, level1, level2, level3, level4, level5, level6, level7, level8, level9, level10, level11, level12};
+        return levels[level];
+    }
+
+    /* expr_c is level 1 */
+    Ast::Value * expressionC(){
+        return binary(1);
+    }
+
+    /* exprN = left:exprN+1 exprN_rest(left) */
+    Ast::Value * binary(int level){
+        Ast::Value * left = level == 12 ? unary() : binary(level + 1);
+        if (left == NULL){
+            return NULL;
+        }
+        return binaryRest(level, left);
+    }
+
+    Ast::Value * binaryRest(int level, Ast::Value * left){
+        const Operator * all = operators(level);
+        while (true){
+            int next = position;
+            spaces();
+            const Operator * found = NULL;
+            for (const Operator * check = all; check->text != NULL; check++){
+                if (match(check->text)){
+                    found = check;
+                    break;
+                }
+            }
+            if (found != NULL){
+                spaces();
+                Ast::Value * right = level == 12 ? unary() : binary(level + 1);
+                if (right != NULL){
+                    left = new Ast::ExpressionInfix(-1, -1, found->type, left, right);
+                    continue;
+                }
+            }
+            position = next;
+            return left;
+        }
+    }
+
+    /* expr13 = unary* s expr13_real */
+    Ast::Value * unary(){
+        int start = position;
+        vector<Ast::ExpressionUnary::UnaryType> unaries;
+        while (true){
+            char next = current();
+            if (next == '!'){
+                unaries.push_back(Ast::ExpressionUnary::Not);
+            } else if (next == '-' && !isDigit(get(position + 1))){
+                unaries.push_back(Ast::ExpressionUnary::Minus);
+            } else if (next == '~'){
+                unaries.push_back(Ast::ExpressionUnary::Negation);
+            } else {
+                break;
+            }
+            position += 1;
+        }
+        spaces();
+
+        Ast::Value * value = primary();
+        if (value == NULL){
+            position = start;
+            return NULL;
+        }
+        for (vector<Ast::ExpressionUnary::UnaryType>::iterator it = unaries.begin(); it != unaries.end(); it++){
+            value = new Ast::ExpressionUnary(-1, -1, *it, value);
+        }
+        return value;
+    }
+
+    /* expr13_real = helper | function | value | "(" s expr s ")" */
+    Ast::Value * primary(){
+        /* only a range or parentheses can start with ( */
+        if (current() == '('){
+            return rangeOrParenthesis();
+        }
+        Ast::Value * out = helper();
+        if (out == NULL){
+            out = function();
+        }
+        if (out == NULL){
+            out = value();
+        }
+        return out;
+    }
+
+    Ast::Value * helper(){
+        static const char * names[] = {"parent", "root", "helper", "target", "partner", "enemyNear", "enemy", "playerid", NULL};
+        int start = position;
+        const char * name = matchFirstCase(names);
+        if (name == NULL){
+            return NULL;
+        }
+        spaces();
+
+        /* helper-expression? */
+        Ast::Value * id = NULL;
+        int next = position;
+        if (match('(')){
+            spaces();
+            id = expressionC();
+            if (id != NULL){
+                spaces();
+                if (!match(')')){
+                    delete id;
+                    id = NULL;
+                }
+            }
+            if (id == NULL){
+                position = next;
+            }
+        }
+
+        spaces();
+        if (match(',')){
+            spaces();
+            Ast::Value * to = function();
+            if (to == NULL){
+                to = keyword();
+            }
+            if (to == NULL){
+                to = identifier();
+            }
+            if (to != NULL){
+                return new Ast::Helper(-1, -1, name, id, to);
+            }
+        }
+        delete id;
+        position = start;
+        return NULL;
+    }
+
+    /* all_compare = compare | compare_equal */
+    bool compare(InfixType & type){
+        static const Operator compares[] = {
+            {"<=", Ast::ExpressionInfix::LessThanEquals},
+            {">=", Ast::ExpressionInfix::GreaterThanEquals},
+            {"<", Ast::ExpressionInfix::LessThan},
+            {">", Ast::ExpressionInfix::GreaterThan},
+            {"=", Ast::ExpressionInfix::Equals},
+            {"!=", Ast::ExpressionInfix::Unequals},
+            {NULL, Ast::ExpressionInfix::Or}
+        };
+        for (const Operator * check = compares; check->text != NULL; check++){
+            if (match(check->text)){
+                type = check->type;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool compareEqual(InfixType & type){
+        if (match('=')){
+            type = Ast::ExpressionInfix::Equals;
+            return true;
+        }
+        if (match("!=")){
+            type = Ast::ExpressionInfix::Unequals;
+            return true;
+        }
+        return false;
+    }
+
+    static Ast::Value * function1(const char * name, Ast::Value * argument){
+        return new Ast::Function(-1, -1, name, new Ast::ValueList(argument));
+    }
+
+    Ast::Value * function(){
+        int start = position;
+
+        if (matchCase("teammode")){
+            int after = position;
+            spaces();
+            if (match('=')){
+                spaces();
+                Ast::Value * argument = identifier();
+                if (argument != NULL){
+                    return function1("teammode", argument);
+                }
+            }
+            position = after;
+            spaces();
+            if (match("!=")){
+                spaces();
+                Ast::Value * argument = identifier();
+                if (argument != NULL){
+                    return function1("teammode!=", argument);
+                }
+            }
+        }
+
+        /* animelem = n, [compare] time becomes animelemtime(n) compare time,
+         * without the time it is animelemtime(n) = 0
+         */
+        position = start;
+        if (matchCase("animelem")){
+            InfixType ignore;
+            spaces();
+            if (compare(ignore)){
+                spaces();
+                Ast::Value * element = integer();
+                if (element != NULL){
+                    int after = position;
+                    spaces();
+                    if (match(',')){
+                        spaces();
+                        InfixType comparison = Ast::ExpressionInfix::Equals;
+                        compare(comparison);
+                        spaces();
+                        Ast::Value * time = integer();
+                        if (time != NULL){
+                            return new Ast::ExpressionInfix(-1, -1, comparison, function1("animelemtime", element), time);
+                        }
+                    }
+                    position = after;
+                    return new Ast::ExpressionInfix(-1, -1, Ast::ExpressionInfix::Equals, function1("animelemtime", element), new Ast::Number(-1, -1, 0));
+                }
+            }
+        }
+
+        /* timemod = m, n is (time % m) = n */
+        position = start;
+        if (matchCase("timemod")){
+            InfixType ignore;
+            spaces();
+            if (compare(ignore)){
+                spaces();
+                Ast::Value * modulo = integer();
+                if (modulo != NULL){
+                    spaces();
+                    if (match(',')){
+                        spaces();
+                        compare(ignore);
+                        spaces();
+                        Ast::Value * to = integer();
+                        if (to != NULL){
+                            Ast::Value * time = new Ast::SimpleIdentifier(lineAt(start), columnAt(start), "time");
+                            return new Ast::ExpressionInfix(-1, -1, Ast::ExpressionInfix::Equals, new Ast::ExpressionInfix(-1, -1, Ast::ExpressionInfix::Modulo, time, modulo), to);
+                        }
+                    }
+                    delete modulo;
+                }
+            }
+        }
+
+        position = start;
+        Ast::Value * out = projectile(start);
+        if (out != NULL){
+            return out;
+        }
+
+        position = start;
+        if (matchCase("hitdefattr")){
+            InfixType comparison;
+            spaces();
+            if (compareEqual(comparison)){
+                spaces();
+                Ast::Value * state = hitDefAttribute();
+                if (state != NULL){
+                    spaces();
+                    if (match(',')){
+                        spaces();
+                        Ast::Value * attributes = hitDefAttackAttribute();
+                        if (attributes != NULL){
+                            Ast::Value * compareState = new Ast::ExpressionInfix(-1, -1, comparison, new Ast::SimpleIdentifier("hitdefattr:state"), state);
+                            Ast::Value * compareAttribute = new Ast::ExpressionInfix(-1, -1, comparison, new Ast::SimpleIdentifier("hitdefattr:attribute"), attributes);
+                            return new Ast::ExpressionInfix(-1, -1, Ast::ExpressionInfix::And, compareState, compareAttribute);
+                        }
+                    }
+                    delete state;
+                }
+            }
+            /* the peg parser stops with an error here */
+            broken = true;
+            position = start;
+            return NULL;
+        }
+
+        position = start;
+        const char * name = functionName();
+        if (name != NULL){
+            spaces();
+            if (match('(')){
+                spaces();
+                Ast::Value * first = expressionC();
+                if (first != NULL){
+                    list<Ast::Value*> values;
+                    values.push_back(first);
+                    moreValues(values);
+                    Ast::ValueList * arguments = new Ast::ValueList(values);
+                    spaces();
+                    if (match(')')){
+                        return new Ast::Function(-1, -1, name, arguments);
+                    }
+                    delete arguments;
+                }
+            }
+        }
+
+        position = start;
+        return NULL;
+    }
+
+    /* projhit(id) = 1, < 10 is projhit(id, 1, arg0 < 10) where the first
+     * argument of the expression is filled in when it runs
+     */
+    Ast::Value * projectile(int start){
+        static const char * names[] = {"projhit", "projguarded", "projcontact", NULL};
+        const char * name = matchFirstCase(names);
+        if (name == NULL){
+            return NULL;
+        }
+
+        /* paren_integer? */
+        Ast::Value * id = NULL;
+        int next = position;
+        if (match('(')){
+            spaces();
+            id = integer();
+            if (id != NULL){
+                spaces();
+                if (!match(')')){
+                    delete id;
+                    id = NULL;
+                }
+            }
+        }
+        if (id == NULL){
+            position = next;
+            id = integer();
+        }
+
+        spaces();
+        if (match('=')){
+            spaces();
+            Ast::Value * argument = integer();
+            if (argument != NULL){
+                int line = lineAt(start);
+                int column = columnAt(start);
+                /* The generated code for (s "," s compare s ticks)? makes each
+                 * part optional on its own, going back to where the group
+                 * started when one doesn't match. So the comma can be left
+                 * out and a value without a comparison is skipped.
+                 */
+                int after = position;
+                spaces();
+                if (!match(',')){
+                    position = after;
+                }
+                spaces();
+                InfixType type;
+                bool compared = compare(type);
+                if (!compared){
+                    position = after;
+                }
+                spaces();
+                Ast::Value * ticks = value();
+                if (ticks == NULL){
+                    position = after;
+                }
+
+                Ast::Value * comparison = NULL;
+                if (compared && ticks != NULL){
+                    comparison = new Ast::ExpressionInfix(-1, -1, type, new Ast::Argument(line, column, 0), ticks);
+                } else if (compared){
+                    /* the peg parser makes a comparison with nothing on the
+                     * right side here, leave it to fail the way it does
+                     */
+                    broken = true;
+                    delete argument;
+                    delete id;
+                    return NULL;
+                } else {
+                    delete ticks;
+                    comparison = new Ast::ExpressionInfix(-1, -1, Ast::ExpressionInfix::LessThanEquals, new Ast::Argument(line, column, 0), new Ast::Number(-1, -1, 1));
+                }
+                if (id == NULL){
+                    id = new Ast::Number(-1, -1, 0);
+                }
+                list<Ast::Value*> arguments;
+                arguments.push_back(id);
+                arguments.push_back(argument);
+                arguments.push_back(comparison);
+                return new Ast::Function(line, column, name, new Ast::ValueList(arguments));
+            }
+        }
+        delete id;
+        return NULL;
+    }
+
+    /* state types like SCA */
+    Ast::Value * hitDefAttribute(){
+        string out;
+        while (true){
+            char next = lower(current());
+            if (next != 's' && next != 'c' && next != 'a'){
+                break;
+            }
+            out += next;
+            position += 1;
+        }
+        if (out.size() == 0){
+            return NULL;
+        }
+        return new Ast::HitDefAttribute(-1, -1, out);
+    }
+
+    /* attack types like NA, SP */
+    bool hitDefAttackItem(Ast::HitDefAttackAttribute * attribute){
+        char type = lower(current());
+        char movement = lower(get(position + 1));
+        if ((type == 'n' || type == 's' || type == 'h' || type == 'a') &&
+            (movement == 'a' || movement == 't' || movement == 'p')){
+            string item;
+            item += type;
+            item += movement;
+            attribute->addAttribute(item);
+            position += 2;
+            return true;
+        }
+        return false;
+    }
+
+    Ast::Value * hitDefAttackAttribute(){
+        Ast::HitDefAttackAttribute * attribute = new Ast::HitDefAttackAttribute(-1, -1);
+        if (!hitDefAttackItem(attribute)){
+            delete attribute;
+            return NULL;
+        }
+        while (true){
+            int next = position;
+            spaces();
+            if (match(',')){
+                spaces();
+                if (hitDefAttackItem(attribute)){
+                    continue;
+                }
+            }
+            position = next;
+            break;
+        }
+        return attribute;
+    }
+};
+
+SectionList * tryParseDef(const char * in, int length){
+    DefParser parser(in, length);
+    return parser.start();
+}
+
+SectionList * tryParseAir(const char * in, int length){
+    AirParser parser(in, length);
+    return parser.start();
+}
+
+SectionList * tryParseCmd(const char * in, int length){
+    CmdParser parser(in, length);
+    return parser.start();
+}
+
+const void * parseDef(const char * in, int length, bool stats){
+    SectionList * out = tryParseDef(in, length);
+    if (out != NULL){
+        return out;
+    }
+    return Def::parse(in, length, stats);
+}
+
+const void * parseAir(const char * in, int length, bool stats){
+    SectionList * out = tryParseAir(in, length);
+    if (out != NULL){
+        return out;
+    }
+    return Air::parse(in, length, stats);
+}
+
+const void * parseCmd(const char * in, int length, bool stats){
+    SectionList * out = tryParseCmd(in, length);
+    if (out != NULL){
+        return out;
+    }
+    return Cmd::parse(in, length, stats);
+}
+
+}
+}
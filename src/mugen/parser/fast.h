@@ -0,0 +1,40 @@
+#ifndef _paintown_mugen_parser_fast_h
+#define _paintown_mugen_parser_fast_h
+
+#include <list>
+
+namespace Ast{
+    class Section;
+}
+
+/* Hand written parsers for the def, air and cmd/cns formats. They make the
+ * same sections as the peg parsers generated from def.peg, air.peg and
+ * cmd.peg, but read the input once from front to back, only going back a few
+ * characters when an alternative doesn't match, instead of keeping a column
+ * of memoized results for every position and garbage collecting the nodes
+ * afterwards.
+ *
+ * The grammars are followed rule for rule so any input the peg parsers
+ * accept gives an equal list of sections. Line and column numbers can be
+ * different where the peg parsers get them wrong.
+ */
+namespace Mugen{
+namespace Fast{
+
+/* Same interface as Def::parse, Air::parse and Cmd::parse. If the input can't
+ * be parsed the peg parser is run on it instead, so errors are reported the
+ * way they always were.
+ */
+const void * parseDef(const char * in, int length, bool stats = false);
+const void * parseAir(const char * in, int length, bool stats = false);
+const void * parseCmd(const char * in, int length, bool stats = false);
+
+/* Only the hand written parsers, NULL if the input can't be parsed */
+std::list<Ast::Section*> * tryParseDef(const char * in, int length);
+std::list<Ast::Section*> * tryParseAir(const char * in, int length);
+std::list<Ast::Section*> * tryParseCmd(const char * in, int length);
+
+}
+}
+
+#endif
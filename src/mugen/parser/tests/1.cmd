@@ -0,0 +1,140 @@
+; The CMD file.
+;-| Super Motions |--------------------------------------------------------
+[Command]
+name = "TripleKFPalm"
+command = ~D, DF, F, D, DF, F, x
+time = 20
+
+[Command]
+name = "TripleKFPalm"   ;Same name as above
+command = ~D, DF, F, D, DF, F, y
+time = 20
+
+[Command]
+name = "SmashKFUpper"
+command = ~D, DB, B, D, DB, B, x+y
+time = 20
+
+;-| Special Motions |------------------------------------------------------
+[Command]
+name = "upper_xy"
+command = ~F, D, DF, x+y
+
+[Command]
+name = "QCF_x"
+command = ~D, DF, F, x
+
+[Command]
+name = "blocking"
+command = /$B
+time = 1
+
+[Command]
+name = "charge"
+command = ~30$B, F, a
+time = 10
+buffer.time = 1
+
+[Command]
+name = "recovery"
+command = x+y
+time = 1
+
+[Command]
+name = "release"
+command = ~a
+time = 1
+
+[Command]
+name = "fwd_only"
+command = >F, >F
+time = 10
+
+[Command]
+name = "holdfwd"
+command = /$F
+time = 1
+
+[Command]
+name = "holdup";Required (do not remove)
+command = /$U
+time = 1
+
+[Command]
+name = "start"
+command = s
+time = 1
+
+[Command]
+name = "empty"
+command =
+time = 1
+
+[Defaults]
+command.time = 15
+command.buffer.time = 1
+
+[Statedef -1]
+
+;===========================================================================
+;Smash Kung Fu Upper
+[State -1, Smash Kung Fu Upper]
+type = ChangeState
+value = 3050
+triggerall = command = "SmashKFUpper"
+triggerall = power >= 2000
+trigger1 = statetype = S
+trigger1 = ctrl
+trigger2 = hitdefattr = SC, NA, SA, HA
+trigger2 = stateno != [200,299]
+trigger2 = movecontact
+trigger3 = stateno = 1310 || stateno = 1330 ;From blocking
+
+[State -1, Triple Kung Fu Palm]
+type = ChangeState
+value = 3000
+triggerall = command = "TripleKFPalm"
+triggerall = power >= 1000
+trigger1 = statetype = S
+trigger1 = ctrl
+trigger2 = hitdefattr = SC, NA, SA
+trigger2 = movecontact
+trigger3 = (stateno = [1000, 1010)) && time > 5
+trigger4 = stateno = (1100, 1199]
+trigger5 = var(1) && !(p2statetype = L) || (1 + 2) * 3 > -var(2)
+
+[State -1, Run Fwd]
+type = ChangeState
+value = 100
+trigger1 = command = "FF"
+trigger1 = statetype = S
+trigger1 = ctrl
+
+[State -1, Misc]
+type = ChangeState
+value = ifelse(var(3) = 1, 1030, 1000 + (random % 3))
+trigger1 = teammode = single
+trigger2 = teammode != turns
+trigger3 = animelem = 3, >= 2
+trigger4 = animelem = 5
+trigger5 = timemod = 3, 0
+trigger6 = projhit = 1, < 20
+trigger7 = projguarded1234 = 1
+trigger8 = projcontact(2) = 0, > 3
+trigger9 = numhelper(1000) < 2 && helper(1000), stateno = 1001
+trigger10 = root, var(2) ^^ parent, fvar(3) ** 2
+trigger11 = enemynear(1), pos x < -20.5 | 3 & ~4 ^ 5
+trigger12 = p2bodydist x = [0, 40] && p2dist y <= -10.
+trigger13 = vel y > 0 && screenpos x != 3 && .5 < 1
+trigger14 = target, movetype = H
+trigger15 = playerid(var(40)), alive
+trigger16 = abs(vel x) % 2 = 1 && floor(1.5) >= ceil(0.4)
+trigger17 = var(10) := 3 + 4
+trigger18 = 1, 2, 3
+trigger19 = 3 = (1, 2, 3)
+trigger20 = const(velocity.walk.fwd.x) / 2 = const(size.height)
+trigger21 = (((((((((((((((((((1)))))))))))))))))))
+trigger22 = gethitvar(fall.yvel) = -3 && sysvar(0) - +1
+trigger23 = !!-time
+trigger24 = selfanimexist(s1000 + 1)
+trigger25 = frontedgedist > 10 && facing = 1 && fall.recover
@@ -1,4 +1,6 @@
 #include "random.h"
+#include "simulation.h"
+#include "serialize.h"
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
@@ -10,6 +12,19 @@ Random::Random(){
     init();
 }
 
+Random::Random(uint32_t seed){
+    index = 0;
+    /* splitmix64 to spread the seed over the whole state */
+    uint64_t mix = seed;
+    for (int i = 0; i < 16; i++){
+        mix += 0x9E3779B97F4A7C15ULL;
+        uint64_t value = mix;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        state[i] = value ^ (value >> 31);
+    }
+}
+
 Random::Random(const Random & copy){
     memcpy(state, copy.state, sizeof(state));
     index = copy.index;
@@ -44,7 +59,21 @@ uint64_t Random::next(){
     state[index] = a^b^d^(a<<2)^(b<<18)^(c<<28);
     return state[index];
 }
+
+Random Random::split(){
+    Random out(*this);
+    out.index = 0;
+    for (int i = 0; i < 16; i++){
+        out.state[i] = next();
+    }
+    return out;
+}
     
+void Random::digest(StateHash & out) const {
+    out.add(state, sizeof(state));
+    out.add(&index, sizeof(index));
+}
+
 Token * Random::serialize() const {
     Token * token = new Token();
     *token << "random";
@@ -75,17 +104,12 @@ Random Random::deserialize(const Token * token){
     return out;
 }
 
-PaintownUtil::ReferenceCount<Random> Random::current;
 PaintownUtil::ReferenceCount<Random> Random::getState(){
-    if (current == NULL){
-        current = PaintownUtil::ReferenceCount<Random>(new Random());
-    }
-
-    return current;
+    return Simulation::current().getRandom();
 }
     
 void Random::setState(const Random & what){
-    current = PaintownUtil::ReferenceCount<Random>(new Random(what));
+    Simulation::current().setRandom(what);
 }
 
 uint32_t Random::random(){
@@ -9,34 +9,43 @@ class Token;
 
 namespace Mugen{
 
+class StateHash;
+
 /* Uses the WELL 512 random algorithm.
  * http://www.iro.umontreal.ca/~panneton/WELLRNG.html
  */
 class Random{
 public:
-    /* Uses time() for default initialization */
+    /* Uses rand() for default initialization */
     Random();
+    /* Always produces the same sequence for the same seed */
+    explicit Random(uint32_t seed);
     Random(const Random & copy);
 
     Random & operator=(const Random &);
 
     uint64_t next();
 
+    /* A new generator seeded from the next numbers of this one */
+    Random split();
+
     static uint32_t random();
 
+    /* The generator of the current Simulation */
     static PaintownUtil::ReferenceCount<Random> getState();
     static void setState(const Random & what);
 
     Token * serialize() const;
     static Random deserialize(const Token * token);
 
+    /* Feeds the generator's state into the hash */
+    void digest(StateHash & out) const;
+
 protected:
     void init();
 
     uint64_t state[16];
     uint32_t index;
-
-    static PaintownUtil::ReferenceCount<Random> current;
 };
 
 uint32_t random();
@@ -0,0 +1,233 @@
+#include "replay.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <r-tech1/file-system.h>
+#include "constraint.h"
+#include "serialize.h"
+#include "stage.h"
+#include "exception.h"
+
+using namespace std;
+
+namespace Mugen{
+
+namespace PaintownUtil = ::Util;
+
+/* Layout of a replay file, all numbers are little endian varints:
+ *
+ *   "MRPL" format seed stage stage-version
+ *   then for each player: name version behavior runs (input ticks)*
+ *
+ * Strings are a varint length followed by the bytes.
+ */
+static const char * ReplayMagic = "MRPL";
+static const uint32_t ReplayFormat = 1;
+
+static void writeNumber(string & out, uint64_t value){
+    while (value >= 0x80){
+        out += (char) ((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += (char) value;
+}
+
+static void writeString(string & out, const string & value){
+    writeNumber(out, value.size());
+    out += value;
+}
+
+class ReplayReader{
+public:
+    ReplayReader(const string & data):
+    data(data),
+    position(0){
+    }
+
+    uint64_t number(){
+        uint64_t out = 0;
+        int shift = 0;
+        while (true){
+            if (position >= data.size() || shift > 63){
+                throw MugenException("Replay file is truncated", __FILE__, __LINE__);
+            }
+            unsigned char byte = data[position];
+            position += 1;
+            out |= (uint64_t) (byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0){
+                return out;
+            }
+            shift += 7;
+        }
+    }
+
+    string text(){
+        uint64_t length = number();
+        if (length > data.size() - position){
+            throw MugenException("Replay file is truncated", __FILE__, __LINE__);
+        }
+        string out = data.substr(position, length);
+        position += length;
+        return out;
+    }
+
+    const string & data;
+    unsigned int position;
+};
+
+InputReplay::Player::Player():
+version(0){
+}
+
+uint32_t InputReplay::Player::ticks() const {
+    uint32_t out = 0;
+    for (vector<Run>::const_iterator it = runs.begin(); it != runs.end(); it++){
+        out += it->ticks;
+    }
+    return out;
+}
+
+InputReplay::InputReplay():
+seed(0),
+stageVersion(0){
+}
+
+void InputReplay::save(const Filesystem::AbsolutePath & path) const {
+    string out = ReplayMagic;
+    writeNumber(out, ReplayFormat);
+    writeNumber(out, seed);
+    writeString(out, stage);
+    writeNumber(out, stageVersion);
+    for (int i = 0; i < 2; i++){
+        const Player & player = players[i];
+        writeString(out, player.name);
+        writeNumber(out, player.version);
+        writeString(out, player.behavior);
+        writeNumber(out, player.runs.size());
+        for (vector<Run>::const_iterator it = player.runs.begin(); it != player.runs.end(); it++){
+            writeNumber(out, it->input);
+            writeNumber(out, it->ticks);
+        }
+    }
+
+    ofstream file(path.path().c_str(), ios::binary);
+    file.write(out.data(), out.size());
+    if (!file.good()){
+        throw MugenException("Could not write replay " + path.path(), __FILE__, __LINE__);
+    }
+}
+
+InputReplay InputReplay::load(const Filesystem::AbsolutePath & path){
+    ifstream file(path.path().c_str(), ios::binary);
+    if (!file.good()){
+        throw MugenException("Could not open replay " + path.path(), __FILE__, __LINE__);
+    }
+    ostringstream contents;
+    contents << file.rdbuf();
+    string data = contents.str();
+
+    if (data.compare(0, 4, ReplayMagic) != 0){
+        throw MugenException(path.path() + " is not a replay", __FILE__, __LINE__);
+    }
+
+    ReplayReader reader(data);
+    reader.position = 4;
+    uint64_t format = reader.number();
+    if (format != ReplayFormat){
+        ostringstream out;
+        out << "Unknown replay format " << format << " in " << path.path();
+        throw MugenException(out.str(), __FILE__, __LINE__);
+    }
+
+    InputReplay out;
+    out.seed = reader.number();
+    out.stage = reader.text();
+    out.stageVersion = reader.number();
+    for (int i = 0; i < 2; i++){
+        Player & player = out.players[i];
+        player.name = reader.text();
+        player.version = reader.number();
+        player.behavior = reader.text();
+        uint64_t runs = reader.number();
+        for (uint64_t run = 0; run < runs; run++){
+            uint32_t input = reader.number();
+            uint32_t ticks = reader.number();
+            player.runs.push_back(Run(input, ticks));
+        }
+    }
+
+    return out;
+}
+
+uint64_t InputReplay::fileVersion(const Filesystem::AbsolutePath & path){
+    PaintownUtil::ReferenceCount<Storage::File> file = Storage::instance().open(path);
+    if (file == NULL){
+        return 0;
+    }
+
+    int size = file->getSize();
+    vector<char> data(size + 1);
+    file->readLine(&data[0], size);
+
+    StateHash hash;
+    hash.add(&data[0], size);
+    return hash.get();
+}
+
+RecordBehavior::RecordBehavior(Behavior & behavior, InputReplay::Player & player):
+behavior(behavior),
+player(player){
+}
+
+vector<string> RecordBehavior::currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed){
+    vector<string> out = behavior.currentCommands(stage, owner, commands, reversed);
+    player.add(commands.getLastInput());
+    return out;
+}
+
+void RecordBehavior::flip(){
+    behavior.flip();
+}
+
+void RecordBehavior::hit(Object * enemy){
+    behavior.hit(enemy);
+}
+
+void RecordBehavior::latch(bool reversed){
+    behavior.latch(reversed);
+}
+
+RecordBehavior::~RecordBehavior(){
+}
+
+ReplayBehavior::ReplayBehavior(const InputReplay::Player & player):
+player(player),
+run(0),
+ticks(0){
+}
+
+vector<string> ReplayBehavior::currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed){
+    uint32_t input = 0;
+    if (run < player.runs.size()){
+        const InputReplay::Run & current = player.runs[run];
+        input = current.input;
+        ticks += 1;
+        if (ticks == current.ticks){
+            run += 1;
+            ticks = 0;
+        }
+    }
+
+    vector<string> out;
+    commands.handle(CommandAutomaton::bitsInput(input), stage.getTicks(), out);
+    return out;
+}
+
+void ReplayBehavior::flip(){
+}
+
+ReplayBehavior::~ReplayBehavior(){
+}
+
+}
@@ -0,0 +1,119 @@
+#ifndef _paintown_mugen_replay_h
+#define _paintown_mugen_replay_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <r-tech1/file-system.h>
+#include "behavior.h"
+
+namespace Mugen{
+
+/* A match recorded as the raw input of each player. Together with the seed
+ * of the random number generator that is enough to play the match again,
+ * since the game logic is deterministic.
+ *
+ * The input of a tick is the bitmask from CommandAutomaton::inputBits and
+ * consecutive ticks with the same input are stored as one run, so holding
+ * a direction for a second costs a few bytes.
+ */
+class InputReplay{
+public:
+    InputReplay();
+
+    struct Run{
+        Run(uint32_t input, uint32_t ticks):
+            input(input),
+            ticks(ticks){
+            }
+
+        uint32_t input;
+        uint32_t ticks;
+    };
+
+    struct Player{
+        Player();
+
+        /* name of the character as given to the game mode */
+        std::string name;
+        /* hash of the character's def file */
+        uint64_t version;
+        /* 'input' if the inputs drive the player, otherwise the behavior
+         * that made the inputs (ai, random, dummy), which plays the
+         * same way again given the same seed.
+         */
+        std::string behavior;
+        std::vector<Run> runs;
+
+        inline void add(uint32_t input){
+            if (runs.size() > 0 && runs.back().input == input){
+                runs.back().ticks += 1;
+            } else {
+                runs.push_back(Run(input, 1));
+            }
+        }
+
+        uint32_t ticks() const;
+    };
+
+    uint32_t seed;
+    std::string stage;
+    uint64_t stageVersion;
+    Player players[2];
+
+    /* Throws MugenException if the file can't be written */
+    void save(const Filesystem::AbsolutePath & path) const;
+    /* Throws MugenException if the file is not a replay */
+    static InputReplay load(const Filesystem::AbsolutePath & path);
+
+    /* Hash of a file's contents, used to check that a replay is played with
+     * the same characters and stage it was recorded with.
+     */
+    static uint64_t fileVersion(const Filesystem::AbsolutePath & path);
+};
+
+/* Passes through to another behavior and records the input it gave the
+ * command automaton each tick.
+ */
+class RecordBehavior: public Behavior {
+public:
+    RecordBehavior(Behavior & behavior, InputReplay::Player & player);
+
+    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed);
+    virtual void flip();
+    virtual void hit(Object * enemy);
+    virtual void latch(bool reversed);
+
+    virtual ~RecordBehavior();
+
+protected:
+    Behavior & behavior;
+    InputReplay::Player & player;
+};
+
+/* Feeds the recorded input of a player back in, one tick at a time. After
+ * the recording runs out no keys are pressed.
+ */
+class ReplayBehavior: public Behavior {
+public:
+    ReplayBehavior(const InputReplay::Player & player);
+
+    virtual std::vector<std::string> currentCommands(const Stage & stage, Character * owner, CommandAutomaton & commands, bool reversed);
+    virtual void flip();
+
+    /* true once all the recorded input has been used */
+    inline bool done() const {
+        return run >= player.runs.size();
+    }
+
+    virtual ~ReplayBehavior();
+
+protected:
+    const InputReplay::Player & player;
+    unsigned int run;
+    uint32_t ticks;
+};
+
+}
+
+#endif
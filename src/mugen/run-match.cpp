@@ -1,5 +1,6 @@
 #include <string>
 #include <ostream>
+#include <stdint.h>
 
 #include <r-tech1/graphics/bitmap.h>
 #include <r-tech1/sound/music.h>
@@ -7,6 +8,8 @@
 #include <r-tech1/system.h>
 #include <r-tech1/console.h>
 #include <r-tech1/message-queue.h>
+#include <r-tech1/thread.h>
+#include <r-tech1/funcs.h>
 // #include <r-tech1/lz4/lz4.h>
 #include <r-tech1/init.h>
 #include "game.h"
@@ -341,7 +344,12 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
         options(options),
         show(true),
         showGameSpeed(0),
-        escapeMenu(options){
+        escapeMenu(options),
+        escape(false),
+        threaded(Data::getInstance().getThreadedLogic()),
+        stopLogic(false),
+        paused(false),
+        failure(NULL){
             gameInput.set(Keyboard::Key_F1, SlowDown);
             gameInput.set(Keyboard::Key_F2, SpeedUp);
             gameInput.set(Keyboard::Key_F3, NormalSpeed);
@@ -376,9 +384,20 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
             delete test;
             delete filtered;
             */
+
+            if (threaded){
+                stage->setInterpolate(Data::getInstance().getInterpolate());
+                if (!PaintownUtil::Thread::createThread(&logicThread, NULL, (PaintownUtil::Thread::ThreadFunction) runLogicThread, this)){
+                    Global::debug(0) << "Could not start the logic thread, running the logic with the drawing" << std::endl;
+                    stage->setInterpolate(false);
+                    threaded = false;
+                }
+            }
         }
 
         virtual ~LogicDraw(){
+            stopThread();
+            delete failure;
             MessageQueue::unregisterInfo(&messages);
         }
 
@@ -412,6 +431,130 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
         int showGameSpeed;
         
         EscapeMenu escapeMenu;
+        /* open the escape menu once the input is handled */
+        bool escape;
+
+        /* When the logic is threaded the stage only changes on the logic
+         * thread, which runs at a steady tick rate no matter how long a frame
+         * takes to draw. The main thread still polls the input devices and
+         * draws. Everything that touches the stage holds this lock.
+         */
+        bool threaded;
+        PaintownUtil::Thread::LockObject lock;
+        PaintownUtil::Thread::Id logicThread;
+        bool stopLogic;
+        /* no time passes on the logic thread while the escape menu is up */
+        bool paused;
+        /* thrown by the logic thread, rethrown on the main thread */
+        Exception::Base * failure;
+
+        /* Holds the lock, but only when there is a logic thread to keep
+         * out. Without one the lock would just be overhead.
+         */
+        class StageLock{
+        public:
+            StageLock(LogicDraw & logic):
+            held(logic.threaded),
+            lock(logic.lock){
+                if (held){
+                    lock.acquire();
+                }
+            }
+
+            ~StageLock(){
+                if (held){
+                    lock.release();
+                }
+            }
+
+            const bool held;
+            PaintownUtil::Thread::LockObject & lock;
+        };
+
+        /* Stops the clock of the logic thread while the escape menu runs its
+         * own loop, without keeping the lock for all that time.
+         */
+        class Pause{
+        public:
+            Pause(LogicDraw & logic):
+            logic(logic){
+                StageLock scoped(logic);
+                logic.paused = true;
+            }
+
+            ~Pause(){
+                StageLock scoped(logic);
+                logic.paused = false;
+            }
+
+            LogicDraw & logic;
+        };
+
+        static void * runLogicThread(void * self){
+            ((LogicDraw*) self)->logicLoop();
+            return NULL;
+        }
+
+        void logicLoop(){
+            /* after a long stall only catch up this many ticks */
+            const double maximumBehind = 5;
+
+            uint64_t last = System::currentMilliseconds();
+            while (true){
+                {
+                    PaintownUtil::Thread::ScopedLock scoped(lock);
+                    if (stopLogic){
+                        return;
+                    }
+
+                    uint64_t now = System::currentMilliseconds();
+                    if (!paused){
+                        gameTicks += (now - last) * secondsInTicks(1) * gameSpeed / 1000.0;
+                    }
+                    last = now;
+                    if (gameTicks > maximumBehind){
+                        gameTicks = maximumBehind;
+                    }
+
+                    if (!paused && !stage->isMatchOver()){
+                        try{
+                            simulate();
+                        } catch (const Exception::Base & fail){
+                            failure = fail.copy();
+                            return;
+                        } catch (const std::exception & fail){
+                            failure = new MugenException(std::string("Logic thread failed: ") + fail.what(), __FILE__, __LINE__);
+                            return;
+                        } catch (...){
+                            failure = new MugenException("Logic thread failed", __FILE__, __LINE__);
+                            return;
+                        }
+                    }
+                }
+
+                PaintownUtil::rest(1);
+            }
+        }
+
+        void stopThread(){
+            if (threaded){
+                {
+                    PaintownUtil::Thread::ScopedLock scoped(lock);
+                    stopLogic = true;
+                }
+                PaintownUtil::Thread::joinThread(logicThread);
+                stage->setInterpolate(false);
+                threaded = false;
+            }
+        }
+
+        /* how far along the logic thread is to its next tick, 0 to 1 */
+        double interpolation() const {
+            if (!threaded){
+                return 1;
+            }
+            return PaintownUtil::clamp(gameTicks + 1, 0.0, 1.0);
+        }
 
         void doReplay(){
             if (replay.enabled){
@@ -442,9 +585,11 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
             Global::debug(0) << "Replay from tick " << replay.ticks << ". Fast forward from " << use << " for " << (replay.ticks - use) << " ticks" << std::endl;
 
             Sound::disableSounds();
+            stage->setSimulationOnly(true);
             for (unsigned int i = use; i < replay.ticks; i++){
                 stage->logic();
             }
+            stage->setSimulationOnly(false);
             Sound::enableSounds();
         }
 
@@ -541,7 +686,7 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
                             }
                             case QuitGame: {
                                 if (!logic.options.isDemoMode()){
-                                    runEscape(logic.escapeMenu);
+                                    logic.escape = true;
                                 }
                                 break;
                             }
@@ -571,9 +716,58 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
         }
 
         virtual void run(){
+            escape = false;
+            doLogic();
+
+            /* the escape menu runs a loop of its own, which must not hold
+             * the lock the whole time it is up
+             */
+            if (escape){
+                Pause pause(*this);
+                runEscape(escapeMenu);
+            }
+        }
 
+        void doLogic(){
+            StageLock scoped(*this);
+
+            if (threaded){
+                if (failure != NULL){
+                    failure->throwSelf();
+                }
+                stage->latchInput();
+            } else {
+                gameTicks += gameSpeed;
+                simulate();
+            }
+
+            while (messages.hasAny()){
+                console.addLine(messages.get());
+            }
+            console.act();
+
+            endMatch = stage->isMatchOver();
+
+            if (showGameSpeed > 0){
+                showGameSpeed -= 1;
+            }
+
+            if (console.isActive()){
+                try{
+                    console.doInput();
+                } catch (Exception::Return & r){
+                    throw QuitGameException();
+                }
+            } else {
+                doInput();
+            }
+
+            options.act();
+        }
+
+        /* run as many ticks as gameTicks says */
+        void simulate(){
             unsigned oldTicks = totalTicks;
-            gameTicks += gameSpeed;
             // Do stage logic catch match exception to handle the next match
 
             if (replay.enabled){
@@ -614,29 +808,6 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
                     snapshots[totalTicks] = stage->snapshotState();
                 }
             }
-
-            while (messages.hasAny()){
-                console.addLine(messages.get());
-            }
-            console.act();
-
-            endMatch = stage->isMatchOver();
-
-            if (showGameSpeed > 0){
-                showGameSpeed -= 1;
-            }
-
-            if (console.isActive()){
-                try{
-                    console.doInput();
-                } catch (Exception::Return & r){
-                    throw QuitGameException();
-                }
-            } else {
-                doInput();
-            }
-
-            options.act();
         }
 
         virtual bool done(){
@@ -664,17 +835,27 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
                 }
             }
 
-            if (stage->isZoomed()){
-                Graphics::Bitmap work(DEFAULT_WIDTH, DEFAULT_HEIGHT);
-                stage->render(&work);
-                // Global::debug(0) << "X1 " << stage->zoomX1() << " Y1 " << stage->zoomY1() << " X2 " << stage->zoomX2() << " Y2 " << stage->zoomY2() << std::endl;
-                work.Stretch(screen, stage->zoomX1(), stage->zoomY1(), stage->zoomX2() - stage->zoomX1(), stage->zoomY2() - stage->zoomY1(), 0, 0, screen.getWidth(), screen.getHeight());
-            } else {
-                Graphics::StretchedBitmap work(DEFAULT_WIDTH, DEFAULT_HEIGHT, screen, Graphics::StretchedBitmap::NoClear, Graphics::qualityFilterName(::Configuration::getQualityFilter()));
-                work.start();
-                stage->render(&work);
-                options.draw(work);
-                work.finish();
+            bool replaying = false;
+            unsigned int replayTicks = 0;
+            unsigned int allTicks = 0;
+            {
+                StageLock scoped(*this);
+                if (stage->isZoomed()){
+                    Graphics::Bitmap work(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+                    stage->render(&work, interpolation());
+                    // Global::debug(0) << "X1 " << stage->zoomX1() << " Y1 " << stage->zoomY1() << " X2 " << stage->zoomX2() << " Y2 " << stage->zoomY2() << std::endl;
+                    work.Stretch(screen, stage->zoomX1(), stage->zoomY1(), stage->zoomX2() - stage->zoomX1(), stage->zoomY2() - stage->zoomY1(), 0, 0, screen.getWidth(), screen.getHeight());
+                } else {
+                    Graphics::StretchedBitmap work(DEFAULT_WIDTH, DEFAULT_HEIGHT, screen, Graphics::StretchedBitmap::NoClear, Graphics::qualityFilterName(::Configuration::getQualityFilter()));
+                    work.start();
+                    stage->render(&work, interpolation());
+                    options.draw(work);
+                    work.finish();
+                }
+
+                replaying = replay.enabled;
+                replayTicks = replay.ticks;
+                allTicks = totalTicks;
             }
 
             FontRender * render = FontRender::getInstance();
@@ -685,13 +866,13 @@ class LogicDraw: public PaintownUtil::Logic, public PaintownUtil::Draw {
                 font.printf(1, screen.getHeight() - font.getHeight() - 5, Graphics::makeColor(255, 255, 255), screen, "Game speed %f", 0, gameSpeed);
             }
 
-            if (replay.enabled){
+            if (replaying){
                 int width = ::Font::getDefaultFont(32, 32).textLength("Replay Mode");
                 const ::Font & small = ::Font::getDefaultFont(20, 20);
                 int x = screen.getWidth() - width - 10;
                 int y = screen.getHeight() - small.getHeight() - 2;
 
-                small.printf(x, y, Graphics::makeColor(255, 255, 255), screen, "Tick %u / %u", 0, replay.ticks, totalTicks);
+                small.printf(x, y, Graphics::makeColor(255, 255, 255), screen, "Tick %u / %u", 0, replayTicks, allTicks);
 
                 const ::Font & font = ::Font::getDefaultFont(32, 32);
                 y -= font.getHeight() - 2;
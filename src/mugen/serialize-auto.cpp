@@ -51,6 +51,14 @@ HitAttributes deserializeHitAttributes(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const HitAttributes & data){
+    digest(out, data.slot);
+    digest(out, data.standing);
+    digest(out, data.crouching);
+    digest(out, data.aerial);
+    digest(out, data.attributes);
+}
+
 
 Token * serialize(const ResourceEffect & data){
     Token * out = new Token();
@@ -81,6 +89,12 @@ ResourceEffect deserializeResourceEffect(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const ResourceEffect & data){
+    digest(out, data.own);
+    digest(out, data.group);
+    digest(out, data.item);
+}
+
 
 Token * serialize(const HitFlags & data){
     Token * out = new Token();
@@ -131,6 +145,16 @@ HitFlags deserializeHitFlags(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const HitFlags & data){
+    digest(out, data.high);
+    digest(out, data.low);
+    digest(out, data.air);
+    digest(out, data.fall);
+    digest(out, data.down);
+    digest(out, data.getHitState);
+    digest(out, data.notGetHitState);
+}
+
 
 Token * serialize(const PauseTime & data){
     Token * out = new Token();
@@ -156,6 +180,11 @@ PauseTime deserializePauseTime(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const PauseTime & data){
+    digest(out, data.player1);
+    digest(out, data.player2);
+}
+
 
 Token * serialize(const Distance & data){
     Token * out = new Token();
@@ -181,6 +210,11 @@ Distance deserializeDistance(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const Distance & data){
+    digest(out, data.x);
+    digest(out, data.y);
+}
+
 
 
 Token * serialize(const Attribute & data){
@@ -209,6 +243,12 @@ Attribute deserializeAttribute(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const Attribute & data){
+    digest(out, data.state);
+    digest(out, data.attackType);
+    digest(out, data.physics);
+}
+
 
 Token * serialize(const Priority & data){
     Token * out = new Token();
@@ -233,6 +273,11 @@ Priority deserializePriority(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const Priority & data){
+    digest(out, data.hit);
+    digest(out, data.type);
+}
+
 
 Token * serialize(const Damage & data){
     Token * out = new Token();
@@ -258,6 +303,11 @@ Damage deserializeDamage(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const Damage & data){
+    digest(out, data.damage);
+    digest(out, data.guardDamage);
+}
+
 
 Token * serialize(const SparkPosition & data){
     Token * out = new Token();
@@ -283,6 +333,11 @@ SparkPosition deserializeSparkPosition(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const SparkPosition & data){
+    digest(out, data.x);
+    digest(out, data.y);
+}
+
 
 Token * serialize(const GetPower & data){
     Token * out = new Token();
@@ -308,6 +363,11 @@ GetPower deserializeGetPower(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const GetPower & data){
+    digest(out, data.hit);
+    digest(out, data.guarded);
+}
+
 
 Token * serialize(const GivePower & data){
     Token * out = new Token();
@@ -333,6 +393,11 @@ GivePower deserializeGivePower(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const GivePower & data){
+    digest(out, data.hit);
+    digest(out, data.guarded);
+}
+
 
 Token * serialize(const GroundVelocity & data){
     Token * out = new Token();
@@ -358,6 +423,11 @@ GroundVelocity deserializeGroundVelocity(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const GroundVelocity & data){
+    digest(out, data.x);
+    digest(out, data.y);
+}
+
 
 Token * serialize(const AirVelocity & data){
     Token * out = new Token();
@@ -383,6 +453,11 @@ AirVelocity deserializeAirVelocity(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const AirVelocity & data){
+    digest(out, data.x);
+    digest(out, data.y);
+}
+
 
 Token * serialize(const AirGuardVelocity & data){
     Token * out = new Token();
@@ -408,6 +483,11 @@ AirGuardVelocity deserializeAirGuardVelocity(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const AirGuardVelocity & data){
+    digest(out, data.x);
+    digest(out, data.y);
+}
+
 
 
 Token * serialize(const Shake & data){
@@ -429,6 +509,10 @@ Shake deserializeShake(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const Shake & data){
+    digest(out, data.time);
+}
+
 Token * serialize(const Fall & data){
     Token * out = new Token();
     *out << "Fall";
@@ -495,6 +579,19 @@ Fall deserializeFall(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const Fall & data){
+    digest(out, data.envShake);
+    digest(out, data.fall);
+    digest(out, data.xVelocity);
+    digest(out, data.yVelocity);
+    digest(out, data.changeXVelocity);
+    digest(out, data.recover);
+    digest(out, data.recoverTime);
+    digest(out, data.damage);
+    digest(out, data.airFall);
+    digest(out, data.forceNoFall);
+}
+
 Token * serialize(const HitDefinition & data){
     Token * out = new Token();
     *out << "HitDefinition";
@@ -799,6 +896,63 @@ HitDefinition deserializeHitDefinition(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const HitDefinition & data){
+    digest(out, data.alive);
+    digest(out, data.attribute);
+    digest(out, data.hitFlag);
+    digest(out, data.guardFlag);
+    digest(out, data.animationType);
+    digest(out, data.animationTypeAir);
+    digest(out, data.animationTypeFall);
+    digest(out, data.priority);
+    digest(out, data.damage);
+    digest(out, data.pause);
+    digest(out, data.guardPause);
+    digest(out, data.spark);
+    digest(out, data.guardSpark);
+    digest(out, data.sparkPosition);
+    digest(out, data.hitSound);
+    digest(out, data.getPower);
+    digest(out, data.givePower);
+    digest(out, data.guardHitSound);
+    digest(out, data.groundType);
+    digest(out, data.airType);
+    digest(out, data.groundSlideTime);
+    digest(out, data.guardSlideTime);
+    digest(out, data.groundHitTime);
+    digest(out, data.guardGroundHitTime);
+    digest(out, data.airHitTime);
+    digest(out, data.guardControlTime);
+    digest(out, data.guardDistance);
+    digest(out, data.yAcceleration);
+    digest(out, data.groundVelocity);
+    digest(out, data.guardVelocity);
+    digest(out, data.airVelocity);
+    digest(out, data.airGuardVelocity);
+    digest(out, data.groundCornerPushoff);
+    digest(out, data.airCornerPushoff);
+    digest(out, data.downCornerPushoff);
+    digest(out, data.guardCornerPushoff);
+    digest(out, data.airGuardCornerPushoff);
+    digest(out, data.airGuardControlTime);
+    digest(out, data.airJuggle);
+    digest(out, data.id);
+    digest(out, data.chainId);
+    digest(out, data.minimum);
+    digest(out, data.maximum);
+    digest(out, data.snap);
+    digest(out, data.player1SpritePriority);
+    digest(out, data.player2SpritePriority);
+    digest(out, data.player1Facing);
+    digest(out, data.player1GetPlayer2Facing);
+    digest(out, data.player2Facing);
+    digest(out, data.player1State);
+    digest(out, data.player2State);
+    digest(out, data.player2GetPlayer1State);
+    digest(out, data.forceStand);
+    digest(out, data.fall);
+}
+
 
 Token * serialize(const HitOverride & data){
     Token * out = new Token();
@@ -834,6 +988,13 @@ HitOverride deserializeHitOverride(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const HitOverride & data){
+    digest(out, data.time);
+    digest(out, data.attributes);
+    digest(out, data.state);
+    digest(out, data.forceAir);
+}
+
 
 
 
@@ -856,6 +1017,10 @@ Shake1 deserializeShake1(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const Shake1 & data){
+    digest(out, data.time);
+}
+
 Token * serialize(const Fall1 & data){
     Token * out = new Token();
     *out << "Fall1";
@@ -912,6 +1077,17 @@ Fall1 deserializeFall1(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const Fall1 & data){
+    digest(out, data.envShake);
+    digest(out, data.fall);
+    digest(out, data.recover);
+    digest(out, data.recoverTime);
+    digest(out, data.xVelocity);
+    digest(out, data.yVelocity);
+    digest(out, data.changeXVelocity);
+    digest(out, data.damage);
+}
+
 Token * serialize(const HitState & data){
     Token * out = new Token();
     *out << "HitState";
@@ -1023,6 +1199,28 @@ HitState deserializeHitState(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const HitState & data){
+    digest(out, data.shakeTime);
+    digest(out, data.hitTime);
+    digest(out, data.hits);
+    digest(out, data.slideTime);
+    digest(out, data.returnControlTime);
+    digest(out, data.recoverTime);
+    digest(out, data.yAcceleration);
+    digest(out, data.yVelocity);
+    digest(out, data.xVelocity);
+    digest(out, data.animationType);
+    digest(out, data.airType);
+    digest(out, data.groundType);
+    digest(out, data.hitType);
+    digest(out, data.guarded);
+    digest(out, data.damage);
+    digest(out, data.chainId);
+    digest(out, data.spritePriority);
+    digest(out, data.fall);
+    digest(out, data.moveContact);
+}
+
 
 
 Token * serialize(const HitSound & data){
@@ -1054,6 +1252,12 @@ HitSound deserializeHitSound(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const HitSound & data){
+    digest(out, data.own);
+    digest(out, data.group);
+    digest(out, data.item);
+}
+
 Token * serialize(const ReversalData & data){
     Token * out = new Token();
     *out << "ReversalData";
@@ -1143,6 +1347,22 @@ ReversalData deserializeReversalData(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const ReversalData & data){
+    digest(out, data.pause);
+    digest(out, data.spark);
+    digest(out, data.hitSound);
+    digest(out, data.sparkX);
+    digest(out, data.sparkY);
+    digest(out, data.player1State);
+    digest(out, data.player2State);
+    digest(out, data.player1Pause);
+    digest(out, data.player2Pause);
+    digest(out, data.standing);
+    digest(out, data.crouching);
+    digest(out, data.aerial);
+    digest(out, data.attributes);
+}
+
 
 
 Token * serialize(const WidthOverride & data){
@@ -1184,6 +1404,14 @@ WidthOverride deserializeWidthOverride(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const WidthOverride & data){
+    digest(out, data.enabled);
+    digest(out, data.edgeFront);
+    digest(out, data.edgeBack);
+    digest(out, data.playerFront);
+    digest(out, data.playerBack);
+}
+
 
 Token * serialize(const HitByOverride & data){
     Token * out = new Token();
@@ -1232,6 +1460,14 @@ HitByOverride deserializeHitByOverride(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const HitByOverride & data){
+    digest(out, data.standing);
+    digest(out, data.crouching);
+    digest(out, data.aerial);
+    digest(out, data.time);
+    digest(out, data.attributes);
+}
+
 
 Token * serialize(const TransOverride & data){
     Token * out = new Token();
@@ -1267,6 +1503,13 @@ TransOverride deserializeTransOverride(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const TransOverride & data){
+    digest(out, data.enabled);
+    digest(out, data.type);
+    digest(out, data.alphaSource);
+    digest(out, data.alphaDestination);
+}
+
 
 Token * serialize(const SpecialStuff & data){
     Token * out = new Token();
@@ -1292,6 +1535,11 @@ SpecialStuff deserializeSpecialStuff(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const SpecialStuff & data){
+    digest(out, data.invisible);
+    digest(out, data.intro);
+}
+
 
 Token * serialize(const Bind & data){
     Token * out = new Token();
@@ -1332,6 +1580,14 @@ Bind deserializeBind(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const Bind & data){
+    digest(out, data.bound);
+    digest(out, data.time);
+    digest(out, data.facing);
+    digest(out, data.offsetX);
+    digest(out, data.offsetY);
+}
+
 
 Token * serialize(const CharacterData & data){
     Token * out = new Token();
@@ -1357,6 +1613,11 @@ CharacterData deserializeCharacterData(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const CharacterData & data){
+    digest(out, data.who);
+    digest(out, data.enabled);
+}
+
 
 Token * serialize(const DrawAngleEffect & data){
     Token * out = new Token();
@@ -1392,6 +1653,13 @@ DrawAngleEffect deserializeDrawAngleEffect(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const DrawAngleEffect & data){
+    digest(out, data.enabled);
+    digest(out, data.angle);
+    digest(out, data.scaleX);
+    digest(out, data.scaleY);
+}
+
 Token * serialize(const StateData & data){
     Token * out = new Token();
     *out << "StateData";
@@ -1472,13 +1740,7 @@ Token * serialize(const StateData & data){
    *out->newToken() << "virtualz" << data.virtualz;
     *out->newToken() << "facing" << serialize(data.facing);
    *out->newToken() << "power" << data.power;
-
-    Token * t7 = out->newToken();
-    *t7 << "commandState";
-    for (std::map<std::string, std::string >::const_iterator it = data.commandState.begin(); it != data.commandState.end(); it++){
-        *t7->newToken() << "e" << serialize(it->first) << serialize(it->second);
-    }
-    
+   *out->newToken() << "commandState" << data.commandState;
     return out;
 }
 
@@ -1729,18 +1991,61 @@ StateData deserializeStateData(const Token * data){
     }
     use = data->findToken("_/commandState");
     if (use != NULL){
-        for (TokenView view = use->view(); view.hasMore(); /**/){
-            const Token * entry = view.next();
-            std::string valueKey;
-            deserialize_stdstring(valueKey, entry->getToken(0));
-            std::string valueValue;
-            deserialize_stdstring(valueValue, entry->getToken(1));
-            out.commandState[valueKey] = valueValue;
-        }
-
-    }
-
-    return out;
+        use->view() >> out.commandState;
+    }
+
+    return out;
+}
+
+void digest(StateHash & out, const StateData & data){
+    digest(out, data.juggleRemaining);
+    digest(out, data.currentJuggle);
+    digest(out, data.currentState);
+    digest(out, data.previousState);
+    digest(out, data.currentAnimation);
+    digest(out, data.velocity_x);
+    digest(out, data.velocity_y);
+    digest(out, data.has_control);
+    digest(out, data.stateTime);
+    digest(out, data.variables);
+    digest(out, data.floatVariables);
+    digest(out, data.systemVariables);
+    digest(out, data.currentPhysics);
+    digest(out, data.stateType);
+    digest(out, data.moveType);
+    digest(out, data.hit);
+    digest(out, data.hitState);
+    digest(out, data.combo);
+    digest(out, data.hitCount);
+    digest(out, data.blocking);
+    digest(out, data.guarding);
+    digest(out, data.widthOverride);
+    digest(out, data.hitByOverride[0]);
+    digest(out, data.hitByOverride[1]);
+    digest(out, data.defenseMultiplier);
+    digest(out, data.attackMultiplier);
+    digest(out, data.frozen);
+    digest(out, data.reversal);
+    digest(out, data.reversalActive);
+    digest(out, data.transOverride);
+    digest(out, data.pushPlayer);
+    digest(out, data.special);
+    digest(out, data.health);
+    digest(out, data.bind);
+    digest(out, data.targets);
+    digest(out, data.spritePriority);
+    digest(out, data.wasHitCounter);
+    digest(out, data.characterData);
+    digest(out, data.drawAngle);
+    digest(out, data.drawAngleData);
+    digest(out, data.active);
+    digest(out, data.hitOverrides);
+    digest(out, data.virtualx);
+    digest(out, data.virtualy);
+    digest(out, data.virtualz);
+    digest(out, data.facing);
+    digest(out, data.power);
+    digest(out, data.commandState);
 }
 
 
@@ -1783,6 +2088,14 @@ AnimationState deserializeAnimationState(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const AnimationState & data){
+    digest(out, data.position);
+    digest(out, data.looped);
+    digest(out, data.started);
+    digest(out, data.ticks);
+    digest(out, data.virtual_ticks);
+}
+
 
 Token * serialize(const ScreenBound & data){
     Token * out = new Token();
@@ -1818,6 +2131,13 @@ ScreenBound deserializeScreenBound(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const ScreenBound & data){
+    digest(out, data.enabled);
+    digest(out, data.offScreen);
+    digest(out, data.panX);
+    digest(out, data.panY);
+}
+
 
 
 Token * serialize(const Pause & data){
@@ -1859,6 +2179,14 @@ Pause deserializePause(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const Pause & data){
+    digest(out, data.time);
+    digest(out, data.buffer);
+    digest(out, data.moveTime);
+    digest(out, data.pauseBackground);
+    digest(out, data.who);
+}
+
 
 Token * serialize(const Zoom & data){
     Token * out = new Token();
@@ -1989,6 +2317,32 @@ Zoom deserializeZoom(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const Zoom & data){
+    digest(out, data.enabled);
+    digest(out, data.x);
+    digest(out, data.y);
+    digest(out, data.zoomTime);
+    digest(out, data.zoomOutTime);
+    digest(out, data.zoom);
+    digest(out, data.in);
+    digest(out, data.time);
+    digest(out, data.bindTime);
+    digest(out, data.deltaX);
+    digest(out, data.deltaY);
+    digest(out, data.scaleX);
+    digest(out, data.scaleY);
+    digest(out, data.velocityX);
+    digest(out, data.velocityY);
+    digest(out, data.accelX);
+    digest(out, data.accelY);
+    digest(out, data.superMoveTime);
+    digest(out, data.pauseMoveTime);
+    digest(out, data.removeOnGetHit);
+    digest(out, data.hitCount);
+    digest(out, data.bound);
+    digest(out, data.owner);
+}
+
 
 Token * serialize(const EnvironmentColor & data){
     Token * out = new Token();
@@ -2019,6 +2373,12 @@ EnvironmentColor deserializeEnvironmentColor(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const EnvironmentColor & data){
+    digest(out, data.color);
+    digest(out, data.time);
+    digest(out, data.under);
+}
+
 
 Token * serialize(const SuperPause & data){
     Token * out = new Token();
@@ -2059,6 +2419,14 @@ SuperPause deserializeSuperPause(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const SuperPause & data){
+    digest(out, data.time);
+    digest(out, data.positionX);
+    digest(out, data.positionY);
+    digest(out, data.soundGroup);
+    digest(out, data.soundItem);
+}
+
 Token * serialize(const StageStateData & data){
     Token * out = new Token();
     *out << "StageStateData";
@@ -2174,6 +2542,25 @@ StageStateData deserializeStageStateData(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const StageStateData & data){
+    digest(out, data.pause);
+    digest(out, data.screenBound);
+    digest(out, data.zoom);
+    digest(out, data.environmentColor);
+    digest(out, data.superPause);
+    digest(out, data.quake_time);
+    digest(out, data.cycles);
+    digest(out, data.inleft);
+    digest(out, data.inright);
+    digest(out, data.onLeftSide);
+    digest(out, data.onRightSide);
+    digest(out, data.inabove);
+    digest(out, data.camerax);
+    digest(out, data.cameray);
+    digest(out, data.ticker);
+    digest(out, data.gameRate);
+}
+
 
 Token * serialize(const PlayerData & data){
     Token * out = new Token();
@@ -2229,5 +2616,16 @@ PlayerData deserializePlayerData(const Token * data){
     return out;
 }
 
+void digest(StateHash & out, const PlayerData & data){
+    digest(out, data.oldx);
+    digest(out, data.oldy);
+    digest(out, data.leftTension);
+    digest(out, data.rightTension);
+    digest(out, data.leftSide);
+    digest(out, data.rightSide);
+    digest(out, data.above);
+    digest(out, data.jumped);
+}
+
 }
 
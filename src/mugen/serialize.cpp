@@ -391,4 +391,118 @@ Graphics::Color defaultGraphicsColor(){
     return Graphics::Color();
 }
 
+StateHash::StateHash():
+value(14695981039346656037ULL){
+}
+
+void StateHash::add(const void * data, unsigned int length){
+    const unsigned char * bytes = (const unsigned char *) data;
+    for (unsigned int i = 0; i < length; i++){
+        value ^= bytes[i];
+        value *= 1099511628211ULL;
+    }
+}
+
+void digest(StateHash & out, bool data){
+    unsigned char value = data ? 1 : 0;
+    out.add(&value, sizeof(value));
+}
+
+void digest(StateHash & out, int data){
+    out.add(&data, sizeof(data));
+}
+
+void digest(StateHash & out, uint32_t data){
+    out.add(&data, sizeof(data));
+}
+
+/* two worlds only match if their doubles are exactly the same */
+void digest(StateHash & out, double data){
+    out.add(&data, sizeof(data));
+}
+
+void digest(StateHash & out, const std::string & data){
+    digest(out, (uint32_t) data.size());
+    out.add(data.data(), data.size());
+}
+
+void digest(StateHash & out, const AttackType::Attribute data){
+    digest(out, (int) data);
+}
+
+void digest(StateHash & out, const AttackType::Animation data){
+    digest(out, (int) data);
+}
+
+void digest(StateHash & out, const AttackType::Ground data){
+    digest(out, (int) data);
+}
+
+void digest(StateHash & out, const TransType data){
+    digest(out, (int) data);
+}
+
+void digest(StateHash & out, const CharacterId & data){
+    digest(out, data.intValue());
+}
+
+void digest(StateHash & out, const Physics::Type data){
+    digest(out, (int) data);
+}
+
+void digest(StateHash & out, const Facing data){
+    digest(out, (int) data);
+}
+
+void digest(StateHash & out, const Graphics::Color & data){
+    digest(out, Graphics::getRed(data));
+    digest(out, Graphics::getGreen(data));
+    digest(out, Graphics::getBlue(data));
+}
+
+void digest(StateHash & out, const RuntimeValue & value){
+    digest(out, (int) value.getType());
+    switch (value.getType()){
+        case RuntimeValue::Invalid: {
+            break;
+        }
+        case RuntimeValue::Bool: {
+            digest(out, value.getBoolValue());
+            break;
+        }
+        case RuntimeValue::String: {
+            digest(out, value.string_value);
+            break;
+        }
+        case RuntimeValue::Double: {
+            digest(out, value.getDoubleValue());
+            break;
+        }
+        case RuntimeValue::ListOfString: {
+            digest(out, value.strings_value);
+            break;
+        }
+        case RuntimeValue::RangeType: {
+            digest(out, value.range.low);
+            digest(out, value.range.high);
+            break;
+        }
+        case RuntimeValue::StateType: {
+            digest(out, value.attribute.standing);
+            digest(out, value.attribute.crouching);
+            digest(out, value.attribute.lying);
+            digest(out, value.attribute.aerial);
+            break;
+        }
+        case RuntimeValue::AttackAttribute: {
+            digest(out, value.attackAttributes);
+            break;
+        }
+        case RuntimeValue::ListOfInt: {
+            digest(out, value.ints_value);
+            break;
+        }
+    }
+}
+
 }
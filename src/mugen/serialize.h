@@ -2,8 +2,10 @@
 #define _paintown_mugen_serialize_h
 
 #include "common.h"
+#include <stdint.h>
 #include <string>
 #include <vector>
+#include <map>
 
 class Token;
 
@@ -51,6 +53,59 @@ namespace Mugen{
     Physics::Type defaultPhysicsType();
     Facing defaultFacing();
     Graphics::Color defaultGraphicsColor();
+
+    /* A 64-bit FNV-1a hash that the game state is fed into one field at a
+     * time. Used to check that two copies of a match are in the same state
+     * without serializing either of them.
+     */
+    class StateHash{
+    public:
+        StateHash();
+
+        void add(const void * data, unsigned int length);
+
+        inline uint64_t get() const {
+            return value;
+        }
+
+    protected:
+        uint64_t value;
+    };
+
+    /* digest() feeds a value into the hash. The state structs get theirs
+     * from serialize.py, these are for the types they are made of.
+     */
+    void digest(StateHash & out, bool data);
+    void digest(StateHash & out, int data);
+    void digest(StateHash & out, uint32_t data);
+    void digest(StateHash & out, double data);
+    void digest(StateHash & out, const std::string & data);
+    void digest(StateHash & out, const AttackType::Attribute data);
+    void digest(StateHash & out, const AttackType::Animation data);
+    void digest(StateHash & out, const AttackType::Ground data);
+    void digest(StateHash & out, const TransType data);
+    void digest(StateHash & out, const CharacterId & data);
+    void digest(StateHash & out, const RuntimeValue & data);
+    void digest(StateHash & out, const Physics::Type data);
+    void digest(StateHash & out, const Facing data);
+    void digest(StateHash & out, const Graphics::Color & data);
+
+    template <class Value>
+    void digest(StateHash & out, const std::vector<Value> & data){
+        digest(out, (uint32_t) data.size());
+        for (typename std::vector<Value>::const_iterator it = data.begin(); it != data.end(); it++){
+            digest(out, *it);
+        }
+    }
+
+    template <class Key, class Value>
+    void digest(StateHash & out, const std::map<Key, Value> & data){
+        digest(out, (uint32_t) data.size());
+        for (typename std::map<Key, Value>::const_iterator it = data.begin(); it != data.end(); it++){
+            digest(out, it->first);
+            digest(out, it->second);
+        }
+    }
 }
 
 #endif
@@ -0,0 +1,86 @@
+#include "simulation.h"
+#include "random.h"
+#include "config.h"
+#include <r-tech1/thread.h>
+
+/* The simulation bound to each thread. r-tech1 has no thread local storage
+ * so use the compiler's.
+ */
+#ifdef _MSC_VER
+#define SIMULATION_THREAD_LOCAL __declspec(thread)
+#else
+#define SIMULATION_THREAD_LOCAL __thread
+#endif
+
+namespace Mugen{
+
+static SIMULATION_THREAD_LOCAL Simulation * bound = NULL;
+
+/* Made the first time a thread without a bound simulation asks for one */
+static Simulation * defaultSimulation = NULL;
+static PaintownUtil::Thread::LockObject defaultLock;
+
+Simulation::Simulation():
+random(new Random()),
+sounds(true),
+gameSpeed(Data::getInstance().getGameSpeed()){
+}
+
+Simulation::Simulation(unsigned int seed):
+random(new Random(seed)),
+sounds(true),
+gameSpeed(Data::getInstance().getGameSpeed()){
+}
+
+Simulation::Simulation(const Simulation & copy):
+random(new Random(*copy.random)),
+sounds(copy.sounds),
+gameSpeed(copy.gameSpeed){
+}
+
+Simulation & Simulation::operator=(const Simulation & copy){
+    random = PaintownUtil::ReferenceCount<Random>(new Random(*copy.random));
+    sounds = copy.sounds;
+    gameSpeed = copy.gameSpeed;
+    return *this;
+}
+
+Simulation::~Simulation(){
+}
+
+Simulation Simulation::fork(){
+    Simulation out(*this);
+    out.setRandom(random->split());
+    return out;
+}
+
+PaintownUtil::ReferenceCount<Random> Simulation::getRandom() const {
+    return random;
+}
+
+void Simulation::setRandom(const Random & what){
+    random = PaintownUtil::ReferenceCount<Random>(new Random(what));
+}
+
+Simulation & Simulation::current(){
+    if (bound != NULL){
+        return *bound;
+    }
+
+    PaintownUtil::Thread::ScopedLock scoped(defaultLock);
+    if (defaultSimulation == NULL){
+        defaultSimulation = new Simulation();
+    }
+    return *defaultSimulation;
+}
+
+Simulation::Scope::Scope(Simulation & simulation):
+previous(bound){
+    bound = &simulation;
+}
+
+Simulation::Scope::~Scope(){
+    bound = previous;
+}
+
+}
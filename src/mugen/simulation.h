@@ -0,0 +1,85 @@
+#ifndef _paintown_mugen_simulation_h
+#define _paintown_mugen_simulation_h
+
+#include <r-tech1/pointer.h>
+
+namespace PaintownUtil = ::Util;
+
+namespace Mugen{
+
+class Random;
+
+/* Everything a match reads or changes that used to be process wide: the
+ * random number generator, whether sounds play and the configuration values
+ * the game logic looks at. Each Stage owns one, so several matches can run in
+ * the same process (and on different threads) without sharing state.
+ *
+ * Code deep inside the game logic gets at the simulation through current(),
+ * which returns the simulation bound to the calling thread with a Scope. A
+ * thread that has not bound a simulation gets the process wide default.
+ */
+class Simulation{
+public:
+    /* Copies the configuration from Mugen::Data and seeds the random
+     * number generator with rand()
+     */
+    Simulation();
+    /* Same as above but the random number generator is seeded with `seed' */
+    explicit Simulation(unsigned int seed);
+    Simulation(const Simulation & copy);
+    Simulation & operator=(const Simulation & copy);
+    virtual ~Simulation();
+
+    /* A new simulation with the same settings and a random number generator
+     * seeded from this one. Successive forks get different random numbers
+     * but the same starting simulation always produces the same forks.
+     */
+    Simulation fork();
+
+    PaintownUtil::ReferenceCount<Random> getRandom() const;
+    void setRandom(const Random & random);
+
+    inline bool soundsEnabled() const {
+        return sounds;
+    }
+
+    inline void enableSounds(){
+        sounds = true;
+    }
+
+    inline void disableSounds(){
+        sounds = false;
+    }
+
+    inline double getGameSpeed() const {
+        return gameSpeed;
+    }
+
+    inline void setGameSpeed(double speed){
+        gameSpeed = speed;
+    }
+
+    /* The simulation bound to this thread */
+    static Simulation & current();
+
+    /* Binds a simulation to the calling thread until the scope ends. Scopes
+     * nest, the previous simulation is bound again when this one goes away.
+     */
+    class Scope{
+    public:
+        Scope(Simulation & simulation);
+        ~Scope();
+
+    protected:
+        Simulation * previous;
+    };
+
+protected:
+    PaintownUtil::ReferenceCount<Random> random;
+    bool sounds;
+    double gameSpeed;
+};
+
+}
+
+#endif
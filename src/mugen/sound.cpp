@@ -1,5 +1,6 @@
 #include <string.h>
 #include "sound.h"
+#include "simulation.h"
 #include <r-tech1/sound/sound.h>
 
 namespace Mugen{
@@ -28,7 +29,7 @@ void Sound::load(){
 }
 
 void Sound::play(){
-    if (enabled && sound){
+    if (enabled && sound && Simulation::current().soundsEnabled()){
         sound->play();
     }
 }
@@ -28,7 +28,9 @@ public:
     static void disableSounds();
 
 protected:
-    /* For globally disabling sounds, such as during replay */
+    /* For globally disabling sounds, such as during replay. A single match
+     * can be silenced with Simulation::disableSounds.
+     */
     static bool enabled;
 };
 
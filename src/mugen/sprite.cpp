@@ -6,6 +6,7 @@
 #include <r-tech1/pointer.h>
 #include <r-tech1/debug.h>
 #include <math.h>
+#include "atlas.h"
 
 namespace PaintownUtil = ::Util;
 
@@ -71,6 +72,7 @@ SpriteV1::SpriteV1(const SpriteV1 &copy){
 
     this->unmaskedBitmap = copy.unmaskedBitmap;
     this->maskedBitmap = copy.maskedBitmap;
+    this->atlasPage = copy.atlasPage;
 }
 
 SpriteV1 & SpriteV1::operator=(const SpriteV1 &copy){
@@ -106,6 +108,7 @@ SpriteV1 & SpriteV1::operator=(const SpriteV1 &copy){
 
     this->unmaskedBitmap = copy.unmaskedBitmap;
     this->maskedBitmap = copy.maskedBitmap;
+    this->atlasPage = copy.atlasPage;
     
     return *this;
 }
@@ -128,6 +131,7 @@ void SpriteV1::copyImage(const PaintownUtil::ReferenceCount<Mugen::SpriteV1> cop
     this->height = copy->height;
     this->unmaskedBitmap = copy->unmaskedBitmap;
     this->maskedBitmap = copy->maskedBitmap;
+    this->atlasPage = copy->atlasPage;
     this->loaded = copy->loaded;
     this->defaultMask = copy->defaultMask;
 }
@@ -243,7 +247,17 @@ PaintownUtil::ReferenceCount<Graphics::Bitmap> SpriteV1::getFinalBitmap(const Mu
     return modImage;
 }
 
+/* can be held in an atlas batch */
+static bool isPlain(const Mugen::Effects & effects){
+    return effects.trans == None &&
+           effects.filter == NULL &&
+           fabs(effects.rotation) <= 0.1 &&
+           !isScaled(effects);
+}
+
 void SpriteV1::render(const int xaxis, const int yaxis, const Graphics::Bitmap &where, const Mugen::Effects &effects){
+    /* before getFinalBitmap, which can make new bitmaps */
+    Atlas::Batch::draw(effects.mask ? atlasPage.raw() : NULL, isPlain(effects), where);
     draw(getFinalBitmap(effects), xaxis, yaxis, where, effects);
 }
 
@@ -263,6 +277,7 @@ PaintownUtil::ReferenceCount<Graphics::Bitmap> SpriteV1::load(bool mask){
 void SpriteV1::reload(bool mask){
     maskedBitmap = NULL;
     unmaskedBitmap = NULL;
+    atlasPage = NULL;
 
     if (mask){
         maskedBitmap = load(mask);
@@ -294,6 +309,14 @@ PaintownUtil::ReferenceCount<Graphics::Bitmap> SpriteV1::getBitmap(bool mask){
     return PaintownUtil::ReferenceCount<Graphics::Bitmap>(NULL);
 }
 
+void SpriteV1::setAtlasImage(const PaintownUtil::ReferenceCount<Graphics::Bitmap> & page, int x, int y){
+    PaintownUtil::ReferenceCount<Graphics::Bitmap> image = getBitmap(true);
+    if (image != NULL){
+        maskedBitmap = PaintownUtil::ReferenceCount<Graphics::Bitmap>(new Graphics::Bitmap(*page, x, y, image->getWidth(), image->getHeight()));
+        atlasPage = page;
+    }
+}
+
 int SpriteV1::getWidth() const {
     return width;
 }
@@ -409,17 +432,20 @@ void SpriteV1::loadPCX(const PaintownUtil::ReferenceCount<Storage::File> & ifile
 }
 
 void SpriteV1::drawPartStretched(int sourceX1, int sourceY, int sourceWidth, int sourceHeight, int destX, int destY, int destWidth, int destHeight, const Mugen::Effects & effects, const Graphics::Bitmap & work){
+    Atlas::Batch::draw(NULL, false, work);
     PaintownUtil::ReferenceCount<Graphics::Bitmap> final = getFinalBitmap(effects);
     // Graphics::Bitmap single(*final, sourceX1, sourceY, sourceWidth, sourceHeight);
     // single.drawStretched(destX, destY, destWidth, destHeight, work);
     final->Stretch(work, sourceX1, sourceY, sourceWidth, sourceHeight, destX, destY, destWidth, destHeight);
 }
 
-static void drawReal(Graphics::Bitmap * bmp, const int xaxis, const int yaxis, const int x, const int y, const Graphics::Bitmap &where, const Mugen::Effects &effects){
+static void drawReal(Graphics::Bitmap * bmp, const void * source, const int xaxis, const int yaxis, const int x, const int y, const Graphics::Bitmap &where, const Mugen::Effects &effects){
     if (bmp == NULL){
         return;
     }
 
+    DrawReport::draw(source, effects.trans);
+
     int startWidth = 0;
     int startHeight = 0;
     int width = bmp->getWidth();
@@ -519,12 +545,13 @@ static void drawReal(Graphics::Bitmap * bmp, const int xaxis, const int yaxis, c
     }
 }
 
-static void drawReal(const PaintownUtil::ReferenceCount<Graphics::Bitmap> & bmp, const int xaxis, const int yaxis, const int x, const int y, const Graphics::Bitmap &where, const Mugen::Effects &effects){
-    drawReal(bmp.raw(), xaxis, yaxis, x, y, where, effects);
-}
-
 void SpriteV1::draw(const PaintownUtil::ReferenceCount<Graphics::Bitmap> & bmp, const int xaxis, const int yaxis, const Graphics::Bitmap &where, const Mugen::Effects &effects){
-    drawReal(bmp, xaxis, yaxis, this->x * effects.scalex, this->y * effects.scaley, where, effects);
+    /* a scaled sprite is drawn from a stretched copy, which isn't in the atlas */
+    const void * source = bmp.raw();
+    if (atlasPage != NULL && bmp.raw() == maskedBitmap.raw()){
+        source = atlasPage.raw();
+    }
+    drawReal(bmp.raw(), source, xaxis, yaxis, this->x * effects.scalex, this->y * effects.scaley, where, effects);
 }
 
 SpriteV2::SpriteV2(const Graphics::Bitmap & image, int group, int item, int x, int y):
@@ -563,13 +590,32 @@ unsigned short SpriteV2::getImageNumber() const {
 }
 
 void SpriteV2::render(const int xaxis, const int yaxis, const Graphics::Bitmap &where, const Mugen::Effects &effects){
-    drawReal(&image, xaxis, yaxis, this->x * effects.scalex, this->y * effects.scaley, where, effects);
+    Atlas::Batch::draw(atlasPage.raw(), isPlain(effects), where);
+    const void * source = &image;
+    if (atlasPage != NULL){
+        source = atlasPage.raw();
+    }
+    drawReal(&image, source, xaxis, yaxis, this->x * effects.scalex, this->y * effects.scaley, where, effects);
 }
 
 void SpriteV2::drawPartStretched(int sourceX1, int sourceY, int sourceWidth, int sourceHeight, int destX, int destY, int destWidth, int destHeight, const Mugen::Effects & effects, const Graphics::Bitmap & work){
+    Atlas::Batch::draw(NULL, false, work);
     Graphics::Bitmap single(image, sourceX1, sourceY, sourceWidth, sourceHeight);
     single.drawStretched(destX, destY, destWidth, destHeight, work);
 }
 
+PaintownUtil::ReferenceCount<Graphics::Bitmap> SpriteV2::getBitmap(bool mask){
+    if (bitmap == NULL){
+        bitmap = PaintownUtil::ReferenceCount<Graphics::Bitmap>(new Graphics::Bitmap(image));
+    }
+    return bitmap;
+}
+
+void SpriteV2::setAtlasImage(const PaintownUtil::ReferenceCount<Graphics::Bitmap> & page, int x, int y){
+    image = Graphics::Bitmap(*page, x, y, image.getWidth(), image.getHeight());
+    atlasPage = page;
+    bitmap = NULL;
+}
+
 
 }
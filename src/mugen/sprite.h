@@ -40,6 +40,18 @@ public:
     virtual unsigned short getImageNumber() const = 0;
     virtual void render(const int xaxis, const int yaxis, const Graphics::Bitmap &where, const Mugen::Effects &effects = Mugen::Effects()) = 0;
     virtual void drawPartStretched(int sourceX1, int sourceY, int sourceWidth, int sourceHeight, int destX, int destY, int destWidth, int destHeight, const Mugen::Effects & effects, const Graphics::Bitmap & work) = 0;
+
+    /* the unscaled bitmap, with the mask color replaced if mask is true */
+    virtual PaintownUtil::ReferenceCount<Graphics::Bitmap> getBitmap(bool mask) = 0;
+
+    /* draw the masked image from the rectangle at x, y in an atlas page
+     * from now on, see atlas.h
+     */
+    virtual void setAtlasImage(const PaintownUtil::ReferenceCount<Graphics::Bitmap> & page, int x, int y) = 0;
+
+protected:
+    /* keeps the page that the image is a sub-bitmap of alive */
+    PaintownUtil::ReferenceCount<Graphics::Bitmap> atlasPage;
 };
 
 class SpriteV1: public Sprite {
@@ -64,6 +76,11 @@ class SpriteV1: public Sprite {
 
         /* for parallax support */
         void drawPartStretched(int sourceX1, int sourceY, int sourceWidth, int sourceHeight, int destX, int destY, int destWidth, int destHeight, const Mugen::Effects & effects, const Graphics::Bitmap & work);
+
+	/* get the internal bitmap */
+        PaintownUtil::ReferenceCount<Graphics::Bitmap> getBitmap(bool mask);
+
+        void setAtlasImage(const PaintownUtil::ReferenceCount<Graphics::Bitmap> & page, int x, int y);
 	
 	// load/reload sprite
         PaintownUtil::ReferenceCount<Graphics::Bitmap> load(bool mask);
@@ -112,9 +129,6 @@ class SpriteV1: public Sprite {
         /* destroy allocated things */
         void cleanup();
 	
-	/* get the internal bitmap */
-        PaintownUtil::ReferenceCount<Graphics::Bitmap> getBitmap(bool mask);
-
         /* get the properly scaled sprite */
         PaintownUtil::ReferenceCount<Graphics::Bitmap> getFinalBitmap(const Mugen::Effects & effects);
 	
@@ -147,7 +161,7 @@ class SpriteV1: public Sprite {
         void draw(const PaintownUtil::ReferenceCount<Graphics::Bitmap> &, const int xaxis, const int yaxis, const Graphics::Bitmap &, const Mugen::Effects &);
 };
 
-class SpriteV2{
+class SpriteV2: public Sprite {
 public:
     SpriteV2(const Graphics::Bitmap & image, int group, int item, int x, int y);
     virtual ~SpriteV2();
@@ -160,9 +174,13 @@ public:
     virtual unsigned short getImageNumber() const;
     virtual void render(const int xaxis, const int yaxis, const Graphics::Bitmap &where, const Mugen::Effects &effects = Mugen::Effects());
     virtual void drawPartStretched(int sourceX1, int sourceY, int sourceWidth, int sourceHeight, int destX, int destY, int destWidth, int destHeight, const Mugen::Effects & effects, const Graphics::Bitmap & work);
+    virtual PaintownUtil::ReferenceCount<Graphics::Bitmap> getBitmap(bool mask);
+    virtual void setAtlasImage(const PaintownUtil::ReferenceCount<Graphics::Bitmap> & page, int x, int y);
 
 protected:
     Graphics::Bitmap image;
+    /* handed out by getBitmap, shares the pixels of image */
+    PaintownUtil::ReferenceCount<Graphics::Bitmap> bitmap;
     int group;
     int item;
     int x, y;
@@ -41,7 +41,9 @@
 #include "parser/all.h"
 
 #include "animation.h"
+#include "atlas.h"
 #include "background.h"
+#include "color-table.h"
 #include "config.h"
 #include "effect.h"
 #include "item.h"
@@ -174,7 +176,12 @@ loaded(false),
 gameHUD(NULL),
 gameOver(false),
 objectId(0),
-replay(false){
+simulation(Simulation::current().fork()),
+replay(false),
+simulationOnly(false),
+interpolate(false),
+lastCameraX(0),
+lastCameraY(0){
     getStateData().gameRate = 1;
 }
 
@@ -482,6 +489,7 @@ void Mugen::Stage::load(){
     if (loaded){
         return;
     }
+    Simulation::Scope scope(simulation);
     ParseCache cache;
 #if 0
     // Lets look for our def since some people think that all file systems are case insensitive
@@ -608,6 +616,9 @@ void Mugen::Stage::load(){
 
     // Mugen::Util::readSprites(Mugen::Data::getInstance().getFileFromMotif(Filesystem::RelativePath("fightfx.sff")), Filesystem::AbsolutePath(), effects);
     Mugen::Util::readSprites(getMotifFile("fightfx.sff"), Filesystem::AbsolutePath(), effects, true);
+    if (Atlas::isEnabled()){
+        Atlas::pack(effects);
+    }
     // sparks = Mugen::Util::loadAnimations(Mugen::Data::getInstance().getFileFromMotif(Filesystem::RelativePath("fightfx.air")), effects);
     sparks = Mugen::Util::loadAnimations(getMotifFile("fightfx.air"), effects, true);
 
@@ -736,6 +747,38 @@ void Mugen::Stage::setReplay(bool what){
     this->replay = what;
 }
 
+bool Mugen::Stage::isSimulationOnly() const {
+    return simulationOnly;
+}
+
+void Mugen::Stage::setSimulationOnly(bool what){
+    this->simulationOnly = what;
+}
+
+void Mugen::Stage::setInterpolate(bool what){
+    this->interpolate = what;
+    lastPositions.clear();
+}
+
+void Mugen::Stage::latchInput(){
+    for (vector<Mugen::Character*>::iterator it = players.begin(); it != players.end(); it++){
+        Mugen::Character * player = *it;
+        if (player->getBehavior() != NULL){
+            player->getBehavior()->latch(player->getFacing() == FacingRight);
+        }
+    }
+}
+
+void Mugen::Stage::savePositions(){
+    lastPositions.clear();
+    for (vector<Mugen::Character*>::iterator it = objects.begin(); it != objects.end(); it++){
+        Mugen::Character * object = *it;
+        lastPositions.push_back(LastPosition(object, object->getId(), object->getX(), object->getY()));
+    }
+    lastCameraX = getStateData().camerax;
+    lastCameraY = getStateData().cameray;
+}
+
 PaintownUtil::ReferenceCount<Mugen::Animation> Mugen::Stage::getFightAnimation(int id){
     if (sparks[id] == 0){
         ostringstream out;
@@ -747,6 +790,11 @@ PaintownUtil::ReferenceCount<Mugen::Animation> Mugen::Stage::getFightAnimation(i
 }
 
 void Mugen::Stage::addSpark(int x, int y, int sparkNumber, bool own, Character * owner){
+    /* sparks have no owner and nothing looks them up, they are only drawn */
+    if (simulationOnly){
+        return;
+    }
+
     PaintownUtil::ReferenceCount<Mugen::Animation> sprite;
     if (own && owner != NULL){
         sprite = owner->getAnimation(sparkNumber);
@@ -1314,6 +1362,11 @@ void Mugen::Stage::runCycle(){
 }
 
 void Mugen::Stage::logic(){
+    Simulation::Scope scope(simulation);
+
+    if (interpolate){
+        savePositions();
+    }
 
     /* This must be the first thing done in this function! */
     /*
@@ -1338,7 +1391,11 @@ void Mugen::Stage::logic(){
     }
     
     // Player HUD Need to make this more elegant than casting and passing from array
-    gameHUD->act(*this, *((Mugen::Character *)players[0]),*((Mugen::Character *)players[1]));
+    if (simulationOnly){
+        gameHUD->simulate(*this, *((Mugen::Character *)players[0]),*((Mugen::Character *)players[1]));
+    } else {
+        gameHUD->act(*this, *((Mugen::Character *)players[0]),*((Mugen::Character *)players[1]));
+    }
 
     /* This must be the last thing done in this function! */
     /*
@@ -1384,7 +1441,8 @@ public:
         sinBlue(sinBlue),
         period(period),
         invert(invert),
-        color(color){
+        color(color),
+        table(Mugen::ColorTable::palette(time, addRed, addGreen, addBlue, multiplyRed, multiplyGreen, multiplyBlue, sinRed, sinGreen, sinBlue, period, invert, color)){
         }
 
     int time;
@@ -1401,64 +1459,8 @@ public:
     int invert;
     int color;
 
-    mutable map<Graphics::Color, Graphics::Color> cache;
-
-    Graphics::Color doFilter(int red, int green, int blue) const {
-        int newRed = red;
-        int newGreen = green;
-        int newBlue = blue;
-
-        if (color < 255){
-            double greyRed = (1 - 0.299) * color / 255 + 0.299;
-            double greyGreen = (1 - 0.587) * color / 255 + 0.587;
-            double greyBlue = (1 - 0.114) * color / 255 + 0.114;
-            red = (int)(red * greyRed + 0.5 + 16);
-            green = (int)(green * greyGreen + 0.5 + 16);
-            blue = (int)(blue * greyBlue + 0.5 + 16);
-        }
-
-        if (invert){
-            red = 255 - red;
-            green = 255 - green;
-            blue = 255 - blue;
-        }
-
-        if (period > 0){
-            newRed = (red + addRed + sinRed * sin(2 * PaintownUtil::pi * time / period)) * multiplyRed / 256;
-            newGreen = (green + addGreen + sinGreen * sin(2 * PaintownUtil::pi * time / period)) * multiplyGreen / 256;
-            newBlue = (blue + addBlue + sinBlue * sin(2 * PaintownUtil::pi * time / period)) * multiplyBlue / 256;
-        } else {
-            newRed = (red + addRed) * multiplyRed / 256;
-            newGreen = (green + addGreen) * multiplyGreen / 256;
-            newBlue = (blue + addBlue) * multiplyBlue / 256;
-        }
-
-        if (newRed > 255){
-            newRed = 255;
-        }
-
-        if (newRed < 0){
-            newRed = 0;
-        }
-
-        if (newGreen > 255){
-            newGreen = 255;
-        }
-
-        if (newGreen < 0){
-            newGreen = 0;
-        }
-
-        if (newBlue > 255){
-            newBlue = 255;
-        }
-
-        if (newBlue < 0){
-            newBlue = 0;
-        }
-
-        return Graphics::makeColor(newRed, newGreen, newBlue);
-    }
+    /* the same palfx tables characters use */
+    Mugen::ColorTable table;
 
     /* FIXME: this was copied verbatim from character.cpp */
     static PaintownUtil::ReferenceCount<Graphics::Shader> create(){
@@ -1501,17 +1503,7 @@ public:
     }
 
     Graphics::Color filter(Graphics::Color pixel) const {
-
-        if (cache.find(pixel) != cache.end()){
-            return cache[pixel];
-        }
-
-        int red = Graphics::getRed(pixel);
-        int green = Graphics::getGreen(pixel);
-        int blue = Graphics::getBlue(pixel);
-        Graphics::Color out = doFilter(red, green, blue);
-        cache[pixel] = out;
-        return out;
+        return table.apply(pixel);
     }
 };
 
@@ -1552,15 +1544,45 @@ PaintownUtil::ReferenceCount<Mugen::World> Mugen::Stage::snapshotState(){
     }
 
     world->setStageData(getStateData());
-    world->setRandom(*Random::getState());
+    world->setRandom(*simulation.getRandom());
     world->setGameInfo(gameHUD->serialize());
 
     return world;
 }
     
+uint64_t Mugen::Stage::hashState(){
+    /* The world keeps its characters sorted by id */
+    map<CharacterId, Mugen::Character*> sorted;
+    for (vector<Mugen::Character*>::iterator it = objects.begin(); it != objects.end(); it++){
+        Mugen::Character * character = *it;
+        sorted[character->getId()] = character;
+    }
+
+    StateHash out;
+    for (map<CharacterId, Mugen::Character*>::iterator it = sorted.begin(); it != sorted.end(); it++){
+        Mugen::Character * character = it->second;
+        /* Only brought up to date when the state is saved */
+        character->getStateData().commandState = character->getCommands().serialize();
+        digestCharacter(out, it->first, character->getStateData(), character->getCurrentAnimationState(), character->getStatePersistent());
+    }
+
+    map<CharacterId, PlayerData> info;
+    for (vector<Mugen::Character*>::iterator it = players.begin(); it != players.end(); it++){
+        Mugen::Character * character = *it;
+        if (playerInfo.find(character) != playerInfo.end()){
+            info[character->getId()] = playerInfo[character];
+        }
+    }
+    digest(out, info);
+
+    digest(out, getStateData());
+    simulation.getRandom()->digest(out);
+    return out.get();
+}
+
 void Mugen::Stage::updateState(const Mugen::World & world){
     setStateData(world.getStageData());
-    Random::setState(world.getRandom());
+    simulation.setRandom(world.getRandom());
     gameHUD->deserialize(world.getGameInfo());
 
     const map<CharacterId, AllCharacterData> & data = world.getCharacterData();
@@ -1614,7 +1636,6 @@ vector<int> Mugen::Stage::allSpritePriorities(){
 
 int Mugen::Stage::findMinimumSpritePriority(){
     vector<int> priorities = allSpritePriorities();
-    std::sort(priorities.begin(), priorities.end());
 
     if (priorities.size() > 0){
         return priorities[0];
@@ -1625,7 +1646,6 @@ int Mugen::Stage::findMinimumSpritePriority(){
 
 int Mugen::Stage::findMaximumSpritePriority(){
     vector<int> priorities = allSpritePriorities();
-    std::sort(priorities.begin(), priorities.end());
 
     if (priorities.size() > 0){
         return priorities[priorities.size() - 1];
@@ -1634,13 +1654,45 @@ int Mugen::Stage::findMaximumSpritePriority(){
     return 0;
 }
 
+void Mugen::Stage::sortRenderList(){
+    renderList.clear();
+
+    unsigned int order = 0;
+    for (vector<Mugen::Character*>::iterator it = objects.begin(); it != objects.end(); it++, order++){
+        Mugen::Character * object = *it;
+        renderList.push_back(RenderEntry(object->getSpritePriority(), RenderEntry::Player, order, object, NULL, NULL));
+    }
+
+    order = 0;
+    for (vector<Mugen::Effect*>::iterator it = showSparks.begin(); it != showSparks.end(); it++, order++){
+        Mugen::Effect * spark = *it;
+        renderList.push_back(RenderEntry(spark->getSpritePriority(), RenderEntry::Spark, order, NULL, spark, NULL));
+    }
+
+    order = 0;
+    for (vector<Projectile*>::iterator it = projectiles.begin(); it != projectiles.end(); it++, order++){
+        Projectile * projectile = *it;
+        renderList.push_back(RenderEntry(projectile->getSpritePriority(), RenderEntry::Shot, order, NULL, NULL, projectile));
+    }
+
+    /* no two entries compare equal so this is as good as a stable sort,
+     * and unlike std::stable_sort it doesn't need a temporary buffer.
+     */
+    std::sort(renderList.begin(), renderList.end());
+}
+
 void Mugen::Stage::render(Graphics::Bitmap *work){
+    renderView(work, getStateData().camerax, getStateData().cameray, map<const Mugen::Character*, DrawShift>());
+}
+
+void Mugen::Stage::renderView(Graphics::Bitmap *work, double camerax, double cameray, const map<const Mugen::Character*, DrawShift> & shifts){
+    DrawReport::beginFrame();
 
     if (getStateData().environmentColor.time == 0){
         if (paletteEffects.time > 0){
-            drawBackgroundWithEffects((int) getStateData().camerax, (int) getStateData().cameray, *work);
+            drawBackgroundWithEffects((int) camerax, (int) cameray, *work);
         } else {
-            background->renderBackground((int) getStateData().camerax, (int) getStateData().cameray, *work);
+            background->renderBackground((int) camerax, (int) cameray, *work);
         }
     } else if (getStateData().environmentColor.under){
         /* FIXME: I'm not exactly sure where the environment color is supposed to go.
@@ -1659,49 +1711,54 @@ void Mugen::Stage::render(Graphics::Bitmap *work){
     //! Render layer 0 HUD
     gameHUD->render(Mugen::Element::Background, *work);
 
-    /* FIXME: this is a hack to deal with sprite priorities. Really we should get all
-     * the drawable objects and sort them.
-     */
-    /*
-    int minumumSpritePriority = findMinimumSpritePriority();
-    int maximumSpritePriority = findMaximumSpritePriority();
-    */
-
-    vector<int> priorities = allSpritePriorities();
-    for (vector<int>::iterator spritePriority = priorities.begin(); spritePriority != priorities.end(); spritePriority++){
-        // Players go in here
-        for (vector<Mugen::Character*>::iterator it = objects.begin(); it != objects.end(); it++){
-            Mugen::Character *obj = *it;
-
-            if (obj->getSpritePriority() == *spritePriority){
-                /* Reflection */
-                /* FIXME: reflection and shade need camerax/y */
-                if (reflectionIntensity > 0){
-                    obj->drawReflection(work, (int)(getStateData().camerax - DEFAULT_WIDTH / 2), (int) getStateData().cameray, reflectionIntensity);
-                }
-
-                /* Shadow */
-                obj->drawMugenShade(work, (int)(getStateData().camerax - DEFAULT_WIDTH / 2), shadowIntensity, shadowColor, shadowYscale, shadowFadeRangeMid, shadowFadeRangeHigh);
+    sortRenderList();
+    {
+        Atlas::Batch batch;
+        for (vector<RenderEntry>::iterator it = renderList.begin(); it != renderList.end(); it++){
+            const RenderEntry & entry = *it;
+            switch (entry.kind){
+                case RenderEntry::Player: {
+                    Mugen::Character * obj = entry.character;
+                    /* the shadow isn't drawn by the sprites, so it can't be held */
+                    Atlas::Batch::flush();
+
+                    /* a character drawn somewhere other than where it is gets
+                     * the camera moved the other way instead
+                     */
+                    double playerCameraX = camerax;
+                    double playerCameraY = cameray;
+                    /* the reflection is upside down */
+                    double reflectionCameraY = cameray;
+                    map<const Mugen::Character*, DrawShift>::const_iterator shift = shifts.find(obj);
+                    if (shift != shifts.end()){
+                        playerCameraX -= shift->second.x;
+                        playerCameraY -= shift->second.y;
+                        reflectionCameraY += shift->second.y;
+                    }
 
-                /* draw the player */
-                obj->draw(work, (int)(getStateData().camerax - DEFAULT_WIDTH / 2), (int) getStateData().cameray);
-            }
-        }
+                    /* Reflection */
+                    /* FIXME: reflection and shade need camerax/y */
+                    if (reflectionIntensity > 0){
+                        obj->drawReflection(work, (int)(playerCameraX - DEFAULT_WIDTH / 2), (int) reflectionCameraY, reflectionIntensity);
+                    }
 
-        for (vector<Mugen::Effect*>::iterator it = showSparks.begin(); it != showSparks.end(); it++){
-            Mugen::Effect * spark = *it;
-            if (spark->getSpritePriority() == *spritePriority){
-                spark->draw(*work, (int) (getStateData().camerax - DEFAULT_WIDTH / 2), (int) getStateData().cameray);
-            }
-        }
+                    /* Shadow */
+                    obj->drawMugenShade(work, (int)(playerCameraX - DEFAULT_WIDTH / 2), shadowIntensity, shadowColor, shadowYscale, shadowFadeRangeMid, shadowFadeRangeHigh);
 
-        for (vector<Projectile*>::iterator it = projectiles.begin(); it != projectiles.end(); it++){
-            Projectile * projectile = *it;
-            if (projectile->getSpritePriority() == *spritePriority){
-                projectile->draw(*work, getStateData().camerax - DEFAULT_WIDTH / 2, getStateData().cameray);
+                    /* draw the player */
+                    obj->draw(work, (int)(playerCameraX - DEFAULT_WIDTH / 2), (int) playerCameraY);
+                    break;
+                }
+                case RenderEntry::Spark: {
+                    entry.spark->draw(*work, (int) (camerax - DEFAULT_WIDTH / 2), (int) cameray);
+                    break;
+                }
+                case RenderEntry::Shot: {
+                    entry.projectile->draw(*work, camerax - DEFAULT_WIDTH / 2, cameray);
+                    break;
+                }
             }
         }
-
     }
 
     if (getStateData().environmentColor.time > 0 && !getStateData().environmentColor.under){
@@ -1713,9 +1770,9 @@ void Mugen::Stage::render(Graphics::Bitmap *work){
 
     if (getStateData().environmentColor.time == 0){
         if (paletteEffects.time > 0){
-            drawForegroundWithEffects((int) getStateData().camerax, (int) getStateData().cameray, *work);
+            drawForegroundWithEffects((int) camerax, (int) cameray, *work);
         } else {
-            background->renderForeground((int) getStateData().camerax, (int) getStateData().cameray, *work);
+            background->renderForeground((int) camerax, (int) cameray, *work);
         }
     }
     
@@ -1773,13 +1830,64 @@ void Mugen::Stage::render(Graphics::Bitmap *work){
     
     // Render console
     // console->draw(*work);
+
+    DrawReport::endFrame();
 }
     
+void Mugen::Stage::render(Graphics::Bitmap *work, double interpolation){
+    if (!interpolate || lastPositions.empty() || interpolation >= 1){
+        render(work);
+        return;
+    }
+
+    if (interpolation < 0){
+        interpolation = 0;
+    }
+
+    /* further than this in one tick is a teleport or a new round, which
+     * shouldn't slide across the screen
+     */
+    const double jump = 80;
+
+    /* nothing the logic uses is changed, the characters are drawn shifted
+     * part of the way back and the camera is moved part of the way back
+     */
+    map<const Mugen::Character*, DrawShift> shifts;
+    for (vector<LastPosition>::iterator it = lastPositions.begin(); it != lastPositions.end(); it++){
+        const LastPosition & last = *it;
+        if (std::find(objects.begin(), objects.end(), last.character) == objects.end() ||
+            last.character->getId() != last.id){
+            continue;
+        }
+
+        const Mugen::Character * character = last.character;
+        double x = character->getX();
+        double y = character->getY();
+        if (fabs(x - last.x) > jump || fabs(y - last.y) > jump){
+            continue;
+        }
+
+        DrawShift & shift = shifts[character];
+        shift.x = (last.x - x) * (1 - interpolation);
+        shift.y = (last.y - y) * (1 - interpolation);
+    }
+
+    double cameraX = getStateData().camerax;
+    double cameraY = getStateData().cameray;
+    if (fabs(cameraX - lastCameraX) <= jump && fabs(cameraY - lastCameraY) <= jump){
+        cameraX = lastCameraX + (cameraX - lastCameraX) * interpolation;
+        cameraY = lastCameraY + (cameraY - lastCameraY) * interpolation;
+    }
+
+    renderView(work, cameraX, cameraY, shifts);
+}
+
 void Mugen::Stage::setMatchWins(int wins){
     this->gameHUD->setMatchWins(wins);
 }
 
 void Mugen::Stage::reset(){
+    Simulation::Scope scope(simulation);
     getStateData().camerax = startx;
     getStateData().cameray = starty;
     originalMaxLeft = maximumLeft(NULL);
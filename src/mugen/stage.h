@@ -11,6 +11,7 @@
 #include <r-tech1/graphics/bitmap.h>
 #include "common.h"
 #include "stage-state.h"
+#include "simulation.h"
 
 namespace Graphics{
 class Bitmap;
@@ -121,6 +122,19 @@ public:
     // Render the backgrounds appropriately
     void render(Graphics::Bitmap *work);
 
+    /* Draws the characters and the camera `interpolation' of the way from
+     * where they were at the start of the last tick (0) to where they are
+     * now (1). Only does something after setInterpolate(true). The stage
+     * itself is not changed, so the logic never sees a drawn position.
+     */
+    void render(Graphics::Bitmap *work, double interpolation);
+
+    /* remember where things are at the start of each tick for render() */
+    virtual void setInterpolate(bool what);
+
+    /* have the human players read their input now, see Behavior::latch */
+    virtual void latchInput();
+
     // Reset scenario
     void reset();
     
@@ -141,6 +155,15 @@ public:
     virtual bool replayEnabled() const;
     virtual void setReplay(bool what);
 
+    /* When set, logic() skips the work that only matters for drawing. No hit
+     * sparks or dust are made, afterimages are not recorded and only the
+     * timer and round of the hud act. The match ends up in the same state
+     * either way. Fast forwarding a replay and catching up after a rollback
+     * turn this on.
+     */
+    virtual bool isSimulationOnly() const;
+    virtual void setSimulationOnly(bool what);
+
     //! Set match
     virtual void setMatchOver(bool over){
         this->gameOver = over;
@@ -183,6 +206,18 @@ public:
     virtual PaintownUtil::ReferenceCount<World> snapshotState();
     virtual void updateState(const World & world);
 
+    /* Same value as snapshotState()->hash() without building the World, so
+     * it is cheap enough to compute every tick.
+     */
+    virtual uint64_t hashState();
+
+    /* The random numbers, sounds and settings of this match. load(), logic()
+     * and reset() run with it bound to the calling thread.
+     */
+    inline Simulation & getSimulation(){
+        return simulation;
+    }
+
     // Inherited world actions
     virtual void draw(Graphics::Bitmap * work);
     virtual void addObject(Character * o);
@@ -332,6 +367,21 @@ protected:
 
     PaletteEffects paletteEffects;
 
+    /* how far from where it really is to draw a character */
+    struct DrawShift{
+        DrawShift():
+            x(0),
+            y(0){
+            }
+
+        double x, y;
+    };
+
+    /* draws everything as seen from the given camera with the characters in
+     * `shifts' moved over. reads the stage but changes nothing the logic uses.
+     */
+    void renderView(Graphics::Bitmap *work, double camerax, double cameray, const std::map<const Character*, DrawShift> & shifts);
+
     void drawBackgroundWithEffects(int x, int y, const Graphics::Bitmap & board);
     void drawForegroundWithEffects(int x, int y, const Graphics::Bitmap & board);
     void drawBackgroundWithEffectsSide(int x, int y, const Graphics::Bitmap & board, void (Background::*render) (int, int, const Graphics::Bitmap &, Graphics::Bitmap::Filter *));
@@ -374,6 +424,9 @@ protected:
     int findMinimumSpritePriority();
     std::vector<int> allSpritePriorities();
 
+    /* fill renderList with everything in the play area in drawing order */
+    void sortRenderList();
+
     std::vector<Character*> getOpponents(Object * who);
 
     /* Location is the directory passed in ctor
@@ -651,6 +704,48 @@ private:
     std::map<int, PaintownUtil::ReferenceCount<Animation> > sparks;
     std::vector<Effect*> showSparks;
 
+    /* something to draw in the play area. entries are ordered by sprite
+     * priority, then characters before sparks before projectiles, then by
+     * their position in their list, which is the order the old per-priority
+     * loops drew them in.
+     */
+    struct RenderEntry{
+        enum Kind{
+            Player,
+            Spark,
+            Shot
+        };
+
+        RenderEntry(int priority, Kind kind, unsigned int order, Character * character, Effect * spark, Projectile * projectile):
+            priority(priority),
+            kind(kind),
+            order(order),
+            character(character),
+            spark(spark),
+            projectile(projectile){
+            }
+
+        bool operator<(const RenderEntry & him) const {
+            if (priority != him.priority){
+                return priority < him.priority;
+            }
+            if (kind != him.kind){
+                return kind < him.kind;
+            }
+            return order < him.order;
+        }
+
+        int priority;
+        Kind kind;
+        unsigned int order;
+        Character * character;
+        Effect * spark;
+        Projectile * projectile;
+    };
+
+    /* kept between frames so its storage is reused */
+    std::vector<RenderEntry> renderList;
+
     // Character huds
     GameInfo *gameHUD;
 
@@ -658,6 +753,9 @@ private:
 
     int objectId;
 
+    /* forked from the simulation that was current when the stage was made */
+    Simulation simulation;
+
     StageStateData stateData;
     StageStateData & getStateData();
     const StageStateData & getStateData() const;
@@ -666,6 +764,31 @@ private:
     PaintownUtil::ReferenceCount<StageObserver> observer;
     /* true if doing in-game replay */
     bool replay;
+    /* true while re-simulating ticks that will not be drawn */
+    bool simulationOnly;
+
+    /* where a character was at the start of the last tick */
+    struct LastPosition{
+        LastPosition(Character * character, const CharacterId & id, double x, double y):
+            character(character),
+            id(id),
+            x(x),
+            y(y){
+            }
+
+        Character * character;
+        /* the character can be gone by the time this is used and a new
+         * helper can have the same address, but not the same id
+         */
+        CharacterId id;
+        double x, y;
+    };
+
+    bool interpolate;
+    std::vector<LastPosition> lastPositions;
+    double lastCameraX, lastCameraY;
+
+    void savePositions();
 };
 
 }
@@ -42,7 +42,6 @@ type(Unknown),
 name(name),
 debug(false),
 persistent(1),
-currentPersistent(1),
 state(state),
 id(id){
 }
@@ -52,7 +51,6 @@ type(Unknown),
 name(name),
 debug(false),
 persistent(1),
-currentPersistent(1),
 state(state),
 id(id),
 spritePriority(0){
@@ -66,14 +64,13 @@ spritePriority(0){
 
         virtual void onAttributeSimple(const Ast::AttributeSimple & simple){
             if (simple == "triggerall"){
-                controller.addTriggerAll(Compiler::compile(simple.getValue()));
+                controller.addTriggerAll(Compiler::compileTrigger(simple.getValue()));
             } else if (PaintownUtil::matchRegex(PaintownUtil::lowerCaseAll(simple.idString()), PaintownUtil::Regex("trigger[0-9]+"))){
                 int trigger = atoi(PaintownUtil::captureRegex(PaintownUtil::lowerCaseAll(simple.idString()), PaintownUtil::Regex("trigger([0-9]+)"), 0).c_str());
-                controller.addTrigger(trigger, Compiler::compile(simple.getValue()));
+                controller.addTrigger(trigger, Compiler::compileTrigger(simple.getValue()));
             } else if (simple == "persistent"){
                 try{
                     simple.view() >> controller.persistent;
-                    controller.currentPersistent = controller.persistent;
                 } catch (const Ast::Exception & fail){
                     /* No values for persistent.. */
                 }
@@ -97,7 +94,6 @@ type(you.type),
 name(you.name),
 debug(you.debug),
 persistent(you.persistent),
-currentPersistent(you.currentPersistent),
 ignoreHitPauseValue(copy(you.ignoreHitPauseValue)),
 state(you.state),
 id(you.id),
@@ -127,14 +123,6 @@ int StateController::getPersistent() const {
     return persistent;
 }
     
-int StateController::getCurrentPersistent() const {
-    return currentPersistent;
-}
-    
-void StateController::setCurrentPersistent(int value){
-    currentPersistent = value;
-}
-    
 unsigned int StateController::getId() const {
     return id;
 }
@@ -151,14 +139,14 @@ StateController::~StateController(){
 
 double evaluateNumber(Compiler::Value * value, const Environment & env, double default_){
     if (value != NULL){
-        return value->evaluate(env).toNumber();
+        return Compiler::evaluateNumber(value, env);
     }
     return default_;
 }
 
 double evaluateNumber(const Value & value, const Environment & env, double default_){
     if (value != NULL){
-        return value->evaluate(env).toNumber();
+        return Compiler::evaluateNumber(value.raw(), env);
     }
     return default_;
 }
@@ -172,28 +160,24 @@ string evaluateString(const Value & value, const Environment & env, string defau
 
 double evaluateBool(Compiler::Value * value, const Environment & env, double default_){
     if (value != NULL){
-        return value->evaluate(env).toBool();
+        return Compiler::evaluateBool(value, env);
     }
     return default_;
 }
 
 bool evaluateBool(const Value & value, const Environment & env, double default_){
     if (value != NULL){
-        return value->evaluate(env).toBool();
+        return Compiler::evaluateBool(value.raw(), env);
     }
     return default_;
 }
 
-   
-void StateController::resetPersistent(){
-    currentPersistent = persistent;
-}
     
 bool StateController::ignoreHitPause(const Environment & environment) const {
     return evaluateBool(ignoreHitPauseValue, environment, false);
 }
 
-bool StateController::persistentOk(){
+bool StateController::persistentOk(int & currentPersistent) const {
     /* count down from the persistent value to 0, then reset back to
      * the persistent value. the controller can activate if the current
      * persistent value reaches 0.
@@ -234,8 +218,7 @@ bool StateController::canTrigger(const Compiler::Value * expression, const Envir
             x += 1;
         }
         */
-        RuntimeValue result = expression->evaluate(environment);
-        return result.toBool();
+        return Compiler::evaluateBool(expression, environment);
     } catch (const MugenNormalRuntimeException e){
         ostringstream out;
         out << "Expression `" << expression->toString() << "' " << e.getFullReason();
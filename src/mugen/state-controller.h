@@ -5,6 +5,7 @@
 #include <vector>
 #include <string>
 #include <r-tech1/pointer.h>
+#include "arena.h"
 
 namespace Ast{
     class Section;
@@ -38,6 +39,17 @@ public:
     StateController(const std::string & name, int state, unsigned int id, Ast::Section * section);
     StateController(const StateController & you);
 
+    /* controllers live in the arena of the character that loads them, see
+     * arena.h
+     */
+    static void * operator new(size_t size){
+        return Arena::allocate(size);
+    }
+
+    static void operator delete(void * memory){
+        Arena::release(memory);
+    }
+
     /* from scrtls.html or more recently
      * http://elecbyte.com/wiki/index.php/Category:State_Controllers
      */
@@ -175,12 +187,14 @@ public:
 
     virtual unsigned int getId() const;
 
-    virtual void resetPersistent();
-    virtual bool persistentOk();
+    /* current is the countdown of the persistent level for the character
+     * running this controller, it starts at getPersistent(). The countdown
+     * is kept by the character so characters (and helpers) can share the
+     * same controller.
+     */
+    virtual bool persistentOk(int & current) const;
 
     virtual int getPersistent() const;
-    virtual int getCurrentPersistent() const;
-    virtual void setCurrentPersistent(int value);
 
     virtual bool ignoreHitPause(const Environment & environment) const;
 
@@ -201,8 +215,6 @@ protected:
 
     /* persistent value set in the controller */
     int persistent;
-    /* countdown of persistent level */
-    int currentPersistent;
 
     ::Util::ClassPointer<Compiler::Value> ignoreHitPauseValue;
 
@@ -126,6 +126,7 @@ struct %(name)s{
 };
 Token * serialize(const %(name)s & data);
 %(name)s deserialize%(name)s(const Token * data);
+void digest(StateHash & out, const %(name)s & data);
 """ % {'name': object.name,
        'more': more,
        'maybe-instance': instance,
@@ -326,6 +327,17 @@ def generate_cpp(object, structs):
         return out
 
 
+    # Feeds every field into the hash in the order they are declared
+    def digest_fields(object):
+        out = ""
+        for field in object.fields:
+            if field.array != None:
+                for i in xrange(0, int(field.array)):
+                    out += """    digest(out, data.%(name)s[%(index)d]);\n""" % {'name': field.name, 'index': i}
+            else:
+                out += """    digest(out, data.%(name)s);\n""" % {'name': field.name}
+        return out
+
     inner_structs = ""
     for field in object.fields:
         if isinstance(field.type_, state.State):
@@ -346,8 +358,12 @@ Token * serialize(const %(name)s & data){
 %(deserialize)s
     return out;
 }
+
+void digest(StateHash & out, const %(name)s & data){
+%(digest)s}
 """ % {'inner': inner_structs,
        'name': object.name,
+       'digest': digest_fields(object),
        'deserialize': deserialize_fields(object),
        'field': serialize_fields(object)}
     return data
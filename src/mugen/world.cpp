@@ -2,6 +2,7 @@
 #include "character.h"
 #include <r-tech1/token.h>
 #include "constraint.h"
+#include "serialize.h"
 #include <vector>
 #include <string>
 #include <sstream>
@@ -19,6 +20,7 @@ gameInfo(NULL){
     
 World::World(const World & copy):
 characterData(copy.characterData),
+stagePlayerData(copy.stagePlayerData),
 stageData(copy.stageData),
 random(copy.random),
 gameInfo(NULL){
@@ -43,14 +45,7 @@ AllCharacterData::AllCharacterData(){
 void World::addCharacter(const Character & who){
     characterData[who.getId()] = AllCharacterData(who.getStateData(), who.getCurrentAnimationState(), who.getStatePersistent());
     AllCharacterData & data = characterData[who.getId()];
-    const std::vector<Command2 *> & commands = who.getCommands();
-    std::map<std::string, std::string > & commandState = data.character.commandState;
-    for (vector<Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
-        Command2 * command = *it;
-        Token * serialized = command->serialize();
-        commandState[command->getName()] = serialized->toStringCompact();
-        delete serialized;
-    }
+    data.character.commandState = who.getCommands().serialize();
 }
     
 void World::setGameInfo(Token * token){
@@ -294,4 +289,80 @@ bool World::operator!=(const World & him) const {
     return !(*this == him);
 }
 
+void digestCharacter(StateHash & out, const CharacterId & id, const StateData & character, const AnimationState & animation, const map<int, map<uint32_t, int> > & statePersistent){
+    digest(out, id);
+    digest(out, character);
+    digest(out, animation);
+    digest(out, statePersistent);
+}
+
+uint64_t World::hash() const {
+    StateHash out;
+    for (map<CharacterId, AllCharacterData>::const_iterator it = characterData.begin(); it != characterData.end(); it++){
+        const AllCharacterData & data = it->second;
+        digestCharacter(out, it->first, data.character, data.animation, data.statePersistent);
+    }
+    digest(out, stagePlayerData);
+    digest(out, stageData);
+    random.digest(out);
+    return out.get();
+}
+
+/* The data of a token, without its children */
+static string tokenValue(const Token * token){
+    std::ostringstream out;
+    for (vector<Token*>::const_iterator it = token->getTokens()->begin(); it != token->getTokens()->end(); it++){
+        const Token * value = *it;
+        if (value->isData()){
+            out << value->getName() << " ";
+        }
+    }
+    return out.str();
+}
+
+static vector<const Token*> children(const Token * token){
+    vector<const Token*> out;
+    for (vector<Token*>::const_iterator it = token->getTokens()->begin(); it != token->getTokens()->end(); it++){
+        if (!(*it)->isData()){
+            out.push_back(*it);
+        }
+    }
+    return out;
+}
+
+/* Walks both trees side by side. Children are matched up by position, which
+ * works because both tokens came out of the same serializer.
+ */
+static void difference(const Token * mine, const Token * his, const string & path, std::ostringstream & out){
+    string here = path + "/" + mine->getName();
+    if (mine->getName() != his->getName()){
+        out << here << " != " << path << "/" << his->getName() << std::endl;
+        return;
+    }
+
+    if (tokenValue(mine) != tokenValue(his)){
+        out << here << ": " << tokenValue(mine) << "!= " << tokenValue(his) << std::endl;
+    }
+
+    vector<const Token*> left = children(mine);
+    vector<const Token*> right = children(his);
+    for (unsigned int i = 0; i < left.size() && i < right.size(); i++){
+        difference(left[i], right[i], here, out);
+    }
+
+    if (left.size() != right.size()){
+        out << here << ": " << left.size() << " children != " << right.size() << " children" << std::endl;
+    }
+}
+
+string World::differences(const World & him) const {
+    Token * meToken = serialize();
+    Token * himToken = him.serialize();
+    std::ostringstream out;
+    difference(meToken, himToken, "", out);
+    delete meToken;
+    delete himToken;
+    return out.str();
+}
+
 }
@@ -6,12 +6,14 @@
 #include "stage-state.h"
 #include "random.h"
 #include <map>
+#include <string>
 
 class Token;
 
 namespace Mugen{
 
 class Character;
+class StateHash;
 
 struct AllCharacterData{
     AllCharacterData(const StateData & character, const AnimationState & animation, const std::map<int, std::map<uint32_t, int> > & statePersistent);
@@ -22,6 +24,11 @@ struct AllCharacterData{
     std::map<int, std::map<uint32_t, int> > statePersistent;
 };
 
+/* Feeds one character's part of the world into the hash. Shared by
+ * World::hash() and Stage::hashState() so both produce the same value.
+ */
+void digestCharacter(StateHash & out, const CharacterId & id, const StateData & character, const AnimationState & animation, const std::map<int, std::map<uint32_t, int> > & statePersistent);
+
 /* Maintains a snapshot of all state data */
 class World{
 public:
@@ -45,6 +52,16 @@ public:
     bool operator==(const World & him) const;
     bool operator!=(const World & him) const;
 
+    /* A hash of the game state, the same as Stage::hashState() returns for
+     * the stage this world was taken from. The game info is not included.
+     */
+    uint64_t hash() const;
+
+    /* Paths and values of the fields that are not the same in the two
+     * worlds, one per line.
+     */
+    std::string differences(const World & him) const;
+
     Token * serialize() const;
     static World * deserialize(const Token * token);
 
@@ -48,12 +48,51 @@ static vector<Token> getAnimations(Token * head){
     }
     return out;
 }
+
+const Filesystem::AbsolutePath & DisplayCharacter::getModel() const {
+    return path;
+}
+
+vector<Filesystem::RelativePath> DisplayCharacter::getIdleFrames() const {
+    vector<Filesystem::RelativePath> frames;
+    PackReader::View raw = reader.getView(path.path());
+    string data = Bor::doParse(raw.getData(), raw.getLength());
+
+    TokenReader tokens;
+    Token * head = tokens.readTokenFromString(data);
+
+    vector<Token> animations = getAnimations(head);
+    for (vector<Token>::iterator it = animations.begin(); it != animations.end(); it++){
+        Token & animation = *it;
+        string name;
+        animation.view() >> name;
+        if (name != "idle"){
+            continue;
+        }
+
+        /* the same paths Paintown::Animation comes up with */
+        string basedir(".");
+        TokenView view = animation.view();
+        while (view.hasMore()){
+            const Token * current;
+            view >> current;
+            if (*current == "basedir"){
+                current->view() >> basedir;
+            } else if (*current == "frame"){
+                string file;
+                current->view() >> file;
+                frames.push_back(Filesystem::RelativePath(basedir).join(Filesystem::RelativePath(file)));
+            }
+        }
+    }
+
+    return frames;
+}
     
 void DisplayCharacter::load(){
-    char * raw = reader.readFile(reader.getFile(path.path()));
-    string data = Bor::doParse(raw, reader.getFileLength(path.path()));
+    PackReader::View raw = reader.getView(path.path());
+    string data = Bor::doParse(raw.getData(), raw.getLength());
     // Global::debug(0) << "Bor input: '" << parsed << "'" << endl;
-    delete[] raw;
 
     TokenReader reader;
     Token * head = reader.readTokenFromString(data);
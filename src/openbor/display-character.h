@@ -2,6 +2,7 @@
 #define _paintown_openbor_display_character_h
 
 #include <string>
+#include <vector>
 #include "paintown-engine/object/display_character.h"
 #include <r-tech1/file-system.h>
 
@@ -12,6 +13,16 @@ class PackReader;
 class DisplayCharacter: public Paintown::DisplayCharacter {
 public:
     DisplayCharacter(PackReader & reader, const Filesystem::AbsolutePath & file);
+
+    /* the model file in the pak */
+    const Filesystem::AbsolutePath & getModel() const;
+
+    /* Reads the model again for the paths of the frames of its 'idle'
+     * animation, the only images load() will ask the mod for. Only touches
+     * the pak so it can run on any thread before load().
+     */
+    std::vector<Filesystem::RelativePath> getIdleFrames() const;
+
 protected:
     /* called by the loader */
     virtual void load();
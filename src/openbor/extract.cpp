@@ -73,14 +73,13 @@ void doExtract(Bor::PackReader & reader, string where){
         char * data = new char[offset.length];
         stream.read(data, offset.length);
         */
-        char * data = reader.readFile(offset);
+        Bor::PackReader::View data = reader.getView(offset);
         string final = where + "/" + path;
         // cout << "Final is '" << final << "'" << endl;
         mkdirs(final);
         ofstream out(final.c_str(), std::ios::out | std::ios::binary);
         cout << "Writing " << final << endl;
-        out.write(data, offset.length);
-        delete[] data;
+        out.write(data.getData(), data.getLength());
     }
 }
 
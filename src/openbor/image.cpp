@@ -0,0 +1,303 @@
+#include <r-tech1/graphics/bitmap.h>
+#include "image.h"
+#include <string.h>
+
+using namespace std;
+
+namespace Bor{
+
+Image::Image():
+width(0),
+height(0),
+transparent(-1){
+}
+
+static int read16(const unsigned char * data){
+    return data[0] | (data[1] << 8);
+}
+
+/* Reads the codes out of the data sub-blocks of an image, lowest bit first */
+class CodeReader{
+public:
+    CodeReader(const vector<unsigned char> & data):
+    data(data),
+    bit(0){
+    }
+
+    /* -1 once the data runs out */
+    int read(int size){
+        if (bit + size > data.size() * 8){
+            return -1;
+        }
+
+        int code = 0;
+        for (int i = 0; i < size; i++){
+            if (data[bit / 8] & (1 << (bit % 8))){
+                code |= 1 << i;
+            }
+            bit += 1;
+        }
+        return code;
+    }
+
+protected:
+    const vector<unsigned char> & data;
+    unsigned int bit;
+};
+
+static const int MaxCodes = 4096;
+
+/* Sprites in a pak are nowhere near this big, anything bigger is a broken
+ * file and not worth allocating for.
+ */
+static const int MaxPixels = 4096 * 4096;
+
+/* Lzw decodes `data' into `out', which is as big as the image */
+static bool decompress(const vector<unsigned char> & data, int minimum, vector<unsigned char> & out){
+    if (minimum < 2 || minimum > 8){
+        return false;
+    }
+
+    const int clear = 1 << minimum;
+    const int end = clear + 1;
+
+    /* each code is the code before it plus one more index */
+    vector<int> prefix(MaxCodes, 0);
+    vector<unsigned char> suffix(MaxCodes, 0);
+    for (int i = 0; i < clear; i++){
+        suffix[i] = i;
+    }
+    vector<unsigned char> stack;
+
+    CodeReader reader(data);
+    int size = minimum + 1;
+    int next = clear + 2;
+    int previous = -1;
+    unsigned char first = 0;
+    unsigned int written = 0;
+
+    while (written < out.size()){
+        int code = reader.read(size);
+        if (code == -1 || code == end){
+            break;
+        }
+
+        if (code == clear){
+            size = minimum + 1;
+            next = clear + 2;
+            previous = -1;
+            continue;
+        }
+
+        if (previous == -1){
+            if (code >= clear){
+                return false;
+            }
+            first = code;
+            out[written] = first;
+            written += 1;
+            previous = code;
+            continue;
+        }
+
+        int in = code;
+        stack.clear();
+        if (code >= next){
+            /* the code being defined right now, previous plus its own first index */
+            if (code > next){
+                return false;
+            }
+            stack.push_back(first);
+            code = previous;
+        }
+
+        while (code >= clear){
+            stack.push_back(suffix[code]);
+            code = prefix[code];
+        }
+        first = code;
+        stack.push_back(first);
+
+        for (vector<unsigned char>::reverse_iterator it = stack.rbegin(); it != stack.rend() && written < out.size(); it++){
+            out[written] = *it;
+            written += 1;
+        }
+
+        if (next < MaxCodes){
+            prefix[next] = previous;
+            suffix[next] = first;
+            next += 1;
+            if (next == (1 << size) && size < 12){
+                size += 1;
+            }
+        }
+
+        previous = in;
+    }
+
+    return true;
+}
+
+/* Rows of an interlaced image come in four passes */
+static void deinterlace(const vector<unsigned char> & rows, int width, int height, vector<unsigned char> & out){
+    static const int start[] = {0, 4, 2, 1};
+    static const int step[] = {8, 8, 4, 2};
+    int row = 0;
+    for (int pass = 0; pass < 4; pass++){
+        for (int y = start[pass]; y < height; y += step[pass]){
+            memcpy(&out[y * width], &rows[row * width], width);
+            row += 1;
+        }
+    }
+}
+
+bool decodeGif(const char * data_, int length, Image & out){
+    const unsigned char * data = (const unsigned char *) data_;
+    if (length < 13 || (memcmp(data, "GIF87a", 6) != 0 && memcmp(data, "GIF89a", 6) != 0)){
+        return false;
+    }
+
+    int screenWidth = read16(data + 6);
+    int screenHeight = read16(data + 8);
+    int flags = data[10];
+    int background = data[11];
+    int position = 13;
+    int transparent = -1;
+
+    vector<unsigned char> global;
+    if (flags & 0x80){
+        int size = 3 * (1 << ((flags & 7) + 1));
+        if (position + size > length){
+            return false;
+        }
+        global.assign(data + position, data + position + size);
+        position += size;
+    }
+
+    while (position < length){
+        int kind = data[position];
+        position += 1;
+
+        if (kind == 0x21){
+            /* the graphic control extension says which index is transparent
+             * for the image after it: a block of 4 bytes with the flags
+             * first and the index last.
+             */
+            if (position + 6 <= length && data[position] == 0xf9 && data[position + 1] >= 4){
+                if (data[position + 2] & 1){
+                    transparent = data[position + 5];
+                } else {
+                    transparent = -1;
+                }
+            }
+
+            /* skip the label and its sub-blocks */
+            position += 1;
+            while (position < length && data[position] != 0){
+                position += data[position] + 1;
+            }
+            position += 1;
+        } else if (kind == 0x2c){
+            if (position + 9 > length){
+                return false;
+            }
+            int left = read16(data + position);
+            int top = read16(data + position + 2);
+            int width = read16(data + position + 4);
+            int height = read16(data + position + 6);
+            int imageFlags = data[position + 8];
+            position += 9;
+
+            vector<unsigned char> palette = global;
+            if (imageFlags & 0x80){
+                int size = 3 * (1 << ((imageFlags & 7) + 1));
+                if (position + size > length){
+                    return false;
+                }
+                palette.assign(data + position, data + position + size);
+                position += size;
+            }
+
+            if (position >= length || palette.empty()){
+                return false;
+            }
+            int minimum = data[position];
+            position += 1;
+
+            vector<unsigned char> compressed;
+            while (position < length && data[position] != 0){
+                int size = data[position];
+                if (position + 1 + size > length){
+                    return false;
+                }
+                compressed.insert(compressed.end(), data + position + 1, data + position + 1 + size);
+                position += size + 1;
+            }
+
+            if (width == 0 || height == 0 || width * height > MaxPixels){
+                return false;
+            }
+            /* the logical screen is never smaller than the image */
+            if ((left + width > screenWidth ? left + width : screenWidth) * (top + height > screenHeight ? top + height : screenHeight) > MaxPixels){
+                return false;
+            }
+
+            vector<unsigned char> indexes(width * height, 0);
+            if (!decompress(compressed, minimum, indexes)){
+                return false;
+            }
+            if (imageFlags & 0x40){
+                vector<unsigned char> rows(indexes);
+                deinterlace(rows, width, height, indexes);
+            }
+
+            /* the image is put on the logical screen, the rest of the screen is
+             * the background color
+             */
+            if (screenWidth < left + width){
+                screenWidth = left + width;
+            }
+            if (screenHeight < top + height){
+                screenHeight = top + height;
+            }
+            out.width = screenWidth;
+            out.height = screenHeight;
+            out.pixels.assign(screenWidth * screenHeight, background);
+            for (int y = 0; y < height; y++){
+                memcpy(&out.pixels[(top + y) * screenWidth + left], &indexes[y * width], width);
+            }
+            out.palette = palette;
+            out.palette.resize(256 * 3, 0);
+            out.transparent = transparent;
+            return true;
+        } else {
+            /* the trailer, or something that isn't a gif */
+            return false;
+        }
+    }
+
+    return false;
+}
+
+Graphics::Bitmap * toBitmap(const Image & image){
+    Graphics::Bitmap * bitmap = new Graphics::Bitmap(image.width, image.height);
+    bitmap->lock();
+    for (int y = 0; y < image.height; y++){
+        for (int x = 0; x < image.width; x++){
+            int pixel = image.pixels[y * image.width + x];
+            int index = pixel * 3;
+            int red = image.palette[index];
+            int green = image.palette[index + 1];
+            int blue = image.palette[index + 2];
+            if (pixel == image.transparent || (red == 255 && green == 0 && blue == 255)){
+                bitmap->putPixel(x, y, Graphics::MaskColor());
+            } else {
+                bitmap->putPixel(x, y, Graphics::makeColor(red, green, blue));
+            }
+        }
+    }
+    bitmap->unlock();
+    return bitmap;
+}
+
+}
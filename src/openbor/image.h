@@ -0,0 +1,42 @@
+#ifndef _paintown_openbor_image_h
+#define _paintown_openbor_image_h
+
+#include <vector>
+
+namespace Graphics{
+class Bitmap;
+}
+
+namespace Bor{
+
+/* The pixels of an image file, decoded without going through the graphics
+ * library so it can be done on any thread. Turning it into a bitmap is left
+ * to the main thread.
+ */
+struct Image{
+    Image();
+
+    int width;
+    int height;
+    /* palette index of each pixel, a row at a time */
+    std::vector<unsigned char> pixels;
+    /* red, green and blue of each palette index */
+    std::vector<unsigned char> palette;
+    /* palette index the gif marks as transparent, -1 if there is none */
+    int transparent;
+};
+
+/* Decodes the first image of a gif file, which is what the sprites in a pak
+ * are. Returns false if the data is not a gif it understands.
+ */
+bool decodeGif(const char * data, int length, Image & out);
+
+/* Makes a bitmap out of a decoded image. The transparent index and magenta,
+ * the mask color in paks, become the mask color. Only call this on the main
+ * thread.
+ */
+Graphics::Bitmap * toBitmap(const Image & image);
+
+}
+
+#endif
@@ -6,12 +6,19 @@
 #include <r-tech1/exceptions/load_exception.h>
 #include <r-tech1/exceptions/exception.h>
 #include <r-tech1/init.h>
+#include <r-tech1/events.h>
+#include <r-tech1/configuration.h>
+#include <r-tech1/input/keyboard.h>
+#include <r-tech1/input/input-source.h>
 #include <r-tech1/input/input-manager.h>
 #include <r-tech1/input/input-map.h>
 #include "mod.h"
 #include "paintown-engine/level/utils.h"
+#include "system/thread-pool.h"
 #include "util.h"
 #include "pack-reader.h"
+#include "display-character.h"
+#include "image.h"
 #include <vector>
 
 using namespace std;
@@ -37,10 +44,6 @@ const string OpenborMod::getMenu(){
     return "menu/main.txt";
 }
 
-/* player1 = 83
- * player2 = 238
- */
-    
 std::vector<Level::LevelInfo> OpenborMod::getLevels(){
     vector<Level::LevelInfo> levels;
     Level::LevelInfo level;
@@ -48,26 +51,35 @@ std::vector<Level::LevelInfo> OpenborMod::getLevels(){
     return levels;
 }
     
+static string lowercase(string in){
+    for (unsigned int i = 0; i < in.length(); i++){
+        if (in[i] >= 'A' && in[i] <= 'Z'){
+            in[i] = in[i] - 'A' + 'a';
+        }
+    }
+    return in;
+}
+
 Graphics::Bitmap * OpenborMod::createBitmap(const Filesystem::RelativePath & path){
+    map<string, Util::ReferenceCount<Graphics::Bitmap> >::iterator found = bitmaps.find(lowercase(path.path()));
+    if (found != bitmaps.end()){
+        return new Graphics::Bitmap(*found->second);
+    }
+
     try{
-        char * data = reader.readFile(reader.getFile(path.path()));
-        Graphics::Bitmap * bitmap = new Graphics::Bitmap(data, reader.getFileLength(path.path()));
-        delete[] data;
-        return bitmap;
+        Bor::PackReader::View data = reader.getView(path.path());
+        return new Graphics::Bitmap(data.getData(), data.getLength());
     } catch (const Bor::PackError & error){
         throw LoadException(__FILE__, __LINE__, error, "Could not create bitmap");
     }
 }
 
 static bool isOpenborPlayer(Bor::PackReader & reader, const string & path){
-    char * data = NULL;
     try{
         TokenReader tokens;
-        char * data = reader.readFile(reader.getFile(path));
-        string parsed = Bor::doParse(data, reader.getFileLength(path));
+        Bor::PackReader::View data = reader.getView(path);
+        string parsed = Bor::doParse(data.getData(), data.getLength());
         // Global::debug(0) << "Bor input: '" << parsed << "'" << endl;
-        delete[] data;
-        data = NULL;
 
         /* will either succeed or throw TokenException */
         Token * start = tokens.readTokenFromString(parsed);
@@ -88,25 +100,126 @@ static bool isOpenborPlayer(Bor::PackReader & reader, const string & path){
         Global::debug(0) << "Failed to parse pak file " << path << " " << e.getReason() << endl;
     }
 
-    delete[] data;
     return false;
 }
 
-#if 0
-static PlayerVector findOpenborPlayers(Bor::PackReader & reader){
-    PlayerVector players;
+/* Finds out if one model in data/chars is a player */
+class FindPlayerJob: public System::ThreadPool::Job {
+public:
+    FindPlayerJob(Bor::PackReader * reader, const string & path):
+    reader(reader),
+    path(path),
+    player(false){
+    }
+
+    virtual void run(){
+        player = isOpenborPlayer(*reader, path);
+    }
+
+    Bor::PackReader * reader;
+    string path;
+    bool player;
+};
+
+/* Decodes the frames one player will need. Only gifs are decoded here,
+ * anything else is left for createBitmap.
+ */
+class DecodePlayerJob: public System::ThreadPool::Job {
+public:
+    DecodePlayerJob(Bor::PackReader * reader, Bor::DisplayCharacter * player):
+    reader(reader),
+    player(player){
+    }
+
+    virtual void run(){
+        try{
+            vector<Filesystem::RelativePath> frames = player->getIdleFrames();
+            for (vector<Filesystem::RelativePath>::iterator it = frames.begin(); it != frames.end(); it++){
+                string key = lowercase(it->path());
+                if (images.find(key) != images.end()){
+                    continue;
+                }
+
+                Bor::PackReader::View data = reader->getView(it->path());
+                Bor::Image image;
+                if (Bor::decodeGif(data.getData(), data.getLength(), image)){
+                    images[key] = image;
+                }
+            }
+        /* loading the player fails the same way later and says why */
+        } catch (const TokenException & fail){
+        } catch (const Bor::PackError & fail){
+        } catch (const Bor::ParseException & fail){
+        }
+    }
+
+    Bor::PackReader * reader;
+    Bor::DisplayCharacter * player;
+    /* decoded frames by lower case path */
+    map<string, Bor::Image> images;
+};
+
+vector<Bor::DisplayCharacter*> OpenborMod::loadPlayers(int threads){
     vector<string> paths = reader.findPaths("data/chars/*/*.txt");
-    sort(paths.begin(), paths.end());
+    System::ThreadPool pool(threads);
+
+    vector<FindPlayerJob> finds;
     for (vector<string>::iterator it = paths.begin(); it != paths.end(); it++){
-        string file = *it;
-        if (isOpenborPlayer(reader, file)){
-            players.push_back(playerInfo(new Bor::DisplayCharacter(reader, file), Filesystem::AbsolutePath(file)));
+        finds.push_back(FindPlayerJob(&reader, *it));
+    }
+
+    vector<System::ThreadPool::Job*> jobs;
+    for (vector<FindPlayerJob>::iterator it = finds.begin(); it != finds.end(); it++){
+        jobs.push_back(&*it);
+    }
+    pool.run(jobs);
+
+    /* findPaths gives back sorted paths so the players stay in that order */
+    vector<Bor::DisplayCharacter*> players;
+    vector<Paintown::DisplayCharacter*> load;
+    vector<DecodePlayerJob> decodes;
+    for (vector<FindPlayerJob>::iterator it = finds.begin(); it != finds.end(); it++){
+        if (it->player){
+            Bor::DisplayCharacter * player = new Bor::DisplayCharacter(reader, Filesystem::AbsolutePath(it->path));
+            players.push_back(player);
+            load.push_back(player);
+            decodes.push_back(DecodePlayerJob(&reader, player));
         }
     }
 
+    jobs.clear();
+    for (vector<DecodePlayerJob>::iterator it = decodes.begin(); it != decodes.end(); it++){
+        jobs.push_back(&*it);
+    }
+    pool.run(jobs);
+
+    /* bitmaps and their reference counts are not safe to make on the pool,
+     * so the decoded pixels are turned into bitmaps here.
+     */
+    for (vector<DecodePlayerJob>::iterator it = decodes.begin(); it != decodes.end(); it++){
+        for (map<string, Bor::Image>::iterator image = it->images.begin(); image != it->images.end(); image++){
+            if (bitmaps.find(image->first) == bitmaps.end()){
+                bitmaps[image->first] = Util::ReferenceCount<Graphics::Bitmap>(Bor::toBitmap(image->second));
+            }
+        }
+        it->images.clear();
+    }
+
+    /* characters that fail to load are still given back, isLoaded() is
+     * false for them. the players keep their own copies of the bitmaps so
+     * the cache is only needed while they load.
+     */
+    Paintown::DisplayCharacterLoader loader(load);
+    try{
+        loader.load();
+    } catch (...){
+        bitmaps.clear();
+        throw;
+    }
+    bitmaps.clear();
+
     return players;
 }
-#endif
 
 namespace Select{
     enum Input{
@@ -116,22 +229,123 @@ namespace Select{
     };
 }
 
+/* threads used to load the players for the select screen */
+static const int PlayerThreads = 4;
+
+/* Shows one player at a time on top of the select background */
+class PlayerSelecter: public Util::Logic, public Util::Draw {
+public:
+    PlayerSelecter(const vector<Bor::DisplayCharacter*> & players, const Graphics::Bitmap & background, const InputSource & source):
+    players(players),
+    background(background),
+    source(source),
+    current(0),
+    is_done(false){
+        for (vector<int>::const_iterator it = source.getKeyboard().begin(); it != source.getKeyboard().end(); it++){
+            int player = *it;
+            input.set(Configuration::getLeft(player), Select::Left);
+            input.set(Configuration::getRight(player), Select::Right);
+            input.set(Configuration::getAttack1(player), Select::Choose);
+        }
+        input.set(Keyboard::Key_ESC, Select::Quit);
+        input.set(Keyboard::Key_ENTER, Select::Choose);
+        input.set(Keyboard::Key_SPACE, Select::Choose);
+
+        if (source.useJoystick()){
+            input.set(Joystick::Left, Select::Left);
+            input.set(Joystick::Right, Select::Right);
+            input.set(Joystick::Start, Select::Choose);
+            input.set(Joystick::Button1, Select::Choose);
+            input.set(Joystick::Quit, Select::Quit);
+        }
+    }
+
+    const vector<Bor::DisplayCharacter*> & players;
+    const Graphics::Bitmap & background;
+    InputMap<Select::Input> input;
+    const InputSource & source;
+    unsigned int current;
+    bool is_done;
+
+    bool done(){
+        return is_done;
+    }
+
+    void run(){
+        vector<InputMap<Select::Input>::InputEvent> out = InputManager::getEvents(input, source);
+        for (vector<InputMap<Select::Input>::InputEvent>::iterator it = out.begin(); it != out.end(); it++){
+            const InputMap<Select::Input>::InputEvent & event = *it;
+            if (event.enabled){
+                if (event.out == Select::Quit){
+                    InputManager::waitForRelease(input, source, Select::Quit);
+                    throw Exception::Return(__FILE__, __LINE__);
+                } else if (event.out == Select::Left){
+                    current = (current + players.size() - 1) % players.size();
+                } else if (event.out == Select::Right){
+                    current = (current + 1) % players.size();
+                } else if (event.out == Select::Choose){
+                    is_done = players[current]->isLoaded();
+                }
+            }
+        }
+
+        Bor::DisplayCharacter * player = players[current];
+        if (player->isLoaded() && player->testAnimation()){
+            player->testReset();
+        }
+    }
+
+    const Filesystem::AbsolutePath & chosen() const {
+        return players[current]->getModel();
+    }
+
+    double ticks(double system){
+        return system * Global::ticksPerSecond(90);
+    }
+
+    void draw(const Graphics::Bitmap & buffer){
+        /* FIXME: hardcoded resolution */
+        Graphics::StretchedBitmap work(640, 480, buffer, Graphics::StretchedBitmap::NoClear, Graphics::qualityFilterName(Configuration::getQualityFilter()));
+        work.start();
+        background.Blit(work);
+        Bor::DisplayCharacter * player = players[current];
+        if (player->isLoaded()){
+            player->setX(83);
+            player->setY(0);
+            player->setZ(155);
+            player->draw(&work, 0, 0);
+        }
+        work.finish();
+    }
+};
+
 Filesystem::AbsolutePath OpenborMod::selectPlayer(const string & message, const Level::LevelInfo & info, int & remap, const InputSource & source){
+    remap = 0;
     Graphics::Bitmap background(makeBitmap(Filesystem::RelativePath("data/bgs/select.gif")));
-    /* FIXME: hardcoded resolution */
-    Graphics::Bitmap work(640, 480);
-    background.Blit(work);
-    work.BlitToScreen();
-    InputMap<Select::Input> input;
-    input.set(Keyboard::Key_ESC, 0, true, Select::Quit);
-    InputManager::waitForPress(input, source, Select::Quit);
 
-    throw Exception::Base(__FILE__, __LINE__);
+    /* player1 is drawn at 83, player2 at 238 */
+    vector<Bor::DisplayCharacter*> players = loadPlayers(PlayerThreads);
+    if (players.empty()){
+        throw LoadException(__FILE__, __LINE__, "No players in data/chars");
+    }
 
-    /* show data/bgs/select.gif
-     * get all players
-     * display selected player at 83, 155
-     */
+    Filesystem::AbsolutePath chosen;
+    try{
+        PlayerSelecter select(players, background, source);
+        Util::standardLoop(select, select);
+        chosen = select.chosen();
+    } catch (...){
+        for (vector<Bor::DisplayCharacter*>::iterator it = players.begin(); it != players.end(); it++){
+            delete *it;
+        }
+        throw;
+    }
+
+    for (vector<Bor::DisplayCharacter*>::iterator it = players.begin(); it != players.end(); it++){
+        delete *it;
+    }
+
+    return chosen;
 }
 
 }
@@ -3,8 +3,17 @@
 
 #include "paintown-engine/game/mod.h"
 #include <r-tech1/file-system.h>
+#include <r-tech1/pointer.h>
+#include <r-tech1/graphics/bitmap.h>
+#include <map>
+#include <string>
+#include <vector>
 #include "pack-reader.h"
 
+namespace Bor{
+    class DisplayCharacter;
+}
+
 namespace Paintown{
 
 class OpenborMod: public Mod {
@@ -14,9 +23,26 @@ public:
     const std::string getMenu();
     virtual Filesystem::AbsolutePath selectPlayer(const std::string & message, const Level::LevelInfo & info, int & remap, const InputSource & source);
     virtual std::vector<Level::LevelInfo> getLevels();
+
+    /* While players are loading the images they need are already decoded,
+     * those calls get a copy that shares the pixels. Anything else is decoded
+     * from the pak. Only call from the main thread.
+     */
     virtual Graphics::Bitmap * createBitmap(const Filesystem::RelativePath & path);
 
+    /* Finds the player models in data/chars and loads them for the select
+     * screen. Finding the players and decoding the frames of their idle
+     * animations is spread over `threads' threads, the bitmaps are made and
+     * the players are loaded on this thread afterwards. The caller owns the
+     * characters that come back.
+     */
+    std::vector<Bor::DisplayCharacter*> loadPlayers(int threads);
+
     Bor::PackReader reader;
+
+protected:
+    /* images decoded for loadPlayers() by lower case path, empty otherwise */
+    std::map<std::string, Util::ReferenceCount<Graphics::Bitmap> > bitmaps;
 };
 
 }
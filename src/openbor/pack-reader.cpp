@@ -5,10 +5,21 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <string.h>
 #include <r-tech1/debug.h>
-#include <r-tech1/regex.h>
 #include <r-tech1/file-system.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#elif !defined(WII) && !defined(PS3) && !defined(MINPSPW) && !defined(NACL)
+#define PACK_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 using namespace std;
 
 namespace Bor{
@@ -42,8 +53,40 @@ static string sanitizePath(const string & path){
     return Path::sanitize(Path::invertSlashes(lowercase(path)));
 }
 
+PackReader::View::View():
+data(NULL),
+length(0){
+}
+
+PackReader::View::View(const char * data, uint32_t length):
+data(data),
+length(length){
+}
+
+PackReader::View::View(const Util::ReferenceCount<std::vector<char> > & copy):
+data(copy->size() > 0 ? &(*copy)[0] : NULL),
+length(copy->size()),
+copy(copy){
+}
+
+/* "txt" for "data/chars/foo/foo.txt", nothing if there is no extension */
+static string extensionOf(const string & path){
+    size_t dot = path.rfind('.');
+    size_t slash = path.rfind('/');
+    if (dot == string::npos || (slash != string::npos && dot < slash)){
+        return "";
+    }
+    return path.substr(dot + 1);
+}
+
 PackReader::PackReader(const Filesystem::AbsolutePath & filename):
-filename(filename){
+filename(filename),
+mapped(NULL),
+mappedSize(0)
+#ifdef _WIN32
+,mapping(NULL)
+#endif
+{
     ifstream stream;
     Global::debug(0) << "Reading pak file " << filename.path() << endl;
     stream.open(filename.path().c_str(), std::ios::in | std::ios::binary);
@@ -90,114 +133,215 @@ filename(filename){
     }
     stream.close();
 
-    handle.open(filename.path().c_str(), std::ios::in | std::ios::binary);
+    /* the files map is sorted so each list comes out sorted too */
+    for (map<string, File>::iterator it = files.begin(); it != files.end(); it++){
+        extensions[extensionOf(it->first)].push_back(it->first);
+    }
+
     Util::Thread::initializeLock(&readLock);
+    mapPak();
+    if (mapped == NULL){
+        Global::debug(1) << "Could not map " << filename.path() << " into memory, reading it through a stream" << endl;
+        handle.open(filename.path().c_str(), std::ios::in | std::ios::binary);
+    }
 }
 
-static string convertToRegex(const string & input){
-    ostringstream out;
-    for (unsigned int i = 0; i < input.size(); i++){
-        char current = input[i];
-        switch (current){
-            case '*' : {
-                out << ".*";
-                break;
-            }
-            case '.' : {
-                out << "\\.";
-                break;
-            }
-            default : {
-                out << current;
-                break;
+void PackReader::mapPak(){
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.path().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE){
+        return;
+    }
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && (uint64_t) size.QuadPart == (SIZE_T) size.QuadPart){
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL){
+            mapped = (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (mapped != NULL){
+                mappedSize = size.QuadPart;
+            } else {
+                CloseHandle(mapping);
+                mapping = NULL;
             }
         }
     }
-    return out.str();
-}
-
-static bool matchPart(const string & path, const string & search){
-    string regex = convertToRegex(search);
-    return Util::matchRegex(path, Util::Regex(regex));
-}
-
-/* split "foo/bar/baz" into [foo, bar, baz] */
-static vector<string> split(const string & path){
-    vector<string> out;
-    size_t begin = 0;
-    size_t last = 0;
-    begin = path.find("/");
-    // Global::debug(0) << "Splitting '" << path << "'" << endl;
-    while (begin != string::npos){
-        string split = path.substr(last, begin - last);
-        // Global::debug(0) << " Part '" << split << "'" << endl;
-        out.push_back(split);
-        last = begin + 1;
-        begin = path.find("/", last);
-    }
-    out.push_back(path.substr(last));
-    return out;
-}
-
-static bool matchPath(const string & path, const string & search){
-    vector<string> pathParts = split(path);
-    vector<string> searchParts = split(search);
-    vector<string>::iterator pathIt = pathParts.begin();
-    vector<string>::iterator searchIt = searchParts.begin();
-    while (true){
-        if (pathIt == pathParts.end() && searchIt == searchParts.end()){
-            /* Both are at the end, success! */
-            return true;
-        } else if (pathIt == pathParts.end() || searchIt == searchParts.end()){
-            /* one got to the end before the other, failure! */
-            return false;
+
+    /* the mapping keeps the file open */
+    CloseHandle(file);
+#elif defined(PACK_MMAP)
+    int file = open(filename.path().c_str(), O_RDONLY);
+    if (file == -1){
+        return;
+    }
+
+    struct stat info;
+    /* a pak bigger than the address space stays unmapped */
+    if (fstat(file, &info) == 0 && info.st_size > 0 && (uint64_t) info.st_size == (size_t) info.st_size){
+        void * memory = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+        if (memory != MAP_FAILED){
+            mapped = (const char *) memory;
+            mappedSize = info.st_size;
         }
-        if (matchPart(*pathIt, *searchIt)){
-            pathIt++;
-            searchIt++;
+    }
+
+    /* the mapping keeps the file open */
+    close(file);
+#endif
+}
+
+void PackReader::unmapPak(){
+    if (mapped == NULL){
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(mapped);
+    CloseHandle(mapping);
+    mapping = NULL;
+#elif defined(PACK_MMAP)
+    munmap((void*) mapped, mappedSize);
+#endif
+    mapped = NULL;
+    mappedSize = 0;
+}
+
+static bool startsWith(const string & what, const string & prefix){
+    return what.compare(0, prefix.size(), prefix) == 0;
+}
+
+/* Matches all of `path' against `search', a '*' in the search matches any
+ * run of characters that doesn't cross a '/'.
+ */
+static bool matchPath(const char * path, const char * search){
+    /* the last '*' seen and where in the path it started matching */
+    const char * star = NULL;
+    const char * resume = NULL;
+    while (*path != '\0'){
+        if (*search == '*'){
+            star = search;
+            search += 1;
+            resume = path;
+        } else if (*search == *path){
+            search += 1;
+            path += 1;
+        } else if (star != NULL && *resume != '/'){
+            /* let the '*' take one more character and try again */
+            resume += 1;
+            path = resume;
+            search = star + 1;
         } else {
             return false;
         }
     }
-    return false;
+
+    while (*search == '*'){
+        search += 1;
+    }
+
+    return *search == '\0';
 }
-    
-vector<string> PackReader::findPaths(const std::string & search){
+
+/* The extension every match of `search' has to have, or nothing if it could
+ * be anything.
+ */
+static string searchExtension(const string & search){
+    string extension = extensionOf(search);
+    if (extension.find('*') != string::npos){
+        return "";
+    }
+    return extension;
+}
+
+vector<string> PackReader::findPaths(const std::string & search) const {
+    string glob = lowercase(search);
+    /* every match starts with the part before the first '*' */
+    string prefix = glob.substr(0, glob.find('*'));
+    string extension = searchExtension(glob);
+
     vector<string> found;
-    for (map<string, File>::iterator it = files.begin(); it != files.end(); it++){
-        const string & path = (*it).first;
-        if (matchPath(path, search)){
-            found.push_back(path);
+    if (extension != ""){
+        map<string, vector<string> >::const_iterator paths = extensions.find(extension);
+        if (paths == extensions.end()){
+            return found;
+        }
+
+        const vector<string> & all = paths->second;
+        for (vector<string>::const_iterator it = lower_bound(all.begin(), all.end(), prefix); it != all.end() && startsWith(*it, prefix); it++){
+            if (matchPath(it->c_str(), glob.c_str())){
+                found.push_back(*it);
+            }
+        }
+    } else {
+        for (map<string, File>::const_iterator it = files.lower_bound(prefix); it != files.end() && startsWith(it->first, prefix); it++){
+            if (matchPath(it->first.c_str(), glob.c_str())){
+                found.push_back(it->first);
+            }
         }
     }
+
     return found;
 }
 
-/* read a blob of bytes */
-char * PackReader::readFile(const File & file){
+PackReader::View PackReader::getView(const File & file) const {
+    if (mapped != NULL){
+        if ((uint64_t) file.start + file.length > mappedSize){
+            ostringstream out;
+            out << "File at " << file.start << " of length " << file.length << " is past the end of " << filename.path();
+            throw PackError(__FILE__, __LINE__, out.str());
+        }
+        return View(mapped + file.start, file.length);
+    }
+
+    Util::ReferenceCount<vector<char> > copy(new vector<char>(file.length));
     Util::Thread::acquireLock(&readLock);
+    handle.clear();
     handle.seekg(file.start);
-    char * data = new char[file.length];
-    handle.read(data, file.length);
+    if (file.length > 0){
+        handle.read(&(*copy)[0], file.length);
+    }
+    bool ok = handle.good();
     Util::Thread::releaseLock(&readLock);
+
+    if (!ok){
+        ostringstream out;
+        out << "Could not read " << file.length << " bytes at " << file.start << " from " << filename.path();
+        throw PackError(__FILE__, __LINE__, out.str());
+    }
+
+    return View(copy);
+}
+
+PackReader::View PackReader::getView(const std::string & path) const {
+    return getView(getFile(path));
+}
+
+/* read a blob of bytes */
+char * PackReader::readFile(const File & file) const {
+    View view = getView(file);
+    char * data = new char[file.length];
+    if (view.getLength() > 0){
+        memcpy(data, view.getData(), view.getLength());
+    }
     return data;
 }
     
-const PackReader::File & PackReader::getFile(const std::string & path){
-    if (files.find(lowercase(path)) != files.end()){
-        return files.find(lowercase(path))->second;
+const PackReader::File & PackReader::getFile(const std::string & path) const {
+    map<string, File>::const_iterator found = files.find(lowercase(path));
+    if (found != files.end()){
+        return found->second;
     }
     ostringstream out;
     out << "No such pak file '" << path << "'";
     throw PackError(__FILE__, __LINE__, out.str());
 }
     
-uint32_t PackReader::getFileLength(const std::string & path){
+uint32_t PackReader::getFileLength(const std::string & path) const {
     const File & file = getFile(path);
     return file.length;
 }
 
 PackReader::~PackReader(){
+    unmapPak();
     handle.close();
     Util::Thread::destroyLock(&readLock);
 }
@@ -9,6 +9,7 @@
 #include <r-tech1/exceptions/exception.h>
 #include <r-tech1/file-system.h>
 #include <r-tech1/thread.h>
+#include <r-tech1/pointer.h>
 
 namespace Bor{
 
@@ -25,6 +26,11 @@ protected:
 
 /* Reads Bor/Openbor packfiles
  * TODO: extend the util/reader.h interface
+ *
+ * The pak is mapped into memory once when it is opened and the files in it
+ * are handed out as views of that memory, so any number of threads can read
+ * files at the same time without locking or copying. If the pak can't be
+ * mapped the files are read with a lock held instead.
  */
 class PackReader{
 public:
@@ -43,30 +49,81 @@ public:
         uint32_t length;
     };
 
+    /* The bytes of one file in the pak. Usually this points straight into
+     * the mapped pak, so it is only good for as long as the PackReader is
+     * around. Views are cheap to copy.
+     */
+    class View{
+    public:
+        View();
+
+        inline const char * getData() const {
+            return data;
+        }
+
+        inline uint32_t getLength() const {
+            return length;
+        }
+
+    protected:
+        friend class PackReader;
+
+        View(const char * data, uint32_t length);
+        View(const Util::ReferenceCount<std::vector<char> > & copy);
+
+        const char * data;
+        uint32_t length;
+        /* only set if the pak isn't mapped, holds a copy of the file */
+        Util::ReferenceCount<std::vector<char> > copy;
+    };
+
     PackReader(const Filesystem::AbsolutePath & path);
 
-    char * readFile(const File & file);
+    /* The file in the pak without copying it */
+    View getView(const File & file) const;
+    View getView(const std::string & path) const;
+
+    /* A copy of the file that the caller has to delete[] */
+    char * readFile(const File & file) const;
 
-    std::vector<std::string> findPaths(const std::string & search);
+    /* Paths of the files that match a glob. A '*' matches any run of
+     * characters other than '/', everything else has to match exactly.
+     * The paths come back sorted.
+     */
+    std::vector<std::string> findPaths(const std::string & search) const;
 
     const std::map<std::string, File> & getFiles() const {
         return files;
     }
 
-    const File & getFile(const std::string & path);
-    uint32_t getFileLength(const std::string & path);
+    const File & getFile(const std::string & path) const;
+    uint32_t getFileLength(const std::string & path) const;
 
     virtual ~PackReader();
 
 private:
+    void mapPak();
+    void unmapPak();
+
     /* Little endian magic number */
     static const uint32_t MAGIC = 0x4B434150;
     Filesystem::AbsolutePath filename;
     std::map<std::string, File> files;
-    std::ifstream handle;
 
-    /* locked when reading data */
-    Util::Thread::Lock readLock;
+    /* the sorted paths of every file with a given extension, "txt", "gif" */
+    std::map<std::string, std::vector<std::string> > extensions;
+
+    /* the whole pak if it could be mapped, otherwise NULL */
+    const char * mapped;
+    uint64_t mappedSize;
+#ifdef _WIN32
+    void * mapping;
+#endif
+
+    /* only used if the pak isn't mapped */
+    mutable std::ifstream handle;
+    /* locked when reading data through handle */
+    mutable Util::Thread::Lock readLock;
 };
 
 }
@@ -8,12 +8,14 @@
 #include <r-tech1/funcs.h>
 #include <r-tech1/sound/sound.h>
 #include <r-tech1/token.h>
+#include <r-tech1/token_exception.h>
 #include "../level/scene.h"
 #include <math.h>
 #include "night_atmosphere.h"
 #include "rain_atmosphere.h"
 #include "snow_atmosphere.h"
 #include "../object/object.h"
+#include "../game/blend-lock.h"
 #include <vector>
 
 using namespace std;
@@ -23,6 +25,9 @@ Atmosphere::Atmosphere(){
 	
 Atmosphere::~Atmosphere(){
 }
+
+void Atmosphere::startDraw(int x){
+}
 	
 Atmosphere * Atmosphere::createAtmosphere( const std::string & name ){
     if ( name == "rain" ){
@@ -58,12 +63,20 @@ Atmosphere(){
     fog->fill(Graphics::MaskColor());
     fog->circleFill( 25, 25, 20, Graphics::makeColor( 0xbb, 0xbb, 0xcc ) );
 
+    const int heights[] = {30, 40, 40, 50, 60};
+    const int rows = sizeof(heights) / sizeof(int);
+    int columns = 0;
+    for ( int i = -20; i < screenX(); i += 20 ){
+        columns += 1;
+    }
+    fogs.reserve(columns * rows);
+
     for ( int i = -20; i < screenX(); i += 20 ){
-        fogs.push_back( new Fog( i + Util::rnd( 9 ) - 4, screenY() - 30, Util::rnd( 360 ) ) );
-        fogs.push_back( new Fog( i + Util::rnd( 9 ) - 4, screenY() - 40, Util::rnd( 360 ) ) );
-        fogs.push_back( new Fog( i + Util::rnd( 9 ) - 4, screenY() - 40, Util::rnd( 360 ) ) );
-        fogs.push_back( new Fog( i + Util::rnd( 9 ) - 4, screenY() - 50, Util::rnd( 360 ) ) );
-        fogs.push_back( new Fog( i + Util::rnd( 9 ) - 4, screenY() - 60, Util::rnd( 360 ) ) );
+        for (int row = 0; row < rows; row++){
+            int x = i + Util::rnd( 9 ) - 4;
+            int index = fogs.add(x, screenY() - heights[row], 0, 0);
+            fogs.angle[index] = Util::rnd( 360 );
+        }
         /*
            for ( int q = 0; q < 3; q++ ){
            fogs.push_back( new Fog( i + Util::rnd( 9 ) - 4, screenY() - Util::rnd( 30 ) - 40, Util::rnd( 360 ) ) );
@@ -74,9 +87,6 @@ Atmosphere(){
 
 FogAtmosphere::~FogAtmosphere(){
     delete fog;
-    for ( vector< Fog * >::iterator it = fogs.begin(); it != fogs.end(); it++ ){
-        delete *it;
-    }
 }
 
 void FogAtmosphere::drawForeground(Graphics::Bitmap * work, int x){
@@ -89,11 +99,11 @@ void FogAtmosphere::drawFront(Graphics::Bitmap * work, int x){
 }
 
 void FogAtmosphere::drawScreen(Graphics::Bitmap * work, int x){
+    BlendLock blend;
     Graphics::Bitmap::transBlender( 0, 0, 0, 64 );
-    for ( vector< Fog * >::iterator it = fogs.begin(); it != fogs.end(); it++ ){
-        Fog * f = *it;
-        int y = (int)(f->y + sin( f->ang * 3.14159 / 180.0 ) * 2);
-        fog->translucent().draw( f->x, y, *work );
+    for (int i = 0; i < fogs.size(); i++){
+        int y = (int)(fogs.y[i] + sin( fogs.angle[i] * 3.14159 / 180.0 ) * 2);
+        fog->translucent().draw( (int) fogs.x[i], y, *work );
     }
     /*
        screenX();
@@ -104,9 +114,8 @@ void FogAtmosphere::drawScreen(Graphics::Bitmap * work, int x){
 }
 
 void FogAtmosphere::act(const Scene & level, const vector<Paintown::Object*> * objects){
-    for ( vector< Fog * >::iterator it = fogs.begin(); it != fogs.end(); it++ ){
-        Fog * f = *it;
-        f->ang += 1;
+    for (int i = 0; i < fogs.size(); i++){
+        fogs.angle[i] += 1;
     }
 }
 
@@ -128,7 +137,8 @@ Atmosphere(),
 darkness(128),
 thunder(NULL),
 lightning(false),
-thunderPause(-1){
+thunderPause(-1),
+lightsChanged(0){
 
     lamp = new Graphics::Bitmap(Storage::instance().find(Filesystem::RelativePath("sprites/lamp.png")).path());
     thunder = Resource::getSound(Filesystem::RelativePath("sounds/thunder.wav"));
@@ -145,71 +155,72 @@ NightAtmosphere::~NightAtmosphere(){
     delete lamp;
 }
 
-/* lights should not overlap! the effect completely messes up if they do
+/* the light buffer is this many times smaller than the screen each way */
+static const int lightScale = 4;
+
+/* each cone is made of this many triangles, each narrower than the last, so
+ * it is brightest in the middle and fades out at the edges
  */
-void NightAtmosphere::drawLight(Graphics::Bitmap * original, Graphics::Bitmap * work, const int x, const int y, const int lower_width, const int upper_width, const Graphics::Color black, const int dark_alpha, const Graphics::Color light, const int light_alpha, bool draw_light){
-    int center_x = x;
-    // int center_x = screenX();
-    
-    /*
-    const int black = Graphics::Bitmap::makeColor(0,0,0);
-    const int light = Graphics::Bitmap::makeColor(32,32,0);
-    const int light_alpha = 0;
-    const int dark_alpha = 128;
-    */
+static const int lightSteps = 4;
 
-    int where_x = center_x - lower_width;
-    int total = lower_width * 2;
-    if (where_x < 0){
-        total += where_x;
-        where_x = 0;
-    }
-    if (total <= 0){
-        return;
+/* Adds up the light of every lamp on top of the ambient light. Lights can
+ * overlap, where they do the light is just brighter.
+ */
+void NightAtmosphere::drawLights(const Graphics::Bitmap & buffer, int x, int ambient){
+    buffer.fill(Graphics::makeColor(ambient, ambient, ambient));
+
+    /* the middle of a cone is as bright as it would be in daylight */
+    int lift = (255 - ambient) / lightSteps;
+
+    BlendLock blend;
+    Graphics::Bitmap::addBlender(0, 0, 0, 255);
+    for (vector<Light*>::iterator it = lights.begin(); it != lights.end(); it++){
+        Light * light = *it;
+        int middle = (light->x - x) / lightScale;
+        int top = light->y / lightScale;
+        int bottom = buffer.getHeight();
+        int width = light->lower_width / lightScale;
+        if (middle + width < 0 || middle - width >= buffer.getWidth()){
+            continue;
+        }
+
+        Graphics::Color color = Graphics::makeColor(lift + Graphics::getRed(light->color) / lightSteps,
+                                                    lift + Graphics::getGreen(light->color) / lightSteps,
+                                                    lift + Graphics::getBlue(light->color) / lightSteps);
+        for (int step = 0; step < lightSteps; step++){
+            int spread = width * (lightSteps - step) / lightSteps;
+            buffer.translucent().triangle(middle, top, middle - spread, bottom, middle + spread, bottom, color);
+        }
     }
+}
 
-    int left = total - lower_width * 2;
-    int middle = total - lower_width;
-    int right = total;
-    if (center_x - lower_width > 0){
-        left = 0;
-        middle = lower_width;
-        right = lower_width * 2;
+const Graphics::Bitmap & NightAtmosphere::updateLightMap(const Graphics::Bitmap & work, int x, int ambient){
+    LightMap * light = NULL;
+    {
+        /* std::map doesn't move its elements, so the pointer stays good when
+         * another view adds its light map. light maps are never removed, there
+         * are only ever a few views.
+         */
+        Util::Thread::ScopedLock scoped(lightMapLock);
+        light = &lightMaps[&work];
     }
 
-    // Bitmap save(*original, where_x, 0, total, work->getWidth());
-    // Bitmap save(*original, where_x, 0, total, original->getHeight());
-    Graphics::Bitmap save(*original, where_x, 0, total, original->getHeight());
-    
-    int top = y;
+    if (light->map == NULL || light->map->getWidth() != work.getWidth() || light->map->getHeight() != work.getHeight()){
+        light->buffer = new Graphics::Bitmap((work.getWidth() + lightScale - 1) / lightScale, (work.getHeight() + lightScale - 1) / lightScale);
+        light->map = new Graphics::Bitmap(work.getWidth(), work.getHeight());
+        light->ambient = -1;
+    }
 
-    if (draw_light){
-        Graphics::Bitmap::transBlender(0, 0, 0, dark_alpha);
-        // Graphics::Bitmap::drawingMode(Graphics::Bitmap::MODE_TRANS);
-        /*
-        int top = -save.getHeight() / 3;
-        top = 30;
-        */
-        int lamp_height = save.getHeight() - top;
-
-        /* y = tan(theta) * x */
-        int lamp_top = (int)(((double)lower_width * 2.0 / (double)lamp_height) * (double)upper_width);
-
-        // int top = 0;
-        save.translucent().triangle(left, top, middle, top, left, save.getHeight(), black);
-        save.translucent().triangle(right, top, middle, top, right, save.getHeight(), black);
-        int nwidth = (int)((double) lamp_top / ((double) lamp_height / (double) lower_width));
-        save.translucent().triangle(middle, top, middle - nwidth, top + lamp_top, middle + nwidth, top + lamp_top, black);
-
-        save.translucent().rectangleFill(0, 0, right, top, black);
-        // Graphics::Bitmap::drawingMode(Graphics::Bitmap::MODE_SOLID);
-        int xwidth = (int)((double) lamp_height / ((double)(save.getHeight() - top) / (double) lower_width));
-        save.light(middle, top, xwidth, lamp_height, lamp_top, light_alpha, dark_alpha, light, black);
-        lamp->draw(middle - 8, top, save);
-    } else {
-        lamp->draw(middle - 8, top, save);
+    if (x == light->x && ambient == light->ambient && lightsChanged == light->lights){
+        return *light->map;
     }
-    save.draw(where_x, 0, *work);
+
+    drawLights(*light->buffer, x, ambient);
+    light->buffer->Stretch(*light->map);
+    light->x = x;
+    light->ambient = ambient;
+    light->lights = lightsChanged;
+    return *light->map;
 }
 
 Graphics::Color NightAtmosphere::getSkyColor() const {
@@ -229,6 +240,7 @@ int NightAtmosphere::getSkyDarkness() const {
 }
 
 void NightAtmosphere::drawFront(Graphics::Bitmap * work, int x){
+    BlendLock blend;
     Graphics::Bitmap::transBlender(0, 0, 0, getSkyDarkness());
     work->applyTrans(getSkyColor());
 }
@@ -241,33 +253,31 @@ void NightAtmosphere::drawScreen(Graphics::Bitmap * work, int x){
 
 void NightAtmosphere::addLight(const int x, const int y, const int lower_width, const int upper_width, const Graphics::Color color, const int alpha){
     lights.push_back(new Light(x, y, lower_width, upper_width, color, alpha));
+    lightsChanged += 1;
 }
 
 void NightAtmosphere::drawForeground(Graphics::Bitmap * work, int x){
-    const Graphics::Color sky = getSkyColor();
-    Graphics::Bitmap::transBlender(0, 0, 0, getSkyDarkness());
-    work->applyTrans(sky);
-
-    /* FIXME: lights are broken in sdl, valgrind spits out some error:
-     * == Invalid read of size 2
-     * ==6497==    at 0x836E601: SPG_RectFilledBlend (SPG_primitives.c:2543)
-     * ==6497==    by 0x8369D56: spg_linehblend (SPG_primitives.c:907)
-     * ==6497==    by 0x8360DB4: SPG_TrigonFilledBlend (SPG_polygon.c:786)
-     * ==6497==    by 0x8343265: Bitmap::triangle(int, int, int, int, int, int, int) const (bitmap.cpp:884)
-     * ==6497==    by 0x815134B: NightAtmosphere::drawLight(Bitmap*, Bitmap*, int, int, int, int, int, int, int, int, bool) (night_atmosphere.cpp:96)
-     *
-    Bitmap save = Bitmap::temporaryBitmap(work->getWidth(), work->getHeight());
-    work->Blit(save);
-    Bitmap::transBlender(0, 0, 0, getSkyDarkness());
-    work->applyTrans(sky);
+    if (lightning){
+        /* the flash brightens the whole screen, which multiplying by the
+         * light map can't do
+         */
+        BlendLock blend;
+        Graphics::Bitmap::transBlender(0, 0, 0, getSkyDarkness());
+        work->applyTrans(getSkyColor());
+    } else {
+        /* a black sky blended in with alpha 255 - darkness leaves
+         * darkness / 255 of each color
+         */
+        const Graphics::Bitmap & lightMap = updateLightMap(*work, x, darkness);
+        BlendLock blend;
+        Graphics::Bitmap::multiplyBlender(0, 0, 0, 255);
+        lightMap.translucent().draw(0, 0, *work);
+    }
 
     for (vector<Light*>::iterator it = lights.begin(); it != lights.end(); it++){
         Light * light = *it;
-        int my_x = light->x - x;
-        int my_y = light->y;
-        drawLight(&save, work, my_x, my_y, light->lower_width, light->upper_width, sky, darkness, light->color, light->alpha, ! lightning);
+        lamp->draw(light->x - x - lamp->getWidth() / 2, light->y, *work);
     }
-    */
 }
 
 void NightAtmosphere::act(const Scene & level, const vector<Paintown::Object*> * objects){
@@ -319,13 +329,13 @@ playing(false){
 
     rain_sound = Sound(Storage::instance().find(Filesystem::RelativePath("sounds/rain.wav")).path());
 
-    Graphics::Color colors[ 2 ];
-    colors[0] = Graphics::makeColor( 0x22, 0x66, 0x66 );
-    colors[1] = Graphics::makeColor( 0x11, 0x44, 0x77 );
-    for (int i = 0; i < 100; i++){
-        Drop * d = new Drop(Util::rnd(screenX() * 2) - screenX() / 2, Util::rnd( screenY() ), Util::rnd(4) + 3, colors[Util::rnd(2)]);
-        rain_drops.push_back(Util::ReferenceCount<Drop>(d));
-    }
+    dropColors[0] = Graphics::makeColor( 0x22, 0x66, 0x66 );
+    dropColors[1] = Graphics::makeColor( 0x11, 0x44, 0x77 );
+    setDrops(100);
+
+    /* act() keeps at most this many around */
+    puddles.reserve(20);
+    objectPuddles.reserve(5);
 
     try{
         const char * files[] = {"sprites/rain-drop/drop1.png",
@@ -343,13 +353,40 @@ playing(false){
 RainAtmosphere::~RainAtmosphere(){
 }
 
+void RainAtmosphere::addDrop(){
+    int x = Util::rnd(screenX() * 2) - screenX() / 2;
+    int y = Util::rnd( screenY() );
+    int length = Util::rnd(4) + 3;
+    Graphics::Color color = dropColors[Util::rnd(2)];
+    int drop = rain_drops.add(x, y, 3, 7);
+    if (drop != -1){
+        rain_drops.length[drop] = length;
+        rain_drops.color[drop] = color;
+    }
+}
+
+void RainAtmosphere::setDrops(int drops){
+    if (drops < 0){
+        drops = 0;
+    }
+
+    rain_drops.reserve(drops);
+    while (rain_drops.size() > drops){
+        rain_drops.remove(rain_drops.size() - 1);
+    }
+    while (rain_drops.size() < drops){
+        addDrop();
+    }
+}
+
 void RainAtmosphere::drawBackground(Graphics::Bitmap * work, int x){
     // const Graphics::Color bluish = Graphics::makeColor(106, 184, 225);
+    BlendLock blend;
     Graphics::Bitmap::transBlender(0, 0, 0, 64);
-    for (vector<Util::ReferenceCount<Puddle> >::iterator it = puddles.begin(); it != puddles.end(); it++){
-        Util::ReferenceCount<Puddle> puddle = *it;
+    for (vector<Puddle>::iterator it = puddles.begin(); it != puddles.end(); it++){
+        const Puddle * puddle = &*it;
         if (puddle->x == -1000){
-            puddle->x = x + Util::rnd(screenX() + 30) - 15;
+            continue;
         }
         // work->circle(puddle->x, puddle->y, (int)puddle->current, bluish);
         int rx = (int) puddle->current;
@@ -365,6 +402,16 @@ void RainAtmosphere::drawBackground(Graphics::Bitmap * work, int x){
     }
 }
 
+/* new puddles go somewhere on the main view */
+void RainAtmosphere::startDraw(int x){
+    for (vector<Puddle>::iterator it = puddles.begin(); it != puddles.end(); it++){
+        Puddle * puddle = &*it;
+        if (puddle->x == -1000){
+            puddle->x = x + Util::rnd(screenX() + 30) - 15;
+        }
+    }
+}
+
 void RainAtmosphere::drawForeground(Graphics::Bitmap * work, int x){
 }
 
@@ -372,12 +419,23 @@ void RainAtmosphere::drawFront(Graphics::Bitmap * work, int x){
 }
 
 void RainAtmosphere::interpret(const Token * message){
+    const Token * drops = message->findToken("message/rain/drops");
+    if (drops != NULL){
+        try{
+            int count;
+            drops->view() >> count;
+            setDrops(count);
+        } catch (const TokenException & e){
+            Global::debug(0) << "Could not set the number of rain drops: " << e.getTrace() << endl;
+        }
+    }
 }
 
 void RainAtmosphere::drawScreen(Graphics::Bitmap * work, int x){
+    BlendLock blend;
     Graphics::Bitmap::transBlender(0, 0, 0, 64);
-    for (vector<Util::ReferenceCount<Puddle> >::iterator it = objectPuddles.begin(); it != objectPuddles.end(); it++){
-        Util::ReferenceCount<Puddle> puddle = *it;
+    for (vector<Puddle>::iterator it = objectPuddles.begin(); it != objectPuddles.end(); it++){
+        const Puddle * puddle = &*it;
         int rx = (int) puddle->current;
         int ry = (int)(puddle->current * 0.8);
         // work->translucent().ellipse(puddle->x - x, puddle->y, rx, ry < 1 ? 1 : ry, bluish);
@@ -390,10 +448,28 @@ void RainAtmosphere::drawScreen(Graphics::Bitmap * work, int x){
         }
     }
 
-    for (vector<Util::ReferenceCount<Drop> >::iterator it = rain_drops.begin(); it != rain_drops.end(); it++){
-        Util::ReferenceCount<Drop> d = *it;
-        work->line(d->x, d->y, d->x + d->length * 2 / 3, d->y + d->length, d->color);
+    ParticleCanvas canvas(*work);
+    for (int i = 0; i < rain_drops.size(); i++){
+        int dropX = (int) rain_drops.x[i];
+        int dropY = (int) rain_drops.y[i];
+        int length = rain_drops.length[i];
+        canvas.line(dropX, dropY, dropX + length * 2 / 3, dropY + length, rain_drops.color[i]);
+    }
+}
+
+/* make the puddles bigger and get rid of the ones that are done. the
+ * puddles that are left stay in the same order.
+ */
+static void growPuddles(vector<Puddle> & puddles, unsigned int maximum){
+    unsigned int keep = 0;
+    for (unsigned int i = 0; i < puddles.size(); i++){
+        puddles[i].size += 0.3;
+        if (puddles[i].size < maximum){
+            puddles[keep] = puddles[i];
+            keep += 1;
+        }
     }
+    puddles.resize(keep, Puddle(0, 0, 0));
 }
 
 void RainAtmosphere::act(const Scene & level, const vector<Paintown::Object*> * objects){
@@ -405,25 +481,8 @@ void RainAtmosphere::act(const Scene & level, const vector<Paintown::Object*> *
         rain_sound.setVolume(1);
     }
 
-    for (vector<Util::ReferenceCount<Puddle> >::iterator it = puddles.begin(); it != puddles.end(); ){
-        Util::ReferenceCount<Puddle> puddle = *it;
-        puddle->size += 0.3;
-        if (puddle->size >= splashes.size()){
-            it = puddles.erase(it);
-        } else {
-            it++;
-        }
-    }
-
-    for (vector<Util::ReferenceCount<Puddle> >::iterator it = objectPuddles.begin(); it != objectPuddles.end(); ){
-        Util::ReferenceCount<Puddle> puddle = *it;
-        puddle->size += 0.3;
-        if (puddle->size >= splashes.size()){
-            it = objectPuddles.erase(it);
-        } else {
-            it++;
-        }
-    }
+    growPuddles(puddles, splashes.size());
+    growPuddles(objectPuddles, splashes.size());
 
     /* create droplets on characters */
     if (objects != NULL && objects->size() > 0){
@@ -433,7 +492,7 @@ void RainAtmosphere::act(const Scene & level, const vector<Paintown::Object*> *
             int y = who->getRY() - Util::rnd(who->getHeight());
             if (who->touchPoint(x, y)){
                 int size = Util::rnd(4) + 2;
-                objectPuddles.push_back(Util::ReferenceCount<Puddle>(new Puddle(x, y, 0)));
+                objectPuddles.push_back(Puddle(x, y, 0));
             }
         }
     }
@@ -445,68 +504,89 @@ void RainAtmosphere::act(const Scene & level, const vector<Paintown::Object*> *
         /* supreme hack! set x to nothing and later on in the draw routine
          * update x
          */
-        puddles.push_back(Util::ReferenceCount<Puddle>(new Puddle(-1000, y, 0)));
+        puddles.push_back(Puddle(-1000, y, 0));
     }
 
-    for (vector<Util::ReferenceCount<Drop> >::iterator it = rain_drops.begin(); it != rain_drops.end(); it++){
-        Util::ReferenceCount<Drop> d = *it;
-        d->y += 7;
-        d->x += 3;
-        if (d->y > screenY()){
-            d->y = -Util::rnd(100) - 20;
+    rain_drops.move();
+    for (int i = 0; i < rain_drops.size(); i++){
+        if (rain_drops.y[i] > screenY()){
+            rain_drops.y[i] = -Util::rnd(100) - 20;
         }
-        if (d->x > screenX()){
-            d->x -= screenX();
+        if (rain_drops.x[i] > screenX()){
+            rain_drops.x[i] -= screenX();
         }
     }
 }
 
 SnowAtmosphere::SnowAtmosphere():
 Atmosphere(){
-    for ( int i = 0; i < 150; i++ ){
-        Flake * f = new Flake(Util::rnd(screenX() * 2 ) - screenX() / 2, Util::rnd( screenY() ), FlakeType(Util::rnd(2)), Util::rnd(360));
-        flakes.push_back(f);
-    }
+    setFlakes(150);
 }
 
 SnowAtmosphere::~SnowAtmosphere(){
-    for ( vector< Flake * >::iterator it = flakes.begin(); it != flakes.end(); it++ ){
-        delete *it;
+}
+
+void SnowAtmosphere::addFlake(){
+    int x = Util::rnd(screenX() * 2 ) - screenX() / 2;
+    int y = Util::rnd( screenY() );
+    FlakeType type = FlakeType(Util::rnd(2));
+    int angle = Util::rnd(360);
+    /* flakes fall at a constant speed, the sideways speed comes from the
+     * direction
+     */
+    int flake = flakes.add(x, y, 0, 0.40);
+    if (flake != -1){
+        flakes.kind[flake] = type;
+        flakes.angle[flake] = angle;
     }
 }
 
-static void drawFlakeSmall(Flake * flake, Graphics::Bitmap * work){
-    int c = (int)(200 + 3 * log((double)(flake->y < 1 ? 1 : 2 * flake->y)));
+void SnowAtmosphere::setFlakes(int count){
+    if (count < 0){
+        count = 0;
+    }
+
+    flakes.reserve(count);
+    while (flakes.size() > count){
+        flakes.remove(flakes.size() - 1);
+    }
+    while (flakes.size() < count){
+        addFlake();
+    }
+}
+
+static void drawFlakeSmall(int x, int y, ParticleCanvas & work){
+    int c = (int)(200 + 3 * log((double)(y < 1 ? 1 : 2 * y)));
     if (c > 255){
         c = 255;
     }
     Graphics::Color color = Graphics::makeColor(c, c, c);
-    work->putPixel(flake->x, flake->y, color);
+    work.pixel(x, y, color);
 }
 
-static void drawFlake0( Flake * f, Graphics::Bitmap * work ){
-    int c = (int)(200 + 3 * log((double)(f->y < 1 ? 1 : 2 * f->y)));
+static void drawFlake0(int x, int y, int angle, ParticleCanvas & work){
+    int c = (int)(200 + 3 * log((double)(y < 1 ? 1 : 2 * y)));
     if (c > 255){
         c = 255;
     }
     Graphics::Color color = Graphics::makeColor(c, c, c);
     // work->circleFill( f->x, f->y, 1, color );
     double pi = 3.141592526;
-    double rads = f->angle * pi / 180;
+    double rads = angle * pi / 180;
     double rads2 = rads + pi / 2.0;
     double length = 1.5;
 
-    int x1 = (int)(f->x - length * cos(rads));
-    int y1 = (int)(f->y + length * sin(rads));
-    int x2 = (int)(f->x + length * cos(rads));
-    int y2 = (int)(f->y - length * sin(rads));
-    work->line(x1, y1, x2, y2, color);
+    int x1 = (int)(x - length * cos(rads));
+    int y1 = (int)(y + length * sin(rads));
+    int x2 = (int)(x + length * cos(rads));
+    int y2 = (int)(y - length * sin(rads));
+    work.line(x1, y1, x2, y2, color);
 
-    x1 = (int)(f->x - length * cos(rads2));
-    y1 = (int)(f->y + length * sin(rads2));
-    x2 = (int)(f->x + length * cos(rads2));
-    y2 = (int)(f->y - length * sin(rads2));
-    work->line(x1, y1, x2, y2, color);
+    x1 = (int)(x - length * cos(rads2));
+    y1 = (int)(y + length * sin(rads2));
+    x2 = (int)(x + length * cos(rads2));
+    y2 = (int)(y - length * sin(rads2));
+    work.line(x1, y1, x2, y2, color);
 
     /*
        work->line( f->x - 1, f->y - 1, f->x + 1, f->y + 1, color );
@@ -524,15 +604,17 @@ void SnowAtmosphere::drawFront(Graphics::Bitmap * work, int x){
 }
 
 void SnowAtmosphere::drawScreen(Graphics::Bitmap * work, int x){
-    for ( vector< Flake * >::iterator it = flakes.begin(); it != flakes.end(); it++ ){
-        Flake * f = *it;
-        switch (f->type){
+    ParticleCanvas canvas(*work);
+    for (int i = 0; i < flakes.size(); i++){
+        int x = (int) flakes.x[i];
+        int y = (int) flakes.y[i];
+        switch (flakes.kind[i]){
             case Small: {
-                drawFlakeSmall(f, work);
+                drawFlakeSmall(x, y, canvas);
                 break;
             }
             case Medium: {
-                drawFlake0(f, work);
+                drawFlake0(x, y, flakes.angle[i], canvas);
                 break;
             }
         }
@@ -540,37 +622,46 @@ void SnowAtmosphere::drawScreen(Graphics::Bitmap * work, int x){
 }
 
 void SnowAtmosphere::act(const Scene & level, const vector<Paintown::Object*> * objects){
-    for ( vector< Flake * >::iterator it = flakes.begin(); it != flakes.end(); it++ ){
-        Flake * f = *it;
-        f->dy += 0.40;
-        f->y = (int) f->dy;
-        f->dx += (double)f->dir / 4.3;
-        f->x = (int) f->dx;
-        f->dir += Util::rnd( 2 ) * 2 - 1;
-        f->angle = (f->angle + f->spin + 360) % 360;
-        f->spin += Util::rnd(11) - 5;
-        if ( f->dir > 3 ){
-            f->dir = 3;
+    flakes.move();
+
+    /* the rest needs random numbers for each flake so it can't be done
+     * in bulk
+     */
+    for (int i = 0; i < flakes.size(); i++){
+        int & dir = flakes.direction[i];
+        dir += Util::rnd( 2 ) * 2 - 1;
+        flakes.angle[i] = (flakes.angle[i] + flakes.spin[i] + 360) % 360;
+        flakes.spin[i] += Util::rnd(11) - 5;
+        if ( dir > 3 ){
+            dir = 3;
         }
-        if ( f->dir < -3 ){
-            f->dir = -3;
+        if ( dir < -3 ){
+            dir = -3;
         }
-        if ( f->y >= screenY() ){
-            f->y = - Util::rnd( 30 );
-            f->dy = f->y;
-            f->x = Util::rnd(screenX());
-            f->dx = f->x;
+        flakes.vx[i] = (double) dir / 4.3;
+
+        if ( (int) flakes.y[i] >= screenY() ){
+            flakes.y[i] = - Util::rnd( 30 );
+            flakes.x[i] = Util::rnd(screenX());
         }
-        if ( f->x < -50 ){
-            f->x = -50;
-            f->dx = f->x;
+        if ( (int) flakes.x[i] < -50 ){
+            flakes.x[i] = -50;
         }
-        if ( f->x > screenX() + 50 ){
-            f->x = screenX() + 50;
-            f->dx = f->x;
+        if ( (int) flakes.x[i] > screenX() + 50 ){
+            flakes.x[i] = screenX() + 50;
         }
     }
 }
 
 void SnowAtmosphere::interpret(const Token * message){
+    const Token * count = message->findToken("message/snow/flakes");
+    if (count != NULL){
+        try{
+            int total;
+            count->view() >> total;
+            setFlakes(total);
+        } catch (const TokenException & e){
+            Global::debug(0) << "Could not set the number of snow flakes: " << e.getTrace() << endl;
+        }
+    }
 }
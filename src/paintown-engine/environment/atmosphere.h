@@ -38,6 +38,13 @@ public:
 
     virtual void act(const Scene & level, const std::vector<Paintown::Object*>*) = 0;
 
+    /* called once a frame before any views are drawn, from the thread that
+     * draws the main view. x is where the main view's camera is. The draw
+     * methods can be called from other threads, so anything that has to
+     * change before drawing is done here.
+     */
+    virtual void startDraw(int x);
+
     /* interpret a trigger's message */
     virtual void interpret(const Token * message) = 0;
 
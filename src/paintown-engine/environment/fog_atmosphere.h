@@ -6,16 +6,11 @@ class Bitmap;
 }
 
 #include "atmosphere.h"
+#include "particles.h"
 #include <vector>
 
 class Token;
 
-struct Fog{
-	Fog( int x, int y, unsigned int ang ):x(x),y(y),ang(ang){}
-	int x, y;
-	unsigned int ang;
-};
-
 class FogAtmosphere: public Atmosphere {
 public:
 
@@ -31,7 +26,8 @@ public:
 
 protected:
     Graphics::Bitmap * fog;
-	std::vector< Fog * > fogs;
+    /* angle is used */
+    Particles fogs;
 };
 
 #endif
@@ -7,8 +7,11 @@ class Bitmap;
 
 #include <r-tech1/token_exception.h>
 #include <r-tech1/graphics/color.h>
+#include <r-tech1/pointer.h>
+#include <r-tech1/thread.h>
 #include "atmosphere.h"
 #include <vector>
+#include <map>
 
 class Token;
 class Sound;
@@ -41,17 +44,50 @@ public:
 
 protected:
 
-    void drawLight(Graphics::Bitmap * original, Graphics::Bitmap * work, const int x, const int y, const int lower_width, const int upper_width, const Graphics::Color black, const int black_alpha, const Graphics::Color light, const int light_alpha, bool draw_light);
+    /* the light map of one view */
+    struct LightMap{
+        LightMap():
+        x(0),
+        ambient(-1),
+        lights(0){
+        }
+
+        Util::ReferenceCount<Graphics::Bitmap> buffer;
+        Util::ReferenceCount<Graphics::Bitmap> map;
+        int x;
+        int ambient;
+        unsigned int lights;
+    };
+
+    void drawLights(const Graphics::Bitmap & buffer, int x, int ambient);
+    const Graphics::Bitmap & updateLightMap(const Graphics::Bitmap & work, int x, int ambient);
     void processLight(const Token * token);
     Graphics::Color getSkyColor() const;
     int getSkyDarkness() const;
 
     std::vector<Light*> lights;
+    /* goes up by one every time a light is added */
+    unsigned int lightsChanged;
 
     /* alpha between 0-255, 255 is completely dark */
     int darkness;
 
     Graphics::Bitmap * lamp;
+
+    /* How bright each part of the screen is. The lights are added up in
+     * a buffer that is a fraction of the size of the screen, and then
+     * stretched to the size of the screen into the light map. The screen is
+     * multiplied by the light map once a frame, so the cost doesn't depend on
+     * how many lights or objects there are. Only rebuilt when the camera moves,
+     * the darkness changes or a light is added.
+     *
+     * Each view (the main view and every mini map) draws into its own
+     * bitmap and has its own camera, so they each keep a light map, keyed by
+     * the bitmap they draw into. Views can be drawn on separate threads, the
+     * lock is only held to find the light map of a view.
+     */
+    std::map<const Graphics::Bitmap*, LightMap> lightMaps;
+    Util::Thread::LockObject lightMapLock;
     Util::ReferenceCount<Sound> thunder;
     bool lightning;
     int lightningFade;
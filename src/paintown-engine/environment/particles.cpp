@@ -0,0 +1,127 @@
+#include "particles.h"
+#include <r-tech1/graphics/bitmap.h>
+#include <stdlib.h>
+
+using namespace std;
+
+Particles::Particles():
+count(0){
+}
+
+void Particles::reserve(int capacity){
+    if (capacity <= this->capacity()){
+        return;
+    }
+
+    x.resize(capacity);
+    y.resize(capacity);
+    vx.resize(capacity);
+    vy.resize(capacity);
+    angle.resize(capacity);
+    spin.resize(capacity);
+    direction.resize(capacity);
+    length.resize(capacity);
+    kind.resize(capacity);
+    color.resize(capacity);
+}
+
+int Particles::add(double x, double y, double vx, double vy){
+    if (count >= capacity()){
+        return -1;
+    }
+
+    int index = count;
+    count += 1;
+
+    this->x[index] = x;
+    this->y[index] = y;
+    this->vx[index] = vx;
+    this->vy[index] = vy;
+    angle[index] = 0;
+    spin[index] = 0;
+    direction[index] = 0;
+    length[index] = 0;
+    kind[index] = 0;
+    color[index] = Graphics::Color();
+
+    return index;
+}
+
+void Particles::remove(int index){
+    if (index < 0 || index >= count){
+        return;
+    }
+
+    int last = count - 1;
+    x[index] = x[last];
+    y[index] = y[last];
+    vx[index] = vx[last];
+    vy[index] = vy[last];
+    angle[index] = angle[last];
+    spin[index] = spin[last];
+    direction[index] = direction[last];
+    length[index] = length[last];
+    kind[index] = kind[last];
+    color[index] = color[last];
+    count = last;
+}
+
+void Particles::clear(){
+    count = 0;
+}
+
+void Particles::move(){
+    if (count == 0){
+        return;
+    }
+
+    /* plain arrays and no calls in the loop body so it vectorizes */
+    double * px = &x[0];
+    double * py = &y[0];
+    const double * pvx = &vx[0];
+    const double * pvy = &vy[0];
+    for (int i = 0; i < count; i++){
+        px[i] += pvx[i];
+        py[i] += pvy[i];
+    }
+}
+
+ParticleCanvas::ParticleCanvas(const Graphics::Bitmap & work):
+work(work),
+width(work.getWidth()),
+height(work.getHeight()){
+    work.lock();
+}
+
+ParticleCanvas::~ParticleCanvas(){
+    work.unlock();
+}
+
+void ParticleCanvas::pixel(int x, int y, Graphics::Color color){
+    if (x >= 0 && x < width && y >= 0 && y < height){
+        work.putPixelNormal(x, y, color);
+    }
+}
+
+void ParticleCanvas::line(int x1, int y1, int x2, int y2, Graphics::Color color){
+    int dx = abs(x2 - x1);
+    int dy = -abs(y2 - y1);
+    int stepX = x1 < x2 ? 1 : -1;
+    int stepY = y1 < y2 ? 1 : -1;
+    int error = dx + dy;
+    while (true){
+        pixel(x1, y1, color);
+        if (x1 == x2 && y1 == y2){
+            return;
+        }
+        int twice = error * 2;
+        if (twice >= dy){
+            error += dy;
+            x1 += stepX;
+        }
+        if (twice <= dx){
+            error += dx;
+            y1 += stepY;
+        }
+    }
+}
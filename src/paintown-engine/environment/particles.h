@@ -0,0 +1,79 @@
+#ifndef _paintown_particles_h
+#define _paintown_particles_h
+
+#include <vector>
+#include <r-tech1/graphics/color.h>
+
+namespace Graphics{
+class Bitmap;
+}
+
+/* A pool of particles for the atmospheres. Each field is kept in its own
+ * array (structure of arrays) so the update loops walk memory in order and
+ * the compiler can vectorize them. The arrays are sized once by reserve(),
+ * adding and removing particles after that never allocates.
+ *
+ * What angle, spin, direction, length, kind and color mean is up to the
+ * atmosphere.
+ */
+class Particles{
+public:
+    Particles();
+
+    /* make room for at least this many particles */
+    void reserve(int capacity);
+
+    /* returns the index of the new particle, or -1 if the pool is full */
+    int add(double x, double y, double vx, double vy);
+
+    /* the last particle takes the place of the removed one, so the order
+     * of the particles is not kept.
+     */
+    void remove(int index);
+
+    void clear();
+
+    inline int size() const {
+        return count;
+    }
+
+    inline int capacity() const {
+        return x.size();
+    }
+
+    /* add the velocity of each particle to its position */
+    void move();
+
+    std::vector<double> x, y;
+    std::vector<double> vx, vy;
+    std::vector<int> angle;
+    std::vector<int> spin;
+    std::vector<int> direction;
+    std::vector<int> length;
+    std::vector<int> kind;
+    std::vector<Graphics::Color> color;
+
+protected:
+    int count;
+};
+
+/* Draws a whole pool of particles into a bitmap while it is locked, so the
+ * pool costs one lock instead of a primitive call per particle. Pixels
+ * outside of the bitmap are dropped.
+ */
+class ParticleCanvas{
+public:
+    ParticleCanvas(const Graphics::Bitmap & work);
+    ~ParticleCanvas();
+
+    void pixel(int x, int y, Graphics::Color color);
+
+    /* both ends are drawn, the same pixels Bitmap::line() would touch */
+    void line(int x1, int y1, int x2, int y2, Graphics::Color color);
+
+protected:
+    const Graphics::Bitmap & work;
+    int width, height;
+};
+
+#endif
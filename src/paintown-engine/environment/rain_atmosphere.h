@@ -2,6 +2,7 @@
 #define _paintown_rain_atmosphere_h
 
 #include "atmosphere.h"
+#include "particles.h"
 #include <r-tech1/sound/sound.h>
 #include <vector>
 
@@ -10,13 +11,6 @@ class Bitmap;
 }
 class Token;
 
-struct Drop{
-    Drop( int x, int y, int length, Graphics::Color color ):x(x),y(y),length(length),color(color){}
-    int x, y;
-    int length;
-    Graphics::Color color;
-};
-
 struct Puddle{
     Puddle(int x, int y, int size):
         x(x), y(y), size(size), current(1){
@@ -38,12 +32,20 @@ public:
 	virtual void drawFront(Graphics::Bitmap * work, int x);
 	virtual void drawScreen(Graphics::Bitmap * work, int x);
 	virtual void act(const Scene & level, const std::vector<Paintown::Object*>*);
+    virtual void startDraw(int x);
     virtual void interpret(const Token * message);
+
+    /* change the number of rain drops */
+    virtual void setDrops(int drops);
 	
 protected:
-        std::vector<Util::ReferenceCount<Drop> > rain_drops;
-        std::vector<Util::ReferenceCount<Puddle> > puddles;
-        std::vector<Util::ReferenceCount<Puddle> > objectPuddles;
+        void addDrop();
+
+        /* length and color are used */
+        Particles rain_drops;
+        Graphics::Color dropColors[2];
+        std::vector<Puddle> puddles;
+        std::vector<Puddle> objectPuddles;
         std::vector<Util::ReferenceCount<Graphics::Bitmap> > splashes;
 	Sound rain_sound;
 	bool playing;
@@ -9,30 +9,13 @@ class Bitmap;
 class Token;
 
 #include "atmosphere.h"
+#include "particles.h"
 
 enum FlakeType{
     Small,
     Medium
 };
 
-struct Flake{
-    Flake(int x, int y, FlakeType type, int angle ):
-        x(x),
-        y(y),
-        dx(x),
-        dy(y),
-        angle(angle),
-        type(type),
-        dir(0),
-        spin(0){}
-    int x, y;
-    double dx, dy;
-    int angle;
-    FlakeType type;
-    int dir;
-    int spin;
-};
-
 class SnowAtmosphere: public Atmosphere {
 public:
 
@@ -46,8 +29,14 @@ public:
     virtual void act(const Scene & level, const std::vector<Paintown::Object*> *);
     virtual void interpret(const Token * message);
 
+    /* change the number of flakes */
+    virtual void setFlakes(int flakes);
+
 protected:
-    std::vector< Flake * > flakes;
+    void addFlake();
+
+    /* kind is the FlakeType. angle, spin and direction are used */
+    Particles flakes;
 };
 
 #endif
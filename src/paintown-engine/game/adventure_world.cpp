@@ -7,6 +7,7 @@
 #include <r-tech1/network/network.h>
 #include <r-tech1/thread.h>
 #include <r-tech1/events.h>
+#include <r-tech1/configuration.h>
 #include "../script/script.h"
 #include "../object/object.h"
 #include "../object/object_attack.h"
@@ -25,9 +26,12 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <algorithm>
 
 using namespace std;
 
+std::string AdventureWorld::ParallelViewsProperty = "paintown/parallel-views";
+
 Camera::Camera(double x, double y):
 x(x),
 y(y),
@@ -66,6 +70,7 @@ double Camera::getY() const {
 AdventureWorld::AdventureWorld():
 World(),
 draw_minimaps( true ),
+viewPoolThreads(0),
 takeAScreenshot(false),
 is_paused(false),
 slowmotion(0),
@@ -84,6 +89,7 @@ AdventureWorld::AdventureWorld( const vector< Paintown::Object * > & players, co
 World(),
 path( path ),
 draw_minimaps( true ),
+viewPoolThreads(0),
 takeAScreenshot(false),
 is_paused(false),
 slowmotion(0),
@@ -432,8 +438,26 @@ void AdventureWorld::dyingObject(const Paintown::Player & obj){
     // enterSlowMotion(60);
 }
 
+void AdventureWorld::collisionCandidates(Paintown::ObjectAttack * o_good, vector<Paintown::Object*> & candidates){
+    int x1 = 0, x2 = 0;
+    if (collisionGrid.isEnabled() && o_good->getAttackExtent(x1, x2)){
+        double z = o_good->getZ();
+        double distance = o_good->minZDistance();
+        collisionGrid.query(x1, x2, z - distance, z + distance, candidates);
+    } else {
+        candidates = objects;
+    }
+}
+
 void AdventureWorld::handleCollisions(Paintown::ObjectAttack * o_good, vector<Paintown::Object*> & added_effects){
-    for (vector<Paintown::Object*>::iterator fight = objects.begin(); fight != objects.end(); fight++){
+    /* the list is a member so it isn't allocated for every attack, but take
+     * it out first in case a collision ends up back in here.
+     */
+    vector<Paintown::Object*> candidates;
+    candidates.swap(collisionObjects);
+    collisionCandidates(o_good, candidates);
+
+    for (vector<Paintown::Object*>::iterator fight = candidates.begin(); fight != candidates.end(); fight++){
         if (*fight != o_good && (*fight)->isCollidable(o_good) && o_good->isCollidable(*fight)){
             // cout << "Zdistance: " << good->ZDistance( *fight ) << " = " << (good->ZDistance( *fight ) < o_good->minZDistance()) << endl;
             // cout << "Collision: " << (*fight)->collision( o_good ) << endl;
@@ -464,6 +488,9 @@ void AdventureWorld::handleCollisions(Paintown::ObjectAttack * o_good, vector<Pa
                 /* move this to the object now */
                 addMessage((*fight)->collidedMessage());
                 (*fight)->takeDamage(*this, o_good, o_good->getDamage(), o_good->getForceX(), o_good->getForceY());
+                if (collisionGrid.isEnabled()){
+                    collisionGrid.refresh(*fight);
+                }
 
 
                 /* TODO: enter slow motion for bosses
@@ -477,6 +504,8 @@ void AdventureWorld::handleCollisions(Paintown::ObjectAttack * o_good, vector<Pa
             }
         }
     }
+
+    candidates.swap(collisionObjects);
 }
 
 void AdventureWorld::updateObject(Paintown::Object * good, vector<Paintown::Object*> & added_effects){
@@ -506,12 +535,25 @@ void AdventureWorld::doLogic(){
     /* increase game time */
     gameTicks += 1;
 
+    /* objects don't get added or removed until the loop is done so their
+     * position in `objects' can identify them in the grid.
+     */
+    collisionGrid.reset(0, scene->getLimit(), getMinimumZ(), getMaximumZ());
+    for (unsigned int index = 0; index < objects.size(); index++){
+        collisionGrid.update(objects[index], index);
+    }
+    collisionGrid.setEnabled(true);
+
     vector<Paintown::Object *> added_effects;
-    for (vector<Paintown::Object *>::iterator it = objects.begin(); it != objects.end(); it++){
-        Paintown::Object * good = *it;
+    for (unsigned int index = 0; index < objects.size(); index++){
+        Paintown::Object * good = objects[index];
         updateObject(good, added_effects);
+        /* things it hit were already moved in handleCollisions */
+        collisionGrid.update(good, index);
     }
 
+    collisionGrid.setEnabled(false);
+
     eraseDeadObjects(added_effects);
     getItems();
 
@@ -686,29 +728,86 @@ void AdventureWorld::addObject( Paintown::Object * o ){
     objects.push_back(o);
 }
 
-void AdventureWorld::drawWorld(const PlayerTracker & tracker, Graphics::Bitmap * where, const map< int, vector< Paintown::Object * > > & object_z, double cameraX){
-    scene->drawBack((int) cameraX, where);
+void AdventureWorld::sortDrawList(){
+    drawEntries.clear();
+    unsigned int order = 0;
+    for (vector<Paintown::Object*>::iterator it = objects.begin(); it != objects.end(); it++, order++){
+        Paintown::Object * n = *it;
+        drawEntries.push_back(DrawEntry(n->getRZ(), order, n));
+    }
 
-    for (map<int, vector<Paintown::Object *> >::const_iterator it = object_z.begin(); it != object_z.end(); it++ ){
-        const vector<Paintown::Object *> & xx = (*it).second;
-        for ( vector<Paintown::Object *>::const_iterator mm = xx.begin(); mm != xx.end(); mm++ ){
+    /* no two entries are equal so std::sort gives the same order as a stable
+     * sort by z without needing a temporary buffer.
+     */
+    std::sort(drawEntries.begin(), drawEntries.end());
 
-            (*mm)->draw(where, (int) cameraX, 0);
-        }
+    drawList.clear();
+    for (vector<DrawEntry>::iterator it = drawEntries.begin(); it != drawEntries.end(); it++){
+        drawList.push_back(it->object);
+    }
+}
+
+void AdventureWorld::drawWorld(const PlayerTracker & tracker, Graphics::Bitmap * where, Graphics::Bitmap * front, const vector< Paintown::Object * > & drawList, double cameraX){
+    scene->drawBack((int) cameraX, where);
+
+    for (vector<Paintown::Object *>::const_iterator it = drawList.begin(); it != drawList.end(); it++){
+        (*it)->draw(where, (int) cameraX, 0);
     }
 
-    scene->drawFront((int) cameraX, where);
+    scene->drawFront((int) cameraX, where, front);
 
     /* need a special case to draw object stuff in front.
      * this is things like icon/name/health, not objects that are part of
      * the scene, and therefore the atmosphere doesn't apply to them.
      */
-    for (map<int,vector<Paintown::Object *> >::const_iterator it = object_z.begin(); it != object_z.end(); it++){
-        const vector<Paintown::Object *> & xx = (*it).second;
-        for ( vector<Paintown::Object *>::const_iterator mm = xx.begin(); mm != xx.end(); mm++ ){
-            (*mm)->drawFront(where, cameraX);
+    Util::Thread::ScopedLock scoped(frontLock);
+    for (vector<Paintown::Object *>::const_iterator it = drawList.begin(); it != drawList.end(); it++){
+        (*it)->drawFront(where, cameraX);
+    }
+}
+
+AdventureWorld::ViewJob::ViewJob(AdventureWorld * world, const PlayerTracker * tracker, Graphics::Bitmap * where, Graphics::Bitmap * front, double cameraX):
+world(world),
+tracker(tracker),
+where(where),
+front(front),
+cameraX(cameraX){
+}
+
+void AdventureWorld::ViewJob::run(){
+    world->drawWorld(*tracker, where, front, world->drawList, cameraX);
+}
+
+void AdventureWorld::drawViews(vector<ViewJob> & views){
+#ifdef USE_ALLEGRO5
+    bool parallel = false;
+#else
+    bool parallel = views.size() > 1 && Configuration::getProperty(ParallelViewsProperty, 0) != 0;
+#endif
+    if (!parallel){
+        for (vector<ViewJob>::iterator it = views.begin(); it != views.end(); it++){
+            it->run();
         }
+        return;
+    }
+
+    for (vector<Paintown::Object*>::iterator it = drawList.begin(); it != drawList.end(); it++){
+        (*it)->prepareDraw();
+    }
+
+    /* the pool might not get all the threads it asked for, so remember how
+     * many were asked for instead of trying again every frame.
+     */
+    if (viewPool == NULL || viewPoolThreads < views.size()){
+        viewPool = new System::ThreadPool(views.size());
+        viewPoolThreads = views.size();
     }
+
+    vector<System::ThreadPool::Job*> jobs;
+    for (vector<ViewJob>::iterator it = views.begin(); it != views.end(); it++){
+        jobs.push_back(&*it);
+    }
+    viewPool->run(jobs);
 }
 
 void AdventureWorld::drawMiniMaps( bool b ){
@@ -755,19 +854,9 @@ void AdventureWorld::doTakeScreenshot(Graphics::Bitmap * work){
     */
 }
 
-void AdventureWorld::drawMiniMap(Graphics::Bitmap * work, const PlayerTracker & player, const map<int, vector<Paintown::Object*> > & object_z, int x, int y, int width, int height){
-    if (mini_map == NULL){
-        /* 1.3333 is the aspect ratio of screen_width/screen_height when the res is any standard of
-         * 640,480 800,600, 1024,768
-         * but it should use the actual values instead of guessing since the screen size
-         * could theoretically change
-         */
-	mini_map = new Graphics::Bitmap(screen_size, (int)((double) screen_size / 1.3333));
-    }
-
-    drawWorld(player, mini_map.raw(), object_z, player.min_x);
+void AdventureWorld::drawMiniMap(Graphics::Bitmap * work, const Graphics::Bitmap & map, int x, int y, int width, int height){
     Graphics::Bitmap mini(width, height);
-    mini_map->Stretch(mini);
+    map.Stretch(mini);
     Graphics::Bitmap::transBlender(0, 0, 0, 160);
     mini.border(0, 1, Graphics::makeColor(255, 255, 255));
     mini.translucent().draw(x, y, *work);
@@ -784,13 +873,23 @@ void AdventureWorld::showDescription(Graphics::Bitmap * work, int time, const st
     }
 }
 
-void AdventureWorld::draw(Graphics::Bitmap * work){
-    map<int, vector<Paintown::Object*> > object_z;
-
-    for (vector< Paintown::Object * >::iterator it = objects.begin(); it != objects.end(); it++){
-        Paintown::Object * n = *it;
-        object_z[n->getRZ()].push_back(n);
+/* the foreground panels of each view are put together in a buffer of their own
+ * so views can be drawn at the same time
+ */
+Graphics::Bitmap * AdventureWorld::getFrontBuffer(unsigned int index, const Graphics::Bitmap & where){
+    if (index >= frontBuffers.size()){
+        frontBuffers.resize(index + 1);
+    }
+    Util::ReferenceCount<Graphics::Bitmap> & front = frontBuffers[index];
+    if (front == NULL || front->getWidth() != where.getWidth() || front->getHeight() != where.getHeight()){
+        front = new Graphics::Bitmap(where.getWidth(), where.getHeight());
     }
+    return front.raw();
+}
+
+void AdventureWorld::draw(Graphics::Bitmap * work){
+    sortDrawList();
+    scene->startDraw((int) camera.getX());
 
     if (descriptionTime > 0 && scene->getDescription() != ""){
         showDescription(work, descriptionTime, scene->getDescription());
@@ -803,6 +902,12 @@ void AdventureWorld::draw(Graphics::Bitmap * work){
     int mini_position_x = work->getWidth() - mini_width - 1;
     int mini_position_y = work->getHeight() - mini_height - 1;
 
+    /* where each mini map goes on the screen, in the same order as the
+     * mini map views.
+     */
+    vector<pair<int, int> > miniPositions;
+    vector<ViewJob> views;
+
     for (vector<PlayerTracker>::iterator it = players.begin(); it != players.end(); it++ ){
         /* this logic is a bit whacky. we assume the first element in the player tracker
          * list is a real player so we draw the world on the real buffer (on = work).
@@ -814,7 +919,7 @@ void AdventureWorld::draw(Graphics::Bitmap * work){
          * to draw a minimap.
          */
         if (it == players.begin()){
-            drawWorld(*it, work, object_z, camera.getX());
+            views.push_back(ViewJob(this, &*it, work, getFrontBuffer(views.size(), *work), camera.getX()));
             /* Don't need a minimap for the main player */
             continue;
         } else if (!shouldDrawMiniMaps()){
@@ -823,8 +928,19 @@ void AdventureWorld::draw(Graphics::Bitmap * work){
             continue;
         }
 
+        unsigned int index = miniPositions.size();
+        if (index >= miniMaps.size()){
+            /* 1.3333 is the aspect ratio of screen_width/screen_height when the res is any standard of
+             * 640,480 800,600, 1024,768
+             * but it should use the actual values instead of guessing since the screen size
+             * could theoretically change
+             */
+            miniMaps.push_back(Util::ReferenceCount<Graphics::Bitmap>(new Graphics::Bitmap(screen_size, (int)((double) screen_size / 1.3333))));
+        }
+
         /* draw the minimaps where the camera is always centered on the guy */
-        drawMiniMap(work, *it, object_z, mini_position_x, mini_position_y, mini_width, mini_height);
+        views.push_back(ViewJob(this, &*it, miniMaps[index].raw(), getFrontBuffer(views.size(), *miniMaps[index]), it->min_x));
+        miniPositions.push_back(make_pair(mini_position_x, mini_position_y));
 
         mini_position_x -= mini_width - 2;
         if (mini_position_x <= 0){
@@ -833,6 +949,15 @@ void AdventureWorld::draw(Graphics::Bitmap * work){
         }
     }
 
+    drawViews(views);
+
+    /* put the mini maps on the screen in a fixed order no matter which
+     * thread finished first.
+     */
+    for (unsigned int i = 0; i < miniPositions.size(); i++){
+        drawMiniMap(work, *miniMaps[i], miniPositions[i].first, miniPositions[i].second, mini_width, mini_height);
+    }
+
     if (shouldTakeScreenshot() && (screenshots.empty() || Util::rnd(15) == 0)){
         doTakeScreenshot(work);
     } else {
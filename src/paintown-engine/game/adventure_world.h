@@ -23,7 +23,10 @@ class Gradient;
 
 #include <r-tech1/file-system.h>
 #include <r-tech1/network/network.h>
+#include <r-tech1/thread.h>
 #include "world.h"
+#include "collision-grid.h"
+#include "system/thread-pool.h"
 #include "../level/cacher.h"
 #include "../level/block.h"
 
@@ -120,6 +123,13 @@ public:
 
 	virtual void drawMiniMaps( bool b );
 	virtual bool shouldDrawMiniMaps();
+
+        /* configuration property, if non-zero the main view and the mini
+         * maps are drawn at the same time on separate threads. off by default,
+         * and never done with allegro5 since its video bitmaps can only be
+         * drawn on the main thread.
+         */
+        static std::string ParallelViewsProperty;
         
         virtual double ticks(const double in) const;
 
@@ -129,6 +139,8 @@ public:
         virtual void eraseDeadObjects(std::vector<Paintown::Object*> & added_effects);
         virtual void updateObject(Paintown::Object * good, std::vector<Paintown::Object*> & added_effects);
         virtual void handleCollisions(Paintown::ObjectAttack * o_good, std::vector<Paintown::Object*> & added_effects);
+        /* objects that o_good might be able to hit, in world order */
+        virtual void collisionCandidates(Paintown::ObjectAttack * o_good, std::vector<Paintown::Object*> & candidates);
 
 	void killAllHumans( Paintown::Object * player );
 
@@ -150,8 +162,12 @@ protected:
 	void loadLevel( const Filesystem::AbsolutePath & path );
 	void threadedLoadLevel( const Filesystem::AbsolutePath & path );
 
-	virtual void drawWorld( const PlayerTracker & tracker, Graphics::Bitmap * where, const std::map< int, std::vector< Paintown::Object * > > & object_z, double cameraX);
-        virtual void drawMiniMap(Graphics::Bitmap * work, const PlayerTracker & player, const std::map<int, std::vector<Paintown::Object*> > & objects, int x, int y, int width, int height);
+	virtual void drawWorld( const PlayerTracker & tracker, Graphics::Bitmap * where, Graphics::Bitmap * front, const std::vector< Paintown::Object * > & drawList, double cameraX);
+        /* shrink a mini map that was already drawn and put it on work */
+        virtual void drawMiniMap(Graphics::Bitmap * work, const Graphics::Bitmap & map, int x, int y, int width, int height);
+
+        /* put the objects into drawList from back to front */
+        virtual void sortDrawList();
         virtual void showDescription(Graphics::Bitmap * work, int time, const std::string & description);
 
 	virtual void deleteObjects( std::vector< Paintown::Object * > * objects );
@@ -193,7 +209,38 @@ protected:
 
     bool draw_minimaps;
 
-    Util::ReferenceCount<Graphics::Bitmap> mini_map;
+    /* one bitmap per mini map so they can all be drawn at the same time */
+    std::vector<Util::ReferenceCount<Graphics::Bitmap> > miniMaps;
+
+    /* draws one view of the world into its own bitmap */
+    class ViewJob: public System::ThreadPool::Job {
+    public:
+        ViewJob(AdventureWorld * world, const PlayerTracker * tracker, Graphics::Bitmap * where, Graphics::Bitmap * front, double cameraX);
+
+        virtual void run();
+
+        AdventureWorld * world;
+        const PlayerTracker * tracker;
+        Graphics::Bitmap * where;
+        /* scratch buffer for the scene foreground of this view */
+        Graphics::Bitmap * front;
+        double cameraX;
+    };
+
+    /* draw all the views, on the view pool if it is turned on */
+    void drawViews(std::vector<ViewJob> & views);
+
+    /* one foreground buffer per view, the same size as the view */
+    std::vector<Util::ReferenceCount<Graphics::Bitmap> > frontBuffers;
+    Graphics::Bitmap * getFrontBuffer(unsigned int index, const Graphics::Bitmap & where);
+
+    Util::ReferenceCount<System::ThreadPool> viewPool;
+    /* how many threads the view pool was asked for */
+    unsigned int viewPoolThreads;
+    /* the text drawn in front of objects goes through the global font
+     * renderer, so only one view draws it at a time.
+     */
+    Util::Thread::LockObject frontLock;
 
     /* screenshots that are shown at the end of the level */
     std::deque<Graphics::Bitmap*> screenshots;
@@ -231,6 +278,39 @@ protected:
     bool replayEnabled;
 
     Camera camera;
+
+    /* where objects are during doLogic, so attacks only look at nearby objects */
+    CollisionGrid collisionGrid;
+    /* reused by handleCollisions */
+    std::vector<Paintown::Object*> collisionObjects;
+
+    /* an object and its place in the drawing order. objects with the same z
+     * are drawn in the order they appear in `objects'.
+     */
+    struct DrawEntry{
+        DrawEntry(int z, unsigned int order, Paintown::Object * object):
+            z(z),
+            order(order),
+            object(object){
+            }
+
+        bool operator<(const DrawEntry & him) const {
+            if (z != him.z){
+                return z < him.z;
+            }
+            return order < him.order;
+        }
+
+        int z;
+        unsigned int order;
+        Paintown::Object * object;
+    };
+
+    /* objects sorted by z, built once per frame and shared by the main view
+     * and the mini maps. kept between frames so their storage is reused.
+     */
+    std::vector<DrawEntry> drawEntries;
+    std::vector<Paintown::Object*> drawList;
 };
 
 #endif
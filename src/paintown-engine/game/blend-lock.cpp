@@ -0,0 +1,11 @@
+#include <r-tech1/thread.h>
+#include "blend-lock.h"
+
+static Util::Thread::LockObject blendLock;
+
+BlendLock::BlendLock():
+scoped(blendLock){
+}
+
+BlendLock::~BlendLock(){
+}
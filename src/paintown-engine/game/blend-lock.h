@@ -0,0 +1,24 @@
+#ifndef _paintown_blend_lock_h
+#define _paintown_blend_lock_h
+
+#include <r-tech1/thread.h>
+
+/* r-tech1 keeps the blender set by Graphics::Bitmap::transBlender() and the
+ * other *Blender() functions in one global that every thread shares. The
+ * views of a world can be drawn on several threads at once, so code that sets
+ * a blender and then draws with it holds a BlendLock from the one to the
+ * other. Don't hold two at once, the lock isn't recursive.
+ */
+class BlendLock{
+public:
+    BlendLock();
+    ~BlendLock();
+
+private:
+    BlendLock(const BlendLock &);
+    BlendLock & operator=(const BlendLock &);
+
+    Util::Thread::ScopedLock scoped;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "collision-grid.h"
+#include "../object/object.h"
+#include <algorithm>
+
+using namespace std;
+
+/* a cell is about as wide as a character */
+static const int CELL_WIDTH = 64;
+static const int CELL_DEPTH = 16;
+
+CollisionGrid::CollisionGrid():
+minX(0),
+minZ(0),
+columns(0),
+rows(0),
+enabled(false){
+}
+
+void CollisionGrid::reset(int minX, int maxX, int minZ, int maxZ){
+    this->minX = minX;
+    this->minZ = minZ;
+    columns = maxX > minX ? (maxX - minX) / CELL_WIDTH + 1 : 1;
+    rows = maxZ > minZ ? (maxZ - minZ) / CELL_DEPTH + 1 : 1;
+
+    if (cells.size() < (unsigned int)(columns * rows)){
+        cells.resize(columns * rows);
+    }
+
+    /* clear() keeps the capacity around for the next tick */
+    for (vector<vector<Entry> >::iterator it = cells.begin(); it != cells.end(); it++){
+        it->clear();
+    }
+    always.clear();
+    for (vector<Placement>::iterator it = placements.begin(); it != placements.end(); it++){
+        *it = Placement();
+    }
+    orders.clear();
+}
+
+int CollisionGrid::cellX(int x) const {
+    int cell = (x - minX) / CELL_WIDTH;
+    if (x < minX || cell < 0){
+        return 0;
+    }
+    if (cell >= columns){
+        return columns - 1;
+    }
+    return cell;
+}
+
+int CollisionGrid::cellZ(double z) const {
+    int cell = (int)((z - minZ) / CELL_DEPTH);
+    if (z < minZ || cell < 0){
+        return 0;
+    }
+    if (cell >= rows){
+        return rows - 1;
+    }
+    return cell;
+}
+
+void CollisionGrid::removeFrom(vector<Entry> & cell, const Entry & entry){
+    for (vector<Entry>::iterator it = cell.begin(); it != cell.end(); it++){
+        if (*it == entry){
+            cell.erase(it);
+            return;
+        }
+    }
+}
+
+void CollisionGrid::remove(const Entry & entry, const Placement & placement){
+    if (placement.always){
+        removeFrom(always, entry);
+        return;
+    }
+
+    for (int x = placement.x1; x <= placement.x2; x++){
+        removeFrom(cells[placement.z * columns + x], entry);
+    }
+}
+
+void CollisionGrid::update(Paintown::Object * object, unsigned int order){
+    if (order >= placements.size()){
+        placements.resize(order + 1);
+    }
+
+    Entry entry(object, order);
+    Placement & placement = placements[order];
+    if (placement.placed){
+        remove(entry, placement);
+        if (placement.object != object){
+            orders.erase(placement.object);
+        }
+    }
+    orders[object] = order;
+
+    placement = Placement();
+    placement.object = object;
+    placement.placed = true;
+
+    int x1 = 0, x2 = 0;
+    if (!object->getHittableExtent(x1, x2)){
+        placement.always = true;
+        always.push_back(entry);
+        return;
+    }
+
+    /* nothing can touch an object without a mask */
+    if (x2 < x1){
+        return;
+    }
+
+    placement.x1 = cellX(x1);
+    placement.x2 = cellX(x2);
+    placement.z = cellZ(object->getZ());
+    for (int x = placement.x1; x <= placement.x2; x++){
+        cells[placement.z * columns + x].push_back(entry);
+    }
+}
+
+void CollisionGrid::refresh(Paintown::Object * object){
+    map<Paintown::Object*, unsigned int>::iterator where = orders.find(object);
+    if (where != orders.end()){
+        update(object, where->second);
+    }
+}
+
+void CollisionGrid::query(int x1, int x2, double z1, double z2, vector<Paintown::Object*> & out){
+    found.clear();
+    found.insert(found.end(), always.begin(), always.end());
+
+    if (x1 <= x2 && z1 <= z2){
+        /* an object at the edge of a cell can be pushed around by
+         * other objects during the tick without being moved in the grid,
+         * so look one cell further in every direction.
+         */
+        int left = max(cellX(x1) - 1, 0);
+        int right = min(cellX(x2) + 1, columns - 1);
+        int front = max(cellZ(z1) - 1, 0);
+        int back = min(cellZ(z2) + 1, rows - 1);
+        for (int z = front; z <= back; z++){
+            for (int x = left; x <= right; x++){
+                const vector<Entry> & cell = cells[z * columns + x];
+                found.insert(found.end(), cell.begin(), cell.end());
+            }
+        }
+    }
+
+    /* keep the order the world would have tested them in */
+    sort(found.begin(), found.end());
+    found.erase(unique(found.begin(), found.end()), found.end());
+
+    out.clear();
+    for (vector<Entry>::iterator it = found.begin(); it != found.end(); it++){
+        out.push_back(it->object);
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef _paintown_collision_grid_h
+#define _paintown_collision_grid_h
+
+#include <vector>
+#include <map>
+
+namespace Paintown{
+class Object;
+}
+
+/* Buckets objects by x and z so an attacking object only has to be tested
+ * against the objects near it instead of every object in the world.
+ * Objects that can't say where their collision masks are go in a list
+ * that every query returns. The cell storage is kept between ticks so
+ * rebuilding the grid each tick doesn't allocate.
+ */
+class CollisionGrid{
+public:
+    CollisionGrid();
+
+    /* forget all objects and cover the area from minX to maxX and
+     * minZ to maxZ. positions outside of the area are clamped to the edge.
+     */
+    void reset(int minX, int maxX, int minZ, int maxZ);
+
+    /* add an object or move it to its current position. `order' is the
+     * position of the object in the world's object list; candidates
+     * come back from query() sorted by it.
+     */
+    void update(Paintown::Object * object, unsigned int order);
+
+    /* move an object that is already in the grid when its order isn't known,
+     * like something that was just hit.
+     */
+    void refresh(Paintown::Object * object);
+
+    /* all objects whose masks might be between x1 and x2 and whose z
+     * is between z1 and z2, in world order.
+     */
+    void query(int x1, int x2, double z1, double z2, std::vector<Paintown::Object*> & out);
+
+    inline bool isEnabled() const {
+        return enabled;
+    }
+
+    inline void setEnabled(bool enabled){
+        this->enabled = enabled;
+    }
+
+protected:
+    struct Entry{
+        Entry():
+        object(0),
+        order(0){
+        }
+
+        Entry(Paintown::Object * object, unsigned int order):
+        object(object),
+        order(order){
+        }
+
+        bool operator<(const Entry & him) const {
+            return order < him.order;
+        }
+
+        bool operator==(const Entry & him) const {
+            return order == him.order;
+        }
+
+        Paintown::Object * object;
+        unsigned int order;
+    };
+
+    /* cells an object occupies, x is inclusive. `always' means it lives in
+     * the unbounded list.
+     */
+    struct Placement{
+        Placement():
+        object(0),
+        placed(false),
+        always(false),
+        x1(0),
+        x2(-1),
+        z(0){
+        }
+
+        Paintown::Object * object;
+        bool placed;
+        bool always;
+        int x1, x2;
+        int z;
+    };
+
+    int cellX(int x) const;
+    int cellZ(double z) const;
+
+    void remove(const Entry & entry, const Placement & placement);
+    void removeFrom(std::vector<Entry> & cell, const Entry & entry);
+
+    /* cells are stored row by row, one row per z cell */
+    std::vector<std::vector<Entry> > cells;
+    std::vector<Entry> always;
+    /* indexed by world order */
+    std::vector<Placement> placements;
+    /* world order of every placed object, so refresh() doesn't have to look
+     * through the placements
+     */
+    std::map<Paintown::Object*, unsigned int> orders;
+    std::vector<Entry> found;
+
+    int minX, minZ;
+    int columns, rows;
+
+    bool enabled;
+};
+
+#endif
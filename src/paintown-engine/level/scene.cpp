@@ -407,54 +407,75 @@ void Scene::drawBack( int x, Graphics::Bitmap * work ){
         fx += normal->getWidth();
     }
 
+    Util::Thread::ScopedLock scoped(atmosphereLock);
     for (vector<Atmosphere*>::iterator it = atmospheres.begin(); it != atmospheres.end(); it++){
         Atmosphere * atmosphere = *it;
         atmosphere->drawBackground(work, x);
     }
-
-    arrow_blink = (arrow_blink + 1) % 10;
 }
 
-/* draw the foreground */
-void Scene::drawFront( int x, Graphics::Bitmap * work ){
+void Scene::startDraw(int x){
+    arrow_blink = (arrow_blink + 1) % 10;
 
     for (vector<Atmosphere*>::iterator it = atmospheres.begin(); it != atmospheres.end(); it++){
         Atmosphere * atmosphere = *it;
-        atmosphere->drawForeground(work, (int)(x * getForegroundParallax()));
+        atmosphere->startDraw(x);
     }
+}
 
+/* draw the foreground */
+void Scene::drawFront( int x, Graphics::Bitmap * work ){
     /* lazily initialize to ensure the buffer is the same size as the bitmap
      * to be drawn on.
      */
-    if (frontBuffer == NULL){
+    if (frontBuffer == NULL || frontBuffer->getWidth() != work->getWidth() || frontBuffer->getHeight() != work->getHeight()){
+        delete frontBuffer;
         frontBuffer = new Graphics::Bitmap(work->getWidth(), work->getHeight());
     }
 
-    frontBuffer->clearToMask();
+    drawFront(x, work, frontBuffer);
+}
+
+void Scene::drawFront( int x, Graphics::Bitmap * work, Graphics::Bitmap * front ){
+    {
+        Util::Thread::ScopedLock scoped(atmosphereLock);
+        for (vector<Atmosphere*>::iterator it = atmospheres.begin(); it != atmospheres.end(); it++){
+            Atmosphere * atmosphere = *it;
+            atmosphere->drawForeground(work, (int)(x * getForegroundParallax()));
+        }
+    }
+
+    front->clearToMask();
 
     double fx = 0;
     if ( front_panels.size() > 0 ){
         while ( fx < scene_length * getForegroundParallax() ){
             for ( vector< Graphics::Bitmap * >::iterator it = front_panels.begin(); it != front_panels.end(); it++ ){
                 Graphics::Bitmap * b = *it;
-                b->draw( (int)(fx - x * getForegroundParallax()), 0, *frontBuffer);
+                b->draw( (int)(fx - x * getForegroundParallax()), 0, *front);
                 fx += b->getWidth();
             }
         }
     }
 
-    /* just draw on the foreground */
-    for (vector<Atmosphere*>::iterator it = atmospheres.begin(); it != atmospheres.end(); it++){
-        Atmosphere * atmosphere = *it;
-        atmosphere->drawFront(frontBuffer, x);
+    {
+        Util::Thread::ScopedLock scoped(atmosphereLock);
+        /* just draw on the foreground */
+        for (vector<Atmosphere*>::iterator it = atmospheres.begin(); it != atmospheres.end(); it++){
+            Atmosphere * atmosphere = *it;
+            atmosphere->drawFront(front, x);
+        }
     }
 
-    frontBuffer->draw(0, 0, *work);
+    front->draw(0, 0, *work);
     
-    /* draw anything on the entire screen */
-    for (vector<Atmosphere*>::iterator it = atmospheres.begin(); it != atmospheres.end(); it++){
-        Atmosphere * atmosphere = *it;
-        atmosphere->drawScreen(work, x);
+    {
+        Util::Thread::ScopedLock scoped(atmosphereLock);
+        /* draw anything on the entire screen */
+        for (vector<Atmosphere*>::iterator it = atmospheres.begin(); it != atmospheres.end(); it++){
+            Atmosphere * atmosphere = *it;
+            atmosphere->drawScreen(work, x);
+        }
     }
 
     if (numberOfEnemies() == 0 && !passedBoundary(x)){
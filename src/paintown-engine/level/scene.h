@@ -8,6 +8,7 @@
 #include "block.h"
 #include <r-tech1/pointer.h>
 #include <r-tech1/file-system.h>
+#include <r-tech1/thread.h>
 
 namespace Graphics{
 class Bitmap;
@@ -40,6 +41,17 @@ public:
     void drawFront( int x, Graphics::Bitmap * work );
     void drawBack( int x, Graphics::Bitmap * work );
 
+    /* Same as drawFront(x, work) but the foreground panels are put together
+     * in `front', which must be the same size as `work'. Views drawn at the
+     * same time on different threads each pass their own.
+     */
+    void drawFront( int x, Graphics::Bitmap * work, Graphics::Bitmap * front );
+
+    /* call once a frame before drawing any views of the scene, x is the
+     * camera of the main view
+     */
+    void startDraw(int x);
+
     int getFinished() const;
 
     inline std::string getDescription() const {
@@ -167,6 +179,11 @@ protected:
 
     Graphics::Bitmap * frontBuffer;
 
+    /* atmospheres keep state while they draw, so only one view draws them
+     * at a time
+     */
+    Util::Thread::LockObject atmosphereLock;
+
     std::vector<Atmosphere*> atmospheres;
     std::vector<Trigger*> triggers;
     std::vector<std::string> music;
@@ -31,12 +31,14 @@ namespace Paintown{
 Frame::Frame( Graphics::Bitmap * p, ECollide * e ){
 	pic = p;
 	collide = e;
+	bounds = CollisionBox::fromBitmap(*p);
 	mine = true;
 }
 	
 Frame::Frame( const Frame & f ){
     pic = f.pic;
     collide = f.collide;
+    bounds = f.bounds;
     mine = false;
 }
 
@@ -127,16 +129,17 @@ offset_x( 0 ),
 offset_y( 0 ),
 shadowX( 0 ),
 shadowY( 0 ),
+script(new AnimationScript()),
+frameSet(new AnimationFrames()),
 range( 0 ),
 is_attack( false ),
 status( Status_Ground ),
 perpetual(false),
 commision( true ),
-contact( NULL ),
 changedAttacks(false){
 
-    prev_sequence = "none";
-    next_sequence = "none";
+    script->prev_sequence = "none";
+    script->next_sequence = "none";
 
     if ( *tok != "anim" && *tok != "animation" ){
         Global::debug( 0 ) <<"Not an animation"<<endl;
@@ -175,7 +178,7 @@ changedAttacks(false){
                 bool hit = true;
                 current.view() >> hit;
                 AnimationEventCanBeHit * event = new AnimationEventCanBeHit(hit);
-                events.push_back(event);
+                script->events.push_back(event);
             } else if ( current == "offset" ){
                 // *current >> offset_x >> offset_y;
                 int x = 0;
@@ -187,7 +190,7 @@ changedAttacks(false){
                 }
                 // cout<<"Read offset as "<<x<<" "<<y<<endl;
                 AnimationEventOffset * ani = new AnimationEventOffset( x, y );
-                events.push_back( ani );
+                script->events.push_back( ani );
             } else if (current == "relative-offset"){
                 int x = 0;
                 int y = 0;
@@ -197,10 +200,10 @@ changedAttacks(false){
                     /* ignore token exceptions here */
                 }
 
-                events.push_back(new AnimationEventRelativeOffset(x, y));
+                script->events.push_back(new AnimationEventRelativeOffset(x, y));
             } else if (current == "projectile" ){
                 AnimationEventProjectile * ani = new AnimationEventProjectile(current1);
-                events.push_back(ani);
+                script->events.push_back(ani);
             } else if ( current == "move" ){
                 try{
                     int x, y, z;
@@ -208,7 +211,7 @@ changedAttacks(false){
                     current.view() >> x >> y >> z;
 
                     AnimationEventMove * em = new AnimationEventMove( x, y, z );
-                    events.push_back(em);
+                    script->events.push_back(em);
                 } catch( const TokenException & te ){
                     Global::debug( 0 ) << "Could not read move event: " << te.getTrace() << endl;
                     /* ignore token exceptions here */
@@ -228,18 +231,18 @@ changedAttacks(false){
                     }
                 }
                 AnimationEventTrail * trail = new AnimationEventTrail(produce, life);
-                events.push_back(trail);
+                script->events.push_back(trail);
             } else if ( current == "sequence" ){
                 string p, n;
                 current.view() >> p >> n;
                 // sequences[ p ] = n;
                 // cout<<getName() << ":Adding sequence "<<p<<endl;
-                sequences.push_back( p );
+                script->sequences.push_back( p );
                 // *current >> prev_sequence >> next_sequence;
             } else if ( current == "contact" ){
                 string st;
                 current.view() >> st;
-                contact = new Sound(*Storage::instance().open(Storage::instance().find(Filesystem::RelativePath(st))));
+                script->contact = new Sound(*Storage::instance().open(Storage::instance().find(Filesystem::RelativePath(st))));
             } else if ( current == "keys" ){
 
                 TokenView keyView = current.view();
@@ -268,7 +271,7 @@ changedAttacks(false){
                             press.combo.push_back(actualKey);
                         }
                     }
-                    keys.push_back( press );
+                    script->keys.push_back( press );
                 }
             } else if ( current == "status" ){
 
@@ -287,7 +290,7 @@ changedAttacks(false){
                 int x, y;
                 current.view() >> x >> y;
                 AnimationEvent * ani = new AnimationEventShadow( x, y );
-                events.push_back( ani );
+                script->events.push_back( ani );
             } else if ( current == "coords" ){
                 const Token * c;
                 TokenView coordsView = current.view();
@@ -307,7 +310,7 @@ changedAttacks(false){
                     coordsView >> c;
                 }
                 AnimationEvent * ani = new AnimationEventCoords( x, y, z );
-                events.push_back( ani );
+                script->events.push_back( ani );
             } else if ( current == "bbox" ){
 
                 /*
@@ -316,7 +319,7 @@ changedAttacks(false){
                    x2 = y2 = 1;
                    in >> x1 >> y1 >> x2 >> y2;
                    AnimationEvent * ani = new AnimationEventBBox( x1, y1, x2, y2 );
-                   events.push_back( ani );
+                   script->events.push_back( ani );
                    */
             } else if (current == "attack"){
 
@@ -335,27 +338,27 @@ changedAttacks(false){
 
                 // AnimationEvent * ani = new AnimationEventAttack( x1, y1, x2, y2, damage, force );
                 AnimationEvent * ani = new AnimationEventAttack(parseAttacks(current));
-                events.push_back(ani);
+                script->events.push_back(ani);
             } else if (current == "perpetual"){
                 bool enabled = false;
                 current.view() >> enabled;
-                events.push_back(new AnimationPerpetual(enabled));
+                script->events.push_back(new AnimationPerpetual(enabled));
             } else if (current == "z-distance" ){
                 double d;
                 current.view() >> d;
                 AnimationEvent * e = new AnimationEventZDistance( d );
-                events.push_back( e );
+                script->events.push_back( e );
             } else if ( current == "sound" ){
                 string st;
                 current.view() >> st;
 
-                if (sounds.find(st) == sounds.end()){
+                if (script->sounds.find(st) == script->sounds.end()){
                     Sound * sp = new Sound(*Storage::instance().open(Storage::instance().find(Filesystem::RelativePath(st))));
-                    sounds[st] = sp;
+                    script->sounds[st] = sp;
                 }
 
                 AnimationEvent * aes = new AnimationEventSound(st);
-                events.push_back( aes );
+                script->events.push_back( aes );
             } else if ( current == "setstatus" ){
                 string st;
                 current.view() >> st;
@@ -366,12 +369,12 @@ changedAttacks(false){
                     m = Status_Grab;
                 }
                 AnimationEvent * ani = new AnimationEventStatus( m );
-                events.push_back( ani );
+                script->events.push_back( ani );
             } else if ( current == "jump" ){
                 double x, y, z;
                 current.view() >> x >> y >> z;
                 AnimationEvent * ani = new AnimationEventJump( x, y, z );
-                events.push_back( ani );
+                script->events.push_back( ani );
             } else if ( current == "decommision" ){
                 string l;
                 current.view() >> l;
@@ -392,11 +395,11 @@ changedAttacks(false){
                     direction = -1;
                 }
                 AnimationEvent * ani = new AnimationEventFace( direction );
-                events.push_back( ani );
+                script->events.push_back( ani );
             } else if ( current == "nop" ){
-                events.push_back( new AnimationEventNOP() );
+                script->events.push_back( new AnimationEventNOP() );
             } else if ( current == "next-ticket" ){
-                events.push_back( new AnimationEventTicket() );
+                script->events.push_back( new AnimationEventTicket() );
             } else if ( current == "range" ){
                 int r;
                 current.view() >> r;
@@ -421,13 +424,13 @@ changedAttacks(false){
                 }
 
                 AnimationEvent * ani = new AnimationEventDelay(delay);
-                events.push_back( ani );
+                script->events.push_back( ani );
             } else if ( current == "frame" ){
                 string path;
                 current.view() >> path;
                 Filesystem::RelativePath full = Filesystem::RelativePath(basedir).join(Filesystem::RelativePath(path));
                 // Filesystem::AbsolutePath full = Filesystem::find(Filesystem::RelativePath(basedir + path));
-                if (frames.find(full.path()) == frames.end()){
+                if (frameSet->frames.find(full.path()) == frameSet->frames.end()){
                     Graphics::Bitmap * pic = Paintown::Mod::getCurrentMod()->createBitmap(full);
                     if (owner != NULL && owner->getSpriteScale() != 1){
                         *pic = pic->scaleBy(owner->getSpriteScale(), owner->getSpriteScale());
@@ -435,14 +438,14 @@ changedAttacks(false){
 
                     ECollide * collide = new ECollide(pic);
                     Frame * f = new Frame(pic, collide);
-                    frames[full.path()] = f;
+                    frameSet->frames[full.path()] = f;
                     if (pic->getError()){
                         // Global::debug( 0 ) <<"Pic error"<<endl;
                         throw LoadException(__FILE__, __LINE__, "Could not load picture");
                     }
                 }
                 AnimationEvent * ani = new AnimationEventFrame(full.path());
-                events.push_back(ani);
+                script->events.push_back(ani);
             } else {
                 Global::debug(0) << tok->getFileName() << " Unhandled animation attribute: "<<endl;
                 current.print(" ");
@@ -461,7 +464,7 @@ changedAttacks(false){
     xls += getName();
     Global::debug( 4 ) << diff.printTime( xls ) << endl;
 
-    if ( frames.empty() ){
+    if ( frameSet->frames.empty() ){
         Global::debug( 0 )<<"No frames given"<<endl;
         // throw exception();
         throw LoadException(__FILE__, __LINE__, "No frames given");
@@ -469,19 +472,19 @@ changedAttacks(false){
 
     delay_counter = 0;
 
-    current_event = events.begin();
+    current_event = script->events.begin();
 
     current_frame = NULL;
     current_collide = NULL;
-    map< string, Frame * >::iterator first = frames.begin();
-    if ( first != frames.end() ){
+    map< string, Frame * >::iterator first = frameSet->frames.begin();
+    if ( first != frameSet->frames.end() ){
         Frame * x = (*first).second;
         current_frame = x->pic;
         current_collide = x->collide;
+        current_bounds = x->bounds;
     }
 
     own_bitmaps = true;
-    own_events = true;
 
     // cout<<"Create animation "<<name<<endl;
 
@@ -501,12 +504,11 @@ commision( true ),
 changedAttacks(false){
 
 	own_bitmaps = false;
-	own_events = false;
-	frames = animation.frames;
-	// for ( vector< AnimationEvent * >::const_iterator it = animation.events.begin(); it != animation.events.end(); it++ )
-		// events.push_back( *it );
-
-	events = animation.events;
+	/* everything that doesn't change after loading is shared with the
+	 * original animation.
+	 */
+	script = animation.script;
+	frameSet = animation.frameSet;
         canBeHit_ = animation.canBeHit_;
 
 	name = animation.getName();
@@ -536,19 +538,9 @@ changedAttacks(false){
 
 	setCommision( animation.isCommisioned() );
 
-	sounds = animation.sounds;
-	contact = animation.contact;
-
-	disable_animations = animation.getDecommisions();
-	enable_animations = animation.getCommisions();
-
 	setRange( animation.getRange() );
 
-	prev_sequence = animation.getPreviousSequence();
-	next_sequence = animation.getNextSequence();
-	
 	// cout<<"Animation sequences = " << animation.getSequences().size() << endl;
-	sequences = animation.getSequences();
 
 	/*
 	for ( map<string,string>::iterator it = sequences.begin(); it != sequences.end(); it++ ){
@@ -562,13 +554,11 @@ changedAttacks(false){
 	}
 	*/
 
-	/* copy the key combos */
-	keys = animation.keys;
-
-	current_event = events.begin();
+	current_event = script->events.begin();
 
 	current_frame = animation.current_frame;
 	current_collide = animation.current_collide;
+	current_bounds = animation.current_bounds;
 
 	/*
 	map< string, Bitmap * >::iterator first = frames.begin();
@@ -668,11 +658,11 @@ void Animation::setDelay(double delay){
 }
 	
 void Animation::addDecommision( const string & s ){
-	disable_animations.push_back( s );	
+	script->disable_animations.push_back( s );	
 }
 
 void Animation::addCommision( const string & s ){
-	enable_animations.push_back( s );
+	script->enable_animations.push_back( s );
 }
         
 Animation * Animation::copy(Character * owner) const {
@@ -690,8 +680,8 @@ void Animation::Delay(){
 }
 	
 void Animation::playSound( const string & path ){
-	if ( sounds.find( path ) != sounds.end() ){
-		Sound * s = sounds[ path ];
+	if ( script->sounds.find( path ) != script->sounds.end() ){
+		Sound * s = script->sounds[ path ];
 		s->play();
 	}
 }
@@ -711,23 +701,34 @@ void Animation::setFacing(const int direction){
 }
 	
 void Animation::reMap(map<Graphics::Color, Graphics::Color> & colors ){
-    /* if they arent are own bitmaps, make them so */
+    /* if they arent are own bitmaps, make them so. the frames are shared
+     * with the animation we were copied from so make a new set.
+     */
     if ( !own_bitmaps ){
-        for ( map<string,Frame*>::iterator it = frames.begin(); it != frames.end(); it++ ){
-            Frame* & xframe = (*it).second;
+        Util::ReferenceCount<AnimationFrames> mine(new AnimationFrames());
+        for ( map<string,Frame*>::iterator it = frameSet->frames.begin(); it != frameSet->frames.end(); it++ ){
+            Frame * xframe = (*it).second;
 
             Graphics::Bitmap * xpic = new Graphics::Bitmap( *(xframe->pic), true );
             ECollide * xcollide = new ECollide( xframe->collide );
 
-            /* oh evil! I am altering a map while iterating over it.
-             * It should be ok, though, since Im altering an element
-             * that already exists.
+            Frame * copy = new Frame( xpic, xcollide );
+            /* the mask was copied, not rebuilt from the remapped pixels */
+            copy->bounds = xframe->bounds;
+            mine->frames[ (*it).first ] = copy;
+
+            /* point at the same frame in the new set, the old set can go
+             * away once nothing else shares it
              */
-            frames[ (*it).first ] = new Frame( xpic, xcollide );
+            if (xframe->pic == current_frame){
+                current_frame = xpic;
+                current_collide = xcollide;
+            }
         }
+        frameSet = mine;
     }
 
-    for ( map<string,Frame*>::iterator it = frames.begin(); it != frames.end(); it++ ){
+    for ( map<string,Frame*>::iterator it = frameSet->frames.begin(); it != frameSet->frames.end(); it++ ){
         Frame * xframe = (*it).second;
 
         Graphics::Bitmap * use = xframe->pic;
@@ -789,35 +790,53 @@ vector<ECollide*> Animation::getNormalCollide(){
     return out;
 }
 
-vector<ECollide*> Animation::getCollide(int facing){
-    double scale = getScale();
-    if (isAttack()){
-        if (changedAttacks){
-            changedAttacks = false;
-            attackCollides.clear();
-            for (vector<Attack>::iterator it = attacks.begin(); it != attacks.end(); it++){
-                Attack & attack = *it;
-                if (attack.getX1() != attack.getX2() && attack.getY1() != attack.getY2()){
-                    /* Have to create our own ECollide structure */
-                    Util::ReferenceCount<ECollide> collide(new ECollide(getWidth(), getHeight()));
-                    EQuad * ac = collide->getHead();
-                    EQuad * adder = new EQuad(attack.getXLen() * scale, attack.getYLen() * scale, NULL);
-                    if (facing == Object::FACING_LEFT){
-                        /* Width is already scaled */
-                        adder->setMinX(getWidth() - attack.getX2() * scale);
-                        adder->setMinY(attack.getY1() * scale);
-                    } else {
-                        adder->setMinX(attack.getX1() * scale);
-                        adder->setMinY(attack.getY1() * scale);
-                    }
+void Animation::getNormalBounds(vector<CollisionBox> & out) const {
+    out.push_back(current_bounds);
+}
 
-                    adder->setFull(true);
-                    ac->addQuad(adder);
+void Animation::updateAttackCollides(int facing){
+    if (!changedAttacks){
+        return;
+    }
 
-                    attackCollides.push_back(collide);
-                }
+    double scale = getScale();
+    changedAttacks = false;
+    attackCollides.clear();
+    attackBounds.clear();
+    for (vector<Attack>::iterator it = attacks.begin(); it != attacks.end(); it++){
+        Attack & attack = *it;
+        if (attack.getX1() != attack.getX2() && attack.getY1() != attack.getY2()){
+            /* Have to create our own ECollide structure */
+            Util::ReferenceCount<ECollide> collide(new ECollide(getWidth(), getHeight()));
+            EQuad * ac = collide->getHead();
+            int width = (int)(attack.getXLen() * scale);
+            int height = (int)(attack.getYLen() * scale);
+            EQuad * adder = new EQuad(width, height, NULL);
+            int minX = 0;
+            int minY = 0;
+            if (facing == Object::FACING_LEFT){
+                /* Width is already scaled */
+                minX = (int)(getWidth() - attack.getX2() * scale);
+                minY = (int)(attack.getY1() * scale);
+            } else {
+                minX = (int)(attack.getX1() * scale);
+                minY = (int)(attack.getY1() * scale);
             }
+            adder->setMinX(minX);
+            adder->setMinY(minY);
+
+            adder->setFull(true);
+            ac->addQuad(adder);
+
+            attackCollides.push_back(collide);
+            attackBounds.push_back(CollisionBox(minX, minY, minX + width, minY + height, getWidth()));
         }
+    }
+}
+
+vector<ECollide*> Animation::getCollide(int facing){
+    if (isAttack()){
+        updateAttackCollides(facing);
 
         vector<ECollide*> out;
         for (vector<Util::ReferenceCount<ECollide> >::iterator it = attackCollides.begin(); it != attackCollides.end(); it++){
@@ -831,6 +850,15 @@ vector<ECollide*> Animation::getCollide(int facing){
     return out;
 }
 
+void Animation::getCollideBounds(int facing, vector<CollisionBox> & out){
+    if (isAttack()){
+        updateAttackCollides(facing);
+        out.insert(out.end(), attackBounds.begin(), attackBounds.end());
+    } else {
+        out.push_back(current_bounds);
+    }
+}
+
 // int Animation::convertKeyPress( const string & key_name ) throw( LoadException ){
 Input::PaintownInput Animation::convertKeyPress( const string & key_name ) {
     // if (key_name == key_names[Keys::Idle]) return Unknown;
@@ -864,9 +892,9 @@ bool Animation::properSequence( const string & seq ){
 			return true;
 	}
 	*/
-	if ( sequences.empty() )
+	if ( script->sequences.empty() )
 		return true;
-	for ( vector< string >::iterator it = sequences.begin(); it != sequences.end(); it++ ){
+	for ( vector< string >::iterator it = script->sequences.begin(); it != script->sequences.end(); it++ ){
 		// cout<<getName()<<": proper sequence with "<<seq<<endl;
 		if ( *it == seq || *it == "none" )
 			return true;
@@ -875,7 +903,7 @@ bool Animation::properSequence( const string & seq ){
 }
 
 bool Animation::hasSequence( const string & seq ){
-    for ( vector< string >::iterator it = sequences.begin(); it != sequences.end(); it++ ){
+    for ( vector< string >::iterator it = script->sequences.begin(); it != script->sequences.end(); it++ ){
         ////  cout<<"Testing has sequence "<<seq<<" against my "<<*it<<endl;
         if ( *it == seq )
             return true;
@@ -893,9 +921,9 @@ bool Animation::hasSequence( const string & seq ){
 Graphics::Bitmap * Animation::getFrame( int x ){
     int i = 0;
     map< string, Frame * >::iterator it;
-    for ( it = frames.begin(); it != frames.end() && i < x; it++, i++ );
+    for ( it = frameSet->frames.begin(); it != frameSet->frames.end() && i < x; it++, i++ );
 
-    if ( it == frames.end() ){
+    if ( it == frameSet->frames.end() ){
         return NULL;
     }
 
@@ -911,29 +939,29 @@ int Animation::getWidth() const {
 }
 
 int Animation::getAverageWidth() const {
-    if (frames.size() == 0){
+    if (frameSet->frames.size() == 0){
         return 0;
     }
 
     int width = 0;
-    for (map<string, Frame*>::const_iterator it = frames.begin(); it != frames.end(); it++){
+    for (map<string, Frame*>::const_iterator it = frameSet->frames.begin(); it != frameSet->frames.end(); it++){
         width += it->second->pic->getWidth();
     }
 
-    return width / frames.size();
+    return width / frameSet->frames.size();
 }
 
 int Animation::getAverageHeight() const {
-    if (frames.size() == 0){
+    if (frameSet->frames.size() == 0){
         return 0;
     }
 
     int width = 0;
-    for (map<string, Frame*>::const_iterator it = frames.begin(); it != frames.end(); it++){
+    for (map<string, Frame*>::const_iterator it = frameSet->frames.begin(); it != frameSet->frames.end(); it++){
         width += it->second->pic->getHeight();
     }
 
-    return width / frames.size();
+    return width / frameSet->frames.size();
 }
 
 int Animation::getHeight() const {
@@ -1004,8 +1032,8 @@ void Animation::jump(double vx, double vy, double vz){
 }
 
 void Animation::contacted(){
-	if ( contact )
-		contact->play();
+	if ( script->contact )
+		script->contact->play();
 }
 
 void Animation::moveX(const int x){
@@ -1051,10 +1079,11 @@ void Animation::setStatus(const int status){
 }
 
 void Animation::setFrame( const string & path ){
-    if ( frames.find(path) != frames.end() ){
-        Frame * x = frames[ path ];
+    if ( frameSet->frames.find(path) != frameSet->frames.end() ){
+        Frame * x = frameSet->frames[ path ];
         current_frame = x->pic;
         current_collide = x->collide;
+        current_bounds = x->bounds;
     } else {
         Global::debug( 0 ) <<"No frame "<<path<<endl;
     }
@@ -1063,15 +1092,16 @@ void Animation::setFrame( const string & path ){
 void Animation::setFrame( const int fr ){
 	map< string, Frame * >::iterator it;
 	int i = 0;
-	for ( it = frames.begin(); it != frames.end() && i < fr; it++, i++ );
+	for ( it = frameSet->frames.begin(); it != frameSet->frames.end() && i < fr; it++, i++ );
 
-	if ( it == frames.end() ){
+	if ( it == frameSet->frames.end() ){
 		Global::debug( 0 ) <<"No frame "<<fr<<endl;
 	}
 
 	Frame * x = (*it).second;
 	current_frame = x->pic;
 	current_collide = x->collide;
+	current_bounds = x->bounds;
 }
 	
 /*
@@ -1091,7 +1121,7 @@ void Animation::setBBox( int x1, int y1, int x2, int y2 ){
 }
 	
 void Animation::reset(){
-    current_event = events.begin();
+    current_event = script->events.begin();
 
     /* set the delay to 0 in case there the animation is reset
      * before it completes
@@ -1107,7 +1137,7 @@ void Animation::reset(){
      * but the animation hasnt changed frames yet, so when it gets drawn
      * current_frame is still equal to the last frame in the animation
      */
-    if (! frames.empty()){
+    if (! frameSet->frames.empty()){
         setFrame( 0 );
     }
 
@@ -1115,7 +1145,7 @@ void Animation::reset(){
      * unfortunately it has the side effect of activating some events like
      * sounds begin played.
      */
-    while (delay_counter <= 0 && current_event != events.end()){
+    while (delay_counter <= 0 && current_event != script->events.end()){
         (*current_event)->Interact( this );
         if ( delay_counter <= 0 )
             current_event++;
@@ -1137,48 +1167,46 @@ bool Animation::Act(){
             current_event++;
         }
     }
-    while (delay_counter <= 0 && current_event != events.end()){
+    while (delay_counter <= 0 && current_event != script->events.end()){
         (*current_event)->Interact(this);
         if (delay_counter <= 0){
             current_event++;
         }
     }
     if (delay_counter <= 0){
-        return current_event == events.end();
+        return current_event == script->events.end();
     }
     return false;
 }
 	
 bool Animation::empty(){
-	return current_event == events.end();
+	return current_event == script->events.end();
 }
 
-Animation::~Animation(){
-    // cout<<"Animation destructor "<<getName()<<":"<<this<<endl;
-    if ( own_events ){
-        // Global::debug( 1 ) << "Destroy animation events" << endl;
-        for ( vector< AnimationEvent * >::iterator it = events.begin(); it != events.end(); it++ )
-            delete *it;
-
-        for ( map<string, Sound * >::iterator it = sounds.begin(); it != sounds.end(); it++ ){
-            delete (*it).second;
-        }
+AnimationScript::AnimationScript():
+contact(NULL){
+}
 
-        delete contact;
+AnimationScript::~AnimationScript(){
+    for ( vector< AnimationEvent * >::iterator it = events.begin(); it != events.end(); it++ ){
+        delete *it;
     }
-    if ( own_bitmaps ){
-        // Global::debug( 1 ) << "Destroy animation bitmaps" << endl;
-        for ( map< string, Frame * >::iterator it = frames.begin(); it != frames.end(); it++ ){
-            Frame * x = (*it).second;
-            // cout<<"Deleting frame "<<x<<" path = "<<x->pic->getPath()<<endl;
-            delete x;
-        }
+
+    for ( map<string, Sound * >::iterator it = sounds.begin(); it != sounds.end(); it++ ){
+        delete (*it).second;
     }
 
-    /*
-    if ( attack_collide )
-        delete attack_collide;
-        */
+    delete contact;
+}
+
+AnimationFrames::~AnimationFrames(){
+    for ( map< string, Frame * >::iterator it = frames.begin(); it != frames.end(); it++ ){
+        delete (*it).second;
+    }
+}
+
+Animation::~Animation(){
+    /* events, sounds and frames go away with the last animation using them */
 }
 
 }
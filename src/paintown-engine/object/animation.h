@@ -9,6 +9,7 @@
 #include <r-tech1/input/input.h>
 #include <r-tech1/graphics/bitmap.h>
 #include "attack.h"
+#include "collision-box.h"
 
 /* is that crazy hat for chicken? */
 
@@ -42,6 +43,8 @@ struct KeyPress{
 struct Frame{
     Graphics::Bitmap * pic;
     ECollide * collide;
+    /* box around the solid part of collide */
+    CollisionBox bounds;
 
     Frame( Graphics::Bitmap * pic, ECollide * e);
     Frame( const Frame & f );
@@ -50,6 +53,37 @@ struct Frame{
     bool mine;
 };
 
+/* everything from the animation definition that doesn't change once it is
+ * loaded. copies of an animation all point at the same script.
+ */
+struct AnimationScript{
+    AnimationScript();
+    ~AnimationScript();
+
+    std::vector< AnimationEvent * > events;
+    std::vector< KeyPress > keys;
+
+    std::string next_sequence, prev_sequence;
+
+    // map< std::string, std::string > sequences;
+    std::vector< std::string > sequences;
+
+    std::map< std::string, Sound * > sounds;
+    Sound * contact;
+
+    std::vector< std::string > disable_animations;
+    std::vector< std::string > enable_animations;
+};
+
+/* the frames of an animation. shared between copies until one of them
+ * remaps its colors.
+ */
+struct AnimationFrames{
+    ~AnimationFrames();
+
+    std::map< std::string, Frame * > frames;
+};
+
 /* stores a sequence of bitmaps along with their collision
  * detection object. 
  */
@@ -91,7 +125,7 @@ public:
 
 	// inline const map<std::string,string> & getSequences() const{
 	inline const std::vector<std::string> & getSequences() const {
-		return sequences;
+		return script->sequences;
 	}
 
 	/* returns true if previous sequence is none or seq */
@@ -194,11 +228,11 @@ public:
 	const std::string getCurrentFramePath() const;
 
 	inline const std::vector<std::string> & getDecommisions() const {
-		return disable_animations;
+		return script->disable_animations;
 	}
 
 	inline const std::vector<std::string> & getCommisions() const {
-		return enable_animations;
+		return script->enable_animations;
 	}
 
         bool isPerpetual() const;
@@ -232,15 +266,15 @@ public:
 	}
 
 	inline const std::string & getPreviousSequence() const{
-		return prev_sequence;
+		return script->prev_sequence;
 	}
 
 	inline const std::string & getNextSequence() const{	
-		return next_sequence;
+		return script->next_sequence;
 	}
 
 	inline const std::vector<KeyPress> & getKeys() const{
-		return keys;
+		return script->keys;
 	}
 
 	inline void setAttacks(const std::vector<Attack> & a){
@@ -262,6 +296,11 @@ public:
 
         std::vector<ECollide*> getCollide(int facing);
         std::vector<ECollide*> getNormalCollide();
+        /* bounding boxes of the masks returned by getCollide/getNormalCollide,
+         * in the same order.
+         */
+        void getCollideBounds(int facing, std::vector<CollisionBox> & out);
+        void getNormalBounds(std::vector<CollisionBox> & out) const;
 	void Draw(int x, int y, Remap * remap, Graphics::Bitmap * work );
 	void DrawFlipped( int x, int y, Remap * remap, Graphics::Bitmap * work );
 	void DrawLit( int x, int y, Remap * remap, Graphics::Bitmap * work );
@@ -280,7 +319,7 @@ public:
         void setHittable(bool b);
 
         virtual const std::vector<AnimationEvent*> & getEvents(){
-            return events;
+            return script->events;
         }
 
     virtual AnimationTrail * makeTrail(const int x, const int y, const int facing, const int life) const;
@@ -302,6 +341,9 @@ protected:
 	void doDraw(int x, int y, const Graphics::Bitmap & frame, Remap * remap, Graphics::Bitmap * work);
 	void doDrawFlipped(int x, int y, const Graphics::Bitmap & frame, Remap * remap, Graphics::Bitmap * work);
 
+        /* rebuild the attack masks if the attacks changed */
+        void updateAttackCollides(int facing);
+
 protected:
         std::string name;
 	bool loop;
@@ -310,6 +352,7 @@ protected:
 
         Graphics::Bitmap * current_frame;
 	ECollide * current_collide;
+        CollisionBox current_bounds;
 	// ECollide * attack_collide;
 	double delay;
 	double delay_counter;
@@ -326,21 +369,14 @@ protected:
 	/* I dont think we need range_x/range_y */
 	int range_x, range_y;
 
-        std::vector< AnimationEvent * > events;
+        Util::ReferenceCount<AnimationScript> script;
+        Util::ReferenceCount<AnimationFrames> frameSet;
         std::vector< AnimationEvent * >::iterator current_event;
-        std::map< std::string, Frame * > frames;
-        std::vector< KeyPress > keys;
-
-        std::string next_sequence, prev_sequence;
-
-	// map< std::string, std::string > sequences;
-        std::vector< std::string > sequences;
 
 	/* range of the attack in X direction */
 	int range;
 
 	bool own_bitmaps;
-	bool own_events;
 	bool is_attack;
 	int status;
 
@@ -350,15 +386,10 @@ protected:
 	/* can we use this animation? */
 	bool commision;
 
-        std::map< std::string, Sound * > sounds;
-	Sound * contact;
-
-        std::vector< std::string > disable_animations;
-        std::vector< std::string > enable_animations;
-
         bool changedAttacks;
         std::vector<Attack> attacks;
         std::vector<Util::ReferenceCount<ECollide> > attackCollides;
+        std::vector<CollisionBox> attackBounds;
 };
 
 }
@@ -2,6 +2,7 @@
 #include "animation_trail.h"
 #include "character.h"
 #include "object.h"
+#include "../game/blend-lock.h"
 
 namespace Paintown{
 
@@ -23,6 +24,7 @@ void AnimationTrail::draw(int rel_x, Remap * remap, Graphics::Bitmap * work) con
     int w = sprite.getWidth() / 2;
     int h = sprite.getHeight();
 
+    BlendLock blend;
     Graphics::Bitmap::transBlender(0, 0, 0, life * 255 / max_life);
     if (facing == Object::FACING_RIGHT){
         sprite.translucent().draw(x-w - rel_x, y-h, remap, *work);
@@ -28,6 +28,7 @@
 #include "object_attack.h"
 #include "stimulation.h"
 #include "draw-effect.h"
+#include "../game/blend-lock.h"
 #include "gib.h"
 
 #include "../factory/shadow.h"
@@ -41,14 +42,16 @@ namespace Paintown{
     
 Remap::Remap(const Filesystem::RelativePath & from, const Filesystem::RelativePath & to):
 remapFrom(from),
-remapTo(to){
+remapTo(to),
+created(false){
     colors = computeRemapColors(from, to);
 }
 
 Remap::Remap(const Remap & copy):
 remapFrom(copy.remapFrom),
 remapTo(copy.remapTo),
-colors(copy.colors){
+colors(copy.colors),
+created(false){
 }
 
 Remap::~Remap(){
@@ -120,8 +123,12 @@ void Remap::setupShader(const Util::ReferenceCount<Graphics::Shader> & what){
 }
 
 Util::ReferenceCount<Graphics::Shader> Remap::getShader(){
-    if (shader == NULL){
+    /* the shader is null without allegro5, so remember that it was made
+     * instead of making it again on every draw
+     */
+    if (!created){
         shader = create();
+        created = true;
     }
     return shader;
 }
@@ -189,9 +196,6 @@ speed( 1 ),
 linked( NULL ),
 moving( 0 ),
 current_map( 0 ),
-die_sound( NULL ),
-landed_sound( NULL ),
-squish_sound( NULL ),
 invincibility(0),
 toughness( 10 ),
 explode( false ),
@@ -221,9 +225,6 @@ speed( 1 ),
 linked( NULL ),
 moving( 0 ),
 current_map( 0 ),
-die_sound( NULL ),
-landed_sound( NULL ),
-squish_sound( NULL ),
 invincibility( 0 ),
 toughness( 10 ),
 explode( false ),
@@ -254,9 +255,6 @@ speed( 1 ),
 linked( NULL ),
 moving( 0 ),
 current_map( 0 ),
-die_sound( NULL ),
-landed_sound( NULL ),
-squish_sound( NULL ),
 invincibility( 0 ),
 toughness( 10 ),
 explode( false ),
@@ -278,9 +276,6 @@ death( 0 ),
 thrown_status( false ),
 moving( 0 ),
 current_map( chr.current_map ),
-die_sound( NULL ),
-landed_sound( NULL ),
-squish_sound( NULL ),
 explode( false ),
 draw_shadow( true ),
 trail_generator(chr.trail_generator),
@@ -323,16 +318,12 @@ spriteScale(chr.spriteScale){
         addEffect(effect->copy(this));
     }
 
-    if ( chr.die_sound != NULL ) 
-        die_sound = new Sound(*(chr.die_sound));
-
-    if ( chr.landed_sound != NULL ){
-        landed_sound = new Sound(*(chr.landed_sound));
-    }
-
-    if ( chr.squish_sound != NULL ){
-        squish_sound = new Sound(*(chr.squish_sound));
-    }
+    /* the sounds and remaps are only read after loading, so share them with
+     * the character we are copying instead of duplicating them.
+     */
+    die_sound = chr.die_sound;
+    landed_sound = chr.landed_sound;
+    squish_sound = chr.squish_sound;
 
     for ( map<string,Util::ReferenceCount<Animation> >::const_iterator it = chr.movements.begin(); it != chr.movements.end(); it++ ){
         const Util::ReferenceCount<Animation> & ani_copy = (*it).second;
@@ -345,31 +336,7 @@ spriteScale(chr.spriteScale){
        animation_current = movements[ "idle" ];
        */
 
-    /* Copy the movements */
-    const map<int, Remap*> & his_mapper = chr.getMapper();
-    for (map<int, Remap*>::const_iterator it = his_mapper.begin(); it != his_mapper.end(); it++ ){
-        int id = (*it).first;
-        Remap * remap = (*it).second;
-        if (remap != NULL){
-            mapper[id] = new Remap(*remap);
-        } else {
-            mapper[id] = NULL;
-        }
-
-        /*
-           const map<string,Animation*> & his = (*it).second;
-           map< string, Animation * > & mine = mapper[ id ];
-
-           for ( map<string,Animation*>::const_iterator m_it = his.begin(); m_it != his.end(); m_it++ ){
-           if ( (*m_it).second != NULL ){
-           const Animation * const & ani_copy = (*m_it).second;
-        // Animation * ani_copy = (*m_it).second;
-
-        mine[ ani_copy->getName() ] = new Animation( *ani_copy, this );
-        }
-        }
-        */
-    }
+    mapper = chr.getMapper();
 
     animation_current = getMovement("idle");
 
@@ -590,21 +557,31 @@ void Character::setSpriteScale(double scale){
     spriteScale = scale;
 }
 
+/* copies share their remaps, so the shader can't be made by whichever
+ * view draws the remap first.
+ */
+void Character::prepareDraw(){
+    Remap * remap = getCurrentRemap();
+    if (remap != NULL){
+        remap->getShader();
+    }
+}
+
 void Character::addRemap(Remap * remap){
-    mapper[mapper.size()] = remap;
+    mapper[mapper.size()] = Util::ReferenceCount<Remap>(remap);
 }
     
 Remap * Character::getCurrentRemap() const {
-    map<int, Remap*>::const_iterator find = getMapper().find(getCurrentMap());
+    map<int, Util::ReferenceCount<Remap> >::const_iterator find = getMapper().find(getCurrentMap());
     if (find != getMapper().end()){
-        return find->second;
+        return find->second.raw();
     }
     return NULL;
 }
         
 bool Character::newRemap(const std::string & from, const std::string & to){
-    for (map<int, Remap*>::iterator it = mapper.begin(); it != mapper.end(); it++){
-        Remap * remap = it->second;
+    for (map<int, Util::ReferenceCount<Remap> >::iterator it = mapper.begin(); it != mapper.end(); it++){
+        const Util::ReferenceCount<Remap> & remap = it->second;
         if (remap != NULL){
             if (remap->getFrom().path() == from &&
                 remap->getTo().path() == to){
@@ -1021,7 +998,7 @@ void Character::takeDamage(World & world, ObjectAttack * obj, int damage, double
         setHealth(1);
         Global::debug(1) << this << " set death to 1. Health " << getHealth() << endl;
 
-        if (die_sound){
+        if (die_sound != NULL){
             die_sound->play();
         }
     }
@@ -1109,7 +1086,7 @@ void Character::landed( World * world ){
 
     switch (getStatus()){
         case Status_Falling : {
-            if ( landed_sound ){
+            if ( landed_sound != NULL ){
                 landed_sound->play();
             }
 
@@ -1124,7 +1101,7 @@ void Character::landed( World * world ){
         }
         case Status_Fell : {
 
-            if ( landed_sound ){
+            if ( landed_sound != NULL ){
                 landed_sound->play();
             }
 
@@ -1523,11 +1500,20 @@ bool Character::realCollision( ObjectAttack * obj ){
     vector<ECollide*> myCollides = this->getNormalCollide();
     vector<ECollide*> himCollides = obj->getCollide();
 
-    for (vector<ECollide*>::iterator mine = myCollides.begin(); mine != myCollides.end(); mine++){
-        for (vector<ECollide*>::iterator him = himCollides.begin(); him != himCollides.end(); him++){
+    /* boxes around the masks let us skip the pixel test for most pairs. only
+     * use them if both sides know the bounds of every mask.
+     */
+    vector<CollisionBox> myBounds;
+    vector<CollisionBox> himBounds;
+    this->getNormalBounds(myBounds);
+    obj->getCollideBounds(himBounds);
+    bool useBounds = myBounds.size() == myCollides.size() && himBounds.size() == himCollides.size();
 
-            ECollide * myCollide = *mine;
-            ECollide * hisCollide = *him;
+    for (unsigned int mine = 0; mine < myCollides.size(); mine++){
+        for (unsigned int him = 0; him < himCollides.size(); him++){
+
+            ECollide * myCollide = myCollides[mine];
+            ECollide * hisCollide = himCollides[him];
             // cout << "Obj attacking with " << obj->getAttackName() << " my collide = " << myCollide << " his collide = " << hisCollide << endl;
             if (myCollide != 0 && hisCollide){
                 bool my_xflip = false;
@@ -1575,6 +1561,10 @@ bool Character::realCollision( ObjectAttack * obj ){
                 // cout<<"Mx: "<<mx<< " My: "<<my<<" Width: "<<myCollide->getWidth()<<" Height: "<<myCollide->getHeight()<<endl;
                 // cout<<"Ax: "<<ax<< " Ay: "<<ay<<" Width: "<<hisCollide->getWidth()<<" Height: "<<hisCollide->getHeight()<<endl;
 
+                if (useBounds && !myBounds[mine].overlaps(mx, my, my_xflip, himBounds[him], ax, ay, his_xflip)){
+                    continue;
+                }
+
                 bool b = myCollide->Collision( hisCollide, mx, my, ax, ay, my_xflip, false, his_xflip, false );
                 /*
                    if ( b && false ){
@@ -1628,6 +1618,7 @@ void Character::drawLifeBar(int x, int y, Graphics::Bitmap * work){
 /* draw a nifty translucent life bar */
 /* FIXME: make this customizable */
 void Character::drawLifeBar(int x, int y, int health, Graphics::Bitmap * work){
+    BlendLock blend;
     Graphics::TranslucentBitmap translucent(*work);
     Graphics::Bitmap::transBlender( 0, 0, 0, 128 );
     const int health_height = 7;
@@ -1933,6 +1924,7 @@ const Graphics::Bitmap * Character::getCurrentFrame() const {
 void Character::drawReflection(Graphics::Bitmap * work, int rel_x, int rel_y, int intensity){
     const Graphics::Bitmap * frame = this->getCurrentFrame();
     if (frame){
+        BlendLock blend;
         Graphics::Bitmap::transBlender(0, 0, 0, intensity);
         int x = (int)((getRX() - rel_x) - frame->getWidth()/2);
         int y = (int)(getRZ() + getY());
@@ -1948,6 +1940,7 @@ void Character::drawReflection(Graphics::Bitmap * work, int rel_x, int rel_y, in
 void Character::drawOutline(Graphics::Bitmap * work, int rel_x, int rel_y, int red, int green, int blue, int intensity){
     const Graphics::Bitmap * frame = this->getCurrentFrame();
     if (frame){
+        BlendLock blend;
         Graphics::Bitmap::transBlender(red, green, blue, intensity);
         int x = (int)((getRX() - rel_x) - frame->getWidth()/2);
         int y = (int)(getRZ() + getY());
@@ -1967,6 +1960,8 @@ void Character::drawShade(Graphics::Bitmap * work, int rel_x, int intensity, Gra
         int x = (int)(getRX() - rel_x - bmp->getWidth()/2);
         int y = (int)(getRZ() + getY() * scale);
 
+        /* draws with a blender */
+        BlendLock blend;
         bmp->drawShadow(*work, x, y, intensity, color, scale, getFacing() == FACING_RIGHT);
 
 #if 0
@@ -2061,6 +2056,31 @@ vector<ECollide*> Character::getNormalCollide() const {
     return vector<ECollide*>();
 }
 
+void Character::getCollideBounds(vector<CollisionBox> & out) const {
+    if (animation_current != NULL){
+        animation_current->getCollideBounds(getFacing(), out);
+    }
+}
+
+void Character::getNormalBounds(vector<CollisionBox> & out) const {
+    if (animation_current != NULL){
+        animation_current->getNormalBounds(out);
+    }
+}
+
+/* the normal mask is the size of the current frame and is placed the same
+ * way realCollision places it.
+ */
+bool Character::getHittableExtent(int & x1, int & x2) const {
+    if (animation_current == NULL){
+        return false;
+    }
+
+    x1 = getRX() - getWidth() / 2 - 1;
+    x2 = getRX() - getWidth() / 2 + getWidth() + 1;
+    return true;
+}
+
 void Character::print() const{
     Global::debug(0) <<"Name: "<<name<<endl;
     Global::debug(0) <<"Health: "<<getHealth()<<endl;
@@ -2079,11 +2099,6 @@ Character::~Character(){
         }
     }
 
-    for ( map< int, Remap*>::iterator it = mapper.begin(); it != mapper.end(); it++ ){
-        Remap * remap = (*it).second;
-        delete remap;
-    }
-
     for (vector<AnimationTrail*>::iterator it = trails.begin(); it != trails.end(); it++){
         delete (*it);
     }
@@ -2092,10 +2107,6 @@ Character::~Character(){
         delete (*it);
     }
 
-    delete die_sound;
-    delete landed_sound;
-    delete squish_sound;
-
     /*
        for ( map<string,Animation*>::iterator it = movements.begin(); it != movements.end(); it++ ){
        Animation *& aa = (*it).second;
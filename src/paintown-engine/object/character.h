@@ -97,6 +97,7 @@ protected:
     Filesystem::RelativePath remapFrom;
     Filesystem::RelativePath remapTo;
     std::map<Graphics::Color, Graphics::Color> colors;
+    bool created;
 
     Util::ReferenceCount<Graphics::Shader> shader;
 };
@@ -120,6 +121,7 @@ public:
 
     /* drawing */
     virtual void draw( Graphics::Bitmap * work, int rel_x, int rel_y );
+    virtual void prepareDraw();
 
     /* intensity is the amount of alpha blending to do.
      * 0 = translucent
@@ -305,6 +307,8 @@ public:
 
     /* collision detection object */
     virtual std::vector<ECollide*> getCollide() const;
+    virtual void getCollideBounds(std::vector<CollisionBox> & out) const;
+    virtual bool getHittableExtent(int & x1, int & x2) const;
 
     inline Object * getLink(){
         return linked;
@@ -316,7 +320,7 @@ public:
 
     virtual Remap * getCurrentRemap() const;
 
-    inline const std::map< int, Remap*> & getMapper() const {
+    inline const std::map< int, Util::ReferenceCount<Remap> > & getMapper() const {
         return mapper;
     }
 
@@ -467,6 +471,7 @@ protected:
     virtual void drawLifeBar( int x, int y, int he, Graphics::Bitmap * work );
 
     virtual std::vector<ECollide*> getNormalCollide() const;
+    virtual void getNormalBounds(std::vector<CollisionBox> & out) const;
 
     /* helper functions */
 
@@ -549,13 +554,16 @@ protected:
     unsigned int current_map;
     /* map from id to map of animations */
     // std::map< int, std::map<std::string, Animation*> > mapper;
-    std::map<int, Remap*> mapper;
+    /* remaps never change once they are loaded so copies of a character
+     * share them.
+     */
+    std::map<int, Util::ReferenceCount<Remap> > mapper;
     std::vector< Object * > projectiles;
     std::vector< BodyPart > body_parts;
 
-    Sound * die_sound;
-    Sound * landed_sound;
-    Sound * squish_sound;
+    Util::ReferenceCount<Sound> die_sound;
+    Util::ReferenceCount<Sound> landed_sound;
+    Util::ReferenceCount<Sound> squish_sound;
     int invincibility;
     int toughness;
     bool explode;
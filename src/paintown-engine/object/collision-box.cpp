@@ -0,0 +1,89 @@
+#include <vector>
+#include <r-tech1/graphics/bitmap.h>
+#include "collision-box.h"
+
+using namespace std;
+
+namespace Paintown{
+
+CollisionBox::CollisionBox():
+x1(0),
+y1(0),
+x2(-1),
+y2(-1),
+width(0),
+empty(true){
+}
+
+CollisionBox::CollisionBox(int x1, int y1, int x2, int y2, int width):
+x1(x1),
+y1(y1),
+x2(x2),
+y2(y2),
+width(width),
+empty(x2 < x1 || y2 < y1){
+}
+
+CollisionBox CollisionBox::fromBitmap(Graphics::Bitmap & bitmap){
+    int minX = bitmap.getWidth();
+    int minY = bitmap.getHeight();
+    int maxX = -1;
+    int maxY = -1;
+
+    vector<Graphics::Color> line;
+    for (int y = 0; y < bitmap.getHeight(); y++){
+        line.clear();
+        bitmap.readLine(line, y);
+        for (unsigned int x = 0; x < line.size(); x++){
+            if (line[x] != Graphics::MaskColor()){
+                if ((int) x < minX){
+                    minX = x;
+                }
+                if ((int) x > maxX){
+                    maxX = x;
+                }
+                if (y < minY){
+                    minY = y;
+                }
+                maxY = y;
+            }
+        }
+    }
+
+    return CollisionBox(minX, minY, maxX, maxY, bitmap.getWidth());
+}
+
+int CollisionBox::left(int x, bool flip) const {
+    if (flip){
+        return x + width - x2 - 2;
+    }
+    return x + x1 - 1;
+}
+
+int CollisionBox::right(int x, bool flip) const {
+    if (flip){
+        return x + width - x1 + 1;
+    }
+    return x + x2 + 1;
+}
+
+bool CollisionBox::overlaps(int x, int y, bool flip, const CollisionBox & him, int hx, int hy, bool hisFlip) const {
+    if (isEmpty() || him.isEmpty()){
+        return false;
+    }
+
+    if (right(x, flip) < him.left(hx, hisFlip) ||
+        him.right(hx, hisFlip) < left(x, flip)){
+        return false;
+    }
+
+    /* masks are never flipped vertically */
+    if (y + y2 + 1 < hy + him.y1 - 1 ||
+        hy + him.y2 + 1 < y + y1 - 1){
+        return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,47 @@
+#ifndef _paintown_collision_box_h
+#define _paintown_collision_box_h
+
+namespace Graphics{
+class Bitmap;
+}
+
+namespace Paintown{
+
+/* Axis aligned box around the solid part of a collision mask. Coordinates
+ * are relative to the upper left corner of the mask and are inclusive.
+ * Used to throw out pairs of masks that can't touch before doing the
+ * per-pixel ECollide test.
+ */
+class CollisionBox{
+public:
+    /* an empty box, nothing can collide with it */
+    CollisionBox();
+    /* width is the width of the whole mask, needed to mirror the box */
+    CollisionBox(int x1, int y1, int x2, int y2, int width);
+
+    /* box around all the non-masked pixels of a bitmap */
+    static CollisionBox fromBitmap(Graphics::Bitmap & bitmap);
+
+    inline bool isEmpty() const {
+        return empty;
+    }
+
+    /* left/right edge when the mask is placed at x. the edges are padded
+     * by a pixel so that rounding in the flipped mask test can't make us
+     * reject a real collision.
+     */
+    int left(int x, bool flip) const;
+    int right(int x, bool flip) const;
+
+    /* true if this box placed at x/y might touch `him' placed at hx/hy */
+    bool overlaps(int x, int y, bool flip, const CollisionBox & him, int hx, int hy, bool hisFlip) const;
+
+protected:
+    int x1, y1, x2, y2;
+    int width;
+    bool empty;
+};
+
+}
+
+#endif
@@ -128,8 +128,8 @@ forceQuit(false){
 
 void DisplayCharacterLoader::load(){
     Global::debug(1, PAINTOWN_DEBUG_CONTEXT) << "Starting display character loader" << endl;
-    while (!done()){
-        DisplayCharacter * character = nextCharacter();
+    DisplayCharacter * character = nextCharacter();
+    while (character != NULL){
         try{
             character->load();
             character->loadDone();
@@ -140,6 +140,7 @@ void DisplayCharacterLoader::load(){
         }
         /* yield the timeslice for slow systems */
         Util::rest(0);
+        character = nextCharacter();
     }
     Global::debug(1, PAINTOWN_DEBUG_CONTEXT) << "Character display loader done" << endl;
 }
@@ -158,8 +159,10 @@ void DisplayCharacterLoader::stop(){
 
 DisplayCharacter * DisplayCharacterLoader::nextCharacter(){
     Util::Thread::ScopedLock locked(data_lock);
-    DisplayCharacter * result = NULL;
-    result = characters.front();
+    if (forceQuit || characters.size() == 0){
+        return NULL;
+    }
+    DisplayCharacter * result = characters.front();
     characters.erase(characters.begin());
     return result;
 }
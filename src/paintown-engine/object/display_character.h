@@ -39,7 +39,9 @@ public:
     /* load all the characters asynchronously */
     DisplayCharacterLoader(const std::vector<DisplayCharacter*> & characters);
 
-    /* start loading */
+    /* start loading. several threads can call this at once, each one
+     * takes the next character nobody has started on yet.
+     */
     void load();
 
     /* stop loading */
@@ -53,6 +55,7 @@ public:
 
     virtual ~DisplayCharacterLoader();
 protected:
+    /* NULL once there is nothing left to load */
     DisplayCharacter * nextCharacter();
 
     std::vector<DisplayCharacter*> characters;
@@ -4,6 +4,7 @@
 #include "globals.h"
 #include <math.h>
 #include "object.h"
+#include "../game/blend-lock.h"
 #include <r-tech1/graphics/bitmap.h>
 #include <r-tech1/funcs.h>
 
@@ -73,6 +74,7 @@ void DrawGlowEffect::draw(int x, Remap * remap, Graphics::Bitmap * work){
     int color_g = (int)((Graphics::getGreen(endColor) - Graphics::getGreen(startColor)) * f + Graphics::getGreen(startColor));
     int color_b = (int)((Graphics::getBlue(endColor) - Graphics::getBlue(startColor)) * f + Graphics::getBlue(startColor));
 
+    BlendLock blend;
     Graphics::Bitmap::transBlender(color_r, color_g, color_b, alpha);
 
     Util::ReferenceCount<Animation> animation = owner->getCurrentMovement();
@@ -5,6 +5,7 @@
 #include "object_nonattack.h"
 #include "gib.h"
 #include "globals.h"
+#include "../game/blend-lock.h"
 #include <math.h>
 
 namespace Paintown{
@@ -34,6 +35,7 @@ bloodImage(g.bloodImage){
 
 void Gib::draw(Graphics::Bitmap * work, int rel_x, int rel_y){
     if (fade > 0){
+        BlendLock blend;
         // Bitmap::dissolveBlender( 0, 0, 0, 255 - fade );
         Graphics::Bitmap::transBlender(0, 0, 0, 255 - fade);
         image.translucent().draw(getRX() - rel_x - image.getWidth() / 2, getRY() - image.getHeight() / 2, *work);
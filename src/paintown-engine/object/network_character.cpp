@@ -156,7 +156,7 @@ void NetworkCharacter::landed( World * world ){
     setThrown( false );
     switch (getStatus()){
         case Status_Falling : {
-            if (landed_sound){
+            if (landed_sound != NULL){
                 landed_sound->play();
             }
 
@@ -286,6 +286,9 @@ void Object::takeDamage(World & world, ObjectAttack * obj, int x, double forceX,
 	
 void Object::drawFront(Graphics::Bitmap * work, int rel_x){
 }
+
+void Object::prepareDraw(){
+}
         
 void Object::drawReflection(Graphics::Bitmap * work, int rel_x, int rel_y, int intensity){
 }
@@ -299,6 +302,44 @@ void Object::touch( Object * obj ){
 vector<ECollide*> Object::getCollide() const {
     return vector<ECollide*>();
 }
+
+void Object::getCollideBounds(vector<CollisionBox> & out) const {
+}
+
+bool Object::getHittableExtent(int & x1, int & x2) const {
+    return false;
+}
+
+bool Object::getAttackExtent(int & x1, int & x2) const {
+    vector<CollisionBox> bounds;
+    getCollideBounds(bounds);
+    if (bounds.empty()){
+        return false;
+    }
+
+    /* same placement that Character::realCollision uses for the attacker */
+    int x = getRX() - getWidth() / 2;
+    bool flip = getFacing() == FACING_LEFT;
+    /* if every box is empty the range stays empty and nothing is near */
+    x1 = 0;
+    x2 = -1;
+    bool first = true;
+    for (vector<CollisionBox>::iterator it = bounds.begin(); it != bounds.end(); it++){
+        const CollisionBox & box = *it;
+        if (box.isEmpty()){
+            continue;
+        }
+        if (first || box.left(x, flip) < x1){
+            x1 = box.left(x, flip);
+        }
+        if (first || box.right(x, flip) > x2){
+            x2 = box.right(x, flip);
+        }
+        first = false;
+    }
+
+    return true;
+}
         
 bool Object::touchPoint(int x, int y){
     return false;
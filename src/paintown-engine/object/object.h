@@ -6,6 +6,7 @@
 #include <r-tech1/sound/sound.h>
 #include <r-tech1/pointer.h>
 #include "trigger.h"
+#include "collision-box.h"
 #include <string>
 #include <vector>
 #include <map>
@@ -61,6 +62,10 @@ public:
 	 */
 	virtual void draw(Graphics::Bitmap * work, int rel_x, int rel_y) = 0;
 	virtual void drawFront(Graphics::Bitmap * work, int rel_x);
+        /* make anything that draw() would create lazily. called on the main
+         * thread before the views of a world are drawn at the same time.
+         */
+        virtual void prepareDraw();
         /* draw reflection. default behavior is to do nothing */
         virtual void drawReflection(Graphics::Bitmap * work, int rel_x, int rel_y, int intensity);
 
@@ -125,6 +130,25 @@ public:
 	 */
 	virtual std::vector<ECollide*> getCollide() const;
 
+	/* getCollideBounds
+	 * Adds the bounding box of each mask returned by getCollide(), in the
+	 * same order. Objects that add nothing always get the full pixel test.
+	 */
+	virtual void getCollideBounds(std::vector<CollisionBox> & out) const;
+
+	/* getHittableExtent
+	 * The x range that the masks used by collision() can cover. Returns false
+	 * if the object can't tell, in which case it has to be checked against
+	 * every attacker.
+	 */
+	virtual bool getHittableExtent(int & x1, int & x2) const;
+
+	/* getAttackExtent
+	 * The x range covered by the masks from getCollide() when another object
+	 * tests against them. Returns false if the bounds aren't known.
+	 */
+	bool getAttackExtent(int & x1, int & x2) const;
+
 	virtual double currentDamage() const {
 		return damage;
 	}
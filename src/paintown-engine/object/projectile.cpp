@@ -7,6 +7,7 @@
 #include "projectile.h"
 #include "object_attack.h"
 #include "../game/world.h"
+#include "../game/blend-lock.h"
 #include "alliance.h"
 #include "animation.h"
 #include <iostream>
@@ -129,6 +130,7 @@ void Projectile::draw( Graphics::Bitmap * work, int rel_x, int rel_y ){
 
 void Projectile::drawReflection(Graphics::Bitmap * work, int rel_x, int rel_y, int intensity){
     if (currentAnimation){
+        BlendLock blend;
         Graphics::Bitmap::transBlender( 0, 0, 0, intensity );
 
         int x = (int)((getRX() - rel_x) - currentAnimation->getCurrentFrame()->getWidth()/2);
@@ -155,6 +157,10 @@ vector<ECollide*> Projectile::getCollide() const {
     return currentAnimation->getCollide(getFacing());
 }
 
+void Projectile::getCollideBounds(vector<CollisionBox> & out) const {
+    currentAnimation->getCollideBounds(getFacing(), out);
+}
+
 Object * Projectile::copy(){
     return new Projectile(this);
 }
@@ -31,6 +31,7 @@ public:
         virtual double getForceX() const;
         virtual double getForceY() const;
 	virtual std::vector<ECollide*> getCollide() const;
+	virtual void getCollideBounds(std::vector<CollisionBox> & out) const;
 	virtual bool isCollidable( Object * obj );
 	virtual bool isGettable();
 	virtual int getWidth() const;
@@ -0,0 +1,123 @@
+#include <r-tech1/thread.h>
+#include <r-tech1/debug.h>
+#include "thread-pool.h"
+
+using namespace std;
+
+namespace System{
+
+ThreadPool::Job::Job(){
+}
+
+ThreadPool::Job::~Job(){
+}
+
+ThreadPool::ThreadPool(int threads):
+jobs(NULL),
+next(0),
+quit(false){
+    Util::Thread::initializeSemaphore(&start, 0);
+    Util::Thread::initializeSemaphore(&finished, 0);
+
+    for (int i = 1; i < threads; i++){
+        Util::Thread::Id thread;
+        if (Util::Thread::createThread(&thread, NULL, (Util::Thread::ThreadFunction) work, this)){
+            workers.push_back(thread);
+        } else {
+            Global::debug(0) << "Could not create a pool thread" << endl;
+            break;
+        }
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        Util::Thread::ScopedLock scoped(lock);
+        quit = true;
+    }
+
+    for (unsigned int i = 0; i < workers.size(); i++){
+        Util::Thread::semaphoreIncrease(&start);
+    }
+
+    for (vector<Util::Thread::Id>::iterator it = workers.begin(); it != workers.end(); it++){
+        Util::Thread::joinThread(*it);
+    }
+
+    Util::Thread::destroySemaphore(&start);
+    Util::Thread::destroySemaphore(&finished);
+}
+
+ThreadPool::Job * ThreadPool::nextJob(){
+    Util::Thread::ScopedLock scoped(lock);
+    if (jobs == NULL || next >= jobs->size()){
+        return NULL;
+    }
+    Job * job = (*jobs)[next];
+    next += 1;
+    return job;
+}
+
+void * ThreadPool::work(void * self_){
+    ThreadPool * self = (ThreadPool*) self_;
+    while (true){
+        Util::Thread::semaphoreDecrease(&self->start);
+
+        {
+            Util::Thread::ScopedLock scoped(self->lock);
+            if (self->quit){
+                return NULL;
+            }
+        }
+
+        /* a worker can wake up after all the jobs were taken, in which
+         * case there is nothing to do.
+         */
+        Job * job = self->nextJob();
+        while (job != NULL){
+            job->run();
+            Util::Thread::semaphoreIncrease(&self->finished);
+            job = self->nextJob();
+        }
+    }
+
+    return NULL;
+}
+
+void ThreadPool::run(const vector<Job*> & jobs){
+    if (jobs.empty()){
+        return;
+    }
+
+    {
+        Util::Thread::ScopedLock scoped(lock);
+        this->jobs = &jobs;
+        next = 0;
+    }
+
+    unsigned int wake = jobs.size() - 1;
+    if (wake > workers.size()){
+        wake = workers.size();
+    }
+    for (unsigned int i = 0; i < wake; i++){
+        Util::Thread::semaphoreIncrease(&start);
+    }
+
+    unsigned int mine = 0;
+    Job * job = nextJob();
+    while (job != NULL){
+        job->run();
+        mine += 1;
+        job = nextJob();
+    }
+
+    /* wait for the jobs the workers took */
+    for (unsigned int i = mine; i < jobs.size(); i++){
+        Util::Thread::semaphoreDecrease(&finished);
+    }
+
+    Util::Thread::ScopedLock scoped(lock);
+    this->jobs = NULL;
+}
+
+}
@@ -0,0 +1,57 @@
+#ifndef _paintown_system_thread_pool_h
+#define _paintown_system_thread_pool_h
+
+#include <vector>
+#include <r-tech1/thread.h>
+
+namespace System{
+
+/* A few threads that stay alive between calls to run() and do independent
+ * jobs at the same time, such as drawing the views of the world or loading
+ * characters. The thread calling run() does jobs too, so a pool of size n
+ * uses n threads in total.
+ */
+class ThreadPool{
+public:
+    class Job{
+    public:
+        Job();
+        virtual ~Job();
+
+        virtual void run() = 0;
+    };
+
+    explicit ThreadPool(int threads);
+    virtual ~ThreadPool();
+
+    /* run all the jobs and return once they have all finished. jobs can
+     * run in any order, so each one should only write to its own data.
+     */
+    void run(const std::vector<Job*> & jobs);
+
+    inline int size() const {
+        return workers.size() + 1;
+    }
+
+protected:
+    static void * work(void * self);
+
+    /* take the next job, NULL if there aren't any left */
+    Job * nextJob();
+
+    std::vector<Util::Thread::Id> workers;
+
+    /* one count per worker that should wake up */
+    Util::Thread::Semaphore start;
+    /* one count per job a worker finished */
+    Util::Thread::Semaphore finished;
+
+    Util::Thread::LockObject lock;
+    const std::vector<Job*> * jobs;
+    unsigned int next;
+    bool quit;
+};
+
+}
+
+#endif
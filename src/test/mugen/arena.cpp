@@ -0,0 +1,118 @@
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <list>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/timedifference.h"
+#include "util/file-system.h"
+#include "mugen/arena.h"
+#include "mugen/character.h"
+#include "mugen/config.h"
+#include "mugen/stage.h"
+#include "mugen/parse-cache.h"
+#include "mugen/parser/all.h"
+#include "mugen/ast/all.h"
+
+/* Shows how much of a character ends up in its arena, then times parsing and
+ * deleting one of its command files with the nodes in an arena and on the
+ * heap.
+ *
+ *   arena [rounds] [character] [cmd file]
+ */
+
+using namespace std;
+
+typedef list<Ast::Section*> Sections;
+
+static string readFile(const string & path){
+    ifstream input(path.c_str(), ios::in | ios::binary);
+    ostringstream out;
+    out << input.rdbuf();
+    return out.str();
+}
+
+static void destroy(Sections * sections){
+    for (Sections::iterator it = sections->begin(); it != sections->end(); it++){
+        delete *it;
+    }
+    delete sections;
+}
+
+static void loadCharacter(const string & path){
+    Mugen::ParseCache cache;
+    Mugen::Character character(Storage::instance().find(Filesystem::RelativePath(path)), Mugen::Stage::Player1Side);
+
+    TimeDifference diff;
+    diff.startTime();
+    character.load();
+    diff.endTime();
+
+    const Mugen::Arena & arena = character.getArena();
+    ostringstream out;
+    out << path << ": " << arena.getAllocations() << " objects, " << arena.getLive() << " live, in " << arena.getSize() / 1024 << "kb of blocks. Loading took";
+    Global::debug(0, "test") << diff.printTime(out.str()) << endl;
+}
+
+/* parses the file `rounds' times in a fresh arena each time, or on the heap
+ * if arena is false
+ */
+static void parse(const string & data, int rounds, bool arena){
+    unsigned int objects = 0;
+    size_t size = 0;
+
+    TimeDifference diff;
+    diff.startTime();
+    for (int i = 0; i < rounds; i++){
+        if (arena){
+            Mugen::Arena nodes;
+            {
+                Mugen::Arena::Scope scope(&nodes);
+                destroy((Sections*) Mugen::Cmd::parse(data.c_str(), data.size(), false));
+            }
+            objects = nodes.getAllocations();
+            size = nodes.getSize();
+        } else {
+            destroy((Sections*) Mugen::Cmd::parse(data.c_str(), data.size(), false));
+        }
+    }
+    diff.endTime();
+
+    ostringstream out;
+    if (arena){
+        out << "Arena: " << objects << " objects in " << size / 1024 << "kb of blocks, ";
+    } else {
+        out << "Heap: ";
+    }
+    out << rounds << " parses of " << data.size() / 1024 << "kb. Took";
+    Global::debug(0, "test") << diff.printTime(out.str()) << endl;
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    string character = argc > 2 ? argv[2] : "mugen/chars/kfm/kfm.def";
+    string cmd = argc > 3 ? argv[3] : "mugen/chars/kfm/kfm.cmd";
+
+    try{
+        loadCharacter(character);
+
+        string data = readFile(Storage::instance().find(Filesystem::RelativePath(cmd)).path());
+        parse(data, rounds, false);
+        parse(data, rounds, true);
+    } catch (const Filesystem::NotFound & fail){
+        Global::debug(0, "test") << "Couldn't find a file: " << fail.getTrace() << endl;
+        return 1;
+    } catch (const Mugen::Cmd::ParseException & fail){
+        Global::debug(0, "test") << "Couldn't parse " << cmd << endl;
+        return 1;
+    }
+
+    return 0;
+}
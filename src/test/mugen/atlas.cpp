@@ -0,0 +1,140 @@
+#include <string>
+#include <sstream>
+#include <vector>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/timedifference.h"
+#include "util/graphics/bitmap.h"
+#include "util/file-system.h"
+#include "util/input/input-manager.h"
+#include "mugen/atlas.h"
+#include "mugen/sprite.h"
+#include "mugen/util.h"
+#include "mugen/exception.h"
+
+/* Packs the sprites of a character into atlas pages and checks that every
+ * sprite still has the same pixels. Then times drawing all of the sprites
+ * with and without the atlas and shows how many batches the draws fall into.
+ * With the atlas the draws are held in an Atlas::Batch, which only sends
+ * them together with allegro5.
+ *
+ *   atlas [frames] [sff]
+ */
+
+using namespace std;
+
+static bool samePixels(const Graphics::Bitmap & a, const Graphics::Bitmap & b){
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()){
+        return false;
+    }
+
+    a.lock();
+    b.lock();
+    bool same = true;
+    for (int y = 0; y < a.getHeight() && same; y++){
+        for (int x = 0; x < a.getWidth() && same; x++){
+            same = a.getPixel(x, y) == b.getPixel(x, y);
+        }
+    }
+    b.unlock();
+    a.unlock();
+    return same;
+}
+
+static bool check(const Filesystem::AbsolutePath & path){
+    Mugen::SpriteMap sprites;
+    Mugen::Util::readSprites(path, Filesystem::AbsolutePath(), sprites, true);
+
+    vector<PaintownUtil::ReferenceCount<Mugen::Sprite> > all;
+    vector<PaintownUtil::ReferenceCount<Graphics::Bitmap> > before;
+    for (Mugen::SpriteMap::iterator group = sprites.begin(); group != sprites.end(); group++){
+        for (Mugen::GroupMap::iterator item = group->second.begin(); item != group->second.end(); item++){
+            all.push_back(item->second);
+            before.push_back(item->second->getBitmap(true));
+        }
+    }
+
+    int pages = Mugen::Atlas::pack(sprites);
+    Global::debug(0, "test") << "Packed " << all.size() << " sprites into " << pages << " pages" << endl;
+
+    for (unsigned int i = 0; i < all.size(); i++){
+        PaintownUtil::ReferenceCount<Graphics::Bitmap> after = all[i]->getBitmap(true);
+        if (before[i] == NULL || after == NULL){
+            continue;
+        }
+        if (!samePixels(*before[i], *after)){
+            Global::debug(0, "test") << "Test failure! Sprite " << all[i]->getGroupNumber() << ", " << all[i]->getImageNumber() << " changed when it was packed" << endl;
+            return false;
+        }
+        if (all[i]->getBitmap(true).raw() != after.raw()){
+            Global::debug(0, "test") << "Test failure! Sprite " << all[i]->getGroupNumber() << ", " << all[i]->getImageNumber() << " made a new bitmap every time it was asked for one" << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void benchmark(const Filesystem::AbsolutePath & path, int frames, bool atlas){
+    Mugen::SpriteMap sprites;
+    Mugen::Util::readSprites(path, Filesystem::AbsolutePath(), sprites, true);
+    if (atlas){
+        Mugen::Atlas::pack(sprites);
+    }
+
+    Mugen::Effects effects;
+    effects.mask = true;
+    Graphics::Bitmap work(640, 480);
+
+    /* the first frame decodes the sprites that weren't packed */
+    double total = 0;
+    for (int frame = 0; frame <= frames; frame++){
+        Mugen::DrawReport::beginFrame();
+        {
+            Mugen::Atlas::Batch batch;
+            int x = 0;
+            for (Mugen::SpriteMap::iterator group = sprites.begin(); group != sprites.end(); group++){
+                for (Mugen::GroupMap::iterator item = group->second.begin(); item != group->second.end(); item++){
+                    item->second->render(x % 640, 400, work, effects);
+                    x += 13;
+                }
+            }
+        }
+        Mugen::DrawReport::endFrame();
+        if (frame > 0){
+            total += Mugen::DrawReport::getFrameTime();
+        }
+    }
+
+    Global::debug(0, "test") << (atlas ? "Atlas" : "Separate bitmaps") << ": " << Mugen::DrawReport::getDraws() << " draws in " << Mugen::DrawReport::getBatches() << " batches, " << (frames > 0 ? total / frames / 1000 : 0) << "ms a frame" << endl;
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    int frames = argc > 1 ? atoi(argv[1]) : 100;
+    string file = argc > 2 ? argv[2] : "mugen/chars/kfm/kfm.sff";
+
+    try{
+        Filesystem::AbsolutePath path = Storage::instance().find(Filesystem::RelativePath(file));
+        if (!check(path)){
+            return 1;
+        }
+
+        benchmark(path, frames, false);
+        benchmark(path, frames, true);
+        Global::debug(0, "test") << "Success!" << endl;
+        return 0;
+    } catch (const MugenException & fail){
+        Global::debug(0, "test") << "Test failure! " << fail.getReason() << endl;
+        return 1;
+    } catch (const Filesystem::NotFound & fail){
+        Global::debug(0, "test") << "Test failure! Couldn't find a file: " << fail.getTrace() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,258 @@
+#include <string>
+#include <sstream>
+#include <map>
+#include <vector>
+#include <math.h>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/funcs.h"
+#include "util/timedifference.h"
+#include "util/graphics/bitmap.h"
+#include "util/input/input-manager.h"
+#include "mugen/color-table.h"
+
+/* Checks that the palfx lookup tables give exactly the colors the old per
+ * pixel filter did, then times both on a sprite sized block of pixels the
+ * way a character draws them, a new filter every frame.
+ *
+ *   color-table [frames]
+ */
+
+using namespace std;
+
+/* The palfx filter as it was before the tables, with its cache */
+class OldPaletteFilter{
+public:
+    OldPaletteFilter(int time, int addRed, int addGreen, int addBlue, int multiplyRed, int multiplyGreen, int multiplyBlue, int sinRed, int sinGreen, int sinBlue, int period, int invert, int color):
+    time(time),
+    addRed(addRed),
+    addGreen(addGreen),
+    addBlue(addBlue),
+    multiplyRed(multiplyRed),
+    multiplyGreen(multiplyGreen),
+    multiplyBlue(multiplyBlue),
+    sinRed(sinRed),
+    sinGreen(sinGreen),
+    sinBlue(sinBlue),
+    period(period),
+    invert(invert),
+    color(color){
+    }
+
+    int time;
+    int addRed;
+    int addGreen;
+    int addBlue;
+    int multiplyRed;
+    int multiplyGreen;
+    int multiplyBlue;
+    int sinRed;
+    int sinGreen;
+    int sinBlue;
+    int period;
+    int invert;
+    int color;
+
+    mutable map<Graphics::Color, Graphics::Color> cache;
+
+    Graphics::Color doFilter(int red, int green, int blue) const {
+        int newRed = red;
+        int newGreen = green;
+        int newBlue = blue;
+
+        if (color < 255){
+            double greyRed = (1 - 0.299) * color / 255 + 0.299;
+            double greyGreen = (1 - 0.587) * color / 255 + 0.587;
+            double greyBlue = (1 - 0.114) * color / 255 + 0.114;
+            red = (int)(red * greyRed + 0.5 + 16);
+            green = (int)(green * greyGreen + 0.5 + 16);
+            blue = (int)(blue * greyBlue + 0.5 + 16);
+        }
+
+        if (invert){
+            red = 255 - red;
+            green = 255 - green;
+            blue = 255 - blue;
+        }
+
+        if (period > 0){
+            newRed = (red + addRed + sinRed * sin(2 * Util::pi * time / period)) * multiplyRed / 256;
+            newGreen = (green + addGreen + sinGreen * sin(2 * Util::pi * time / period)) * multiplyGreen / 256;
+            newBlue = (blue + addBlue + sinBlue * sin(2 * Util::pi * time / period)) * multiplyBlue / 256;
+        } else {
+            newRed = (red + addRed) * multiplyRed / 256;
+            newGreen = (green + addGreen) * multiplyGreen / 256;
+            newBlue = (blue + addBlue) * multiplyBlue / 256;
+        }
+
+        if (newRed > 255){
+            newRed = 255;
+        }
+
+        if (newRed < 0){
+            newRed = 0;
+        }
+
+        if (newGreen > 255){
+            newGreen = 255;
+        }
+
+        if (newGreen < 0){
+            newGreen = 0;
+        }
+
+        if (newBlue > 255){
+            newBlue = 255;
+        }
+
+        if (newBlue < 0){
+            newBlue = 0;
+        }
+
+        return Graphics::makeColor(newRed, newGreen, newBlue);
+    }
+
+    Graphics::Color filter(Graphics::Color pixel) const {
+        if (cache.find(pixel) != cache.end()){
+            return cache[pixel];
+        }
+
+        int red = Graphics::getRed(pixel);
+        int green = Graphics::getGreen(pixel);
+        int blue = Graphics::getBlue(pixel);
+        Graphics::Color out = doFilter(red, green, blue);
+        cache[pixel] = out;
+        return out;
+    }
+};
+
+struct Effect{
+    int time;
+    int add[3];
+    int multiply[3];
+    int sin[3];
+    int period;
+    int invert;
+    int color;
+
+    OldPaletteFilter old() const {
+        return OldPaletteFilter(time, add[0], add[1], add[2], multiply[0], multiply[1], multiply[2], sin[0], sin[1], sin[2], period, invert, color);
+    }
+
+    Mugen::ColorTable table() const {
+        return Mugen::ColorTable::palette(time, add[0], add[1], add[2], multiply[0], multiply[1], multiply[2], sin[0], sin[1], sin[2], period, invert, color);
+    }
+};
+
+static int between(int low, int high){
+    return low + rand() % (high - low + 1);
+}
+
+/* includes the edges the clamping has to deal with */
+static Effect randomEffect(){
+    Effect effect;
+    effect.time = between(0, 200);
+    for (int i = 0; i < 3; i++){
+        effect.add[i] = between(-300, 300);
+        effect.multiply[i] = between(0, 512);
+        effect.sin[i] = between(-255, 255);
+    }
+    effect.period = between(-1, 60);
+    effect.invert = between(0, 1);
+    effect.color = between(0, 256);
+    return effect;
+}
+
+static Graphics::Color randomColor(){
+    return Graphics::makeColor(between(0, 255), between(0, 255), between(0, 255));
+}
+
+static bool same(Graphics::Color a, Graphics::Color b){
+    return Graphics::getRed(a) == Graphics::getRed(b) &&
+           Graphics::getGreen(a) == Graphics::getGreen(b) &&
+           Graphics::getBlue(a) == Graphics::getBlue(b);
+}
+
+static bool testSame(int effects){
+    for (int i = 0; i < effects; i++){
+        Effect effect = randomEffect();
+        OldPaletteFilter old = effect.old();
+        Mugen::ColorTable table = effect.table();
+        for (int color = 0; color < 2000; color++){
+            Graphics::Color pixel = color < 256 ? Graphics::makeColor(color, color, color) : randomColor();
+            if (!same(old.filter(pixel), table.apply(pixel))){
+                Global::debug(0, "test") << "Test failure! Palette table doesn't match the filter for time " << effect.time << " period " << effect.period << " invert " << effect.invert << " color " << effect.color << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* A sprite only uses the colors of its palette */
+static vector<Graphics::Color> makeSprite(int width, int height){
+    vector<Graphics::Color> palette;
+    for (int i = 0; i < 256; i++){
+        palette.push_back(randomColor());
+    }
+
+    vector<Graphics::Color> pixels;
+    for (int i = 0; i < width * height; i++){
+        pixels.push_back(palette[rand() % palette.size()]);
+    }
+    return pixels;
+}
+
+static void benchmark(int frames){
+    vector<Graphics::Color> sprite = makeSprite(128, 128);
+    vector<Graphics::Color> out(sprite.size());
+    Effect effect = randomEffect();
+    effect.period = 30;
+
+    TimeDifference diff;
+    diff.startTime();
+    for (int frame = 0; frame < frames; frame++){
+        effect.time = frame;
+        OldPaletteFilter filter = effect.old();
+        for (unsigned int i = 0; i < sprite.size(); i++){
+            out[i] = filter.filter(sprite[i]);
+        }
+    }
+    diff.endTime();
+    ostringstream filterOut;
+    filterOut << "Filter with a cache, " << frames << " frames of 128x128. Took";
+    Global::debug(0, "test") << diff.printTime(filterOut.str()) << endl;
+
+    diff.startTime();
+    for (int frame = 0; frame < frames; frame++){
+        effect.time = frame;
+        Mugen::ColorTable table = effect.table();
+        for (unsigned int i = 0; i < sprite.size(); i++){
+            out[i] = table.apply(sprite[i]);
+        }
+    }
+    diff.endTime();
+    ostringstream tableOut;
+    tableOut << "Lookup tables, " << frames << " frames of 128x128. Took";
+    Global::debug(0, "test") << diff.printTime(tableOut.str()) << endl;
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    int frames = argc > 1 ? atoi(argv[1]) : 60;
+    srand(1);
+
+    if (!testSame(500)){
+        return 1;
+    }
+
+    benchmark(frames);
+    Global::debug(0, "test") << "Success!" << endl;
+    return 0;
+}
@@ -968,6 +968,10 @@ int testKeys(Ast::KeyList * keys, const vector<Mugen::Input> & inputs){
     // NewCommand command(keys);
     Mugen::Command2 command("", keys, 1000, 0);
 
+    /* The automaton has to agree with Command2 on every tick */
+    Mugen::CommandAutomaton automaton;
+    automaton.add(Mugen::Command2("", keys, 1000, 0));
+
     /* Make sure we emit something */
     bool emitted = false;
     int tick = 0;
@@ -979,14 +983,21 @@ int testKeys(Ast::KeyList * keys, const vector<Mugen::Input> & inputs){
             last = true;
         }
 
+        bool fired = command.handle(input, tick);
+        vector<string> out;
+        automaton.handle(input, tick, out);
+        if (fired != (out.size() == 1)){
+            return 1;
+        }
+
         if (!last){
             /* If its not the last input then the command should not fire, so if it does then its an error */
-            if (command.handle(input, tick)){
+            if (fired){
                 return 1;
             }
         } else {
             /* And similarly if its the last input the command should fire, otherwise error */
-            if (!command.handle(input, tick)){
+            if (!fired){
                 return 1;
             } else {
                 emitted = true;
@@ -1348,6 +1359,52 @@ int test23(){
     return success;
 }
 
+/* Same as test23 but saves the state of the automaton in the middle */
+int test24(){
+    std::vector<Ast::Key*> keys;
+    keys.push_back(new Ast::KeySingle(0, 0, "a"));
+    keys.push_back(new Ast::KeySingle(0, 0, "a"));
+    keys.push_back(new Ast::KeySingle(0, 0, "b"));
+    Ast::KeyList * list = new Ast::KeyList(0, 0, keys);
+
+    bool fail = true;
+    bool success = false;
+    
+    std::ostringstream script;
+    script << "a;~a;a;~a;b";
+
+    vector<Mugen::Input> input = loadScript(script.str());
+    vector<string> out;
+    
+    Mugen::CommandAutomaton automaton1;
+    automaton1.add(Mugen::Command2("", list, 1000, 0));
+
+    for (int i = 0; i < 3; i++){
+        automaton1.handle(input[i], i, out);
+        if (out.size() != 0){
+            return fail;
+        }
+    }
+
+    Mugen::CommandAutomaton automaton2;
+    automaton2.add(Mugen::Command2("", list, 1000, 0));
+    automaton2.deserialize(automaton1.serialize());
+
+    // ~a
+    automaton2.handle(input[3], 3, out);
+    if (out.size() != 0){
+        return fail;
+    }
+    
+    // b
+    automaton2.handle(input[4], 4, out);
+    if (out.size() != 1){
+        return fail;
+    }
+    
+    return success;
+}
+
 int runTest(int (*test)(), const std::string & name){
     if (test()){
         Global::debug(0) << name << " failed" << std::endl;
@@ -1382,6 +1439,7 @@ int main(int argc, char ** argv){
         runTest(test21, "Test21") ||
         runTest(test22, "Test22") ||
         runTest(test23, "Test23") ||
+        runTest(test24, "Test24") ||
         /* having false here lets us copy/paste a runTest line easily */
         false
         ){
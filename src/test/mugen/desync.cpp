@@ -0,0 +1,170 @@
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/token.h"
+#include "util/exception.h"
+#include "mugen/character.h"
+#include "mugen/config.h"
+#include "mugen/behavior.h"
+#include "mugen/stage.h"
+#include "mugen/world.h"
+#include "mugen/simulation.h"
+#include "mugen/parse-cache.h"
+#include "util/file-system.h"
+#include "test-match.h"
+
+/* Finds the first tick where two runs of a match stop agreeing.
+ *
+ *   desync [ticks] [character]
+ *     Plays the same seeded match twice, checks that Stage::hashState() agrees
+ *     with the hash of the snapshotted World on every tick, then compares the
+ *     two runs and prints the fields that differ at the first bad tick.
+ *
+ *   desync left right
+ *     Each file has a `tick hash' pair per line, as written by the two peers
+ *     of a network match with the desync-log option (the .server and .client
+ *     files). Prints the first tick where the hashes differ.
+ */
+
+using namespace std;
+
+typedef vector<pair<uint32_t, uint64_t> > Hashes;
+
+/* Hashes for the same ticks in both lists. Once two games diverge they stay
+ * diverged so the first bad tick can be found by bisection.
+ */
+static int firstDivergence(const Hashes & left, const Hashes & right){
+    unsigned int size = left.size() < right.size() ? left.size() : right.size();
+    if (size == 0 || left[size - 1].second == right[size - 1].second){
+        return -1;
+    }
+
+    unsigned int low = 0;
+    unsigned int high = size - 1;
+    while (low < high){
+        unsigned int middle = (low + high) / 2;
+        if (left[middle].second == right[middle].second){
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return left[low].first;
+}
+
+static Hashes readHashes(const string & path){
+    Hashes out;
+    ifstream input(path.c_str());
+    uint32_t tick = 0;
+    uint64_t hash = 0;
+    while (input >> tick >> hash){
+        out.push_back(make_pair(tick, hash));
+    }
+    return out;
+}
+
+/* Plays `ticks' ticks and returns the hash after each one. Fails if the
+ * cheap hash and the hash of the full snapshot ever disagree.
+ */
+static bool play(int seed, int ticks, const string & path, Hashes & hashes){
+    Match match(path, seed, Mugen::Data::getInstance().getDifficulty());
+    for (int tick = 0; tick < ticks && !match.stage.isMatchOver(); tick++){
+        match.stage.logic();
+        uint64_t hash = match.stage.hashState();
+        if (hash != match.stage.snapshotState()->hash()){
+            Global::debug(0, "test") << "Test failure! Stage and World hashes differ at tick " << match.stage.getTicks() << endl;
+            return false;
+        }
+        hashes.push_back(make_pair((uint32_t) match.stage.getTicks(), hash));
+    }
+    return true;
+}
+
+/* Plays up to `tick' and returns the World */
+static PaintownUtil::ReferenceCount<Mugen::World> worldAt(int seed, uint32_t tick, const string & path){
+    Match match(path, seed, Mugen::Data::getInstance().getDifficulty());
+    while (match.stage.getTicks() < tick){
+        match.stage.logic();
+    }
+    return match.stage.snapshotState();
+}
+
+static int runMatches(int ticks, const string & path){
+    Mugen::ParseCache cache;
+    Hashes first;
+    Hashes second;
+    if (!play(1, ticks, path, first) || !play(1, ticks, path, second)){
+        return 1;
+    }
+
+    int tick = firstDivergence(first, second);
+    if (tick != -1){
+        Global::debug(0, "test") << "Test failure! Desync at tick " << tick << endl;
+        PaintownUtil::ReferenceCount<Mugen::World> left = worldAt(1, tick, path);
+        PaintownUtil::ReferenceCount<Mugen::World> right = worldAt(1, tick, path);
+        Global::debug(0, "test") << left->differences(*right) << endl;
+        return 1;
+    }
+
+    Global::debug(0, "test") << "Success! " << first.size() << " ticks hashed the same both times" << endl;
+    return 0;
+}
+
+/* The peers don't have to start or stop logging at the same tick, so only
+ * the ticks both of them logged are compared.
+ */
+static void commonTicks(const Hashes & left, const Hashes & right, Hashes & leftOut, Hashes & rightOut){
+    map<uint32_t, uint64_t> rightTicks(right.begin(), right.end());
+    for (Hashes::const_iterator it = left.begin(); it != left.end(); it++){
+        map<uint32_t, uint64_t>::iterator found = rightTicks.find(it->first);
+        if (found != rightTicks.end()){
+            leftOut.push_back(*it);
+            rightOut.push_back(*found);
+        }
+    }
+}
+
+static int compareFiles(const string & left, const string & right){
+    Hashes leftTicks;
+    Hashes rightTicks;
+    commonTicks(readHashes(left), readHashes(right), leftTicks, rightTicks);
+    if (leftTicks.size() == 0){
+        Global::debug(0, "test") << "No ticks in common" << endl;
+        return 1;
+    }
+
+    int tick = firstDivergence(leftTicks, rightTicks);
+    if (tick != -1){
+        Global::debug(0, "test") << "Desync at tick " << tick << endl;
+        return 1;
+    }
+    Global::debug(0, "test") << "No desync" << endl;
+    return 0;
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    try{
+        if (argc > 2 && atoi(argv[1]) == 0){
+            return compareFiles(argv[1], argv[2]);
+        }
+
+        int ticks = argc > 1 ? atoi(argv[1]) : 2000;
+        string path = argc > 2 ? argv[2] : "mugen/chars/kfm/kfm.def";
+        return runMatches(ticks, path);
+    } catch (const Exception::Base & fail){
+        Global::debug(0, "test") << "Test failure! " << fail.getTrace() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,142 @@
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <list>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/file-system.h"
+#include "mugen/parser/all.h"
+#include "mugen/parser/fast.h"
+#include "mugen/ast/all.h"
+
+/* Parses every file in the given directories with the peg parsers and the
+ * hand written parsers and checks that both make the same sections, or that
+ * both reject the file.
+ *
+ *   fast-parse [directory ...]
+ */
+
+using namespace std;
+
+typedef list<Ast::Section*> Sections;
+typedef const void * (*PegParser)(const char * in, int length, bool stats);
+typedef Sections * (*FastParser)(const char * in, int length);
+
+static bool hasExtension(const string & file, const string & extension){
+    return file.size() >= extension.size() && file.compare(file.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+static string readFile(const string & path){
+    ifstream input(path.c_str(), ios::in | ios::binary);
+    ostringstream out;
+    out << input.rdbuf();
+    return out.str();
+}
+
+static string print(Sections * sections){
+    ostringstream out;
+    for (Sections::iterator it = sections->begin(); it != sections->end(); it++){
+        out << (*it)->toString() << endl;
+    }
+    return out.str();
+}
+
+static void destroy(Sections * sections){
+    for (Sections::iterator it = sections->begin(); it != sections->end(); it++){
+        delete *it;
+    }
+    delete sections;
+}
+
+/* the peg parsers throw their own ParseException or an Ast::Exception */
+static bool parsePeg(PegParser parse, const string & data, string & out){
+    try{
+        Sections * sections = (Sections*) parse(data.c_str(), data.size(), false);
+        out = print(sections);
+        destroy(sections);
+        return true;
+    } catch (const Mugen::Def::ParseException & fail){
+    } catch (const Mugen::Air::ParseException & fail){
+    } catch (const Mugen::Cmd::ParseException & fail){
+    } catch (const Ast::Exception & fail){
+    }
+    return false;
+}
+
+static bool compare(const string & path){
+    PegParser peg = Mugen::Cmd::parse;
+    FastParser fast = Mugen::Fast::tryParseCmd;
+    if (hasExtension(path, ".def")){
+        peg = Mugen::Def::parse;
+        fast = Mugen::Fast::tryParseDef;
+    } else if (hasExtension(path, ".air")){
+        peg = Mugen::Air::parse;
+        fast = Mugen::Fast::tryParseAir;
+    }
+
+    string data = readFile(path);
+    string expected;
+    bool pegParsed = parsePeg(peg, data, expected);
+
+    Sections * sections = fast(data.c_str(), data.size());
+    if (sections == NULL){
+        if (pegParsed){
+            Global::debug(0, "test") << "Test failure! " << path << " was not parsed" << endl;
+        }
+        return !pegParsed;
+    }
+
+    string actual = print(sections);
+    destroy(sections);
+    if (!pegParsed){
+        Global::debug(0, "test") << "Test failure! " << path << " is not valid but was parsed" << endl;
+        return false;
+    }
+
+    if (actual != expected){
+        Global::debug(0, "test") << "Test failure! " << path << " was parsed differently" << endl;
+        Global::debug(0, "test") << "Expected:" << endl << expected << endl;
+        Global::debug(0, "test") << "Got:" << endl << actual << endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    vector<string> directories;
+    for (int i = 1; i < argc; i++){
+        directories.push_back(argv[i]);
+    }
+    if (directories.size() == 0){
+        directories.push_back("src/mugen/parser/tests");
+    }
+
+    int files = 0;
+    bool ok = true;
+    for (vector<string>::iterator directory = directories.begin(); directory != directories.end(); directory++){
+        vector<Filesystem::AbsolutePath> paths = Storage::instance().getFiles(Filesystem::AbsolutePath(*directory), "*");
+        for (vector<Filesystem::AbsolutePath>::iterator it = paths.begin(); it != paths.end(); it++){
+            files += 1;
+            ok = compare(it->path()) && ok;
+        }
+    }
+
+    if (files == 0){
+        Global::debug(0, "test") << "Test failure! No files to parse" << endl;
+        return 1;
+    }
+
+    if (ok){
+        Global::debug(0, "test") << "Success! " << files << " files parsed the same way" << endl;
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,187 @@
+#include <string>
+#include <sstream>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/exception.h"
+#include "mugen/ast/all.h"
+#include "mugen/character.h"
+#include "mugen/compiler.h"
+#include "mugen/exception.h"
+#include "mugen/config.h"
+#include "mugen/stage.h"
+#include "mugen/parse-cache.h"
+#include "util/file-system.h"
+#include "test-match.h"
+
+/* Checks that the trigger compiler folds constant expressions, computes
+ * expressions over a character's constants once per character, shares
+ * triggers between the controllers of a state, and that all of them give
+ * the same answers as evaluating the expressions every time.
+ *
+ *   fold [character] [ticks]
+ */
+
+using namespace std;
+
+static Ast::Value * number(double value){
+    return new Ast::Number(-1, -1, value);
+}
+
+static Ast::Value * infix(Ast::ExpressionInfix::InfixType type, Ast::Value * left, Ast::Value * right){
+    return new Ast::ExpressionInfix(-1, -1, type, left, right);
+}
+
+static Ast::Value * constant(const string & name){
+    return new Ast::Function(-1, -1, "const", new Ast::ValueList(new Ast::SimpleIdentifier(name)));
+}
+
+static bool check(bool ok, const string & what){
+    if (!ok){
+        Global::debug(0, "test") << "Test failure! " << what << endl;
+    }
+    return ok;
+}
+
+static bool testConstants(){
+    Mugen::EmptyEnvironment empty;
+
+    /* (1 + 2) * 3 */
+    Mugen::Compiler::Value * folded = Mugen::Compiler::compileAndDelete(infix(Ast::ExpressionInfix::Multiply, infix(Ast::ExpressionInfix::Add, number(1), number(2)), number(3)));
+    bool ok = check(folded->constness() == Mugen::Compiler::Constant, "(1 + 2) * 3 is not constant") &&
+              check(folded->evaluate(empty).toNumber() == 9, "(1 + 2) * 3 is not 9");
+    delete folded;
+
+    /* a runtime error is left for runtime */
+    Mugen::Compiler::Value * broken = Mugen::Compiler::compileAndDelete(infix(Ast::ExpressionInfix::Modulo, number(1), number(0)));
+    try{
+        broken->evaluate(empty);
+        ok = check(false, "1 % 0 did not fail") && ok;
+    } catch (const MugenException & fail){
+    }
+    delete broken;
+
+    /* time is not known until the game runs */
+    Mugen::Compiler::Value * varying = Mugen::Compiler::compileAndDelete(infix(Ast::ExpressionInfix::Add, new Ast::SimpleIdentifier("time"), number(1)));
+    ok = check(varying->constness() == Mugen::Compiler::Varying, "time + 1 is constant") && ok;
+    delete varying;
+
+    return ok;
+}
+
+/* Controllers of one state with the same trigger share its result until one
+ * of them activates. Here the trigger is evaluated for one controller, the
+ * next controller changes the state and the cache is cleared the way
+ * Character::doStates does it, then the trigger is evaluated again for a
+ * later controller.
+ */
+static bool testSharedTrigger(Mugen::Stage & stage, Mugen::Character & player){
+    Ast::Value * trigger = infix(Ast::ExpressionInfix::Add, new Ast::SimpleIdentifier("stateno"), number(1));
+    Mugen::Compiler::Value * first = Mugen::Compiler::compileTrigger(trigger);
+    Mugen::Compiler::Value * second = Mugen::Compiler::compileTrigger(trigger);
+    Mugen::Compiler::Value * unshared = Mugen::Compiler::compile(trigger);
+    delete trigger;
+
+    Mugen::FullEnvironment environment(stage, player, vector<string>());
+    Mugen::TriggerCache triggers;
+    environment.setCache(&triggers);
+
+    int before = player.getCurrentState();
+    int after = before == 0 ? 20 : 0;
+    bool ok = check(first->evaluate(environment).toNumber() == before + 1, "shared stateno + 1 has the wrong value");
+
+    player.changeState(stage, after);
+
+    /* not cleared yet, so the later controller gets the earlier result */
+    ok = check(second->evaluate(environment).toNumber() == before + 1, "stateno + 1 is not shared between controllers") && ok;
+
+    triggers.clear();
+    ok = check(unshared->evaluate(environment).toNumber() == after + 1, "stateno + 1 did not see the state change") && ok;
+    ok = check(second->evaluate(environment).toNumber() == unshared->evaluate(environment).toNumber(), "shared and unshared stateno + 1 disagree after a state change") && ok;
+    ok = check(first->evaluate(environment).toNumber() == after + 1, "the first controller's trigger did not see the state change") && ok;
+
+    delete first;
+    delete second;
+    delete unshared;
+    return ok;
+}
+
+static bool testCharacter(const string & path){
+    Mugen::Character player1(Storage::instance().find(Filesystem::RelativePath(path)), Mugen::Stage::Player1Side);
+    Mugen::Character player2(Storage::instance().find(Filesystem::RelativePath(path)), Mugen::Stage::Player2Side);
+    player1.load();
+    player2.load();
+    Mugen::Stage stage(Storage::instance().find(Filesystem::RelativePath("mugen/stages/kfm.def")));
+    stage.addPlayer1(&player1);
+    stage.addPlayer2(&player2);
+    stage.load();
+    stage.reset();
+
+    /* both players are the same character, so give player 2 a constant of
+     * its own to tell the cached values apart
+     */
+    player2.setWalkForwardX(player1.getWalkForwardX() + 1);
+
+    /* const(size.height) * 2 + const(velocity.walk.fwd.x) */
+    Mugen::Compiler::Value * cached = Mugen::Compiler::compileAndDelete(infix(Ast::ExpressionInfix::Add, infix(Ast::ExpressionInfix::Multiply, constant("size.height"), number(2)), constant("velocity.walk.fwd.x")));
+    double expected1 = player1.getHeight() * 2 + player1.getWalkForwardX();
+    double expected2 = player2.getHeight() * 2 + player2.getWalkForwardX();
+
+    bool ok = check(cached->constness() == Mugen::Compiler::CharacterConstant, "size and velocity constants are not per character constants");
+    for (int i = 0; i < 3; i++){
+        ok = check(cached->evaluate(Mugen::FullEnvironment(stage, player1)).toNumber() == expected1, "cached constant has the wrong value") && ok;
+        ok = check(cached->evaluate(Mugen::FullEnvironment(stage, player2)).toNumber() == expected2, "cached constant has the wrong value for player 2") && ok;
+    }
+    delete cached;
+
+    return testSharedTrigger(stage, player1) && ok;
+}
+
+/* The same match played with shared triggers and without has to end up in
+ * the same state on every tick.
+ */
+static bool testMatches(const string & path, int ticks){
+    vector<uint64_t> hashes[2];
+    for (int share = 0; share < 2; share++){
+        Mugen::Compiler::setShareTriggers(share == 1);
+        Match match(path, 1, Mugen::Data::getInstance().getDifficulty());
+        for (int tick = 0; tick < ticks && !match.stage.isMatchOver(); tick++){
+            match.stage.logic();
+            hashes[share].push_back(match.stage.hashState());
+        }
+    }
+    Mugen::Compiler::setShareTriggers(true);
+
+    for (unsigned int tick = 0; tick < hashes[0].size() && tick < hashes[1].size(); tick++){
+        if (hashes[0][tick] != hashes[1][tick]){
+            ostringstream out;
+            out << "shared triggers changed the match at tick " << (tick + 1);
+            return check(false, out.str());
+        }
+    }
+
+    return check(hashes[0].size() == hashes[1].size(), "shared triggers changed how long the match lasted");
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    string path = argc > 1 ? argv[1] : "mugen/chars/kfm/kfm.def";
+    int ticks = argc > 2 ? atoi(argv[2]) : 2000;
+
+    try{
+        Mugen::ParseCache cache;
+        if (testConstants() && testCharacter(path) && testMatches(path, ticks)){
+            Global::debug(0, "test") << "Success!" << endl;
+            return 0;
+        }
+        return 1;
+    } catch (const Exception::Base & fail){
+        Global::debug(0, "test") << "Test failure! " << fail.getTrace() << endl;
+        return 1;
+    }
+}
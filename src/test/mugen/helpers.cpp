@@ -0,0 +1,87 @@
+#include <string>
+#include <sstream>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/timedifference.h"
+#include "mugen/character.h"
+#include "mugen/helper.h"
+#include "mugen/config.h"
+#include "mugen/stage.h"
+#include "mugen/parse-cache.h"
+#include "util/file-system.h"
+
+/* Times spawning helpers the way the Helper controller does and touching
+ * every state and animation the owner has, which is what a helper does over
+ * its lifetime.
+ *
+ *   helpers [helpers] [rounds] [character]
+ */
+
+using namespace std;
+
+typedef PaintownUtil::ReferenceCount<Mugen::State> RefState;
+typedef PaintownUtil::ReferenceCount<Mugen::Animation> RefAnimation;
+
+static void spawn(Mugen::Character & owner, Mugen::Stage & stage, int helpers){
+    const map<int, RefState> & states = owner.getStates();
+    const map<int, RefAnimation> & animations = owner.getAnimations();
+
+    vector<Mugen::Helper*> spawned;
+    for (int i = 0; i < helpers; i++){
+        Mugen::Helper * helper = new Mugen::Helper(&owner, &owner, i, "benchmark");
+        for (map<int, RefState>::const_iterator it = states.begin(); it != states.end(); it++){
+            helper->getState(it->first, stage);
+        }
+        for (map<int, RefAnimation>::const_iterator it = animations.begin(); it != animations.end(); it++){
+            helper->getAnimation(it->first);
+        }
+        spawned.push_back(helper);
+    }
+
+    for (vector<Mugen::Helper*>::iterator it = spawned.begin(); it != spawned.end(); it++){
+        delete *it;
+    }
+}
+
+static void run(int helpers, int rounds, const string & path){
+    Mugen::ParseCache cache;
+    string stagePath = "mugen/stages/kfm.def";
+    Mugen::Character owner(Storage::instance().find(Filesystem::RelativePath(path)), Mugen::Stage::Player1Side);
+    Mugen::Character enemy(Storage::instance().find(Filesystem::RelativePath(path)), Mugen::Stage::Player2Side);
+    Global::debug(0) << "Loading " << path << endl;
+    owner.load();
+    enemy.load();
+    Mugen::Stage stage(Storage::instance().find(Filesystem::RelativePath(stagePath)));
+    stage.addPlayer1(&owner);
+    stage.addPlayer2(&enemy);
+    Global::debug(0) << "Loading stage" << std::endl;
+    stage.load();
+    stage.reset();
+
+    TimeDifference diff;
+    diff.startTime();
+    for (int i = 0; i < rounds; i++){
+        spawn(owner, stage, helpers);
+    }
+    diff.endTime();
+
+    ostringstream out;
+    out << "Spawned " << helpers * rounds << " helpers (" << owner.getStates().size() << " states, " << owner.getAnimations().size() << " animations). Took";
+    Global::debug(0, "test") << diff.printTime(out.str()) << endl;
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    int helpers = argc > 1 ? atoi(argv[1]) : 50;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+    string path = argc > 3 ? argv[3] : "mugen/chars/kfm/kfm.def";
+
+    run(helpers, rounds, path);
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <string>
+#include <sstream>
+#include <stdlib.h>
+#include <stdio.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/exception.h"
+#include "mugen/character.h"
+#include "mugen/config.h"
+#include "mugen/stage.h"
+#include "mugen/replay.h"
+#include "mugen/random.h"
+#include "mugen/simulation.h"
+#include "mugen/parse-cache.h"
+#include "util/file-system.h"
+#include "test-match.h"
+
+/* Plays a match from made up input while recording it, saves the recording,
+ * loads it back and plays it again. Both matches have to end in the same
+ * state.
+ *
+ *   input-replay [ticks] [character]
+ */
+
+using namespace std;
+
+static const char * REPLAY_FILE = "input-replay.replay";
+
+static uint64_t play(const string & path, uint32_t seed, Mugen::Behavior & behavior1, Mugen::Behavior & behavior2, int ticks){
+    Match match(path, behavior1, behavior2, seed);
+    for (int i = 0; i < ticks && !match.stage.isMatchOver(); i++){
+        match.stage.logic();
+    }
+
+    return match.stage.hashState();
+}
+
+static int run(int ticks, const string & path){
+    Mugen::ParseCache cache;
+
+    Mugen::InputReplay::Player input1 = makeInput(ticks, 42);
+    Mugen::InputReplay::Player input2 = makeInput(ticks / 2, 42);
+
+    Mugen::InputReplay recorded;
+    recorded.seed = 1234;
+    recorded.stage = "mugen/stages/kfm.def";
+    recorded.players[0].name = path;
+    recorded.players[0].behavior = "input";
+    recorded.players[1].name = path;
+    recorded.players[1].behavior = "input";
+
+    Mugen::ReplayBehavior source1(input1);
+    Mugen::ReplayBehavior source2(input2);
+    Mugen::RecordBehavior record1(source1, recorded.players[0]);
+    Mugen::RecordBehavior record2(source2, recorded.players[1]);
+    uint64_t first = play(path, recorded.seed, record1, record2, ticks);
+
+    Filesystem::AbsolutePath file(REPLAY_FILE);
+    recorded.save(file);
+    Mugen::InputReplay loaded = Mugen::InputReplay::load(file);
+    remove(REPLAY_FILE);
+
+    if (loaded.seed != recorded.seed || loaded.players[0].runs.size() != recorded.players[0].runs.size() || loaded.players[1].ticks() != recorded.players[1].ticks()){
+        Global::debug(0, "test") << "Test failure! Loaded replay is not the one that was saved" << endl;
+        return 1;
+    }
+
+    Mugen::ReplayBehavior replay1(loaded.players[0]);
+    Mugen::ReplayBehavior replay2(loaded.players[1]);
+    uint64_t second = play(path, loaded.seed, replay1, replay2, ticks);
+
+    if (first != second){
+        Global::debug(0, "test") << "Test failure! The replay ended in a different state" << endl;
+        return 1;
+    }
+
+    Global::debug(0, "test") << "Success! " << recorded.players[0].ticks() << " ticks recorded in " << recorded.players[0].runs.size() + recorded.players[1].runs.size() << " runs" << endl;
+    return 0;
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    int ticks = argc > 1 ? atoi(argv[1]) : 3000;
+    string path = argc > 2 ? argv[2] : "mugen/chars/kfm/kfm.def";
+
+    try{
+        return run(ticks, path);
+    } catch (const Exception::Base & fail){
+        Global::debug(0, "test") << "Test failure! " << fail.getTrace() << endl;
+        return 1;
+    }
+}
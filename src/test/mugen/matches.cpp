@@ -0,0 +1,141 @@
+#include <string>
+#include <sstream>
+#include <vector>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/thread.h"
+#include "util/token.h"
+#include "util/timedifference.h"
+#include "util/exception.h"
+#include "mugen/character.h"
+#include "mugen/config.h"
+#include "mugen/behavior.h"
+#include "mugen/stage.h"
+#include "mugen/world.h"
+#include "mugen/simulation.h"
+#include "mugen/parse-cache.h"
+#include "util/file-system.h"
+#include "test-match.h"
+
+/* Runs the same matches one after another and then all at once, one per
+ * thread, and checks that each match ends the same way both times.
+ *
+ *   matches [matches] [ticks] [character]
+ */
+
+using namespace std;
+
+/* one match to play and how it ended */
+struct Game{
+    Game(int seed, int ticks, const string & path, int difficulty):
+    seed(seed),
+    ticks(ticks),
+    path(path),
+    difficulty(difficulty),
+    ran(0){
+    }
+
+    int seed;
+    int ticks;
+    string path;
+    int difficulty;
+
+    /* filled in by play() */
+    int ran;
+    string world;
+    string error;
+};
+
+static void play(Game & game){
+    try{
+        Match match(game.path, game.seed, game.difficulty);
+        while (!match.stage.isMatchOver() && game.ran < game.ticks){
+            match.stage.logic();
+            game.ran += 1;
+        }
+
+        Token * world = match.stage.snapshotState()->serialize();
+        game.world = world->toString();
+        delete world;
+    } catch (const Exception::Base & fail){
+        game.error = fail.getTrace();
+    }
+}
+
+static void * playThread(void * game){
+    play(*(Game*) game);
+    return NULL;
+}
+
+static vector<Game> makeMatches(int count, int ticks, const string & path){
+    vector<Game> matches;
+    for (int i = 0; i < count; i++){
+        matches.push_back(Game(i + 1, ticks, path, Mugen::Data::getInstance().getDifficulty()));
+    }
+    return matches;
+}
+
+static int run(int count, int ticks, const string & path){
+    /* shared by every match */
+    Mugen::ParseCache cache;
+
+    vector<Game> serial = makeMatches(count, ticks, path);
+    TimeDifference diff;
+    diff.startTime();
+    for (vector<Game>::iterator it = serial.begin(); it != serial.end(); it++){
+        play(*it);
+    }
+    diff.endTime();
+    ostringstream serialOut;
+    serialOut << count << " matches one at a time. Took";
+    Global::debug(0, "test") << diff.printTime(serialOut.str()) << endl;
+
+    vector<Game> parallel = makeMatches(count, ticks, path);
+    vector<Util::Thread::Id> threads;
+    diff.startTime();
+    for (vector<Game>::iterator it = parallel.begin(); it != parallel.end(); it++){
+        Util::Thread::Id thread;
+        if (!Util::Thread::createThread(&thread, NULL, (Util::Thread::ThreadFunction) playThread, &*it)){
+            Global::debug(0, "test") << "Test failure! Could not create a thread" << endl;
+            return 1;
+        }
+        threads.push_back(thread);
+    }
+    for (vector<Util::Thread::Id>::iterator it = threads.begin(); it != threads.end(); it++){
+        Util::Thread::joinThread(*it);
+    }
+    diff.endTime();
+    ostringstream parallelOut;
+    parallelOut << count << " matches on " << count << " threads. Took";
+    Global::debug(0, "test") << diff.printTime(parallelOut.str()) << endl;
+
+    for (int i = 0; i < count; i++){
+        if (serial[i].error != "" || parallel[i].error != ""){
+            Global::debug(0, "test") << "Test failure! Match " << i << " failed: " << serial[i].error << parallel[i].error << endl;
+            return 1;
+        }
+
+        if (serial[i].ran != parallel[i].ran || serial[i].world != parallel[i].world){
+            Global::debug(0, "test") << "Test failure! Match " << i << " ran " << serial[i].ran << " ticks alone and " << parallel[i].ran << " ticks on a thread and ended differently" << endl;
+            return 1;
+        }
+    }
+
+    Global::debug(0, "test") << "Success! All matches ended the same way" << endl;
+    return 0;
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    int count = argc > 1 ? atoi(argv[1]) : 4;
+    int ticks = argc > 2 ? atoi(argv[2]) : 3000;
+    string path = argc > 3 ? argv[3] : "mugen/chars/kfm/kfm.def";
+
+    return run(count, ticks, path);
+}
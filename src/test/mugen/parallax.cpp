@@ -0,0 +1,120 @@
+#include <string>
+#include <sstream>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/configuration.h"
+#include "util/debug.h"
+#include "util/timedifference.h"
+#include "util/graphics/bitmap.h"
+#include "util/file-system.h"
+#include "util/input/input-manager.h"
+#include "mugen/background.h"
+#include "mugen/exception.h"
+
+/* Draws the background of a stage, parallax floors included, with the rows
+ * drawn from a ParallaxRaster and with Sprite::drawPartStretched while the
+ * camera pans back and forth across it. Every frame has to come out the same,
+ * then both ways are timed.
+ *
+ *   parallax [frames] [stage]
+ */
+
+using namespace std;
+
+static bool samePixels(const Graphics::Bitmap & a, const Graphics::Bitmap & b){
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()){
+        return false;
+    }
+
+    a.lock();
+    b.lock();
+    bool same = true;
+    for (int y = 0; y < a.getHeight() && same; y++){
+        for (int x = 0; x < a.getWidth() && same; x++){
+            same = a.getPixel(x, y) == b.getPixel(x, y);
+        }
+    }
+    b.unlock();
+    a.unlock();
+    return same;
+}
+
+/* left to right and back every 4 seconds, with a little up and down */
+static int cameraX(int frame){
+    return abs(frame % 480 - 240) - 120;
+}
+
+static int cameraY(int frame){
+    return -abs(frame % 120 - 60) / 4;
+}
+
+static void draw(Mugen::Background & background, int frame, const Graphics::Bitmap & work){
+    background.act();
+    background.renderBackground(cameraX(frame), cameraY(frame), work);
+    background.renderForeground(cameraX(frame), cameraY(frame), work);
+}
+
+static bool check(const Filesystem::AbsolutePath & path, int frames){
+    Mugen::Background raster(path, "BG");
+    Mugen::Background stretched(path, "BG");
+    raster.setParallaxRaster(true);
+    stretched.setParallaxRaster(false);
+
+    Graphics::Bitmap rasterWork(320, 240);
+    Graphics::Bitmap stretchedWork(320, 240);
+    for (int frame = 0; frame < frames; frame++){
+        draw(raster, frame, rasterWork);
+        draw(stretched, frame, stretchedWork);
+        if (!samePixels(rasterWork, stretchedWork)){
+            Global::debug(0, "test") << "Test failure! Frame " << frame << " is different with the parallax raster" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void benchmark(const Filesystem::AbsolutePath & path, int frames, bool useRaster){
+    Mugen::Background background(path, "BG");
+    background.setParallaxRaster(useRaster);
+    Graphics::Bitmap work(320, 240);
+
+    TimeDifference diff;
+    diff.startTime();
+    for (int frame = 0; frame < frames; frame++){
+        draw(background, frame, work);
+    }
+    diff.endTime();
+
+    ostringstream out;
+    out << "Drew " << frames << " frames " << (useRaster ? "with" : "without") << " the parallax raster. Took";
+    Global::debug(0, "test") << diff.printTime(out.str()) << endl;
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+    Configuration::loadConfigurations();
+
+    int frames = argc > 1 ? atoi(argv[1]) : 600;
+    string file = argc > 2 ? argv[2] : "mugen/stages/kfm.def";
+
+    try{
+        Filesystem::AbsolutePath path = Storage::instance().find(Filesystem::RelativePath(file));
+        if (!check(path, frames)){
+            return 1;
+        }
+        benchmark(path, frames, false);
+        benchmark(path, frames, true);
+    } catch (const MugenException & fail){
+        Global::debug(0, "test") << "Exception: " << fail.getReason() << endl;
+        return 1;
+    } catch (const Filesystem::NotFound & fail){
+        Global::debug(0, "test") << "Exception: " << fail.getTrace() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <list>
+#include <stdlib.h>
+#include <ctype.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/timedifference.h"
+#include "util/file-system.h"
+#include "mugen/parser/all.h"
+#include "mugen/parser/fast.h"
+#include "mugen/ast/all.h"
+
+/* Times the peg parsers against the hand written parsers on the same files.
+ * A directory is searched for .def, .air, .cmd, .cns and .st files.
+ *
+ *   parse-speed [rounds] [file or directory ...]
+ */
+
+using namespace std;
+
+typedef list<Ast::Section*> Sections;
+typedef const void * (*Parser)(const char * in, int length, bool stats);
+
+struct Input{
+    Input(const string & path, const string & data, Parser peg, Parser fast):
+    path(path),
+    data(data),
+    peg(peg),
+    fast(fast){
+    }
+
+    string path;
+    string data;
+    Parser peg;
+    Parser fast;
+};
+
+static bool hasExtension(const string & file, const string & extension){
+    return file.size() >= extension.size() && file.compare(file.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+static string readFile(const string & path){
+    ifstream input(path.c_str(), ios::in | ios::binary);
+    ostringstream out;
+    out << input.rdbuf();
+    return out.str();
+}
+
+static string lowerCase(string text){
+    for (unsigned int i = 0; i < text.size(); i++){
+        text[i] = tolower(text[i]);
+    }
+    return text;
+}
+
+static void add(vector<Input> & inputs, const string & path){
+    string lower = lowerCase(path);
+    if (hasExtension(lower, ".def")){
+        inputs.push_back(Input(path, readFile(path), Mugen::Def::parse, Mugen::Fast::parseDef));
+    } else if (hasExtension(lower, ".air")){
+        inputs.push_back(Input(path, readFile(path), Mugen::Air::parse, Mugen::Fast::parseAir));
+    } else if (hasExtension(lower, ".cmd") || hasExtension(lower, ".cns") || hasExtension(lower, ".st")){
+        inputs.push_back(Input(path, readFile(path), Mugen::Cmd::parse, Mugen::Fast::parseCmd));
+    }
+}
+
+static void destroy(Sections * sections){
+    for (Sections::iterator it = sections->begin(); it != sections->end(); it++){
+        delete *it;
+    }
+    delete sections;
+}
+
+/* Files that don't parse are skipped, returns the number of bytes parsed */
+static unsigned long parseAll(const vector<Input> & inputs, bool fast){
+    unsigned long bytes = 0;
+    for (vector<Input>::const_iterator it = inputs.begin(); it != inputs.end(); it++){
+        const Input & input = *it;
+        Parser parse = fast ? input.fast : input.peg;
+        try{
+            destroy((Sections*) parse(input.data.c_str(), input.data.size(), false));
+            bytes += input.data.size();
+        } catch (const Mugen::Def::ParseException & fail){
+        } catch (const Mugen::Air::ParseException & fail){
+        } catch (const Mugen::Cmd::ParseException & fail){
+        } catch (const Ast::Exception & fail){
+        }
+    }
+    return bytes;
+}
+
+static void benchmark(const vector<Input> & inputs, int rounds, bool fast){
+    unsigned long bytes = 0;
+    TimeDifference diff;
+    diff.startTime();
+    for (int i = 0; i < rounds; i++){
+        bytes += parseAll(inputs, fast);
+    }
+    diff.endTime();
+
+    ostringstream out;
+    out << (fast ? "Hand written" : "Peg") << " parsers read " << bytes / 1024 << "kb in " << inputs.size() * rounds << " files. Took";
+    Global::debug(0, "test") << diff.printTime(out.str()) << endl;
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    vector<string> paths;
+    for (int i = 2; i < argc; i++){
+        paths.push_back(argv[i]);
+    }
+    if (paths.size() == 0){
+        paths.push_back("src/mugen/parser/tests");
+    }
+
+    vector<Input> inputs;
+    for (vector<string>::iterator it = paths.begin(); it != paths.end(); it++){
+        Filesystem::AbsolutePath path(*it);
+        if (Storage::instance().isDirectory(path)){
+            vector<Filesystem::AbsolutePath> files = Storage::instance().getFilesRecursive(path, "*");
+            for (vector<Filesystem::AbsolutePath>::iterator file = files.begin(); file != files.end(); file++){
+                add(inputs, file->path());
+            }
+        } else {
+            add(inputs, path.path());
+        }
+    }
+
+    benchmark(inputs, rounds, false);
+    benchmark(inputs, rounds, true);
+    return 0;
+}
@@ -352,7 +352,7 @@ public:
 
     map<unsigned int, Mugen::Input> inputs;
 
-    vector<string> currentCommands(const Mugen::Stage & stage, Mugen::Character * owner, const vector<Mugen::Command2*> & commands, bool reversed){
+    vector<string> currentCommands(const Mugen::Stage & stage, Mugen::Character * owner, Mugen::CommandAutomaton & commands, bool reversed){
         vector<string> out;
 
         if (inputs.find(stage.getTicks()) == inputs.end()){
@@ -364,12 +364,9 @@ public:
 
         Global::debug(1) << "Tick " << stage.getTicks() << " input: " << describeInput(input) << std::endl;
 
-        for (vector<Mugen::Command2*>::const_iterator it = commands.begin(); it != commands.end(); it++){
-            Mugen::Command2 * command = *it;
-            if (command->handle(input, stage.getTicks())){
-                Global::debug(1) << "command: " << command->getName() << endl;
-                out.push_back(command->getName());
-            }
+        commands.handle(input, stage.getTicks(), out);
+        for (vector<string>::const_iterator it = out.begin(); it != out.end(); it++){
+            Global::debug(1) << "command: " << *it << endl;
         }
 
         return out;
@@ -469,7 +466,7 @@ public:
         out << "\n";
     }
 
-    vector<string> currentCommands(const Mugen::Stage & stage, Mugen::Character * owner, const vector<Mugen::Command2*> & commands, bool reversed){
+    vector<string> currentCommands(const Mugen::Stage & stage, Mugen::Character * owner, Mugen::CommandAutomaton & commands, bool reversed){
         vector<string> out = Mugen::HumanBehavior::currentCommands(stage, owner, commands, reversed);
         writeInput(stage.getTicks(), getInput());
         return out;
@@ -116,6 +116,26 @@ static void load(const char * path, parser what){
             Global::debug(0) << "Pass!" << endl;
         }
 
+        /* same again with the binary form the parse cache keeps */
+        diff.startTime();
+        Ast::BinaryWriter writer;
+        parsed.writeBinary(writer);
+        string binary = writer.finish(0);
+        diff.endTime();
+        Global::debug(0, "test") << diff.printTime("binary write") << endl;
+
+        diff.startTime();
+        Ast::BinaryReader binaryReader(binary.data(), binary.size());
+        Ast::AstParse binaryParsed(Ast::AstParse::readBinary(binaryReader));
+        diff.endTime();
+        Global::debug(0, "test") << diff.printTime("binary read") << endl;
+
+        if (parsed != binaryParsed){
+            Global::debug(0) << "Binary fail!" << endl;
+        } else {
+            Global::debug(0) << "Binary pass!" << endl;
+        }
+
         /* cleanup */
         delete serial;
         remove(file.c_str());
@@ -0,0 +1,119 @@
+#include <string>
+#include <sstream>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/exception.h"
+#include "util/timedifference.h"
+#include "mugen/character.h"
+#include "mugen/config.h"
+#include "mugen/stage.h"
+#include "mugen/world.h"
+#include "mugen/replay.h"
+#include "mugen/random.h"
+#include "mugen/simulation.h"
+#include "mugen/parse-cache.h"
+#include "util/file-system.h"
+#include "test-match.h"
+
+/* Plays the same match twice side by side, once normally and once in
+ * simulation only mode, and checks that the worlds are the same after every
+ * tick. Then rewinds a match to its start and times re-simulating it both
+ * ways, the way a replay fast forward or a rollback does.
+ *
+ *   simulate [ticks] [character]
+ */
+
+using namespace std;
+
+static bool compare(const string & path, const Mugen::InputReplay::Player & input1, const Mugen::InputReplay::Player & input2, int ticks){
+    Match drawn(path, input1, input2);
+    Match simulated(path, input1, input2);
+    simulated.stage.setSimulationOnly(true);
+
+    for (int tick = 0; tick < ticks && !drawn.stage.isMatchOver(); tick++){
+        drawn.stage.logic();
+        simulated.stage.logic();
+
+        if (drawn.stage.snapshotState()->hash() != simulated.stage.snapshotState()->hash()){
+            Global::debug(0, "test") << "Test failure! Simulation only mode went out of sync at tick " << tick << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Re-simulates the ticks after `start' from the input history and checks
+ * that it ends up where the match did the first time.
+ */
+static bool resimulate(Match & match, const Mugen::World & start, int ticks, uint64_t expected, bool simulationOnly){
+    match.stage.updateState(start);
+    match.stage.setReplay(true);
+    match.stage.setSimulationOnly(simulationOnly);
+
+    TimeDifference diff;
+    diff.startTime();
+    for (int tick = 0; tick < ticks; tick++){
+        match.stage.logic();
+    }
+    diff.endTime();
+
+    match.stage.setSimulationOnly(false);
+    match.stage.setReplay(false);
+
+    double seconds = diff.getTime() / 1000000.0;
+    Global::debug(0, "test") << (simulationOnly ? "Simulation only" : "Normal") << " re-simulation: " << ticks << " ticks in " << seconds << "s, " << (seconds > 0 ? ticks / seconds : 0) << " ticks/sec" << endl;
+
+    if (match.stage.hashState() != expected){
+        Global::debug(0, "test") << "Test failure! Re-simulation did not end in the same state" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool benchmark(const string & path, const Mugen::InputReplay::Player & input1, const Mugen::InputReplay::Player & input2, int ticks){
+    Match match(path, input1, input2);
+    PaintownUtil::ReferenceCount<Mugen::World> start = match.stage.snapshotState();
+
+    int tick = 0;
+    for (tick = 0; tick < ticks && !match.stage.isMatchOver(); tick++){
+        match.stage.logic();
+    }
+    uint64_t expected = match.stage.hashState();
+
+    return resimulate(match, *start, tick, expected, false) &&
+           resimulate(match, *start, tick, expected, true);
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    int ticks = argc > 1 ? atoi(argv[1]) : 3000;
+    string path = argc > 2 ? argv[2] : "mugen/chars/kfm/kfm.def";
+
+    try{
+        Mugen::ParseCache cache;
+        Mugen::InputReplay::Player input1 = makeInput(ticks, 42);
+        Mugen::InputReplay::Player input2 = makeInput(ticks, 7);
+
+        if (!compare(path, input1, input2, ticks)){
+            return 1;
+        }
+
+        if (!benchmark(path, input1, input2, ticks)){
+            return 1;
+        }
+
+        Global::debug(0, "test") << "Success!" << endl;
+        return 0;
+    } catch (const Exception::Base & fail){
+        Global::debug(0, "test") << "Test failure! " << fail.getTrace() << endl;
+        return 1;
+    }
+}
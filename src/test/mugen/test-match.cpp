@@ -0,0 +1,68 @@
+#include "test-match.h"
+#include "mugen/random.h"
+#include "util/file-system.h"
+
+using namespace std;
+
+Mugen::InputReplay::Player makeInput(int ticks, uint32_t seed){
+    Mugen::Random random(seed);
+    Mugen::InputReplay::Player out;
+    out.behavior = "input";
+    int total = 0;
+    while (total < ticks){
+        uint32_t hold = random.next() % 30 + 1;
+        out.runs.push_back(Mugen::InputReplay::Run(random.next() & 0x7ff, hold));
+        total += hold;
+    }
+    return out;
+}
+
+static const char * STAGE = "mugen/stages/kfm.def";
+
+Match::Match(const string & path, const Mugen::InputReplay::Player & input1, const Mugen::InputReplay::Player & input2, uint32_t seed):
+simulation(seed),
+scope(simulation),
+behavior1(new Mugen::ReplayBehavior(input1)),
+behavior2(new Mugen::ReplayBehavior(input2)),
+player1(Storage::instance().find(Filesystem::RelativePath(path)), Mugen::Stage::Player1Side),
+player2(Storage::instance().find(Filesystem::RelativePath(path)), Mugen::Stage::Player2Side),
+stage(Storage::instance().find(Filesystem::RelativePath(STAGE))){
+    start(*behavior1, *behavior2, seed);
+}
+
+Match::Match(const string & path, uint32_t seed, int difficulty):
+simulation(seed),
+scope(simulation),
+behavior1(new Mugen::LearningAIBehavior(difficulty)),
+behavior2(new Mugen::LearningAIBehavior(difficulty)),
+player1(Storage::instance().find(Filesystem::RelativePath(path)), Mugen::Stage::Player1Side),
+player2(Storage::instance().find(Filesystem::RelativePath(path)), Mugen::Stage::Player2Side),
+stage(Storage::instance().find(Filesystem::RelativePath(STAGE))){
+    start(*behavior1, *behavior2, seed);
+}
+
+Match::Match(const string & path, Mugen::Behavior & use1, Mugen::Behavior & use2, uint32_t seed):
+simulation(seed),
+scope(simulation),
+player1(Storage::instance().find(Filesystem::RelativePath(path)), Mugen::Stage::Player1Side),
+player2(Storage::instance().find(Filesystem::RelativePath(path)), Mugen::Stage::Player2Side),
+stage(Storage::instance().find(Filesystem::RelativePath(STAGE))){
+    start(use1, use2, seed);
+}
+
+Match::~Match(){
+}
+
+void Match::start(Mugen::Behavior & use1, Mugen::Behavior & use2, uint32_t seed){
+    simulation.disableSounds();
+    player1.load();
+    player2.load();
+    player1.setBehavior(&use1);
+    player2.setBehavior(&use2);
+    stage.addPlayer1(&player1);
+    stage.addPlayer2(&player2);
+    stage.load();
+    stage.getSimulation().disableSounds();
+    stage.getSimulation().setRandom(Mugen::Random(seed));
+    stage.reset();
+}
@@ -0,0 +1,48 @@
+#ifndef _paintown_test_mugen_test_match_h
+#define _paintown_test_mugen_test_match_h
+
+#include <string>
+#include <stdint.h>
+#include "util/pointer.h"
+#include "mugen/character.h"
+#include "mugen/behavior.h"
+#include "mugen/replay.h"
+#include "mugen/simulation.h"
+#include "mugen/stage.h"
+
+/* Things the tests that play matches have in common */
+
+/* Random presses that are held for a while, like a person mashing buttons */
+Mugen::InputReplay::Player makeInput(int ticks, uint32_t seed);
+
+/* Two copies of a character fighting on the kfm stage, reset and ready for
+ * stage.logic(). Sounds are off. The character is loaded with a simulation
+ * seeded from `seed' bound to the thread, and the stage's random numbers
+ * start from `seed' the same way a replay is played back.
+ */
+class Match{
+public:
+    /* the players press the recorded input, which has to outlive the match */
+    Match(const std::string & path, const Mugen::InputReplay::Player & input1, const Mugen::InputReplay::Player & input2, uint32_t seed = 1234);
+
+    /* the players are run by the learning ai */
+    Match(const std::string & path, uint32_t seed, int difficulty);
+
+    /* the players are run by behaviors that outlive the match */
+    Match(const std::string & path, Mugen::Behavior & behavior1, Mugen::Behavior & behavior2, uint32_t seed);
+
+    virtual ~Match();
+
+    Mugen::Simulation simulation;
+    Mugen::Simulation::Scope scope;
+    PaintownUtil::ReferenceCount<Mugen::Behavior> behavior1;
+    PaintownUtil::ReferenceCount<Mugen::Behavior> behavior2;
+    Mugen::Character player1;
+    Mugen::Character player2;
+    Mugen::Stage stage;
+
+protected:
+    void start(Mugen::Behavior & use1, Mugen::Behavior & use2, uint32_t seed);
+};
+
+#endif
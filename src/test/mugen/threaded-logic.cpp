@@ -0,0 +1,214 @@
+#include <string>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/exception.h"
+#include "util/thread.h"
+#include "util/funcs.h"
+#include "util/graphics/bitmap.h"
+#include "util/input/input-manager.h"
+#include "mugen/stage.h"
+#include "mugen/behavior.h"
+#include "mugen/replay.h"
+#include "mugen/parse-cache.h"
+#include "test-match.h"
+
+/* Plays the same match twice, once on this thread and once on a logic thread
+ * while this thread keeps drawing it with interpolation the way a threaded
+ * match does. Both have to end in the same state. Then does the same with a
+ * human player recorded by a RecordBehavior, the way StartRecord sets it up,
+ * which has to read its input only when it is latched.
+ *
+ *   threaded-logic [ticks] [character]
+ */
+
+using namespace std;
+
+/* What the logic thread shares with the drawing thread. Everything in here
+ * and the stage are only touched with the lock held.
+ */
+struct Shared{
+    Shared(Mugen::Stage & stage, int ticks):
+    stage(stage),
+    ticks(ticks),
+    done(false){
+    }
+
+    Mugen::Stage & stage;
+    int ticks;
+    bool done;
+    string failure;
+    PaintownUtil::Thread::LockObject lock;
+};
+
+static void * logicThread(void * arg){
+    Shared & shared = *(Shared*) arg;
+    for (int tick = 0; tick < shared.ticks; tick++){
+        {
+            PaintownUtil::Thread::ScopedLock scoped(shared.lock);
+            if (shared.stage.isMatchOver()){
+                break;
+            }
+            try{
+                shared.stage.logic();
+            } catch (const Exception::Base & fail){
+                shared.failure = fail.getTrace();
+                break;
+            } catch (const std::exception & fail){
+                shared.failure = fail.what();
+                break;
+            } catch (...){
+                shared.failure = "unknown exception";
+                break;
+            }
+        }
+        /* let the drawing in between ticks */
+        PaintownUtil::rest(0);
+    }
+
+    PaintownUtil::Thread::ScopedLock scoped(shared.lock);
+    shared.done = true;
+    return NULL;
+}
+
+static uint64_t unthreaded(const string & path, const Mugen::InputReplay::Player & input1, const Mugen::InputReplay::Player & input2, int ticks){
+    Match match(path, input1, input2);
+    for (int tick = 0; tick < ticks && !match.stage.isMatchOver(); tick++){
+        match.stage.logic();
+    }
+    return match.stage.hashState();
+}
+
+/* Counts the times the input was latched, the input devices are only read
+ * then
+ */
+class LatchedHuman: public Mugen::HumanBehavior {
+public:
+    LatchedHuman():
+    HumanBehavior(InputMap<Mugen::Keys>(), InputMap<Mugen::Keys>()),
+    latches(0){
+    }
+
+    virtual void latch(bool reversed){
+        latches += 1;
+        HumanBehavior::latch(reversed);
+    }
+
+    int latches;
+};
+
+/* Runs the logic on its own thread and draws on this one until the match is
+ * over or `ticks' ticks have gone by
+ */
+static bool drawWhilePlaying(Match & match, int ticks){
+    match.stage.setInterpolate(true);
+    Shared shared(match.stage, ticks);
+
+    PaintownUtil::Thread::Id thread;
+    if (!PaintownUtil::Thread::createThread(&thread, NULL, (PaintownUtil::Thread::ThreadFunction) logicThread, &shared)){
+        Global::debug(0, "test") << "Test failure! Could not start the logic thread" << endl;
+        return false;
+    }
+
+    Graphics::Bitmap work(320, 240);
+    int frames = 0;
+    bool done = false;
+    while (!done){
+        {
+            PaintownUtil::Thread::ScopedLock scoped(shared.lock);
+            match.stage.latchInput();
+            match.stage.render(&work, 0.5);
+            done = shared.done;
+        }
+        frames += 1;
+        PaintownUtil::rest(1);
+    }
+    PaintownUtil::Thread::joinThread(thread);
+    match.stage.setInterpolate(false);
+
+    if (shared.failure != ""){
+        Global::debug(0, "test") << "Test failure! The logic thread failed: " << shared.failure << endl;
+        return false;
+    }
+
+    Global::debug(0, "test") << "Drew " << frames << " frames while the logic thread ran" << endl;
+    return true;
+}
+
+static bool threaded(const string & path, const Mugen::InputReplay::Player & input1, const Mugen::InputReplay::Player & input2, int ticks, uint64_t & hash){
+    Match match(path, input1, input2);
+    if (!drawWhilePlaying(match, ticks)){
+        return false;
+    }
+    hash = match.stage.hashState();
+    return true;
+}
+
+static bool human(const string & path, const Mugen::InputReplay::Player & input2, int ticks){
+    uint64_t hashes[2];
+    Mugen::InputReplay::Player recorded[2];
+    for (int thread = 0; thread < 2; thread++){
+        LatchedHuman player;
+        Mugen::RecordBehavior record(player, recorded[thread]);
+        Mugen::ReplayBehavior opponent(input2);
+        Match match(path, record, opponent, 1234);
+        if (thread == 0){
+            for (int tick = 0; tick < ticks && !match.stage.isMatchOver(); tick++){
+                match.stage.logic();
+            }
+        } else {
+            if (!drawWhilePlaying(match, ticks)){
+                return false;
+            }
+            if (player.latches == 0){
+                Global::debug(0, "test") << "Test failure! The recorded human player was never latched" << endl;
+                return false;
+            }
+        }
+        hashes[thread] = match.stage.hashState();
+    }
+
+    if (hashes[0] != hashes[1] || recorded[0].runs.size() != recorded[1].runs.size()){
+        Global::debug(0, "test") << "Test failure! The threaded match with a human player ended in a different state" << endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    int ticks = argc > 1 ? atoi(argv[1]) : 2000;
+    string path = argc > 2 ? argv[2] : "mugen/chars/kfm/kfm.def";
+
+    try{
+        Mugen::ParseCache cache;
+        Mugen::InputReplay::Player input1 = makeInput(ticks, 42);
+        Mugen::InputReplay::Player input2 = makeInput(ticks, 7);
+
+        uint64_t expected = unthreaded(path, input1, input2, ticks);
+        uint64_t hash = 0;
+        if (!threaded(path, input1, input2, ticks, hash)){
+            return 1;
+        }
+
+        if (hash != expected){
+            Global::debug(0, "test") << "Test failure! The threaded match ended in a different state" << endl;
+            return 1;
+        }
+
+        if (!human(path, input2, ticks)){
+            return 1;
+        }
+
+        Global::debug(0, "test") << "Success!" << endl;
+        return 0;
+    } catch (const Exception::Base & fail){
+        Global::debug(0, "test") << "Test failure! " << fail.getTrace() << endl;
+        return 1;
+    }
+}
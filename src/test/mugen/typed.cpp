@@ -0,0 +1,90 @@
+#include <string>
+#include <sstream>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/exception.h"
+#include "util/timedifference.h"
+#include "mugen/character.h"
+#include "mugen/compiler.h"
+#include "mugen/config.h"
+#include "mugen/stage.h"
+#include "mugen/replay.h"
+#include "mugen/random.h"
+#include "mugen/simulation.h"
+#include "mugen/parse-cache.h"
+#include "util/file-system.h"
+#include "test-match.h"
+
+/* Plays the same match twice side by side, once with triggers evaluated
+ * through RuntimeValue and once with the typed evaluation, and checks that
+ * the two are in the same state after every tick. Then times both.
+ *
+ *   typed [ticks] [character]
+ */
+
+using namespace std;
+
+static bool compare(const string & path, const Mugen::InputReplay::Player & input1, const Mugen::InputReplay::Player & input2, int ticks){
+    Match interpreted(path, input1, input2);
+    Match typed(path, input1, input2);
+
+    for (int tick = 0; tick < ticks && !interpreted.stage.isMatchOver(); tick++){
+        Mugen::Compiler::setTypedEvaluation(false);
+        interpreted.stage.logic();
+        Mugen::Compiler::setTypedEvaluation(true);
+        typed.stage.logic();
+
+        if (interpreted.stage.hashState() != typed.stage.hashState()){
+            Global::debug(0, "test") << "Test failure! Typed evaluation went out of sync at tick " << tick << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void benchmark(const string & path, const Mugen::InputReplay::Player & input1, const Mugen::InputReplay::Player & input2, int ticks, bool typed){
+    Match match(path, input1, input2);
+    Mugen::Compiler::setTypedEvaluation(typed);
+
+    TimeDifference diff;
+    diff.startTime();
+    int tick = 0;
+    for (tick = 0; tick < ticks && !match.stage.isMatchOver(); tick++){
+        match.stage.logic();
+    }
+    diff.endTime();
+
+    double seconds = diff.getTime() / 1000000.0;
+    Global::debug(0, "test") << (typed ? "Typed" : "RuntimeValue") << " evaluation: " << tick << " ticks in " << seconds << "s, " << (seconds > 0 ? tick / seconds : 0) << " ticks/sec" << endl;
+}
+
+int main(int argc, char ** argv){
+    InputManager manager;
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    int ticks = argc > 1 ? atoi(argv[1]) : 3000;
+    string path = argc > 2 ? argv[2] : "mugen/chars/kfm/kfm.def";
+
+    try{
+        Mugen::ParseCache cache;
+        Mugen::InputReplay::Player input1 = makeInput(ticks, 42);
+        Mugen::InputReplay::Player input2 = makeInput(ticks, 7);
+
+        if (!compare(path, input1, input2, ticks)){
+            return 1;
+        }
+
+        benchmark(path, input1, input2, ticks, false);
+        benchmark(path, input1, input2, ticks, true);
+        Global::debug(0, "test") << "Success!" << endl;
+        return 0;
+    } catch (const Exception::Base & fail){
+        Global::debug(0, "test") << "Test failure! " << fail.getTrace() << endl;
+        return 1;
+    }
+}
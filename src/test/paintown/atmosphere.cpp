@@ -0,0 +1,171 @@
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/message-queue.h"
+#include "util/file-system.h"
+#include "util/font.h"
+#include "util/funcs.h"
+#include "util/token.h"
+#include "util/tokenreader.h"
+#include "util/timedifference.h"
+#include "util/graphics/bitmap.h"
+#include "util/input/input-manager.h"
+#include "paintown-engine/game/mod.h"
+#include "paintown-engine/level/scene.h"
+#include "paintown-engine/level/cacher.h"
+#include "paintown-engine/environment/rain_atmosphere.h"
+#include "paintown-engine/environment/snow_atmosphere.h"
+#include "paintown-engine/environment/night_atmosphere.h"
+#include "factory/collector.h"
+
+/* Stress test for the atmospheres. Fills the screen with rain and snow and
+ * times updating and drawing them, then times the lighting of a night level
+ * with a row of lamps.
+ *
+ *   atmosphere [particles] [ticks] [level] [lamps]
+ */
+
+using namespace std;
+
+static void runAtmosphere(Atmosphere & atmosphere, const Scene & scene, int ticks, const string & what){
+    Graphics::Bitmap work(320, 240);
+    vector<Paintown::Object*> objects;
+
+    TimeDifference diff;
+    diff.startTime();
+    for (int i = 0; i < ticks; i++){
+        atmosphere.act(scene, &objects);
+    }
+    diff.endTime();
+
+    ostringstream act;
+    act << what << ": " << ticks << " ticks of logic. Took";
+    Global::debug(0, "test") << diff.printTime(act.str()) << endl;
+
+    diff.startTime();
+    for (int i = 0; i < ticks; i++){
+        work.clear();
+        atmosphere.drawScreen(&work, 0);
+    }
+    diff.endTime();
+
+    ostringstream draw;
+    draw << what << ": " << ticks << " draws. Took";
+    Global::debug(0, "test") << diff.printTime(draw.str()) << endl;
+}
+
+/* The light map is rebuilt every frame while the camera scrolls and reused
+ * while it stands still, also when two views are drawn one after another.
+ */
+static void runNight(int lamps, int ticks){
+    ostringstream message;
+    message << "(message (night";
+    for (int i = 0; i < lamps; i++){
+        message << " (lamp " << (i * 80 + 40) << ")";
+    }
+    message << "))";
+
+    TokenReader reader;
+    NightAtmosphere night;
+    night.interpret(reader.readTokenFromString(message.str()));
+
+    Graphics::Bitmap work(320, 240);
+    TimeDifference diff;
+
+    diff.startTime();
+    for (int i = 0; i < ticks; i++){
+        work.fill(Graphics::makeColor(128, 128, 128));
+        night.drawForeground(&work, i % (lamps * 80 + 1));
+    }
+    diff.endTime();
+
+    ostringstream scrolling;
+    scrolling << "night: " << ticks << " draws with " << lamps << " lamps while scrolling. Took";
+    Global::debug(0, "test") << diff.printTime(scrolling.str()) << endl;
+
+    diff.startTime();
+    for (int i = 0; i < ticks; i++){
+        work.fill(Graphics::makeColor(128, 128, 128));
+        night.drawForeground(&work, 0);
+    }
+    diff.endTime();
+
+    ostringstream still;
+    still << "night: " << ticks << " draws with " << lamps << " lamps standing still. Took";
+    Global::debug(0, "test") << diff.printTime(still.str()) << endl;
+
+    /* the main view and a mini map take turns, each with its own camera */
+    Graphics::Bitmap mini(160, 120);
+    diff.startTime();
+    for (int i = 0; i < ticks; i++){
+        work.fill(Graphics::makeColor(128, 128, 128));
+        night.drawForeground(&work, 0);
+        mini.fill(Graphics::makeColor(128, 128, 128));
+        night.drawForeground(&mini, 200);
+    }
+    diff.endTime();
+
+    ostringstream split;
+    split << "night: " << ticks << " draws of two views with " << lamps << " lamps standing still. Took";
+    Global::debug(0, "test") << diff.printTime(split.str()) << endl;
+}
+
+static int run(int particles, int ticks, const string & level, int lamps){
+    try{
+        Level::DefaultCacher cacher;
+        Scene scene(Storage::instance().find(Filesystem::RelativePath(level)), cacher);
+        TokenReader reader;
+
+        ostringstream rainMessage;
+        rainMessage << "(message (rain (drops " << particles << ")))";
+        RainAtmosphere rain;
+        rain.interpret(reader.readTokenFromString(rainMessage.str()));
+        runAtmosphere(rain, scene, ticks, "rain");
+
+        ostringstream snowMessage;
+        snowMessage << "(message (snow (flakes " << particles << ")))";
+        SnowAtmosphere snow;
+        snow.interpret(reader.readTokenFromString(snowMessage.str()));
+        runAtmosphere(snow, scene, ticks, "snow");
+
+        runNight(lamps, ticks);
+    } catch (const Filesystem::NotFound & e){
+        Global::debug(0, "test") << "Test failure! Couldn't find a file: " << e.getTrace() << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int paintown_main(int argc, char ** argv){
+    Global::InitConditions conditions;
+    Global::init(conditions);
+    Collector janitor;
+    InputManager manager;
+    Util::Thread::initializeLock(&MessageQueue::messageLock);
+
+    Util::Parameter<Util::ReferenceCount<Path::RelativePath> > defaultFont(Font::defaultFont, Util::ReferenceCount<Path::RelativePath>(new Path::RelativePath("fonts/LiberationSans-Regular.ttf")));
+
+    Paintown::Mod::loadDefaultMod();
+    Global::setDebug(0);
+
+    int particles = argc > 1 ? atoi(argv[1]) : 10000;
+    int ticks = argc > 2 ? atoi(argv[2]) : 1000;
+    string level = argc > 3 ? argv[3] : "paintown/levels/1.txt";
+    int lamps = argc > 4 ? atoi(argv[4]) : 8;
+
+    int die = 0;
+    try{
+        die = run(particles, ticks, level, lamps);
+    } catch (const Exception::Base & fail){
+        Global::debug(0) << "Fail: " << fail.getTrace() << std::endl;
+        die = 1;
+    }
+
+    return die;
+}
+
+int main(int argc, char ** argv){
+    return paintown_main(argc, argv);
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/message-queue.h"
+#include "util/file-system.h"
+#include "util/timedifference.h"
+#include "util/graphics/bitmap.h"
+#include "util/input/input-manager.h"
+#include "paintown-engine/game/mod.h"
+#include "paintown-engine/factory/object_factory.h"
+#include "openbor/mod.h"
+#include "openbor/display-character.h"
+#include "factory/collector.h"
+
+/* Loads the players of an openbor mod the way the select screen would, on
+ * one thread and then on several. The mod is opened again for each run so
+ * no decoded images are shared between them.
+ *
+ *   bor-players <file.pak> [threads]
+ */
+
+using namespace std;
+
+static int load(const Filesystem::AbsolutePath & path, int threads){
+    Paintown::Mod::loadOpenborMod(path);
+    Paintown::OpenborMod * mod = (Paintown::OpenborMod*) Paintown::Mod::getCurrentMod();
+
+    TimeDifference diff;
+    diff.startTime();
+    vector<Bor::DisplayCharacter*> players = mod->loadPlayers(threads);
+    diff.endTime();
+
+    int loaded = 0;
+    for (vector<Bor::DisplayCharacter*>::iterator it = players.begin(); it != players.end(); it++){
+        Bor::DisplayCharacter * player = *it;
+        if (player->isLoaded()){
+            loaded += 1;
+        }
+        delete player;
+    }
+
+    ostringstream out;
+    out << "Loaded " << loaded << " of " << players.size() << " players on " << threads << " threads. Took";
+    Global::debug(0, "test") << diff.printTime(out.str()) << endl;
+    return loaded;
+}
+
+int paintown_main(int argc, char ** argv){
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Collector janitor;
+    InputManager manager;
+    Util::Thread::initializeLock(&MessageQueue::messageLock);
+    Global::setDebug(0);
+
+    if (argc < 2){
+        Global::debug(0, "test") << "Give a pak file" << endl;
+        return 1;
+    }
+
+    int threads = argc > 2 ? atoi(argv[2]) : 4;
+
+    int die = 0;
+    try{
+        Filesystem::AbsolutePath path(argv[1]);
+        if (load(path, 1) != load(path, threads)){
+            Global::debug(0, "test") << "Test failure! Loading on " << threads << " threads loaded a different number of players" << endl;
+            die = 1;
+        }
+    } catch (const Exception::Base & fail){
+        Global::debug(0, "test") << "Test failure! " << fail.getTrace() << endl;
+        die = 1;
+    }
+
+    Paintown::Mod::setMod(NULL);
+    ObjectFactory::destroy();
+    return die;
+}
+
+int main(int argc, char ** argv){
+    return paintown_main(argc, argv);
+}
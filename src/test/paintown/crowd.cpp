@@ -0,0 +1,96 @@
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/message-queue.h"
+#include "util/file-system.h"
+#include "util/font.h"
+#include "util/funcs.h"
+#include "util/timedifference.h"
+#include "util/graphics/bitmap.h"
+#include "util/input/input-manager.h"
+#include "paintown-engine/game/mod.h"
+#include "paintown-engine/game/adventure_world.h"
+#include "paintown-engine/object/player.h"
+#include "paintown-engine/object/enemy.h"
+#include "paintown-engine/factory/object_factory.h"
+#include "factory/collector.h"
+
+/* Stress test for collision detection. Puts a lot of enemies around the
+ * player and runs the world logic as fast as possible.
+ *
+ *   crowd [enemies] [ticks] [level] [enemy]
+ */
+
+using namespace std;
+
+static int run(int enemies, int ticks, const string & level, const string & enemyPath){
+    string playerPath = "players/akuma/akuma.txt";
+    try{
+        Paintown::Player player(Storage::instance().find(Filesystem::RelativePath(playerPath)), Util::ReferenceCount<InputSource>(new InputSource(true)));
+        vector<Paintown::Object*> players;
+        players.push_back(&player);
+        AdventureWorld world(players, Storage::instance().find(Filesystem::RelativePath(level)));
+
+        Paintown::Enemy prototype(Storage::instance().find(Filesystem::RelativePath(enemyPath)));
+        for (int i = 0; i < enemies; i++){
+            Paintown::Enemy * enemy = new Paintown::Enemy(prototype);
+            enemy->setX(player.getX() + Util::rnd(-400, 400));
+            enemy->setZ(world.getMinimumZ() + Util::rnd(world.getMaximumZ() - world.getMinimumZ()));
+            /* keep the crowd alive for the whole run */
+            enemy->setMaxHealth(999999);
+            enemy->setHealth(999999);
+            world.addEnemy(enemy);
+        }
+
+        TimeDifference diff;
+        diff.startTime();
+        for (int i = 0; i < ticks; i++){
+            world.act();
+        }
+        diff.endTime();
+
+        ostringstream out;
+        out << "Ran " << ticks << " ticks with " << world.getObjects().size() << " objects. Took";
+        Global::debug(0, "test") << diff.printTime(out.str()) << endl;
+    } catch (const Filesystem::NotFound & e){
+        Global::debug(0, "test") << "Test failure! Couldn't find a file: " << e.getTrace() << endl;
+        return 1;
+    }
+
+    ObjectFactory::destroy();
+    return 0;
+}
+
+int paintown_main(int argc, char ** argv){
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Collector janitor;
+    InputManager manager;
+    Util::Thread::initializeLock(&MessageQueue::messageLock);
+
+    Util::Parameter<Util::ReferenceCount<Path::RelativePath> > defaultFont(Font::defaultFont, Util::ReferenceCount<Path::RelativePath>(new Path::RelativePath("fonts/LiberationSans-Regular.ttf")));
+
+    Paintown::Mod::loadDefaultMod();
+    Global::setDebug(0);
+
+    int enemies = argc > 1 ? atoi(argv[1]) : 300;
+    int ticks = argc > 2 ? atoi(argv[2]) : 1000;
+    string level = argc > 3 ? argv[3] : "paintown/levels/1.txt";
+    string enemy = argc > 4 ? argv[4] : "chars/joe/joe.txt";
+
+    int die = 0;
+    try{
+        die = run(enemies, ticks, level, enemy);
+    } catch (const Exception::Base & fail){
+        Global::debug(0) << "Fail: " << fail.getTrace() << std::endl;
+        die = 1;
+    }
+
+    return die;
+}
+
+int main(int argc, char ** argv){
+    return paintown_main(argc, argv);
+}
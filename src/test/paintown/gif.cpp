@@ -0,0 +1,99 @@
+#include <iostream>
+#include <map>
+#include <string>
+#include <ctype.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/file-system.h"
+#include "util/graphics/bitmap.h"
+#include "util/exceptions/exception.h"
+#include "openbor/pack-reader.h"
+#include "openbor/image.h"
+
+/* Decodes every gif in an openbor pak with Bor::decodeGif and with the
+ * graphics library, the way createBitmap does it, and requires both to give
+ * the same pixels.
+ *
+ *   gif <file.pak>
+ */
+
+using namespace std;
+
+static bool isGif(const string & path){
+    if (path.size() < 4){
+        return false;
+    }
+    string end = path.substr(path.size() - 4);
+    for (unsigned int i = 0; i < end.size(); i++){
+        end[i] = tolower(end[i]);
+    }
+    return end == ".gif";
+}
+
+static bool samePixels(const Graphics::Bitmap & a, const Graphics::Bitmap & b){
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()){
+        return false;
+    }
+
+    a.lock();
+    b.lock();
+    bool same = true;
+    for (int y = 0; y < a.getHeight() && same; y++){
+        for (int x = 0; x < a.getWidth() && same; x++){
+            same = a.getPixel(x, y) == b.getPixel(x, y);
+        }
+    }
+    b.unlock();
+    a.unlock();
+    return same;
+}
+
+static int run(const Filesystem::AbsolutePath & path){
+    Bor::PackReader reader(path);
+    int gifs = 0;
+    int failures = 0;
+    for (map<string, Bor::PackReader::File>::const_iterator it = reader.getFiles().begin(); it != reader.getFiles().end(); it++){
+        if (!isGif(it->first)){
+            continue;
+        }
+        gifs += 1;
+
+        Bor::PackReader::View data = reader.getView(it->second);
+        Bor::Image image;
+        if (!Bor::decodeGif(data.getData(), data.getLength(), image)){
+            Global::debug(0, "test") << "Test failure! Could not decode " << it->first << endl;
+            failures += 1;
+            continue;
+        }
+
+        Graphics::Bitmap * decoded = Bor::toBitmap(image);
+        Graphics::Bitmap loaded(data.getData(), data.getLength());
+        if (!samePixels(*decoded, loaded)){
+            Global::debug(0, "test") << "Test failure! " << it->first << " decoded to different pixels" << endl;
+            failures += 1;
+        }
+        delete decoded;
+    }
+
+    Global::debug(0, "test") << "Compared " << gifs << " gifs, " << failures << " were different" << endl;
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char ** argv){
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    if (argc < 2){
+        Global::debug(0, "test") << "Give a pak file" << endl;
+        return 1;
+    }
+
+    try{
+        return run(Filesystem::AbsolutePath(argv[1]));
+    } catch (const Exception::Base & fail){
+        Global::debug(0, "test") << "Test failure! " << fail.getTrace() << endl;
+        return 1;
+    }
+}
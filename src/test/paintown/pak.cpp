@@ -0,0 +1,129 @@
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/debug.h"
+#include "util/thread.h"
+#include "util/timedifference.h"
+#include "util/file-system.h"
+#include "openbor/pack-reader.h"
+
+/* Reads every file in an openbor pak, first on one thread and then on
+ * several at once, and times looking files up with findPaths.
+ *
+ *   pak <file.pak> [threads]
+ */
+
+using namespace std;
+
+/* Adds up the bytes so reading a file can't be skipped */
+static uint32_t checksum(const Bor::PackReader::View & view){
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < view.getLength(); i++){
+        sum = sum * 31 + (unsigned char) view.getData()[i];
+    }
+    return sum;
+}
+
+static uint32_t readAll(const Bor::PackReader & reader){
+    uint32_t sum = 0;
+    for (map<string, Bor::PackReader::File>::const_iterator it = reader.getFiles().begin(); it != reader.getFiles().end(); it++){
+        sum += checksum(reader.getView(it->second));
+    }
+    return sum;
+}
+
+struct Job{
+    Job():
+        reader(NULL),
+        sum(0),
+        failed(false){
+        }
+
+    const Bor::PackReader * reader;
+    uint32_t sum;
+    bool failed;
+};
+
+static void * readThread(void * arg){
+    Job * job = (Job*) arg;
+    try{
+        job->sum = readAll(*job->reader);
+    } catch (const Bor::PackError & fail){
+        job->failed = true;
+    }
+    return NULL;
+}
+
+static int run(const Filesystem::AbsolutePath & path, int threads){
+    TimeDifference diff;
+
+    diff.startTime();
+    Bor::PackReader reader(path);
+    diff.endTime();
+    ostringstream opened;
+    opened << "Opened " << path.path() << " with " << reader.getFiles().size() << " files. Took";
+    Global::debug(0, "test") << diff.printTime(opened.str()) << endl;
+
+    diff.startTime();
+    uint32_t expected = readAll(reader);
+    diff.endTime();
+    Global::debug(0, "test") << diff.printTime("Read every file on one thread. Took") << endl;
+
+    vector<Job> jobs(threads);
+    vector<Util::Thread::Id> ids(threads);
+    diff.startTime();
+    for (int i = 0; i < threads; i++){
+        jobs[i].reader = &reader;
+        Util::Thread::createThread(&ids[i], NULL, (Util::Thread::ThreadFunction) readThread, &jobs[i]);
+    }
+    for (int i = 0; i < threads; i++){
+        Util::Thread::joinThread(ids[i]);
+    }
+    diff.endTime();
+    ostringstream concurrent;
+    concurrent << "Read every file on " << threads << " threads at once. Took";
+    Global::debug(0, "test") << diff.printTime(concurrent.str()) << endl;
+
+    for (int i = 0; i < threads; i++){
+        if (jobs[i].failed || jobs[i].sum != expected){
+            Global::debug(0, "test") << "Test failure! Thread " << i << " read different data" << endl;
+            return 1;
+        }
+    }
+
+    const char * searches[] = {"data/chars/*/*.txt", "data/*.txt", "*.gif", "data/sprites/*", "data/bgs/*/*.*"};
+    const int count = sizeof(searches) / sizeof(const char *);
+    diff.startTime();
+    for (int i = 0; i < count; i++){
+        vector<string> found = reader.findPaths(searches[i]);
+        Global::debug(0, "test") << " " << searches[i] << ": " << found.size() << " files" << endl;
+    }
+    diff.endTime();
+    Global::debug(0, "test") << diff.printTime("Searched the pak. Took") << endl;
+
+    return 0;
+}
+
+int main(int argc, char ** argv){
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Global::setDebug(0);
+
+    if (argc < 2){
+        Global::debug(0, "test") << "Give a pak file" << endl;
+        return 1;
+    }
+
+    int threads = argc > 2 ? atoi(argv[2]) : 4;
+
+    try{
+        return run(Filesystem::AbsolutePath(argv[1]), threads);
+    } catch (const Exception::Base & fail){
+        Global::debug(0, "test") << "Test failure! " << fail.getTrace() << endl;
+        return 1;
+    }
+}
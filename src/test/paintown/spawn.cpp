@@ -0,0 +1,89 @@
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/message-queue.h"
+#include "util/file-system.h"
+#include "util/font.h"
+#include "util/funcs.h"
+#include "util/timedifference.h"
+#include "util/graphics/bitmap.h"
+#include "util/input/input-manager.h"
+#include "paintown-engine/game/mod.h"
+#include "paintown-engine/object/enemy.h"
+#include "paintown-engine/factory/object_factory.h"
+#include "factory/collector.h"
+
+/* Measures how long it takes to make and throw away copies of an enemy,
+ * which is what the object factory does every time a level spawns something.
+ *
+ *   spawn [copies] [enemy]
+ */
+
+using namespace std;
+
+static int run(int copies, const string & enemyPath){
+    try{
+        Paintown::Enemy prototype(Storage::instance().find(Filesystem::RelativePath(enemyPath)));
+        vector<Paintown::Enemy*> enemies;
+        enemies.reserve(copies);
+
+        TimeDifference diff;
+        diff.startTime();
+        for (int i = 0; i < copies; i++){
+            enemies.push_back(new Paintown::Enemy(prototype));
+        }
+        diff.endTime();
+
+        ostringstream out;
+        out << "Copied " << copies << " enemies. Took";
+        Global::debug(0, "test") << diff.printTime(out.str()) << endl;
+
+        diff.startTime();
+        for (vector<Paintown::Enemy*>::iterator it = enemies.begin(); it != enemies.end(); it++){
+            delete *it;
+        }
+        diff.endTime();
+
+        ostringstream out2;
+        out2 << "Deleted " << copies << " enemies. Took";
+        Global::debug(0, "test") << diff.printTime(out2.str()) << endl;
+    } catch (const Filesystem::NotFound & e){
+        Global::debug(0, "test") << "Test failure! Couldn't find a file: " << e.getTrace() << endl;
+        return 1;
+    }
+
+    ObjectFactory::destroy();
+    return 0;
+}
+
+int paintown_main(int argc, char ** argv){
+    Global::InitConditions conditions;
+    conditions.graphics = Global::InitConditions::Disabled;
+    Global::init(conditions);
+    Collector janitor;
+    InputManager manager;
+    Util::Thread::initializeLock(&MessageQueue::messageLock);
+
+    Util::Parameter<Util::ReferenceCount<Path::RelativePath> > defaultFont(Font::defaultFont, Util::ReferenceCount<Path::RelativePath>(new Path::RelativePath("fonts/LiberationSans-Regular.ttf")));
+
+    Paintown::Mod::loadDefaultMod();
+    Global::setDebug(0);
+
+    int copies = argc > 1 ? atoi(argv[1]) : 1000;
+    string enemy = argc > 2 ? argv[2] : "chars/joe/joe.txt";
+
+    int die = 0;
+    try{
+        die = run(copies, enemy);
+    } catch (const Exception::Base & fail){
+        Global::debug(0) << "Fail: " << fail.getTrace() << std::endl;
+        die = 1;
+    }
+
+    return die;
+}
+
+int main(int argc, char ** argv){
+    return paintown_main(argc, argv);
+}
@@ -0,0 +1,161 @@
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include "util/init.h"
+#include "util/message-queue.h"
+#include "util/file-system.h"
+#include "util/font.h"
+#include "util/funcs.h"
+#include "util/configuration.h"
+#include "util/timedifference.h"
+#include "util/graphics/bitmap.h"
+#include "util/input/input-manager.h"
+#include "paintown-engine/game/mod.h"
+#include "paintown-engine/game/adventure_world.h"
+#include "paintown-engine/object/player.h"
+#include "paintown-engine/object/buddy_player.h"
+#include "paintown-engine/factory/object_factory.h"
+#include "factory/collector.h"
+
+/* Times drawing the world with one view and with a view per player (the
+ * main screen plus a mini map for each buddy), first on one thread and then
+ * with the views drawn in parallel. The last frame drawn each way has to be
+ * the same.
+ *
+ *   views [views] [frames] [level]
+ */
+
+using namespace std;
+
+static void drawFrames(AdventureWorld & world, Graphics::Bitmap & work, int frames, const string & what){
+    TimeDifference diff;
+    diff.startTime();
+    for (int i = 0; i < frames; i++){
+        world.draw(&work);
+    }
+    diff.endTime();
+
+    ostringstream out;
+    out << what << ": drew " << frames << " frames. Took";
+    Global::debug(0, "test") << diff.printTime(out.str()) << endl;
+}
+
+static bool samePixels(const Graphics::Bitmap & a, const Graphics::Bitmap & b){
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()){
+        return false;
+    }
+
+    a.lock();
+    b.lock();
+    bool same = true;
+    for (int y = 0; y < a.getHeight() && same; y++){
+        for (int x = 0; x < a.getWidth() && same; x++){
+            same = a.getPixel(x, y) == b.getPixel(x, y);
+        }
+    }
+    b.unlock();
+    a.unlock();
+    return same;
+}
+
+static bool runViews(int views, int frames, const string & level, Paintown::Player & player, Paintown::Player & base){
+    /* the scene blinks its arrow every 10 frames, so draw a multiple of that
+     * to end up on the same blink both times
+     */
+    frames = (frames + 9) / 10 * 10;
+
+    bool same = true;
+    vector<Paintown::BuddyPlayer*> buddies;
+    vector<Paintown::Object*> players;
+    players.push_back(&player);
+    for (int i = 1; i < views; i++){
+        Paintown::BuddyPlayer * buddy = new Paintown::BuddyPlayer(&player, base);
+        buddies.push_back(buddy);
+        players.push_back(buddy);
+    }
+
+    {
+        AdventureWorld world(players, Storage::instance().find(Filesystem::RelativePath(level)));
+        world.drawMiniMaps(true);
+        /* get everyone on the screen */
+        world.act();
+
+        Graphics::Bitmap work(640, 480);
+
+        ostringstream serial;
+        serial << views << " views, serial";
+        Configuration::setProperty(AdventureWorld::ParallelViewsProperty, "0");
+        drawFrames(world, work, frames, serial.str());
+        Graphics::Bitmap serialWork(work, true);
+
+        ostringstream parallel;
+        parallel << views << " views, parallel";
+        Configuration::setProperty(AdventureWorld::ParallelViewsProperty, "1");
+        drawFrames(world, work, frames, parallel.str());
+
+        if (!samePixels(serialWork, work)){
+            Global::debug(0, "test") << "Test failure! " << views << " views drawn in parallel don't match the serial drawing" << endl;
+            same = false;
+        }
+
+        Configuration::setProperty(AdventureWorld::ParallelViewsProperty, "0");
+    }
+
+    for (vector<Paintown::BuddyPlayer*>::iterator it = buddies.begin(); it != buddies.end(); it++){
+        delete *it;
+    }
+
+    return same;
+}
+
+static int run(int views, int frames, const string & level){
+    string playerPath = "players/akuma/akuma.txt";
+    try{
+        Paintown::Player player(Storage::instance().find(Filesystem::RelativePath(playerPath)), Util::ReferenceCount<InputSource>(new InputSource(true)));
+        Paintown::Player base(Storage::instance().find(Filesystem::RelativePath(playerPath)), Util::ReferenceCount<InputSource>(NULL));
+
+        if (!runViews(1, frames, level, player, base)){
+            return 1;
+        }
+        if (views > 1 && !runViews(views, frames, level, player, base)){
+            return 1;
+        }
+    } catch (const Filesystem::NotFound & e){
+        Global::debug(0, "test") << "Test failure! Couldn't find a file: " << e.getTrace() << endl;
+        return 1;
+    }
+
+    ObjectFactory::destroy();
+    return 0;
+}
+
+int paintown_main(int argc, char ** argv){
+    Global::InitConditions conditions;
+    Global::init(conditions);
+    Collector janitor;
+    InputManager manager;
+    Util::Thread::initializeLock(&MessageQueue::messageLock);
+
+    Util::Parameter<Util::ReferenceCount<Path::RelativePath> > defaultFont(Font::defaultFont, Util::ReferenceCount<Path::RelativePath>(new Path::RelativePath("fonts/LiberationSans-Regular.ttf")));
+
+    Paintown::Mod::loadDefaultMod();
+    Global::setDebug(0);
+
+    int views = argc > 1 ? atoi(argv[1]) : 4;
+    int frames = argc > 2 ? atoi(argv[2]) : 500;
+    string level = argc > 3 ? argv[3] : "paintown/levels/1.txt";
+
+    int die = 0;
+    try{
+        die = run(views, frames, level);
+    } catch (const Exception::Base & fail){
+        Global::debug(0) << "Fail: " << fail.getTrace() << std::endl;
+        die = 1;
+    }
+
+    return die;
+}
+
+int main(int argc, char ** argv){
+    return paintown_main(argc, argv);
+}